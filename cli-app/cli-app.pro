@@ -0,0 +1,52 @@
+TEMPLATE = app
+TARGET   = file-commander-cli
+
+# The same compiler settings, defines and output folders as the core library.
+# The core library needs Qt GUI and Widgets to link (icons, the plugin interface), but nothing creates a QGuiApplication, so no display is required.
+include(../file-commander-core/config.pri)
+
+CONFIG += console
+CONFIG -= app_bundle
+
+DESTDIR  = ../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../file-commander-core/$${included_item}
+
+INCLUDEPATH += \
+	$$PWD/src/
+
+SOURCES += \
+	src/main.cpp \
+	src/cjsonoutput.cpp \
+	src/fileoperationcommands.cpp \
+	src/querycommands.cpp
+
+HEADERS += \
+	src/cjsonoutput.h \
+	src/commands.h
+
+LIBS += -L../bin/$${OUTPUT_DIR} -lcore -lqtutils -lcpputils
+
+win*{
+	LIBS += -lole32 -lShell32 -lUser32
+}
+
+mac*{
+	LIBS += -framework AppKit
+}
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libcore.a $${DESTDIR}/libqtutils.a $${DESTDIR}/libcpputils.a
+}
+
+linux*|freebsd{
+	isEmpty(PREFIX) {
+		PREFIX = $${DESTDIR}/installation
+	}
+	target.path = $${PREFIX}/bin
+	INSTALLS += target
+}
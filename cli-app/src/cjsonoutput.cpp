@@ -0,0 +1,38 @@
+#include "cjsonoutput.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QJsonDocument>
+RESTORE_COMPILER_WARNINGS
+
+#include <mutex>
+#include <stdio.h>
+
+void CJsonOutput::writeEvent(const char* event, QJsonObject fields)
+{
+	fields.insert(QStringLiteral("event"), QString::fromLatin1(event));
+	const QByteArray line = QJsonDocument(fields).toJson(QJsonDocument::Compact);
+
+	// The events may come from different threads, and a line must never be interleaved with another one
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+	::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), stdout);
+	::fputc('\n', stdout);
+	::fflush(stdout);
+}
+
+CProgressThrottle::CProgressThrottle(std::chrono::milliseconds interval) : _interval{interval}
+{
+}
+
+bool CProgressThrottle::due()
+{
+	if (_interval.count() <= 0)
+		return false;
+
+	const auto now = std::chrono::steady_clock::now();
+	if (now - _lastEvent < _interval)
+		return false;
+
+	_lastEvent = now;
+	return true;
+}
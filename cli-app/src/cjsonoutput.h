@@ -0,0 +1,31 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QJsonObject>
+RESTORE_COMPILER_WARNINGS
+
+#include <chrono>
+
+// The machine-readable output of the commands: JSON Lines on the standard output, one event per line, so that a script can act on each line as it arrives.
+// Every object has an "event" field. The log messages go to the standard error and never mix with the events.
+class CJsonOutput
+{
+public:
+	// Adds "event": 'event' to 'fields', writes the object as a single line and flushes it
+	static void writeEvent(const char* event, QJsonObject fields = QJsonObject());
+};
+
+// Lets through no more than one progress event per interval; a zero interval disables the progress events altogether
+class CProgressThrottle
+{
+public:
+	explicit CProgressThrottle(std::chrono::milliseconds interval);
+
+	bool due();
+
+private:
+	const std::chrono::milliseconds _interval;
+	std::chrono::steady_clock::time_point _lastEvent;
+};
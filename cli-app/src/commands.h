@@ -0,0 +1,45 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QStringList>
+RESTORE_COMPILER_WARNINGS
+
+#include <chrono>
+
+class CPruningRules;
+class QCommandLineParser;
+
+// The exit codes of all the commands
+enum ExitCode {
+	ExitSuccess = 0,
+	ExitNegativeResult = 1, // compare: the files differ; search: nothing has been found
+	ExitUsageError = 2,
+	ExitFailed = 3,         // An error, or a halt that the policy says to abort on
+	ExitInterrupted = 4     // SIGINT or SIGTERM
+};
+
+struct CommonOptions {
+	std::chrono::milliseconds progressInterval {1000};
+};
+
+// Adds the options every command has (help, verbosity, progress interval) to 'parser' and parses 'arguments', which start with the program name and the command.
+// Prints the help and exits if asked to; prints the error to the standard error and returns false if the arguments are wrong.
+bool parseCommandLine(QCommandLineParser& parser, const QStringList& arguments, CommonOptions& options);
+// The options of the commands that walk folder trees: --exclude, --max-depth, --one-file-system, --skip-hidden and --skip-system (see CPruningRules).
+// Must be added before parseCommandLine(). pruningRulesFromCommandLine() prints the error to the standard error and returns false if the values are wrong.
+void addPruningOptions(QCommandLineParser& parser);
+bool pruningRulesFromCommandLine(const QCommandLineParser& parser, CPruningRules& rules);
+// Set by SIGINT and SIGTERM; the commands stop as soon as they can once it is
+bool interruptRequested();
+
+// fileoperationcommands.cpp
+int copyCommand(const QStringList& arguments);
+int moveCommand(const QStringList& arguments);
+int deleteCommand(const QStringList& arguments);
+
+// querycommands.cpp
+int searchCommand(const QStringList& arguments);
+int compareCommand(const QStringList& arguments);
+int duCommand(const QStringList& arguments);
@@ -0,0 +1,295 @@
+#include "commands.h"
+#include "cjsonoutput.h"
+#include "fileoperations/coperationperformer.h"
+#include "pruningrules/cpruningrules.h"
+#include "system/ctimeelapsed.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QJsonArray>
+RESTORE_COMPILER_WARNINGS
+
+#include <map>
+#include <optional>
+#include <thread>
+#include <vector>
+
+static const char* haltReasonName(HaltReason reason)
+{
+	static const std::map<HaltReason, const char*> names {
+		{hrFileExists, "file_exists"},
+		{hrSourceFileIsReadOnly, "source_read_only"},
+		{hrDestFileIsReadOnly, "destination_read_only"},
+		{hrFailedToMakeItemWritable, "failed_to_make_writable"},
+		{hrFileDoesntExit, "file_doesnt_exist"},
+		{hrCreatingFolderFailed, "failed_to_create_folder"},
+		{hrFailedToDelete, "failed_to_delete"},
+		{hrUnknownError, "unknown_error"},
+		{hrNotEnoughSpace, "not_enough_space"},
+		{hrFailedToChangeAttributes, "failed_to_change_attributes"}
+	};
+
+	const auto name = names.find(reason);
+	assert_and_return_r(name != names.end(), "unknown_error");
+	return name->second;
+}
+
+namespace {
+
+// Collects the notifications of the performer; they are delivered on the main thread by processEvents()
+struct CliOperationObserver final : public CFileOperationObserver {
+	inline void onProgressChanged(float totalPercentage, size_t numFilesProcessed, size_t totalNumFiles, float filePercentage, uint64_t speed, uint32_t secondsRemaining) override {
+		if (!progressThrottle.due())
+			return;
+
+		CJsonOutput::writeEvent("progress", QJsonObject{
+			{"percent", static_cast<double>(totalPercentage)},
+			{"files_processed", static_cast<qint64>(numFilesProcessed)},
+			{"files_total", static_cast<qint64>(totalNumFiles)},
+			{"file_percent", static_cast<double>(filePercentage)},
+			{"bytes_per_second", static_cast<qint64>(speed)},
+			{"seconds_remaining", static_cast<qint64>(secondsRemaining)},
+			{"current_file", currentFile}
+		});
+	}
+
+	inline void onProcessHalted(HaltReason reason, CFileSystemObject source, CFileSystemObject dest, QString errorMessage) override {
+		CJsonOutput::writeEvent("halted", QJsonObject{
+			{"reason", haltReasonName(reason)},
+			{"source", source.fullAbsolutePath()},
+			{"destination", dest.fullAbsolutePath()},
+			{"message", errorMessage}
+		});
+
+		haltReason = reason;
+	}
+
+	inline void onProcessFinished(QString /*message*/) override {}
+
+	inline void onCurrentFileChanged(QString file) override {
+		currentFile = file;
+	}
+
+	explicit CliOperationObserver(std::chrono::milliseconds progressInterval) : progressThrottle{progressInterval} {}
+
+	CProgressThrottle progressThrottle;
+	QString currentFile;
+	std::optional<HaltReason> haltReason;
+};
+
+}
+
+// Every halt not covered by a policy is answered with "abort" as there's nobody to ask
+static bool applyPolicy(COperationPerformer& performer, const QString& policy, const std::map<QString, UserResponse>& responses, std::initializer_list<HaltReason> reasons)
+{
+	if (policy == "abort")
+		return true;
+
+	const auto response = responses.find(policy);
+	if (response == responses.end())
+	{
+		::fprintf(stderr, "Unknown policy: %s\n", qUtf8Printable(policy));
+		return false;
+	}
+
+	for (const HaltReason reason: reasons)
+		performer.setGlobalResponse(reason, response->second);
+
+	return true;
+}
+
+static bool parseRate(const QString& value, uint64_t& rate)
+{
+	bool ok = false;
+	rate = value.toULongLong(&ok);
+	if (!ok)
+		::fprintf(stderr, "Invalid rate: %s\n", qUtf8Printable(value));
+
+	return ok;
+}
+
+static int runOperation(const Operation operation, const QStringList& arguments)
+{
+	const bool copyOrMove = operation == operationCopy || operation == operationMove;
+
+	QCommandLineParser parser;
+	if (copyOrMove)
+	{
+		parser.setApplicationDescription(operation == operationCopy ? "Copies the items into the destination folder." : "Moves the items into the destination folder.");
+		parser.addPositionalArgument("sources", "The files and folders to copy.", "<source>...");
+		parser.addPositionalArgument("destination", "The folder to copy into.");
+	}
+	else
+	{
+		parser.setApplicationDescription("Deletes the items with all their contents.");
+		parser.addPositionalArgument("items", "The files and folders to delete.", "<item>...");
+	}
+
+	// What to do when the operation halts, each maps to the answer that would otherwise be asked of the user
+	const QCommandLineOption ifExistsOption("if-exists", "When the destination item already exists: overwrite, skip or abort.", "policy", "abort");
+	const QCommandLineOption ifReadOnlyOption("if-read-only", "When an item is read-only: proceed, skip or abort.", "policy", "abort");
+	const QCommandLineOption onErrorOption("on-error", "When an item can't be processed: skip or abort.", "policy", "abort");
+	const QCommandLineOption ioPriorityOption("io-priority", "The I/O priority: normal, low or idle.", "priority", "normal");
+	const QCommandLineOption bandwidthLimitOption("bandwidth-limit", "The maximum copying speed, 0 for unlimited.", "bytes/s", "0");
+	const QCommandLineOption operationsLimitOption("operations-limit", "The maximum number of items deleted per second, 0 for unlimited.", "items/s", "0");
+	const QCommandLineOption cacheNeutralOption("cache-neutral", "Don't fill the OS page cache with the contents of the files copied.");
+	const QCommandLineOption deltaTransferOption("delta-transfer", "Update the existing large files in place by writing only the blocks that differ.");
+	const QCommandLineOption preserveLinksOption("preserve-links", "Recreate the symbolic links and the hard links instead of copying what they point to.");
+
+	if (copyOrMove)
+		parser.addOptions({ifExistsOption, bandwidthLimitOption, cacheNeutralOption, deltaTransferOption, preserveLinksOption});
+	else
+		parser.addOption(operationsLimitOption);
+
+	parser.addOptions({ifReadOnlyOption, onErrorOption, ioPriorityOption});
+	// A move would delete the excluded items along with the source, so pruning is only offered for copying
+	if (operation == operationCopy)
+		addPruningOptions(parser);
+
+	CommonOptions options;
+	CPruningRules pruningRules;
+	if (!parseCommandLine(parser, arguments, options) || (operation == operationCopy && !pruningRulesFromCommandLine(parser, pruningRules)))
+		return ExitUsageError;
+
+	QStringList paths = parser.positionalArguments();
+	if (paths.size() < (copyOrMove ? 2 : 1))
+	{
+		::fprintf(stderr, "%s", qUtf8Printable(parser.helpText()));
+		return ExitUsageError;
+	}
+
+	const QString destination = copyOrMove ? QFileInfo(paths.takeLast()).absoluteFilePath() : QString();
+
+	std::vector<CFileSystemObject> sources;
+	QJsonArray sourcePaths;
+	for (const QString& path: paths)
+	{
+		CFileSystemObject item(path);
+		if (!item.exists())
+		{
+			CJsonOutput::writeEvent("error", QJsonObject{{"message", "The item doesn't exist"}, {"path", path}});
+			return ExitFailed;
+		}
+
+		sourcePaths.push_back(item.fullAbsolutePath());
+		sources.push_back(std::move(item));
+	}
+
+	COperationPerformer performer(operation, std::move(sources), destination);
+	if (operation == operationCopy)
+		performer.setPruningRules(std::move(pruningRules));
+
+	const std::map<QString, UserResponse> overwriteOrSkip {{"overwrite", urProceedWithAll}, {"skip", urSkipAll}};
+	const std::map<QString, UserResponse> proceedOrSkip {{"proceed", urProceedWithAll}, {"skip", urSkipAll}};
+	const std::map<QString, UserResponse> skip {{"skip", urSkipAll}};
+	if ((copyOrMove && !applyPolicy(performer, parser.value(ifExistsOption), overwriteOrSkip, {hrFileExists})) ||
+		!applyPolicy(performer, parser.value(ifReadOnlyOption), proceedOrSkip, {hrSourceFileIsReadOnly, hrDestFileIsReadOnly}) ||
+		!applyPolicy(performer, parser.value(onErrorOption), skip, {hrFailedToMakeItemWritable, hrFileDoesntExit, hrCreatingFolderFailed, hrFailedToDelete, hrNotEnoughSpace, hrUnknownError, hrFailedToChangeAttributes}))
+	{
+		return ExitUsageError;
+	}
+
+	static const std::map<QString, IoPriority> ioPriorities {{"normal", IoPriority::Normal}, {"low", IoPriority::Low}, {"idle", IoPriority::Idle}};
+	const auto ioPriority = ioPriorities.find(parser.value(ioPriorityOption));
+	if (ioPriority == ioPriorities.end())
+	{
+		::fprintf(stderr, "Unknown I/O priority: %s\n", qUtf8Printable(parser.value(ioPriorityOption)));
+		return ExitUsageError;
+	}
+
+	performer.setIoPriority(ioPriority->second);
+
+	uint64_t rateLimit = 0;
+	if (copyOrMove)
+	{
+		if (!parseRate(parser.value(bandwidthLimitOption), rateLimit))
+			return ExitUsageError;
+
+		performer.setBandwidthLimit(rateLimit);
+		performer.setCacheNeutralCopying(parser.isSet(cacheNeutralOption));
+		performer.setDeltaTransfer(parser.isSet(deltaTransferOption));
+		performer.setPreserveLinks(parser.isSet(preserveLinksOption));
+	}
+	else
+	{
+		if (!parseRate(parser.value(operationsLimitOption), rateLimit))
+			return ExitUsageError;
+
+		performer.setOperationsPerSecondLimit(rateLimit);
+	}
+
+	static const char* operationNames[] {"copy", "move", "delete"};
+	QJsonObject startedEvent{{"operation", operationNames[operation]}, {"sources", sourcePaths}};
+	if (copyOrMove)
+		startedEvent.insert("destination", destination);
+	CJsonOutput::writeEvent("started", startedEvent);
+
+	CTimeElapsed timer;
+	timer.start();
+
+	CliOperationObserver observer(options.progressInterval);
+	performer.setObserver(&observer);
+	performer.start();
+
+	bool aborted = false, interrupted = false;
+	while (!performer.done())
+	{
+		observer.processEvents();
+		if (observer.haltReason)
+		{
+			aborted = true;
+			performer.userResponse(*observer.haltReason, urAbort);
+			observer.haltReason.reset();
+		}
+
+		if (!interrupted && interruptRequested())
+		{
+			interrupted = true;
+			performer.cancel();
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	observer.processEvents();
+
+	QJsonObject finishedEvent{
+		{"status", interrupted ? "interrupted" : (aborted ? "aborted" : "completed")},
+		{"elapsed_ms", static_cast<qint64>(timer.elapsed())}
+	};
+
+	if (copyOrMove)
+	{
+		const auto links = performer.linkStatistics();
+		finishedEvent.insert("hard_links_recreated", static_cast<qint64>(links.hardLinksRecreated));
+		finishedEvent.insert("symbolic_links_recreated", static_cast<qint64>(links.symLinksRecreated));
+
+		const auto delta = performer.deltaTransferStatistics();
+		finishedEvent.insert("files_updated_in_place", static_cast<qint64>(delta.filesUpdated));
+		finishedEvent.insert("bytes_skipped_by_delta_transfer", static_cast<qint64>(delta.bytesSkipped));
+	}
+
+	CJsonOutput::writeEvent("finished", finishedEvent);
+
+	if (interrupted)
+		return ExitInterrupted;
+
+	return aborted ? ExitFailed : ExitSuccess;
+}
+
+int copyCommand(const QStringList& arguments)
+{
+	return runOperation(operationCopy, arguments);
+}
+
+int moveCommand(const QStringList& arguments)
+{
+	return runOperation(operationMove, arguments);
+}
+
+int deleteCommand(const QStringList& arguments)
+{
+	return runOperation(operationDelete, arguments);
+}
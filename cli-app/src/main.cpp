@@ -0,0 +1,170 @@
+#include "commands.h"
+#include "pruningrules/cpruningrules.h"
+#include "settings/csettings.h"
+#include "logging/casynclogger.h"
+#include "utility/on_scope_exit.hpp"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+RESTORE_COMPILER_WARNINGS
+
+#include <atomic>
+#include <csignal>
+#include <stdio.h>
+
+static std::atomic<bool> interruptFlag {false};
+
+static void onInterruptSignal(int)
+{
+	interruptFlag = true;
+}
+
+bool interruptRequested()
+{
+	return interruptFlag;
+}
+
+bool parseCommandLine(QCommandLineParser& parser, const QStringList& arguments, CommonOptions& options)
+{
+	const QCommandLineOption helpOption = parser.addHelpOption();
+	const QCommandLineOption verboseOption("verbose", "Write the log messages to the standard error, not just the warnings.");
+	const QCommandLineOption progressIntervalOption("progress-interval", "How often to report the progress, 0 for never.", "ms", QString::number(options.progressInterval.count()));
+	parser.addOption(verboseOption);
+	parser.addOption(progressIntervalOption);
+
+	if (!parser.parse(arguments))
+	{
+		::fprintf(stderr, "%s\n\n%s", qUtf8Printable(parser.errorText()), qUtf8Printable(parser.helpText()));
+		return false;
+	}
+
+	if (parser.isSet(helpOption))
+		parser.showHelp(ExitSuccess);
+
+	bool ok = false;
+	const int progressInterval = parser.value(progressIntervalOption).toInt(&ok);
+	if (!ok || progressInterval < 0)
+	{
+		::fprintf(stderr, "Invalid progress interval: %s\n", qUtf8Printable(parser.value(progressIntervalOption)));
+		return false;
+	}
+
+	options.progressInterval = std::chrono::milliseconds(progressInterval);
+
+	if (parser.isSet(verboseOption))
+		CAsyncLogger::instance().setCategoryLevel("default", CAsyncLogger::Level::Debug);
+
+	return true;
+}
+
+void addPruningOptions(QCommandLineParser& parser)
+{
+	parser.addOptions({
+		{"exclude", "Skip the items matching the .gitignore-style pattern along with everything inside them. Can be repeated.", "pattern"},
+		{"max-depth", "Don't look deeper than this many levels below the given folders.", "levels"},
+		{"one-file-system", "Don't enter the folders on other file systems."},
+		{"skip-hidden", "Skip the hidden items."},
+		{"skip-system", "Skip the system items (FIFOs, sockets and devices; the items with the system attribute on Windows)."}
+	});
+}
+
+bool pruningRulesFromCommandLine(const QCommandLineParser& parser, CPruningRules& rules)
+{
+	rules.setPatterns(parser.values("exclude"));
+	rules.setSameFileSystemOnly(parser.isSet("one-file-system"));
+	rules.setSkipHidden(parser.isSet("skip-hidden"));
+	rules.setSkipSystem(parser.isSet("skip-system"));
+
+	if (parser.isSet("max-depth"))
+	{
+		bool ok = false;
+		const uint maxDepth = parser.value("max-depth").toUInt(&ok);
+		if (!ok)
+		{
+			::fprintf(stderr, "Invalid maximum depth: %s\n", qUtf8Printable(parser.value("max-depth")));
+			return false;
+		}
+
+		rules.setMaxDepth(maxDepth);
+	}
+
+	return true;
+}
+
+struct Command {
+	const char* name;
+	int (*run)(const QStringList& arguments);
+	const char* description;
+};
+
+static const Command commands[] {
+	{"copy", copyCommand, "Copy files and folders into a folder"},
+	{"move", moveCommand, "Move files and folders into a folder"},
+	{"delete", deleteCommand, "Delete files and folders with all their contents"},
+	{"search", searchCommand, "Find files by name and, optionally, contents"},
+	{"compare", compareCommand, "Compare the contents of two files"},
+	{"du", duCommand, "Calculate the space occupied by files and folders"}
+};
+
+static void printUsage(FILE* stream, const QString& programName)
+{
+	::fprintf(stream, "Usage: %s <command> [options] [arguments]\n\nCommands:\n", qUtf8Printable(programName));
+	for (const Command& command: commands)
+		::fprintf(stream, "  %-10s%s\n", command.name, command.description);
+
+	::fprintf(stream, "\n'%s <command> --help' describes the options of a command.\n"
+		"The progress and the results are written to the standard output as JSON, one object per line.\n"
+		"Exit codes: 0 - success, 1 - the files differ or nothing has been found, 2 - wrong arguments, 3 - failed or aborted, 4 - interrupted.\n",
+		qUtf8Printable(programName));
+}
+
+int main(int argc, char *argv[])
+{
+	CAsyncLogger::instance().install();
+	EXEC_ON_SCOPE_EXIT([]() {CAsyncLogger::instance().uninstall();});
+	// The standard error is for the warnings unless --verbose is specified
+	CAsyncLogger::instance().setCategoryLevel("default", CAsyncLogger::Level::Warning);
+
+	AdvancedAssert::setLoggingFunc([](const char* message){
+		qWarning() << message;
+		CAsyncLogger::instance().flush(); // The assertion may be about to abort the process
+	});
+
+	// Only a core application: the CLI must run where there is no display
+	QCoreApplication app(argc, argv);
+	app.setOrganizationName("GitHubSoft");
+	app.setApplicationName("File Commander CLI");
+
+	// The core keeps a few things in the settings (e. g. the pruning rules), which must not interfere with the GUI application's
+	CSettings::setApplicationName(app.applicationName());
+	CSettings::setOrganizationName(app.organizationName());
+
+	std::signal(SIGINT, onInterruptSignal);
+	std::signal(SIGTERM, onInterruptSignal);
+
+	const QStringList arguments = app.arguments();
+	const QString programName = arguments.empty() ? QStringLiteral("file-commander-cli") : arguments.front();
+	if (arguments.size() < 2)
+	{
+		printUsage(stderr, programName);
+		return ExitUsageError;
+	}
+	else if (arguments[1] == "--help" || arguments[1] == "-h" || arguments[1] == "help")
+	{
+		printUsage(stdout, programName);
+		return ExitSuccess;
+	}
+
+	for (const Command& command: commands)
+	{
+		if (arguments[1] == command.name)
+			return command.run(QStringList{programName + ' ' + command.name} + arguments.mid(2));
+	}
+
+	::fprintf(stderr, "Unknown command: %s\n\n", qUtf8Printable(arguments[1]));
+	printUsage(stderr, programName);
+	return ExitUsageError;
+}
@@ -0,0 +1,365 @@
+#include "commands.h"
+#include "cjsonoutput.h"
+#include "filesearchengine/cfilesearchengine.h"
+#include "pruningrules/cpruningrules.h"
+#include "filecomparator/cfilecomparator.h"
+#include "statistics/coccupiedspacecalculator.h"
+#include "system/ctimeelapsed.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+RESTORE_COMPILER_WARNINGS
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+static bool allPathsExist(const QStringList& paths)
+{
+	for (const QString& path: paths)
+	{
+		if (!QFileInfo::exists(path))
+		{
+			CJsonOutput::writeEvent("error", QJsonObject{{"message", "The item doesn't exist"}, {"path", path}});
+			return false;
+		}
+	}
+
+	return true;
+}
+
+namespace {
+
+struct CliSearchListener final : public CFileSearchEngine::FileSearchListener {
+	inline void itemScanned(const QString& currentItem) override {
+		++numItemsScanned;
+		if (progressThrottle.due())
+			CJsonOutput::writeEvent("progress", QJsonObject{{"items_scanned", static_cast<qint64>(numItemsScanned)}, {"current_item", currentItem}});
+	}
+
+	inline void matchFound(const CFileSystemObject& match) override {
+		++numMatches;
+		QJsonObject event{{"path", match.fullAbsolutePath()}, {"type", match.isDir() ? "folder" : "file"}};
+		if (match.isFile())
+			event.insert("size", static_cast<qint64>(match.size()));
+		CJsonOutput::writeEvent("match", event);
+	}
+
+	inline void searchFinished(CFileSearchEngine::SearchStatus status, uint32_t itemsPerSecond) override {
+		finished = true;
+		cancelled = status == CFileSearchEngine::SearchCancelled;
+		speed = itemsPerSecond;
+	}
+
+	explicit CliSearchListener(std::chrono::milliseconds progressInterval) : progressThrottle{progressInterval} {}
+
+	CProgressThrottle progressThrottle;
+	uint64_t numItemsScanned = 0;
+	uint64_t numMatches = 0;
+	uint32_t speed = 0;
+	std::atomic<bool> finished {false};
+	bool cancelled = false;
+};
+
+}
+
+int searchCommand(const QStringList& arguments)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Finds the items whose name contains the text (or matches it, if it has the *, ? and [...] wildcards), and optionally have a line containing the text.\n"
+		"Several patterns can be separated with ';', a pattern starting with '!' excludes the items it matches, a pattern with a '/' is matched against the full path.");
+	parser.addPositionalArgument("name", "What to look for in the item names, \"*\" for everything.");
+	parser.addPositionalArgument("where", "The folders to search in.", "<where>...");
+
+	const QCommandLineOption contentsOption("contents", "Only report the files that contain this text (which may have wildcards).", "text");
+	const QCommandLineOption caseSensitiveOption("case-sensitive", "Match the name and the contents case-sensitively.");
+	const QCommandLineOption typeOption("type", "Only report the items of these types: any combination of f (files), d (folders) and l (symbolic links).", "types");
+	const QCommandLineOption minSizeOption("min-size", "Only report the files of at least this size.", "bytes");
+	const QCommandLineOption maxSizeOption("max-size", "Only report the files of at most this size.", "bytes");
+	const QCommandLineOption modifiedAfterOption("modified-after", "Only report the items modified at this time or later.", "ISO 8601 date");
+	const QCommandLineOption modifiedBeforeOption("modified-before", "Only report the items modified at this time or earlier.", "ISO 8601 date");
+	const QCommandLineOption changedAfterOption("changed-after", "Only report the items whose status changed at this time or later.", "ISO 8601 date");
+	const QCommandLineOption changedBeforeOption("changed-before", "Only report the items whose status changed at this time or earlier.", "ISO 8601 date");
+	const QCommandLineOption permissionsSetOption("perm", "Only report the items that have all of these permission bits set.", "octal mode");
+	const QCommandLineOption permissionsClearOption("no-perm", "Only report the items that have none of these permission bits set.", "octal mode");
+	parser.addOptions({contentsOption, caseSensitiveOption, typeOption, minSizeOption, maxSizeOption, modifiedAfterOption, modifiedBeforeOption, changedAfterOption, changedBeforeOption, permissionsSetOption, permissionsClearOption});
+	addPruningOptions(parser);
+
+	CommonOptions options;
+	CPruningRules pruningRules;
+	if (!parseCommandLine(parser, arguments, options) || !pruningRulesFromCommandLine(parser, pruningRules))
+		return ExitUsageError;
+
+	AttributeFilter attributeFilter;
+	const auto invalidValue = [&parser](const QCommandLineOption& option) {
+		::fprintf(stderr, "Invalid %s: %s\n", qUtf8Printable(option.names().front()), qUtf8Printable(parser.value(option)));
+		return ExitUsageError;
+	};
+
+	if (parser.isSet(typeOption))
+	{
+		static const std::map<QChar, AttributeFilter::ItemType> typeLetters {{'f', AttributeFilter::Files}, {'d', AttributeFilter::Folders}, {'l', AttributeFilter::SymLinks}};
+		attributeFilter.types = 0;
+		for (const QChar letter: parser.value(typeOption))
+		{
+			const auto type = typeLetters.find(letter);
+			if (type == typeLetters.end())
+				return invalidValue(typeOption);
+			attributeFilter.types |= type->second;
+		}
+	}
+
+	for (const auto& sizeLimit: {std::make_pair(&minSizeOption, &attributeFilter.minSize), std::make_pair(&maxSizeOption, &attributeFilter.maxSize)})
+	{
+		if (!parser.isSet(*sizeLimit.first))
+			continue;
+
+		bool ok = false;
+		*sizeLimit.second = parser.value(*sizeLimit.first).toULongLong(&ok);
+		if (!ok)
+			return invalidValue(*sizeLimit.first);
+	}
+
+	for (const auto& dateLimit: {std::make_pair(&modifiedAfterOption, &attributeFilter.modifiedAfter), std::make_pair(&modifiedBeforeOption, &attributeFilter.modifiedBefore),
+		std::make_pair(&changedAfterOption, &attributeFilter.changedAfter), std::make_pair(&changedBeforeOption, &attributeFilter.changedBefore)})
+	{
+		if (!parser.isSet(*dateLimit.first))
+			continue;
+
+		const QDateTime date = QDateTime::fromString(parser.value(*dateLimit.first), Qt::ISODate);
+		if (!date.isValid())
+			return invalidValue(*dateLimit.first);
+		*dateLimit.second = static_cast<time_t>(date.toSecsSinceEpoch());
+	}
+
+	for (const auto& permissions: {std::make_pair(&permissionsSetOption, &attributeFilter.permissionsSet), std::make_pair(&permissionsClearOption, &attributeFilter.permissionsClear)})
+	{
+		if (!parser.isSet(*permissions.first))
+			continue;
+
+		bool ok = false;
+		*permissions.second = parser.value(*permissions.first).toUInt(&ok, 8);
+		if (!ok || *permissions.second > 0777)
+			return invalidValue(*permissions.first);
+	}
+
+	QStringList where = parser.positionalArguments();
+	if (where.size() < 2 || where.front().isEmpty())
+	{
+		::fprintf(stderr, "%s", qUtf8Printable(parser.helpText()));
+		return ExitUsageError;
+	}
+
+	const QString name = where.takeFirst();
+	if (!allPathsExist(where))
+		return ExitFailed;
+
+	for (QString& path: where)
+		path = QFileInfo(path).absoluteFilePath();
+
+	CJsonOutput::writeEvent("started", QJsonObject{{"operation", "search"}, {"name", name}, {"where", QJsonArray::fromStringList(where)}, {"contents", parser.value(contentsOption)}});
+
+	// No controller and no UI thread: the listener is notified right away on the search threads, one notification at a time
+	std::mutex listenerMutex;
+	CFileSearchEngine engine([&listenerMutex](std::function<void ()> task, int /*tag*/) {
+		std::lock_guard<std::mutex> lock(listenerMutex);
+		task();
+	}, nullptr);
+	CliSearchListener listener(options.progressInterval);
+	engine.addListener(&listener);
+
+	const bool caseSensitive = parser.isSet(caseSensitiveOption);
+	engine.search(name, caseSensitive, where, parser.value(contentsOption), caseSensitive, attributeFilter, pruningRules);
+
+	bool interrupted = false;
+	// The worker thread is still winding down when the last notification arrives
+	while (!listener.finished || engine.searchInProgress())
+	{
+		if (!interrupted && interruptRequested())
+		{
+			interrupted = true;
+			engine.stopSearching();
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	engine.removeListener(&listener);
+
+	CJsonOutput::writeEvent("finished", QJsonObject{
+		{"status", listener.cancelled ? "interrupted" : "completed"},
+		{"matches", static_cast<qint64>(listener.numMatches)},
+		{"items_scanned", static_cast<qint64>(listener.numItemsScanned)},
+		{"items_per_second", static_cast<qint64>(listener.speed)}
+	});
+
+	if (listener.cancelled)
+		return ExitInterrupted;
+
+	return listener.numMatches > 0 ? ExitSuccess : ExitNegativeResult;
+}
+
+int compareCommand(const QStringList& arguments)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Compares two files byte by byte. Exits with 0 if they are identical, 1 if they differ.");
+	parser.addPositionalArgument("first", "The first file.");
+	parser.addPositionalArgument("second", "The second file.");
+
+	CommonOptions options;
+	if (!parseCommandLine(parser, arguments, options))
+		return ExitUsageError;
+
+	const QStringList paths = parser.positionalArguments();
+	if (paths.size() != 2)
+	{
+		::fprintf(stderr, "%s", qUtf8Printable(parser.helpText()));
+		return ExitUsageError;
+	}
+
+	std::unique_ptr<QIODevice> files[2];
+	for (size_t i = 0; i < 2; ++i)
+	{
+		auto file = std::make_unique<QFile>(paths[static_cast<int>(i)]);
+		if (!file->open(QFile::ReadOnly))
+		{
+			CJsonOutput::writeEvent("error", QJsonObject{{"message", file->errorString()}, {"path", paths[static_cast<int>(i)]}});
+			return ExitFailed;
+		}
+
+		files[i] = std::move(file);
+	}
+
+	CJsonOutput::writeEvent("started", QJsonObject{{"operation", "compare"}, {"first", QFileInfo(paths[0]).absoluteFilePath()}, {"second", QFileInfo(paths[1]).absoluteFilePath()}});
+
+	CTimeElapsed timer;
+	timer.start();
+
+	// Compared on a worker thread so that the main one can react to the interruption
+	CProgressThrottle progressThrottle(options.progressInterval);
+	std::atomic<int> result {-1};
+	CFileComparator comparator;
+	comparator.compareFilesThreaded(std::move(files[0]), std::move(files[1]), [&progressThrottle](int percent) {
+		if (percent < 100 && progressThrottle.due())
+			CJsonOutput::writeEvent("progress", QJsonObject{{"percent", percent}});
+	}, [&result](CFileComparator::ComparisonResult comparisonResult) {
+		result = comparisonResult;
+	});
+
+	while (result < 0)
+	{
+		if (interruptRequested())
+			comparator.abortComparison(); // Returns once the comparison thread has finished
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	// Joins the thread, which may still be reporting the progress
+	comparator.abortComparison();
+
+	static const char* resultNames[] {"equal", "different", "interrupted"};
+	CJsonOutput::writeEvent("finished", QJsonObject{{"status", resultNames[result]}, {"elapsed_ms", static_cast<qint64>(timer.elapsed())}});
+
+	switch (result)
+	{
+	case CFileComparator::Equal:
+		return ExitSuccess;
+	case CFileComparator::NotEqual:
+		return ExitNegativeResult;
+	default:
+		return ExitInterrupted;
+	}
+}
+
+static QJsonObject statisticsToJson(const FilesystemObjectsStatistics& stats)
+{
+	return QJsonObject{
+		{"files", static_cast<qint64>(stats.files)},
+		{"folders", static_cast<qint64>(stats.folders)},
+		{"size", static_cast<qint64>(stats.occupiedSpace)},
+		{"allocated_size", static_cast<qint64>(stats.allocatedSpace)}
+	};
+}
+
+int duCommand(const QStringList& arguments)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Calculates the size of the items along with everything inside them. Each hard-linked file is counted once, symbolic links are not followed.\n"
+		"For a single folder, the breakdown lists its immediate children, otherwise the items themselves, largest first.");
+	parser.addPositionalArgument("items", "The files and folders to examine.", "<item>...");
+	addPruningOptions(parser);
+
+	CommonOptions options;
+	CPruningRules pruningRules;
+	if (!parseCommandLine(parser, arguments, options) || !pruningRulesFromCommandLine(parser, pruningRules))
+		return ExitUsageError;
+
+	const QStringList paths = parser.positionalArguments();
+	if (paths.empty())
+	{
+		::fprintf(stderr, "%s", qUtf8Printable(parser.helpText()));
+		return ExitUsageError;
+	}
+	else if (!allPathsExist(paths))
+		return ExitFailed;
+
+	std::vector<QString> absolutePaths;
+	QJsonArray items;
+	for (const QString& path: paths)
+	{
+		absolutePaths.push_back(QFileInfo(path).absoluteFilePath());
+		items.push_back(absolutePaths.back());
+	}
+
+	CJsonOutput::writeEvent("started", QJsonObject{{"operation", "du"}, {"items", items}});
+
+	COccupiedSpaceCalculator calculator(std::move(absolutePaths), std::move(pruningRules));
+	calculator.start();
+
+	CProgressThrottle progressThrottle(options.progressInterval);
+	bool interrupted = false;
+	while (!calculator.finished())
+	{
+		if (!interrupted && interruptRequested())
+		{
+			interrupted = true;
+			calculator.cancel();
+		}
+
+		if (progressThrottle.due())
+		{
+			const auto progress = calculator.snapshot();
+			QJsonObject event = statisticsToJson(progress.totals);
+			event.insert("current_item", progress.currentItem);
+			CJsonOutput::writeEvent("progress", event);
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	const COccupiedSpaceCalculator::Snapshot results = calculator.snapshot();
+
+	QJsonArray breakdown;
+	for (const OccupiedSpaceEntry& entry: results.breakdown)
+	{
+		QJsonObject item = statisticsToJson(entry.stats);
+		item.insert("path", entry.fullPath);
+		item.insert("is_folder", entry.isDir);
+		breakdown.push_back(item);
+	}
+
+	QJsonObject finishedEvent = statisticsToJson(results.totals);
+	finishedEvent.insert("status", results.cancelled ? "interrupted" : "completed");
+	finishedEvent.insert("hard_links_skipped", static_cast<qint64>(results.hardLinksSkipped));
+	finishedEvent.insert("elapsed_ms", static_cast<qint64>(results.msElapsed));
+	finishedEvent.insert("breakdown", breakdown);
+	CJsonOutput::writeEvent("finished", finishedEvent);
+
+	return results.cancelled ? ExitInterrupted : ExitSuccess;
+}
@@ -55,6 +55,9 @@ mac* | linux* | freebsd {
 
 DEFINES += PLUGIN_MODULE
 
+# qDebug() is compiled out of the release builds of everything that includes this file; qInfo() and above are kept
+CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
+
 INCLUDEPATH += \
 	src \
 	include \
@@ -0,0 +1,30 @@
+TEMPLATE = app
+CONFIG += console
+TARGET = asynclogger_test
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libcpputils.a
+}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+
+INCLUDEPATH += \
+	../../src/
+
+LIBS += -L$${DESTDIR} -lcpputils
+
+SOURCES += \
+	asynclogger_test.cpp \
+	../../src/logging/casynclogger.cpp
+
+HEADERS += \
+	../../src/logging/casynclogger.h \
+	../../src/logging/cmpscqueue.hpp
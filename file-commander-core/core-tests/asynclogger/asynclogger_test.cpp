@@ -0,0 +1,133 @@
+#include "logging/casynclogger.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDebug>
+#include <QLoggingCategory>
+#include <QStringList>
+RESTORE_COMPILER_WARNINGS
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+Q_LOGGING_CATEGORY(testCategory, "fc.test")
+
+namespace {
+
+std::mutex capturedMutex;
+QStringList captured;
+std::vector<std::thread::id> capturingThreads;
+
+void capturingHandler(QtMsgType /*type*/, const QMessageLogContext& /*context*/, const QString& text)
+{
+	std::lock_guard<std::mutex> lock(capturedMutex);
+	captured.push_back(text);
+	capturingThreads.push_back(std::this_thread::get_id());
+}
+
+// Installs the capturing handler under the async logger for the duration of a test
+struct LoggerFixture {
+	LoggerFixture()
+	{
+		captured.clear();
+		capturingThreads.clear();
+		previousHandler = qInstallMessageHandler(&capturingHandler);
+		CAsyncLogger::instance().install();
+	}
+
+	~LoggerFixture()
+	{
+		CAsyncLogger::instance().uninstall();
+		qInstallMessageHandler(previousHandler);
+	}
+
+	QtMessageHandler previousHandler = nullptr;
+};
+
+}
+
+TEST_CASE("Messages are written on the background thread in order", "[asynclogger]")
+{
+	LoggerFixture fixture;
+	CAsyncLogger::instance().setMaxRepeatsPerSecond(0);
+
+	static constexpr int NumThreads = 4, NumMessages = 1000;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < NumThreads; ++t)
+	{
+		threads.emplace_back([t] {
+			for (int i = 0; i < NumMessages; ++i)
+				qInfo().noquote() << QString("%1 %2").arg(t).arg(i);
+		});
+	}
+
+	for (auto& thread: threads)
+		thread.join();
+
+	CAsyncLogger::instance().flush();
+
+	std::lock_guard<std::mutex> lock(capturedMutex);
+	REQUIRE(captured.size() == NumThreads * NumMessages);
+
+	// The messages of every thread come in the order they have been logged
+	std::vector<int> lastIndex(NumThreads, -1);
+	for (const QString& message: captured)
+	{
+		const auto parts = message.split(' ');
+		REQUIRE(parts.size() == 2);
+		const int t = parts[0].toInt(), i = parts[1].toInt();
+		CHECK(i == lastIndex[(size_t)t] + 1);
+		lastIndex[(size_t)t] = i;
+	}
+
+	for (const auto& threadId: capturingThreads)
+		CHECK(threadId != std::this_thread::get_id());
+
+	CAsyncLogger::instance().setMaxRepeatsPerSecond(20);
+}
+
+TEST_CASE("Repeated messages are rate-limited", "[asynclogger]")
+{
+	LoggerFixture fixture;
+	CAsyncLogger::instance().setMaxRepeatsPerSecond(5);
+	const uint64_t suppressedBefore = CAsyncLogger::instance().numMessagesSuppressed();
+
+	for (int i = 0; i < 100; ++i)
+		qInfo() << "The same message";
+	qInfo() << "Another message";
+
+	// The summary comes when the logger is uninstalled at the latest
+	CAsyncLogger::instance().uninstall();
+
+	std::lock_guard<std::mutex> lock(capturedMutex);
+	CHECK(captured.count(QString("The same message")) == 5);
+	CHECK(captured.count(QString("Another message")) == 1);
+	CHECK(CAsyncLogger::instance().numMessagesSuppressed() - suppressedBefore == 95);
+	CHECK(std::count_if(captured.begin(), captured.end(), [](const QString& message) {
+		return message.startsWith("The same message") && message.contains("95");
+	}) == 1);
+
+	CAsyncLogger::instance().setMaxRepeatsPerSecond(20);
+}
+
+TEST_CASE("Categories can be silenced", "[asynclogger]")
+{
+	LoggerFixture fixture;
+
+	CAsyncLogger::instance().setCategoryLevel("fc.test", CAsyncLogger::Level::Warning);
+	qCInfo(testCategory) << "Dropped";
+	qCWarning(testCategory) << "Kept";
+	qInfo() << "Default category";
+
+	CAsyncLogger::instance().setCategoryLevel("fc.test", CAsyncLogger::Level::Debug);
+	qCInfo(testCategory) << "Kept again";
+
+	CAsyncLogger::instance().flush();
+
+	std::lock_guard<std::mutex> lock(capturedMutex);
+	CHECK(captured == QStringList({"Kept", "Default category", "Kept again"}));
+}
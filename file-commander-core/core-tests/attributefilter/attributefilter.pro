@@ -0,0 +1,36 @@
+TEMPLATE = app
+CONFIG += console
+TARGET = attributefilter_test
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libqtutils.a $${DESTDIR}/libcpputils.a
+}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+INCLUDEPATH += \
+	../../src/
+
+LIBS += -L$${DESTDIR} -lqtutils -lcpputils
+
+SOURCES += \
+	attributefilter_test.cpp \
+	../../src/filesearchengine/cattributefilter.cpp \
+	../../src/cfilesystemobject.cpp \
+	../../src/fasthash.c \
+	../../src/iconprovider/ciconprovider.cpp \
+	../../src/iconprovider/ciconproviderimpl.cpp
+
+HEADERS += \
+	../../src/filesearchengine/cattributefilter.h \
+	../../src/cfilesystemobject.h \
+	../../src/fasthash.h \
+	../../src/iconprovider/ciconprovider.h \
+	../../src/iconprovider/ciconproviderimpl.h
@@ -0,0 +1,106 @@
+#include "filesearchengine/cattributefilter.h"
+#include "cfilesystemobject.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+static CFileSystemObject createFile(const QString& path, int size, const QDateTime& modified)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::WriteOnly));
+	REQUIRE(file.write(QByteArray(size, 'x')) == size);
+	REQUIRE(file.setFileTime(modified, QFileDevice::FileModificationTime));
+	file.close();
+
+	return CFileSystemObject(path);
+}
+
+TEST_CASE("The default filter matches everything", "[attributefilter]")
+{
+	QTemporaryDir dir(QDir::currentPath() + "/attributefilter_XXXXXX");
+	REQUIRE(dir.isValid());
+
+	const AttributeFilter filter;
+	CHECK(filter.isEmpty());
+	CHECK(filter.matches(createFile(dir.path() + "/file", 10, QDateTime::currentDateTime())));
+	CHECK(filter.matches(CFileSystemObject(dir.path())));
+}
+
+TEST_CASE("Type, size and date ranges", "[attributefilter]")
+{
+	QTemporaryDir dir(QDir::currentPath() + "/attributefilter_XXXXXX");
+	REQUIRE(dir.isValid());
+
+	const QDateTime now = QDateTime::currentDateTime();
+	const CFileSystemObject small = createFile(dir.path() + "/small", 100, now.addDays(-30));
+	const CFileSystemObject large = createFile(dir.path() + "/large", 100000, now.addDays(-1));
+	const CFileSystemObject folder(dir.path());
+
+	AttributeFilter filter;
+	filter.types = AttributeFilter::Folders;
+	CHECK(!filter.isEmpty());
+	CHECK(filter.matches(folder));
+	CHECK(!filter.matches(small));
+
+	filter = AttributeFilter();
+	filter.minSize = 1000;
+	CHECK(filter.matches(large));
+	CHECK(!filter.matches(small));
+	CHECK(!filter.matches(folder)); // Only files have a size
+
+	filter = AttributeFilter();
+	filter.maxSize = 100; // Inclusive
+	CHECK(filter.matches(small));
+	CHECK(!filter.matches(large));
+
+	filter = AttributeFilter();
+	filter.modifiedAfter = static_cast<time_t>(now.addDays(-7).toSecsSinceEpoch());
+	CHECK(filter.matches(large));
+	CHECK(!filter.matches(small));
+
+	filter.modifiedAfter = std::numeric_limits<time_t>::min();
+	filter.modifiedBefore = static_cast<time_t>(now.addDays(-7).toSecsSinceEpoch());
+	CHECK(!filter.matches(large));
+	CHECK(filter.matches(small));
+
+	// The status has just changed
+	filter = AttributeFilter();
+	filter.changedAfter = static_cast<time_t>(now.addDays(-1).toSecsSinceEpoch());
+	CHECK(filter.matches(small));
+	filter.changedAfter = static_cast<time_t>(now.addDays(1).toSecsSinceEpoch());
+	CHECK(!filter.matches(small));
+}
+
+#ifndef _WIN32
+TEST_CASE("Permission bits", "[attributefilter]")
+{
+	QTemporaryDir dir(QDir::currentPath() + "/attributefilter_XXXXXX");
+	REQUIRE(dir.isValid());
+
+	const QString path = dir.path() + "/script";
+	createFile(path, 10, QDateTime::currentDateTime());
+	REQUIRE(QFile::setPermissions(path, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner | QFileDevice::ReadGroup | QFileDevice::ReadOther));
+	const CFileSystemObject script(path);
+
+	AttributeFilter filter;
+	filter.permissionsSet = 0100;
+	CHECK(filter.matches(script));
+	filter.permissionsSet = 0744;
+	CHECK(filter.matches(script));
+	filter.permissionsSet = 0001;
+	CHECK(!filter.matches(script));
+
+	filter.permissionsSet = 0;
+	filter.permissionsClear = 0022; // Not writable by the group or the others
+	CHECK(filter.matches(script));
+	filter.permissionsClear = 0200;
+	CHECK(!filter.matches(script));
+}
+#endif
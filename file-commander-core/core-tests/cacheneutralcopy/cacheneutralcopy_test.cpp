@@ -0,0 +1,144 @@
+#include "cfilemanipulator.h"
+#include "fileoperations/ccacheneutralcopier.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+static constexpr size_t CopyChunkSize = 5 * 1024 * 1024;
+
+static QByteArray randomData(size_t size)
+{
+	std::mt19937 generator(static_cast<uint32_t>(size));
+	QByteArray data(static_cast<int>(size), '\0');
+	for (char& c: data)
+		c = static_cast<char>(generator());
+
+	return data;
+}
+
+static void writeFile(const QString& path, const QByteArray& data)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::WriteOnly));
+	REQUIRE(file.write(data) == data.size());
+}
+
+static QByteArray readFile(const QString& path)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::ReadOnly));
+	return file.readAll();
+}
+
+static void copyFile(const QString& sourcePath, const QString& destFolder, const QString& destName, bool cacheNeutral)
+{
+	CFileManipulator manipulator{CFileSystemObject(sourcePath)};
+	manipulator.setCacheNeutralCopying(cacheNeutral);
+	do
+	{
+		REQUIRE(manipulator.copyChunk(CopyChunkSize, destFolder, destName) == FileOperationResultCode::Ok);
+	} while (manipulator.copyOperationInProgress());
+}
+
+TEST_CASE("Cache-neutral copying produces identical files", "[cacheneutralcopy]")
+{
+	QTemporaryDir tempDir(QDir::currentPath() + "/cacheneutralcopy_XXXXXX");
+	REQUIRE(tempDir.isValid());
+	const QString folder = tempDir.path() + '/';
+
+	// Sizes around the O_DIRECT alignment and the copy chunk size
+	for (const size_t size: {size_t{0}, size_t{1}, size_t{4095}, size_t{4096}, size_t{4097}, CopyChunkSize, CopyChunkSize + 3, 2 * CopyChunkSize + 4096})
+	{
+		const QByteArray data = randomData(size);
+		writeFile(folder + "source.bin", data);
+
+		copyFile(folder + "source.bin", folder, "copy.bin", true);
+		CHECK(QFileInfo(folder + "copy.bin").size() == static_cast<qint64>(size));
+		CHECK(readFile(folder + "copy.bin") == data);
+
+		REQUIRE(QFile::remove(folder + "copy.bin"));
+	}
+}
+
+#ifdef __linux__
+
+// The fraction of the file's pages that are currently in the page cache
+static double pageCacheResidency(const QString& path)
+{
+	const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+	REQUIRE(fd >= 0);
+
+	const off_t size = ::lseek(fd, 0, SEEK_END);
+	REQUIRE(size > 0);
+
+	void* mapping = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	REQUIRE(mapping != MAP_FAILED);
+
+	const long pageSize = ::sysconf(_SC_PAGESIZE);
+	std::vector<unsigned char> pageStatus(static_cast<size_t>((size + pageSize - 1) / pageSize));
+	REQUIRE(::mincore(mapping, static_cast<size_t>(size), pageStatus.data()) == 0);
+	::munmap(mapping, static_cast<size_t>(size));
+
+	size_t numResidentPages = 0;
+	for (const unsigned char status: pageStatus)
+		numResidentPages += status & 1u;
+
+	return static_cast<double>(numResidentPages) / static_cast<double>(pageStatus.size());
+}
+
+static void dropFromPageCache(const QString& path)
+{
+	const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+	REQUIRE(fd >= 0);
+	::fdatasync(fd);
+	::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	::close(fd);
+}
+
+TEST_CASE("Cache-neutral copying leaves the data out of the page cache", "[cacheneutralcopy]")
+{
+	QTemporaryDir tempDir(QDir::currentPath() + "/cacheneutralcopy_XXXXXX");
+	REQUIRE(tempDir.isValid());
+	const QString folder = tempDir.path() + '/';
+
+	const QByteArray data = randomData(32 * 1024 * 1024 + 12345);
+	writeFile(folder + "source.bin", data);
+	dropFromPageCache(folder + "source.bin");
+
+	if (pageCacheResidency(folder + "source.bin") > 0.5)
+	{
+		// tmpfs and the like: the data lives in the page cache, there's nothing to measure
+		WARN("The file system keeps files in the page cache, skipping the residency check");
+		return;
+	}
+
+	copyFile(folder + "source.bin", folder, "copy.bin", true);
+
+	// Measured before reading the copy back, which would bring it into the cache
+	const double sourceResidency = pageCacheResidency(folder + "source.bin");
+	const double copyResidency = pageCacheResidency(folder + "copy.bin");
+	INFO("Source residency: " << sourceResidency << ", copy residency: " << copyResidency);
+	CHECK(sourceResidency < 0.05);
+	CHECK(copyResidency < 0.05);
+
+	CHECK(readFile(folder + "copy.bin") == data);
+}
+
+#endif
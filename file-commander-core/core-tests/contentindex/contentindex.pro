@@ -0,0 +1,29 @@
+TEMPLATE = app
+CONFIG += console
+TARGET = contentindex_test
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libcpputils.a
+}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+
+INCLUDEPATH += \
+	../../src/
+
+LIBS += -L$${DESTDIR} -lcpputils
+
+SOURCES += \
+	contentindex_test.cpp \
+	../../src/contentindex/ctrigramindex.cpp
+
+HEADERS += \
+	../../src/contentindex/ctrigramindex.h
@@ -0,0 +1,154 @@
+#include "contentindex/ctrigramindex.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+#include <vector>
+
+static std::vector<CTrigramExtractor::Trigram> trigramsOf(CTrigramExtractor& extractor, const QByteArray& text)
+{
+	extractor.add(text.constData(), static_cast<size_t>(text.size()));
+	return extractor.takeTrigrams();
+}
+
+static CTrigramIndex::FileStamp stampOf(uint64_t size, int64_t modificationTimeNs)
+{
+	CTrigramIndex::FileStamp stamp;
+	stamp.size = size;
+	stamp.modificationTimeNs = modificationTimeNs;
+	stamp.statusChangeTimeNs = modificationTimeNs;
+	stamp.inode = 42;
+	return stamp;
+}
+
+static std::vector<CTrigramIndex::DocumentId> candidates(const CTrigramIndex& index, const QString& query, bool wildcards = false)
+{
+	const auto result = index.documentsContaining(CTrigramExtractor::queryTrigrams(query, wildcards));
+	REQUIRE(result);
+	return *result;
+}
+
+TEST_CASE("Trigram extraction", "[contentindex]")
+{
+	CTrigramExtractor extractor;
+
+	// Letters are case-folded, repeated trigrams are only reported once
+	CHECK(trigramsOf(extractor, "abcABC").size() == 3); // abc bca cab
+	CHECK(trigramsOf(extractor, "aaaa").size() == 1);
+
+	// Feeding the data in chunks gives the same result as all at once
+	extractor.add("ab", 2);
+	extractor.add("cd", 2);
+	CHECK(extractor.takeTrigrams() == trigramsOf(extractor, "abcd"));
+
+	// Non-ASCII bytes break the sequence
+	CHECK(trigramsOf(extractor, QString::fromUtf8("ab\xC3\xA9" "cd").toUtf8()).empty());
+
+	// Too short to narrow anything down
+	CHECK(CTrigramExtractor::queryTrigrams("ab", false).empty());
+	CHECK(CTrigramExtractor::queryTrigrams("ab*cd", true).empty());
+	CHECK(CTrigramExtractor::queryTrigrams("abc*de?fgh", true).size() == 2);
+	CHECK(CTrigramExtractor::queryTrigrams("a[xyz]bc", true).empty());
+}
+
+TEST_CASE("Narrowing down the candidates", "[contentindex]")
+{
+	CTrigramExtractor extractor;
+	CTrigramIndex index;
+
+	const auto apple = index.addDocument("/a.txt", stampOf(1, 1), trigramsOf(extractor, "An apple a day"));
+	const auto orange = index.addDocument("/o.txt", stampOf(1, 1), trigramsOf(extractor, "Orange juice"));
+	const auto both = index.addDocument("/b.txt", stampOf(1, 1), trigramsOf(extractor, "apple and orange"));
+	index.addUnindexedDocument("/binary.bin", stampOf(100, 1));
+
+	CHECK(index.numDocuments() == 4);
+	CHECK(!index.documentsContaining({}));
+
+	CHECK(candidates(index, "APPLE") == std::vector<CTrigramIndex::DocumentId>{apple, both});
+	CHECK(candidates(index, "orange") == std::vector<CTrigramIndex::DocumentId>{orange, both});
+	CHECK(candidates(index, "apple*orange", true) == std::vector<CTrigramIndex::DocumentId>{both});
+	CHECK(candidates(index, "banana").empty());
+
+	SECTION("Re-indexing a file replaces its previous version")
+	{
+		const auto generation = index.generation();
+		const auto newApple = index.addDocument("/a.txt", stampOf(2, 2), trigramsOf(extractor, "A banana a day"));
+		CHECK(newApple > both);
+		// The existing IDs stay valid
+		CHECK(index.generation() == generation);
+		CHECK(index.nextDocumentId() == newApple + 1);
+		CHECK(index.numDocuments() == 4);
+		CHECK(candidates(index, "apple") == std::vector<CTrigramIndex::DocumentId>{both});
+		CHECK(candidates(index, "banana") == std::vector<CTrigramIndex::DocumentId>{newApple});
+
+		CTrigramIndex::DocumentId id = 0;
+		const auto* document = index.document("/a.txt", &id);
+		REQUIRE(document);
+		CHECK(id == newApple);
+		CHECK(document->stamp == stampOf(2, 2));
+		CHECK(document->stamp != stampOf(2, 3));
+	}
+
+	SECTION("Removing and compacting")
+	{
+		index.removeDocument("/o.txt");
+		CHECK(index.document("/o.txt") == nullptr);
+		CHECK(candidates(index, "orange") == std::vector<CTrigramIndex::DocumentId>{both});
+
+		const size_t postingsBefore = index.numPostings();
+		const auto generation = index.generation();
+		index.compact();
+		CHECK(index.generation() != generation);
+		CHECK(index.numPostings() < postingsBefore);
+		CHECK(index.numDocuments() == 3);
+
+		CTrigramIndex::DocumentId bothId = 0;
+		REQUIRE(index.document("/b.txt", &bothId));
+		CHECK(candidates(index, "orange") == std::vector<CTrigramIndex::DocumentId>{bothId});
+	}
+}
+
+TEST_CASE("Saving and loading the index", "[contentindex]")
+{
+	QTemporaryDir dir(QDir::currentPath() + "/contentindex_XXXXXX");
+	REQUIRE(dir.isValid());
+	const QString indexPath = dir.path() + "/index.bin";
+
+	CTrigramExtractor extractor;
+	CTrigramIndex index;
+	// Enough documents for the deltas to take more than one byte
+	for (int i = 0; i < 1000; ++i)
+		index.addDocument(QString("/file%1.txt").arg(i), stampOf(static_cast<uint64_t>(i), i), trigramsOf(extractor, QByteArray("common text ") + QByteArray::number(i * 7919)));
+	index.addUnindexedDocument("/binary.bin", stampOf(100, 1));
+	index.removeDocument("/file5.txt");
+
+	REQUIRE(index.save(indexPath));
+
+	CTrigramIndex loaded;
+	REQUIRE(loaded.load(indexPath));
+	CHECK(loaded.numDocuments() == index.numDocuments());
+	CHECK(loaded.numPostings() == index.numPostings());
+	CHECK(candidates(loaded, "common") == candidates(index, "common"));
+	CHECK(candidates(loaded, "common").size() == 999);
+	CHECK(candidates(loaded, QString::number(999 * 7919)) == candidates(index, QString::number(999 * 7919)));
+
+	const auto* binary = loaded.document("/binary.bin");
+	REQUIRE(binary);
+	CHECK(!binary->indexed);
+	CHECK(binary->stamp == stampOf(100, 1));
+	CHECK(loaded.document("/file5.txt") == nullptr);
+
+	// A damaged file is rejected
+	QFile file(indexPath);
+	REQUIRE(file.open(QFile::ReadWrite));
+	REQUIRE(file.resize(file.size() / 2));
+	file.close();
+	CHECK(!loaded.load(indexPath));
+	CHECK(loaded.empty());
+}
@@ -0,0 +1,167 @@
+#include "cbenchmarkrunner.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDebug>
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+CBenchmarkRunner::CBenchmarkRunner(size_t iterations, size_t warmupIterations, const QString& filter) :
+	_iterations{std::max(iterations, size_t{1})},
+	_warmupIterations{warmupIterations},
+	_filter{filter}
+{
+	assert_r(_filter.isValid());
+}
+
+bool CBenchmarkRunner::enabled(const QString& name, const QString& scenario) const
+{
+	return _filter.pattern().isEmpty() || _filter.match(name + '/' + scenario).hasMatch();
+}
+
+bool CBenchmarkRunner::run(const QString& name, const QString& scenario, const Iteration& iteration, const Preparation& prepare)
+{
+	if (!enabled(name, scenario))
+		return true;
+
+	qInfo() << "Running" << name << "on" << scenario;
+
+	QJsonObject result{
+		{"name", name},
+		{"scenario", scenario}
+	};
+
+	const auto fail = [&](const QString& message) {
+		qInfo() << name << "has failed:" << message;
+		result.insert("error", message);
+		_results.push_back(result);
+		_anyFailed = true;
+		return false;
+	};
+
+	resetPeakRss();
+
+	std::vector<double> durations;
+	durations.reserve(_iterations);
+	Workload workload;
+
+	for (size_t i = 0; i < _warmupIterations + _iterations; ++i)
+	{
+		if (prepare && !prepare())
+			return fail("preparation failed");
+
+		const auto start = std::chrono::steady_clock::now();
+		const auto processed = iteration();
+		const auto end = std::chrono::steady_clock::now();
+
+		if (!processed)
+			return fail("iteration " + QString::number(i) + " failed");
+
+		if (i < _warmupIterations)
+			continue;
+
+		workload = *processed;
+		durations.push_back(std::chrono::duration<double>(end - start).count());
+	}
+
+	std::sort(durations.begin(), durations.end());
+
+	// The throughput is calculated from the median, which isn't skewed by the odd run that has been disturbed by something else going on in the system
+	const double median = percentile(durations, 50);
+	result.insert("iterations", static_cast<qint64>(durations.size()));
+	result.insert("items", static_cast<qint64>(workload.items));
+	result.insert("bytes", static_cast<qint64>(workload.bytes));
+	result.insert("seconds", statistics(durations));
+	result.insert("items_per_second", median > 0.0 ? workload.items / median : 0.0);
+	result.insert("bytes_per_second", median > 0.0 ? workload.bytes / median : 0.0);
+	result.insert("peak_rss_bytes", static_cast<qint64>(peakRssBytes()));
+
+	_results.push_back(result);
+	return true;
+}
+
+const QJsonArray& CBenchmarkRunner::results() const
+{
+	return _results;
+}
+
+bool CBenchmarkRunner::anyFailed() const
+{
+	return _anyFailed;
+}
+
+uint64_t CBenchmarkRunner::peakRssBytes()
+{
+#if defined _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	assert_and_return_r(::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)) != FALSE, 0);
+	return counters.PeakWorkingSetSize;
+#elif defined __linux__
+	// Unlike ru_maxrss, VmHWM can be reset (see resetPeakRss())
+	QFile status("/proc/self/status");
+	if (status.open(QFile::ReadOnly))
+	{
+		for (QByteArray line = status.readLine(); !line.isEmpty(); line = status.readLine())
+		{
+			if (line.startsWith("VmHWM:"))
+				return line.mid(6).trimmed().split(' ').front().toULongLong() * 1024;
+		}
+	}
+
+	struct rusage usage;
+	assert_and_return_r(::getrusage(RUSAGE_SELF, &usage) == 0, 0);
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#else
+	struct rusage usage;
+	assert_and_return_r(::getrusage(RUSAGE_SELF, &usage) == 0, 0);
+#ifdef __APPLE__
+	return static_cast<uint64_t>(usage.ru_maxrss); // Bytes on macOS, kilobytes elsewhere
+#else
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+void CBenchmarkRunner::resetPeakRss()
+{
+#ifdef __linux__
+	// Resets VmHWM to the current RSS (Linux 4.0 and newer)
+	QFile clearRefs("/proc/self/clear_refs");
+	if (clearRefs.open(QFile::WriteOnly))
+		clearRefs.write("5");
+#endif
+}
+
+QJsonObject CBenchmarkRunner::statistics(const std::vector<double>& durations)
+{
+	assert_and_return_r(!durations.empty(), {});
+
+	return QJsonObject{
+		{"min", durations.front()},
+		{"mean", std::accumulate(durations.begin(), durations.end(), 0.0) / static_cast<double>(durations.size())},
+		{"p50", percentile(durations, 50)},
+		{"p90", percentile(durations, 90)},
+		{"p99", percentile(durations, 99)},
+		{"max", durations.back()}
+	};
+}
+
+double CBenchmarkRunner::percentile(const std::vector<double>& durations, double p)
+{
+	assert_and_return_r(!durations.empty(), 0.0);
+
+	const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(durations.size())));
+	return durations[std::clamp(rank, size_t{1}, durations.size()) - 1];
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <functional>
+#include <optional>
+#include <stdint.h>
+#include <vector>
+
+// Runs each benchmark a number of times and collects the timings, the throughput and the peak memory use as JSON.
+class CBenchmarkRunner
+{
+public:
+	// What a single run of a benchmark has processed, the throughput is calculated from it
+	struct Workload {
+		uint64_t items = 0;
+		uint64_t bytes = 0;
+	};
+
+	// Runs the measured code once. An empty result means the run has failed, and the benchmark is reported as failed.
+	using Iteration = std::function<std::optional<Workload> ()>;
+	// Runs before each iteration, e. g. to recreate the data the previous iteration has consumed. Not timed.
+	using Preparation = std::function<bool ()>;
+
+	CBenchmarkRunner(size_t iterations, size_t warmupIterations, const QString& filter);
+
+	// Benchmarks whose "name/scenario" doesn't match the filter are skipped
+	bool enabled(const QString& name, const QString& scenario) const;
+	// Returns false if the benchmark has failed. A skipped benchmark is not a failure.
+	bool run(const QString& name, const QString& scenario, const Iteration& iteration, const Preparation& prepare = {});
+
+	const QJsonArray& results() const;
+	bool anyFailed() const;
+
+	// The high-water mark of the process resident set size since the last reset
+	static uint64_t peakRssBytes();
+	// Not possible everywhere, in which case the peak stays the one of the whole process
+	static void resetPeakRss();
+
+private:
+	// The durations are in seconds, sorted
+	static QJsonObject statistics(const std::vector<double>& durations);
+	// Nearest-rank percentile
+	static double percentile(const std::vector<double>& durations, double p);
+
+private:
+	const size_t _iterations;
+	const size_t _warmupIterations;
+	const QRegularExpression _filter;
+
+	QJsonArray _results;
+	bool _anyFailed = false;
+};
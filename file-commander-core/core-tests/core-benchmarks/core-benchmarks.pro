@@ -0,0 +1,39 @@
+TEMPLATE = app
+TARGET   = core_benchmarks
+CONFIG += console
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+# Unlike the tests, the benchmarks need most of the core (CPanel and CFileSearchEngine can't exist without CController), so they link the whole library
+LIBS += -L$${DESTDIR} -ltest_utils -lcore -lqtutils -lcpputils
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libcore.a $${DESTDIR}/libqtutils.a $${DESTDIR}/libcpputils.a $${DESTDIR}/libtest_utils.a
+}
+
+win*{
+	LIBS += -lole32 -lShell32 -lUser32 -lPsapi
+}
+
+mac*{
+	LIBS += -framework AppKit
+}
+
+INCLUDEPATH += \
+	../../src/ \
+	../test-utils/src/
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+
+SOURCES += \
+	core_benchmarks.cpp \
+	cbenchmarkrunner.cpp
+
+HEADERS += \
+	cbenchmarkrunner.h
@@ -0,0 +1,480 @@
+#include "cbenchmarkrunner.h"
+#include "ccontroller.h"
+#include "directoryscanner.h"
+#include "filecomparator/cfilecomparator.h"
+#include "fileoperations/coperationperformer.h"
+#include "settings/csettings.h"
+#include "assert/advanced_assert.h"
+
+// test_utils
+#include "ctestfoldergenerator.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+
+// A generated tree the benchmarks run on
+struct Scenario {
+	QString name;
+	QString path;
+	uint64_t files = 0;
+	uint64_t folders = 0;
+	uint64_t bytes = 0;
+	double generationSeconds = 0.0;
+
+	inline uint64_t items() const { return files + folders; }
+
+	QJsonObject toJson() const {
+		return QJsonObject{
+			{"name", name},
+			{"files", static_cast<qint64>(files)},
+			{"folders", static_cast<qint64>(folders)},
+			{"bytes", static_cast<qint64>(bytes)},
+			{"generation_seconds", generationSeconds}
+		};
+	}
+};
+
+static bool writeRandomData(QFile& file, const qint64 size, std::mt19937& generator)
+{
+	QByteArray chunk;
+	for (qint64 written = 0; written < size; written += chunk.size())
+	{
+		chunk.resize(static_cast<int>(std::min<qint64>(size - written, 1024 * 1024)));
+		for (char& c: chunk)
+			c = static_cast<char>(generator());
+
+		assert_and_return_r(file.write(chunk) == chunk.size(), false);
+	}
+
+	return true;
+}
+
+static CTestFolderGenerator::TreeProfile flatProfile(const size_t numFiles)
+{
+	CTestFolderGenerator::TreeProfile profile;
+	profile.levels = {{0, 0, numFiles, numFiles}};
+	return profile;
+}
+
+// A single chain of nested folders with a few small files on every level
+static CTestFolderGenerator::TreeProfile deepProfile(const size_t depth, const size_t filesPerLevel)
+{
+	CTestFolderGenerator::TreeProfile profile;
+	profile.levels.assign(depth, {1, 1, filesPerLevel, filesPerLevel});
+	return profile;
+}
+
+// Mostly small files, some medium-sized and a few large ones, in a random tree of folders
+static CTestFolderGenerator::TreeProfile mixedProfile(const size_t depth, const size_t maxFanOut, const size_t maxFilesPerFolder)
+{
+	CTestFolderGenerator::TreeProfile profile;
+	profile.levels.assign(depth, {1, maxFanOut, 0, maxFilesPerFolder});
+	profile.levels.push_back({0, 0, 0, maxFilesPerFolder});
+	profile.fileSizes = {
+		{0, 4 * 1024, 970, false},
+		{4 * 1024, 256 * 1024, 28, false},
+		{1024 * 1024, 8 * 1024 * 1024, 2, false}
+	};
+	return profile;
+}
+
+static bool generateTree(const QString& path, const CTestFolderGenerator::TreeProfile& profile, const uint32_t seed, const size_t numThreads)
+{
+	CTestFolderGenerator generator;
+	generator.setSeed(seed);
+	return QDir().mkpath(path) && generator.generateTree(path, profile, nullptr, numThreads);
+}
+
+// Two identical files
+static bool generateComparisonFiles(const QString& path, const qint64 size, const uint32_t seed)
+{
+	assert_and_return_r(QDir().mkpath(path), false);
+
+	std::mt19937 dataGenerator{seed};
+	QFile file(path + "/a.bin");
+	assert_and_return_r(file.open(QFile::WriteOnly), false);
+	assert_and_return_r(writeRandomData(file, size, dataGenerator), false);
+	file.close();
+
+	return QFile::copy(path + "/a.bin", path + "/b.bin");
+}
+
+// Counts what has actually been generated
+static void measureScenario(Scenario& scenario)
+{
+	scanDirectory(CFileSystemObject(scenario.path), [&scenario](const CFileSystemObject& item) {
+		if (item.fullAbsolutePath() == scenario.path)
+			return;
+
+		if (item.isDir())
+			++scenario.folders;
+		else
+		{
+			++scenario.files;
+			scenario.bytes += item.size();
+		}
+	});
+}
+
+template <typename Generator>
+static std::optional<Scenario> createScenario(const QString& name, const QString& rootPath, Generator&& generator)
+{
+	qInfo() << "Generating" << name;
+
+	Scenario scenario;
+	scenario.name = name;
+	scenario.path = rootPath + '/' + name;
+
+	const auto start = std::chrono::steady_clock::now();
+	if (!generator(scenario.path))
+	{
+		qInfo() << "Failed to generate" << name;
+		return {};
+	}
+
+	scenario.generationSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	measureScenario(scenario);
+	return scenario;
+}
+
+struct OperationObserver final : public CFileOperationObserver {
+	inline void onProgressChanged(float /*totalPercentage*/, size_t /*numFilesProcessed*/, size_t /*totalNumFiles*/, float /*filePercentage*/, uint64_t /*speed*/, uint32_t /*secondsRemaining*/) override {}
+	inline void onProcessHalted(HaltReason reason, CFileSystemObject /*source*/, CFileSystemObject /*dest*/, QString /*errorMessage*/) override {
+		haltReason = reason;
+	}
+	inline void onProcessFinished(QString /*message*/ = QString()) override {}
+	inline void onCurrentFileChanged(QString /*file*/) override {}
+
+	std::optional<HaltReason> haltReason;
+};
+
+// Returns false if the operation has stopped to ask the user what to do, which never happens when all goes well
+static bool performOperation(const Operation operation, const QString& sourcePath, const QString& destination = QString())
+{
+	COperationPerformer performer(operation, CFileSystemObject(sourcePath), destination);
+	OperationObserver observer;
+	performer.setObserver(&observer);
+	performer.start();
+
+	bool halted = false;
+	while (!performer.done())
+	{
+		observer.processEvents();
+		if (observer.haltReason)
+		{
+			halted = true;
+			performer.userResponse(*observer.haltReason, urAbort);
+			observer.haltReason.reset();
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	observer.processEvents();
+	return !halted;
+}
+
+// Delivers the controller's notifications until 'condition' holds
+template <typename Condition>
+static bool waitFor(CController& controller, Condition&& condition)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::minutes(30);
+	for (;;)
+	{
+		controller.uiThreadTimerTick();
+		if (condition())
+			return true;
+		else if (std::chrono::steady_clock::now() > deadline)
+			return false;
+
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+}
+
+struct PanelListener final : public PanelContentsChangedListener {
+	inline void panelContentsChanged(Panel /*p*/, FileListRefreshCause /*operation*/) override {
+		++numRefreshes;
+	}
+	inline void itemDiscoveryInProgress(Panel /*p*/, qulonglong /*itemHash*/, size_t /*progress*/, const QString& /*currentDir*/) override {}
+
+	size_t numRefreshes = 0;
+};
+
+struct SearchListener final : public CFileSearchEngine::FileSearchListener {
+	inline void itemScanned(const QString& /*currentItem*/) override {}
+	inline void matchFound(const CFileSystemObject& /*match*/) override {
+		++numMatches;
+	}
+	inline void searchFinished(CFileSearchEngine::SearchStatus status, uint32_t /*itemsPerSecond*/) override {
+		finished = true;
+		cancelled = status == CFileSearchEngine::SearchCancelled;
+	}
+
+	size_t numMatches = 0;
+	bool finished = false;
+	bool cancelled = false;
+};
+
+static QJsonObject systemInfo()
+{
+	return QJsonObject{
+		{"os", QSysInfo::prettyProductName()},
+		{"kernel", QSysInfo::kernelType() + ' ' + QSysInfo::kernelVersion()},
+		{"cpu_architecture", QSysInfo::currentCpuArchitecture()},
+		{"logical_cores", static_cast<int>(std::thread::hardware_concurrency())},
+		{"qt_version", qVersion()},
+#ifdef QT_NO_DEBUG
+		{"build", "release"}
+#else
+		{"build", "debug"}
+#endif
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	app.setOrganizationName("GitHubSoft");
+	app.setApplicationName("File Commander core benchmarks");
+
+	// CController stores the panel paths, the benchmarks must not touch the settings of the actual application
+	CSettings::setApplicationName(app.applicationName());
+	CSettings::setOrganizationName(app.organizationName());
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Measures the performance of the file-commander-core components on generated file trees and prints the results as JSON.");
+	parser.addHelpOption();
+
+	const QCommandLineOption seedOption("seed", "The seed for generating the trees.", "seed", "1");
+	const QCommandLineOption iterationsOption("iterations", "The number of measured runs of each benchmark.", "count", "5");
+	const QCommandLineOption warmupOption("warmup", "The number of runs of each benchmark before the measured ones.", "count", "1");
+	const QCommandLineOption filterOption("filter", "Only run the benchmarks whose name/scenario matches this regular expression.", "regexp");
+	const QCommandLineOption workDirOption("work-dir", "Where to generate the trees. The file system affects the results.", "path", QDir::tempPath());
+	const QCommandLineOption outputOption("output", "Write the results to a file instead of the standard output.", "file");
+	const QCommandLineOption flatFilesOption("flat-files", "The number of files in the flat folder.", "count", "1000000");
+	const QCommandLineOption deepLevelsOption("deep-levels", "The nesting depth of the deep tree.", "count", "100");
+	const QCommandLineOption deepFilesOption("deep-files-per-level", "The number of files on every level of the deep tree.", "count", "10");
+	const QCommandLineOption mixedDepthOption("mixed-depth", "The nesting depth of the mixed tree.", "count", "4");
+	const QCommandLineOption mixedFanOutOption("mixed-fan-out", "The maximum number of subfolders in a folder of the mixed tree.", "count", "10");
+	const QCommandLineOption mixedFilesOption("mixed-files-per-folder", "The maximum number of files in a folder of the mixed tree.", "count", "40");
+	const QCommandLineOption generatorThreadsOption("generator-threads", "The number of threads for generating the trees, 0 for automatic.", "count", "0");
+	const QCommandLineOption compareSizeOption("compare-size-mb", "The size of the files being compared, in MiB.", "size", "256");
+
+	parser.addOptions({seedOption, iterationsOption, warmupOption, filterOption, workDirOption, outputOption,
+		flatFilesOption, deepLevelsOption, deepFilesOption, mixedDepthOption, mixedFanOutOption, mixedFilesOption, generatorThreadsOption, compareSizeOption});
+	parser.process(app);
+
+	bool allValid = true;
+	const auto number = [&parser, &allValid](const QCommandLineOption& option) -> size_t {
+		bool ok = false;
+		const auto value = parser.value(option).toULongLong(&ok);
+		if (!ok)
+		{
+			std::cerr << "Invalid value of --" << option.names().front().toStdString() << ": " << parser.value(option).toStdString() << std::endl;
+			allValid = false;
+		}
+
+		return static_cast<size_t>(value);
+	};
+
+	const auto seed = static_cast<uint32_t>(number(seedOption));
+	const size_t iterations = number(iterationsOption), warmupIterations = number(warmupOption);
+	const size_t flatFiles = number(flatFilesOption);
+	const size_t deepLevels = number(deepLevelsOption), deepFilesPerLevel = number(deepFilesOption);
+	const size_t mixedDepth = number(mixedDepthOption), mixedFanOut = number(mixedFanOutOption), mixedFilesPerFolder = number(mixedFilesOption);
+	const size_t generatorThreads = number(generatorThreadsOption);
+	const size_t compareSize = number(compareSizeOption) * 1024 * 1024;
+
+	if (!allValid || iterations == 0 || !QRegularExpression(parser.value(filterOption)).isValid())
+		parser.showHelp(1);
+
+	CBenchmarkRunner runner(iterations, warmupIterations, parser.value(filterOption));
+
+	QTemporaryDir workDir(parser.value(workDirOption) + "/core_benchmarks_XXXXXX");
+	if (!workDir.isValid())
+	{
+		std::cerr << "Failed to create a temporary folder in " << parser.value(workDirOption).toStdString() << std::endl;
+		return 1;
+	}
+
+	const QString rootPath = QFileInfo(workDir.path()).canonicalFilePath();
+
+	// Every tree has its own seed, so that changing the size of one doesn't change the contents of the others
+	const auto flat = createScenario("flat", rootPath, [&](const QString& path) { return generateTree(path, flatProfile(flatFiles), seed, generatorThreads); });
+	const auto deep = createScenario("deep", rootPath, [&](const QString& path) { return generateTree(path, deepProfile(deepLevels, deepFilesPerLevel), seed + 1, generatorThreads); });
+	const auto mixed = createScenario("mixed", rootPath, [&](const QString& path) { return generateTree(path, mixedProfile(mixedDepth, mixedFanOut, mixedFilesPerFolder), seed + 2, generatorThreads); });
+	const auto comparison = createScenario("comparison", rootPath, [&](const QString& path) { return generateComparisonFiles(path, static_cast<qint64>(compareSize), seed + 3); });
+	if (!flat || !deep || !mixed || !comparison)
+		return 1;
+
+	// Directory scanning
+	for (const Scenario* scenario: {&*flat, &*deep, &*mixed})
+	{
+		runner.run("scanDirectory", scenario->name, [scenario]() -> std::optional<CBenchmarkRunner::Workload> {
+			uint64_t numItems = 0;
+			scanDirectory(CFileSystemObject(scenario->path), [&numItems](const CFileSystemObject&) {
+				++numItems;
+			});
+
+			return CBenchmarkRunner::Workload{numItems, 0};
+		});
+	}
+
+	// The panel and the search engine can't exist without the controller, which is created only if needed because it starts a few threads of its own
+	std::unique_ptr<CController> controller;
+	if (runner.enabled("CPanel::refreshFileList", flat->name) || runner.enabled("CFileSearchEngine", mixed->name))
+		controller = std::make_unique<CController>();
+
+	if (runner.enabled("CPanel::refreshFileList", flat->name))
+	{
+		PanelListener listener;
+		controller->setPanelContentsChangedListener(LeftPanel, &listener);
+		CPanel& panel = controller->panel(LeftPanel);
+
+		// The refreshes started when the controller was created may still be running, but they all list the current folder by the time they get to it
+		const bool pathSet = panel.setPath(flat->path, refreshCauseOther) == FileOperationResultCode::Ok &&
+			waitFor(*controller, [&panel, &flat]() { return panel.list().size() >= flat->files; });
+
+		runner.run("CPanel::refreshFileList", flat->name, [&]() -> std::optional<CBenchmarkRunner::Workload> {
+			const size_t numRefreshes = listener.numRefreshes;
+			panel.refreshFileList(refreshCauseOther);
+			if (!waitFor(*controller, [&]() { return listener.numRefreshes > numRefreshes; }))
+				return {};
+
+			return CBenchmarkRunner::Workload{panel.list().size(), 0};
+		}, [pathSet]() {
+			return pathSet;
+		});
+	}
+
+	if (runner.enabled("CFileSearchEngine", mixed->name))
+	{
+		CFileSearchEngine& engine = controller->fileSearchEngine();
+		SearchListener listener;
+		engine.addListener(&listener);
+
+		// By name (with a wildcard, which is the slower path) and by contents, which reads every file through
+		const std::vector<std::pair<QString, QString>> queries {
+			{"*.a*", QString()},
+			{"*", "no such text"}
+		};
+
+		for (const auto& query: queries)
+		{
+			const QString name = query.second.isEmpty() ? "CFileSearchEngine (name)" : "CFileSearchEngine (contents)";
+			const uint64_t bytes = query.second.isEmpty() ? 0 : mixed->bytes;
+			runner.run(name, mixed->name, [&]() -> std::optional<CBenchmarkRunner::Workload> {
+				listener = SearchListener();
+				engine.search(query.first, false, QStringList{mixed->path}, query.second, false);
+				// The worker thread is still winding down when the last notification arrives, and a new search can't start until it's done
+				if (!waitFor(*controller, [&]() { return listener.finished && !engine.searchInProgress(); }) || listener.cancelled)
+					return {};
+
+				return CBenchmarkRunner::Workload{mixed->items(), bytes};
+			});
+		}
+
+		engine.removeListener(&listener);
+	}
+
+	// File operations. The mixed tree is copied to copyTarget, the copy is moved to moveTarget and back, and deleted.
+	const QString copyTarget = rootPath + "/copy", moveTarget = rootPath + "/move";
+	const QString copiedTree = copyTarget + '/' + mixed->name, movedTree = moveTarget + '/' + mixed->name;
+	if (!QDir().mkpath(copyTarget) || !QDir().mkpath(moveTarget))
+		return 1;
+
+	const auto prepareCopiedTree = [&]() {
+		if (QFileInfo::exists(movedTree))
+			return QDir().rename(movedTree, copiedTree);
+		else if (!QFileInfo::exists(copiedTree))
+			return performOperation(operationCopy, mixed->path, copyTarget);
+		else
+			return true;
+	};
+
+	runner.run("COperationPerformer (copy)", mixed->name, [&]() -> std::optional<CBenchmarkRunner::Workload> {
+		if (!performOperation(operationCopy, mixed->path, copyTarget))
+			return {};
+
+		return CBenchmarkRunner::Workload{mixed->items(), mixed->bytes};
+	}, [&]() {
+		return !QFileInfo::exists(copiedTree) || QDir(copiedTree).removeRecursively();
+	});
+
+	runner.run("COperationPerformer (move)", mixed->name, [&]() -> std::optional<CBenchmarkRunner::Workload> {
+		if (!performOperation(operationMove, copiedTree, moveTarget))
+			return {};
+
+		return CBenchmarkRunner::Workload{mixed->items(), mixed->bytes};
+	}, prepareCopiedTree);
+
+	runner.run("COperationPerformer (delete)", mixed->name, [&]() -> std::optional<CBenchmarkRunner::Workload> {
+		if (!performOperation(operationDelete, copiedTree))
+			return {};
+
+		return CBenchmarkRunner::Workload{mixed->items(), 0};
+	}, prepareCopiedTree);
+
+	runner.run("CFileComparator", comparison->name, [&]() -> std::optional<CBenchmarkRunner::Workload> {
+		QFile fileA(comparison->path + "/a.bin"), fileB(comparison->path + "/b.bin");
+		if (!fileA.open(QFile::ReadOnly) || !fileB.open(QFile::ReadOnly))
+			return {};
+
+		CFileComparator comparator;
+		std::optional<CFileComparator::ComparisonResult> result;
+		comparator.compareFiles(fileA, fileB, [](int) {}, [&result](CFileComparator::ComparisonResult r) {
+			result = r;
+		});
+
+		if (result != CFileComparator::Equal)
+			return {};
+
+		return CBenchmarkRunner::Workload{2, 2 * static_cast<uint64_t>(fileA.size())};
+	});
+
+	QJsonArray scenarios;
+	for (const Scenario* scenario: {&*flat, &*deep, &*mixed, &*comparison})
+		scenarios.push_back(scenario->toJson());
+
+	const QJsonObject report{
+		{"format_version", 1},
+		{"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+		{"seed", static_cast<qint64>(seed)},
+		{"system", systemInfo()},
+		{"scenarios", scenarios},
+		{"benchmarks", runner.results()}
+	};
+
+	const QByteArray json = QJsonDocument(report).toJson();
+	if (parser.isSet(outputOption))
+	{
+		QFile output(parser.value(outputOption));
+		if (!output.open(QFile::WriteOnly) || output.write(json) != json.size())
+		{
+			std::cerr << "Failed to write " << parser.value(outputOption).toStdString() << std::endl;
+			return 1;
+		}
+	}
+	else
+		std::cout << json.constData();
+
+	return runner.anyFailed() ? 1 : 0;
+}
@@ -1,11 +1,15 @@
 TEMPLATE = subdirs
 
-SUBDIRS = operationperformer filesystemobject filesystemobject-high-level filecomparator
+SUBDIRS = operationperformer filesystemobject filesystemobject-high-level filecomparator parallelscanner hashing cacheneutralcopy deltacopy ratelimiter tracer metrics asynclogger testtreegenerator contentindex namematcher attributefilter diskusage filesystemwatcher core-benchmarks
+SUBDIRS += core
 SUBDIRS += qtutils cpputils cpp-template-utils test-utils
 
 cpp-template-utils.subdir = ../../cpp-template-utils
 cpputils.subdir = ../../cpputils
 
+core.file = ../file-commander-core.pro
+core.depends = qtutils
+
 qtutils.subdir = ../../qtutils
 qtutils.depends = cpputils
 
@@ -15,3 +19,17 @@ operationperformer.depends = test-utils
 filesystemobject.depends = qtutils
 filesystemobject-high-level.depends = qtutils
 filecomparator.depends = cpputils test-utils
+parallelscanner.depends = qtutils test-utils
+hashing.depends = cpputils
+cacheneutralcopy.depends = qtutils test-utils
+deltacopy.depends = qtutils test-utils
+tracer.depends = cpputils
+metrics.depends = cpputils
+asynclogger.depends = cpputils
+contentindex.depends = cpputils
+namematcher.depends = cpputils
+attributefilter.depends = qtutils
+diskusage.depends = qtutils test-utils
+filesystemwatcher.depends = qtutils
+testtreegenerator.depends = qtutils test-utils
+core-benchmarks.depends = core test-utils
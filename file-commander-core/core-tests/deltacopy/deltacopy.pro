@@ -0,0 +1,48 @@
+TEMPLATE = app
+CONFIG += console
+TARGET = deltacopy_test
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libqtutils.a $${DESTDIR}/libcpputils.a $${DESTDIR}/libtest_utils.a
+}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+
+INCLUDEPATH += \
+	../../src/ \
+	../test-utils/src/
+
+LIBS += -L$${DESTDIR} -lcpputils -lqtutils -ltest_utils
+
+SOURCES += \
+	deltacopy_test.cpp \
+	../../src/fileoperations/ccacheneutralcopier.cpp \
+	../../src/fileoperations/cdeltacopier.cpp \
+	../../src/hashing/cblake3hasher.cpp \
+	../../src/cfilemanipulator.cpp \
+	../../src/tracing/ctracer.cpp \
+	../../src/metrics/cmetricsregistry.cpp \
+	../../src/cfilesystemobject.cpp \
+	../../src/fasthash.c \
+	../../src/iconprovider/ciconprovider.cpp \
+	../../src/iconprovider/ciconproviderimpl.cpp
+
+HEADERS += \
+	../../src/fileoperations/ccacheneutralcopier.h \
+	../../src/fileoperations/cdeltacopier.h \
+	../../src/hashing/cblake3hasher.h \
+	../../src/cfilemanipulator.h \
+	../../src/tracing/ctracer.h \
+	../../src/metrics/cmetricsregistry.h \
+	../../src/cfilesystemobject.h \
+	../../src/fasthash.h \
+	../../src/iconprovider/ciconprovider.h \
+	../../src/iconprovider/ciconproviderimpl.h
@@ -0,0 +1,151 @@
+#include "cfilemanipulator.h"
+#include "fileoperations/cdeltacopier.h"
+#include "hashing/cblake3hasher.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <random>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+static constexpr size_t CopyChunkSize = 5 * 1024 * 1024;
+static constexpr size_t FileSize = 3 * CopyChunkSize + 12345;
+static_assert(FileSize >= CDeltaCopier::MinFileSize, "The test file must be big enough for the delta transfer to kick in");
+
+static QByteArray randomData(size_t size, uint32_t seed)
+{
+	std::mt19937 generator(seed);
+	QByteArray data(static_cast<int>(size), '\0');
+	for (char& c: data)
+		c = static_cast<char>(generator());
+
+	return data;
+}
+
+static void writeFile(const QString& path, const QByteArray& data)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::WriteOnly));
+	REQUIRE(file.write(data) == data.size());
+}
+
+static QByteArray readFile(const QString& path)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::ReadOnly));
+	return file.readAll();
+}
+
+// Returns the number of bytes skipped
+static uint64_t copyFile(const QString& sourcePath, const QString& destFolder, const QString& destName, size_t chunkSize = CopyChunkSize)
+{
+	CFileManipulator manipulator{CFileSystemObject(sourcePath)};
+	manipulator.setDeltaTransfer(true);
+	do
+	{
+		REQUIRE(manipulator.copyChunk(chunkSize, destFolder, destName) == FileOperationResultCode::Ok);
+	} while (manipulator.copyOperationInProgress());
+
+	return manipulator.bytesSkipped();
+}
+
+TEST_CASE("Delta transfer only writes the blocks that differ", "[deltacopy]")
+{
+	if (!CDeltaCopier::supported())
+		return;
+
+	QTemporaryDir tempDir(QDir::currentPath() + "/deltacopy_XXXXXX");
+	REQUIRE(tempDir.isValid());
+	const QString folder = tempDir.path() + '/';
+
+	const QByteArray source = randomData(FileSize, 1);
+	writeFile(folder + "source.bin", source);
+
+	SECTION("New file")
+	{
+		CHECK(copyFile(folder + "source.bin", folder, "copy.bin") == 0);
+		CHECK(readFile(folder + "copy.bin") == source);
+	}
+
+	SECTION("Identical file")
+	{
+		writeFile(folder + "copy.bin", source);
+		CHECK(copyFile(folder + "source.bin", folder, "copy.bin") == FileSize);
+		CHECK(readFile(folder + "copy.bin") == source);
+	}
+
+	SECTION("A few bytes changed")
+	{
+		QByteArray dest = source;
+		// In the first block, across a block boundary, and in the last (incomplete) block
+		for (const size_t offset: {size_t{100}, 3 * CDeltaCopier::BlockSize - 1, 3 * CDeltaCopier::BlockSize, FileSize - 1})
+			dest[static_cast<int>(offset)] = static_cast<char>(~dest[static_cast<int>(offset)]);
+		writeFile(folder + "copy.bin", dest);
+
+		const uint64_t lastBlockSize = FileSize % CDeltaCopier::BlockSize;
+		const uint64_t maxBytesWritten = 3 * CDeltaCopier::BlockSize + lastBlockSize;
+
+		CHECK(copyFile(folder + "source.bin", folder, "copy.bin") == FileSize - maxBytesWritten);
+		CHECK(readFile(folder + "copy.bin") == source);
+
+		// Chunks that are not multiples of the block size split the blocks into smaller parts, which can only reduce the amount written
+		writeFile(folder + "copy.bin", dest);
+		CHECK(copyFile(folder + "source.bin", folder, "copy.bin", 64 * 1024 * 3) >= FileSize - maxBytesWritten);
+		CHECK(readFile(folder + "copy.bin") == source);
+	}
+
+	SECTION("Shorter and longer destination")
+	{
+		writeFile(folder + "copy.bin", source.left(static_cast<int>(FileSize / 2)));
+		CHECK(copyFile(folder + "source.bin", folder, "copy.bin") >= FileSize / 2 - CDeltaCopier::BlockSize);
+		CHECK(readFile(folder + "copy.bin") == source);
+
+		writeFile(folder + "copy.bin", source + randomData(CDeltaCopier::BlockSize + 7, 2));
+		CHECK(copyFile(folder + "source.bin", folder, "copy.bin") == FileSize);
+		CHECK(QFileInfo(folder + "copy.bin").size() == static_cast<qint64>(FileSize));
+		CHECK(readFile(folder + "copy.bin") == source);
+	}
+}
+
+TEST_CASE("Delta transfer calculates the digest of the file", "[deltacopy]")
+{
+	if (!CDeltaCopier::supported())
+		return;
+
+	QTemporaryDir tempDir(QDir::currentPath() + "/deltacopy_XXXXXX");
+	REQUIRE(tempDir.isValid());
+	const QString folder = tempDir.path() + '/';
+
+	// Exactly a multiple of the block size, and not
+	for (const size_t size: {size_t{8} * CDeltaCopier::BlockSize, FileSize})
+	{
+		const QByteArray source = randomData(size, 3);
+		writeFile(folder + "source.bin", source);
+		QByteArray dest = source;
+		dest[0] = static_cast<char>(~dest[0]);
+		writeFile(folder + "copy.bin", dest);
+
+		CDeltaCopier copier;
+		REQUIRE(copier.open(folder + "source.bin", folder + "copy.bin", size));
+		for (uint64_t offset = 0; offset < size; offset += CopyChunkSize)
+			REQUIRE(copier.update(offset, static_cast<size_t>(std::min<uint64_t>(CopyChunkSize, size - offset))));
+		REQUIRE(copier.finish());
+
+		CHECK(copier.bytesWritten() == CDeltaCopier::BlockSize);
+		CHECK(copier.bytesSkipped() == size - CDeltaCopier::BlockSize);
+
+		CBlake3Hasher hasher;
+		hasher.update(source.constData(), static_cast<size_t>(source.size()));
+		CHECK(copier.digest() == hasher.finalize());
+
+		copier.close();
+		CHECK(readFile(folder + "copy.bin") == source);
+	}
+}
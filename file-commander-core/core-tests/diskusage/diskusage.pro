@@ -0,0 +1,47 @@
+TEMPLATE = app
+CONFIG += console
+TARGET = diskusage_test
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libqtutils.a $${DESTDIR}/libcpputils.a $${DESTDIR}/libtest_utils.a
+}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+
+INCLUDEPATH += \
+	../../src/ \
+	../test-utils/src/ \
+	../../../plugins/tools/diskusageplugin/src/
+
+LIBS += -L$${DESTDIR} -lcpputils -lqtutils -ltest_utils
+
+SOURCES += \
+	diskusage_test.cpp \
+	../../../plugins/tools/diskusageplugin/src/csizetree.cpp \
+	../../../plugins/tools/diskusageplugin/src/cdiskusagescanner.cpp \
+	../../../plugins/tools/diskusageplugin/src/treemaplayout.cpp \
+	../../src/parallelscanner/cparalleldirectoryscanner.cpp \
+	../../src/pruningrules/cpruningrules.cpp \
+	../../src/cfilesystemobject.cpp \
+	../../src/fasthash.c \
+	../../src/iconprovider/ciconprovider.cpp \
+	../../src/iconprovider/ciconproviderimpl.cpp
+
+HEADERS += \
+	../../../plugins/tools/diskusageplugin/src/csizetree.h \
+	../../../plugins/tools/diskusageplugin/src/cdiskusagescanner.h \
+	../../../plugins/tools/diskusageplugin/src/treemaplayout.h \
+	../../src/parallelscanner/cparalleldirectoryscanner.h \
+	../../src/pruningrules/cpruningrules.h \
+	../../src/cfilesystemobject.h \
+	../../src/fasthash.h \
+	../../src/iconprovider/ciconprovider.h \
+	../../src/iconprovider/ciconproviderimpl.h
@@ -0,0 +1,189 @@
+#include "csizetree.h"
+#include "cdiskusagescanner.h"
+#include "treemaplayout.h"
+#include "catch2_utils.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+TEST_CASE("CSizeTree folder totals", "[diskusage]")
+{
+	CSizeTree tree;
+	const auto root = tree.addNode(CSizeTree::InvalidNode, "/root/", 0, true);
+	REQUIRE(root == tree.root());
+
+	const auto folderA = tree.addNode(root, "a", 0, true);
+	const auto folderB = tree.addNode(folderA, "b", 0, true);
+	tree.addNode(root, "file1", 100, false);
+	tree.addNode(folderA, "file2", 20, false);
+	const auto file3 = tree.addNode(folderB, "file3", 3, false);
+
+	CHECK(tree.nodeCount() == 6);
+	CHECK(tree.node(root).size == 123);
+	CHECK(tree.node(root).numFiles == 3);
+	CHECK(tree.node(folderA).size == 23);
+	CHECK(tree.node(folderA).numFiles == 2);
+	CHECK(tree.node(folderB).size == 3);
+	CHECK(tree.node(file3).numFiles == 1);
+	CHECK(tree.node(file3).parent == folderB);
+
+	CHECK(tree.name(file3) == "file3");
+	CHECK(tree.path(file3) == "/root/a/b/file3");
+
+	// Incremental additions are reflected right away
+	tree.addNode(folderB, "file4", 1000, false);
+	CHECK(tree.node(root).size == 1123);
+	CHECK(tree.node(folderA).size == 1023);
+
+	const auto children = tree.childrenSortedBySize(root);
+	REQUIRE(children.size() == 2);
+	CHECK(children[0].name == "a");
+	CHECK(children[0].isDir);
+	CHECK(children[0].size == 1023);
+	CHECK(children[1].name == "file1");
+	CHECK(!children[1].isDir);
+
+	tree.clear();
+	CHECK(tree.nodeCount() == 0);
+	CHECK(tree.root() == CSizeTree::InvalidNode);
+}
+
+TEST_CASE("CSizeTree concurrent additions", "[diskusage]")
+{
+	CSizeTree tree;
+	const auto root = tree.addNode(CSizeTree::InvalidNode, "/", 0, true);
+
+	static constexpr uint32_t numThreads = 8, numFilesPerThread = 100000;
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < numThreads; ++t)
+	{
+		threads.emplace_back([&tree, root, t]() {
+			const auto folder = tree.addNode(root, QString::number(t), 0, true);
+			for (uint32_t i = 0; i < numFilesPerThread; ++i)
+				tree.addNode(folder, QString::number(i), t + 1, false);
+		});
+	}
+
+	for (auto& thread: threads)
+		thread.join();
+
+	// 1 + 2 + ... + numThreads bytes per file index
+	CHECK(tree.node(root).size == uint64_t{numFilesPerThread} * numThreads * (numThreads + 1) / 2);
+	CHECK(tree.node(root).numFiles == numThreads * numFilesPerThread);
+	CHECK(tree.nodeCount() == 1 + numThreads + numThreads * numFilesPerThread);
+
+	for (const auto& child: tree.childrenSortedBySize(root))
+		CHECK(child.size == (child.name.toULongLong() + 1) * numFilesPerThread);
+}
+
+#ifndef _WIN32
+TEST_CASE("CDiskUsageScanner counts hard links once", "[diskusage]")
+{
+	QTemporaryDir root(QDir::tempPath() + "/" + CURRENT_TEST_NAME.c_str() + "_XXXXXX");
+	REQUIRE(root.isValid());
+
+	const QString rootPath = QDir::cleanPath(root.path());
+	REQUIRE(QDir(rootPath).mkpath("sub"));
+
+	QFile file(rootPath + "/file");
+	REQUIRE(file.open(QFile::WriteOnly));
+	REQUIRE(file.write(QByteArray(100000, 'x')) == 100000);
+	file.close();
+
+	REQUIRE(::link(QFile::encodeName(rootPath + "/file").constData(), QFile::encodeName(rootPath + "/link1").constData()) == 0);
+	REQUIRE(::link(QFile::encodeName(rootPath + "/file").constData(), QFile::encodeName(rootPath + "/sub/link2").constData()) == 0);
+
+	struct stat st;
+	REQUIRE(::stat(QFile::encodeName(rootPath + "/file").constData(), &st) == 0);
+	const uint64_t allocatedSize = static_cast<uint64_t>(st.st_blocks) * 512;
+
+	CDiskUsageScanner scanner;
+	scanner.start(rootPath);
+	while (!scanner.finished())
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	const CSizeTree& tree = scanner.tree();
+	REQUIRE(tree.root() != CSizeTree::InvalidNode);
+	CHECK(tree.nodeCount() == 5);
+	CHECK(tree.node(tree.root()).numFiles == 3);
+	// Whichever link was found first is counted
+	CHECK(tree.node(tree.root()).size == allocatedSize);
+}
+#endif
+
+TEST_CASE("Squarified treemap layout", "[diskusage]")
+{
+	std::mt19937 rng(12345);
+	std::uniform_real_distribution<double> weightDistribution(1.0, 1000.0);
+
+	for (const size_t numItems: {1, 2, 3, 10, 100})
+	{
+		std::vector<double> weights(numItems);
+		for (double& weight: weights)
+			weight = weightDistribution(rng);
+		std::sort(weights.begin(), weights.end(), std::greater<double>());
+		// Zero weights go last
+		weights.push_back(0.0);
+
+		const QRectF bounds(10.0, 20.0, 800.0, 600.0);
+		const auto rects = squarifiedLayout(weights, bounds);
+		REQUIRE(rects.size() == weights.size());
+
+		CHECK(rects.back().isEmpty());
+
+		const double totalWeight = std::accumulate(weights.begin(), weights.end(), 0.0);
+		const double boundsArea = bounds.width() * bounds.height();
+		static constexpr double epsilon = 1e-6;
+
+		double totalArea = 0.0;
+		for (size_t i = 0; i < numItems; ++i)
+		{
+			const QRectF& rect = rects[i];
+			const double area = rect.width() * rect.height();
+			totalArea += area;
+
+			// The area is proportional to the weight
+			CHECK(area == Approx(weights[i] / totalWeight * boundsArea).epsilon(epsilon));
+
+			// Within the parent
+			CHECK(rect.left() >= bounds.left() - epsilon);
+			CHECK(rect.top() >= bounds.top() - epsilon);
+			CHECK(rect.right() <= bounds.right() + epsilon);
+			CHECK(rect.bottom() <= bounds.bottom() + epsilon);
+
+			// No overlap
+			for (size_t j = i + 1; j < numItems; ++j)
+			{
+				const QRectF intersection = rect.intersected(rects[j]);
+				CHECK(intersection.width() * intersection.height() <= epsilon * boundsArea);
+			}
+		}
+
+		// The rectangles fill the parent
+		CHECK(totalArea == Approx(boundsArea).epsilon(epsilon));
+	}
+
+	// Nothing to lay out
+	const auto emptyLayout = squarifiedLayout({0.0, 0.0}, QRectF(0, 0, 100, 100));
+	REQUIRE(emptyLayout.size() == 2);
+	CHECK(emptyLayout[0].isEmpty());
+	CHECK(emptyLayout[1].isEmpty());
+}
@@ -1,5 +1,11 @@
 #include "cfilesystemobject.h"
 
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
 #define CATCH_CONFIG_MAIN
 #include "../catch2/catch.hpp"
 
@@ -49,3 +55,36 @@ TEST_CASE("::pathHierarchy tests", "[CFileSystemObject]" )
 #endif
 }
 
+TEST_CASE("An object without metadata has the same identity as the full one", "[CFileSystemObject]")
+{
+	QTemporaryDir dir(QDir::currentPath() + "/fso_test_XXXXXX");
+	REQUIRE(dir.isValid());
+
+	const QString filePath = dir.path() + "/archive.tar.gz";
+	QFile file(filePath);
+	REQUIRE(file.open(QFile::WriteOnly));
+	REQUIRE(file.write("0123456789") == 10);
+	file.close();
+
+	const QString folderPath = dir.path() + "/folder.d";
+	REQUIRE(QDir().mkdir(folderPath));
+
+	for (const auto& [path, type]: {std::pair{filePath, File}, std::pair{folderPath, Directory}})
+	{
+		const CFileSystemObject placeholder(path, type);
+		const CFileSystemObject full{QFileInfo{path}};
+
+		CHECK(placeholder.properties().metadataPending);
+		CHECK(!full.properties().metadataPending);
+
+		CHECK(placeholder.hash() == full.hash());
+		CHECK(placeholder.fullAbsolutePath() == full.fullAbsolutePath());
+		CHECK(placeholder.fullName() == full.fullName());
+		CHECK(placeholder.name() == full.name());
+		CHECK(placeholder.extension() == full.extension());
+		CHECK(placeholder.parentDirPath() == full.parentDirPath());
+		CHECK(placeholder.type() == full.type());
+	}
+
+	CHECK(CFileSystemObject{QFileInfo{filePath}}.size() == 10);
+}
@@ -0,0 +1,34 @@
+TEMPLATE = app
+CONFIG += console
+TARGET = filesystemwatcher_test
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libqtutils.a $${DESTDIR}/libcpputils.a
+}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+
+INCLUDEPATH += \
+	../../src/ \
+	../test-utils/src/
+
+LIBS += -L$${DESTDIR} -lcpputils -lqtutils
+
+SOURCES += \
+	filesystemwatcher_test.cpp \
+	../../src/filesystemwatcher/cfilesystemwatcher.cpp \
+	../../src/filesystemhelpers/filesystemhelpers.cpp \
+	../../src/tracing/ctracer.cpp
+
+HEADERS += \
+	../../src/filesystemwatcher/cfilesystemwatcher.h \
+	../../src/filesystemhelpers/filesystemhelpers.hpp \
+	../../src/tracing/ctracer.h
@@ -0,0 +1,264 @@
+#include "filesystemwatcher/cfilesystemwatcher.h"
+#include "filesystemhelpers/filesystemhelpers.hpp"
+#include "catch2_utils.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCoreApplication>
+#include <QFile>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#define CATCH_CONFIG_RUNNER
+#include "../catch2/catch.hpp"
+
+#include <chrono>
+#include <thread>
+
+// Mirrors the constants in cfilesystemwatcher.cpp
+static constexpr int ForegroundPollingPeriodMs = 333;
+static constexpr int BackgroundPollingPeriodMs = 2000;
+static constexpr int MaxPollingPeriodMs = 10000;
+static constexpr size_t DetailChecksPerTick = 64;
+static constexpr size_t DetailChecksPerTickOnHighLatencyMount = 8;
+static constexpr auto StampSettlingTime = std::chrono::seconds(2);
+
+static constexpr int NumFiles = 200;
+
+struct Changes
+{
+	QStringList added, removed, changed;
+
+	void clear() {
+		added.clear();
+		removed.clear();
+		changed.clear();
+	}
+};
+
+static void appendToFile(const QString& path, const QByteArray& data)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::WriteOnly | QFile::Append));
+	REQUIRE(file.write(data) == data.size());
+}
+
+static QString fileName(int index)
+{
+	return QStringLiteral("file_%1").arg(index, 3, 10, QChar('0'));
+}
+
+static void createFiles(const QString& folder)
+{
+	for (int i = 0; i < NumFiles; ++i)
+		appendToFile(folder + '/' + fileName(i), "0");
+}
+
+static void watch(CFileSystemWatcher& watcher, const QString& folder, Changes& changes)
+{
+	watcher.addCallback([&changes](const transparent_set<QFileInfo>& added, const transparent_set<QFileInfo>& removed, const transparent_set<QFileInfo>& changed) {
+		for (const auto& item : added)
+			changes.added.push_back(item.fileName());
+		for (const auto& item : removed)
+			changes.removed.push_back(item.fileName());
+		for (const auto& item : changed)
+			changes.changed.push_back(item.fileName());
+	});
+
+	REQUIRE(watcher.setPathToWatch(folder));
+	watcher.checkForChanges();
+	REQUIRE(changes.added.size() == NumFiles);
+	changes.clear();
+}
+
+#ifndef _WIN32
+static uint64_t deviceId(const QString& path)
+{
+	struct stat st;
+	REQUIRE(::stat(QFile::encodeName(path).constData(), &st) == 0);
+	return static_cast<uint64_t>(st.st_dev);
+}
+
+// The estimate is smoothed, so enough samples bring it to (nearly) any value
+static void setMountLatency(const QString& path, double latencyMs)
+{
+	for (int i = 0; i < 100; ++i)
+		FileSystemHelpers::updateMountLatencyEstimate(deviceId(path), latencyMs);
+}
+#endif
+
+TEST_CASE("An in-place change is detected on the next tick while the folder stamp is settling", "[filesystemwatcher]")
+{
+	QTemporaryDir folder;
+	REQUIRE(folder.isValid());
+	createFiles(folder.path());
+
+	CFileSystemWatcher watcher;
+	Changes changes;
+	watch(watcher, folder.path(), changes);
+
+	// The folder keeps being listed until its stamp has been the same for StampSettlingTime
+	appendToFile(folder.filePath(fileName(NumFiles - 1)), "1");
+	watcher.checkForChanges();
+
+	CHECK(changes.added.empty());
+	CHECK(changes.removed.empty());
+	CHECK(changes.changed == QStringList{fileName(NumFiles - 1)});
+}
+
+TEST_CASE("An in-place change is found by the sampled detail checks once the folder stamp has settled", "[filesystemwatcher]")
+{
+	QTemporaryDir folder;
+	REQUIRE(folder.isValid());
+	createFiles(folder.path());
+
+#ifndef _WIN32
+	setMountLatency(folder.path(), 0.0);
+#endif
+
+	CFileSystemWatcher watcher;
+	Changes changes;
+	watch(watcher, folder.path(), changes);
+	REQUIRE(watcher.detailChecksPerTick() == DetailChecksPerTick);
+
+	std::this_thread::sleep_for(StampSettlingTime + std::chrono::milliseconds(100));
+
+	// Writing to a file doesn't change the stamp of its folder, so the folder is not listed again.
+	// The change is only noticed once the round-robin detail checks, which start from the first item, get to this file.
+	const int changedFileIndex = NumFiles - 1;
+	appendToFile(folder.filePath(fileName(changedFileIndex)), "1");
+
+	const int expectedTick = changedFileIndex / static_cast<int>(DetailChecksPerTick) + 1;
+	int tick = 0;
+	while (changes.changed.empty() && tick < expectedTick + 1)
+	{
+		++tick;
+		watcher.checkForChanges();
+	}
+
+	CHECK(tick == expectedTick);
+	CHECK(changes.added.empty());
+	CHECK(changes.removed.empty());
+	CHECK(changes.changed == QStringList{fileName(changedFileIndex)});
+
+	// Nothing else has changed, a full round of detail checks stays silent
+	changes.clear();
+	for (int i = 0; i < NumFiles / static_cast<int>(DetailChecksPerTick) + 1; ++i)
+		watcher.checkForChanges();
+
+	CHECK(changes.changed.empty());
+}
+
+TEST_CASE("Adding and removing items changes the folder stamp and is detected on the next tick", "[filesystemwatcher]")
+{
+	QTemporaryDir folder;
+	REQUIRE(folder.isValid());
+	createFiles(folder.path());
+
+	CFileSystemWatcher watcher;
+	Changes changes;
+	watch(watcher, folder.path(), changes);
+
+	std::this_thread::sleep_for(StampSettlingTime + std::chrono::milliseconds(100));
+	watcher.checkForChanges();
+	CHECK(changes.changed.empty());
+
+	appendToFile(folder.filePath("new_file"), "1");
+	watcher.checkForChanges();
+	CHECK(changes.added == QStringList{"new_file"});
+	CHECK(changes.removed.empty());
+
+	changes.clear();
+	REQUIRE(QFile::remove(folder.filePath(fileName(0))));
+	watcher.checkForChanges();
+	CHECK(changes.added.empty());
+	CHECK(changes.removed == QStringList{fileName(0)});
+}
+
+TEST_CASE("The polling follows the activity state", "[filesystemwatcher]")
+{
+	QTemporaryDir folder;
+	REQUIRE(folder.isValid());
+	createFiles(folder.path());
+
+#ifndef _WIN32
+	setMountLatency(folder.path(), 0.0);
+#endif
+
+	CFileSystemWatcher watcher;
+	Changes changes;
+	watch(watcher, folder.path(), changes);
+	CHECK(watcher.pollingPeriodMs() == ForegroundPollingPeriodMs);
+
+	watcher.setActivityState(ActivityState::Background);
+	CHECK(watcher.pollingPeriodMs() == BackgroundPollingPeriodMs);
+	watcher.checkForChanges();
+	CHECK(watcher.pollingPeriodMs() == BackgroundPollingPeriodMs);
+
+	watcher.setActivityState(ActivityState::Suspended);
+	CHECK(watcher.pollingPeriodMs() == 0);
+
+	// Back in the foreground, the changes made while suspended are picked up right away, without waiting for the timer
+	appendToFile(folder.filePath("new_file"), "1");
+	CHECK(changes.added.empty());
+
+	watcher.setActivityState(ActivityState::Foreground);
+	CHECK(watcher.pollingPeriodMs() == ForegroundPollingPeriodMs);
+	CHECK(changes.added == QStringList{"new_file"});
+}
+
+#ifndef _WIN32
+TEST_CASE("The polling period adapts to the mount latency within [base, 10 s]", "[filesystemwatcher]")
+{
+	QTemporaryDir folder;
+	REQUIRE(folder.isValid());
+	createFiles(folder.path());
+
+	setMountLatency(folder.path(), 0.0);
+
+	CFileSystemWatcher watcher;
+	Changes changes;
+	watch(watcher, folder.path(), changes);
+
+	// A fast mount is polled at the base period, never faster
+	CHECK(watcher.pollingPeriodMs() == ForegroundPollingPeriodMs);
+	CHECK(watcher.detailChecksPerTick() == DetailChecksPerTick);
+
+	// 20 ms * 200 = 4 s
+	setMountLatency(folder.path(), 20.0);
+	watcher.checkForChanges();
+	CHECK(watcher.pollingPeriodMs() > ForegroundPollingPeriodMs);
+	CHECK(watcher.pollingPeriodMs() < MaxPollingPeriodMs);
+	CHECK(watcher.detailChecksPerTick() == DetailChecksPerTickOnHighLatencyMount);
+
+	// Clamped from above, no matter how slow the mount is
+	setMountLatency(folder.path(), 1000.0);
+	watcher.checkForChanges();
+	CHECK(watcher.pollingPeriodMs() == MaxPollingPeriodMs);
+
+	watcher.setActivityState(ActivityState::Background);
+	watcher.checkForChanges();
+	CHECK(watcher.pollingPeriodMs() == MaxPollingPeriodMs);
+
+	// And from below once the mount is fast again
+	setMountLatency(folder.path(), 0.0);
+	watcher.checkForChanges();
+	CHECK(watcher.pollingPeriodMs() == BackgroundPollingPeriodMs);
+
+	watcher.setActivityState(ActivityState::Foreground);
+	watcher.checkForChanges();
+	CHECK(watcher.pollingPeriodMs() == ForegroundPollingPeriodMs);
+	CHECK(watcher.detailChecksPerTick() == DetailChecksPerTick);
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+	// The polling timer needs an event dispatcher. The event loop is never run, so the ticks only happen when a test calls checkForChanges().
+	QCoreApplication app(argc, argv);
+
+	return Catch::Session().run(argc, argv);
+}
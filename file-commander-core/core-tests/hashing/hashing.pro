@@ -0,0 +1,25 @@
+TEMPLATE = app
+CONFIG += console
+TARGET = hashing_test
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+
+INCLUDEPATH += \
+	../../src/
+
+SOURCES += \
+	hashing_test.cpp \
+	../../src/hashing/cblake3hasher.cpp \
+	../../src/hashing/cxxhash64.cpp
+
+HEADERS += \
+	../../src/hashing/cblake3hasher.h \
+	../../src/hashing/cxxhash64.h
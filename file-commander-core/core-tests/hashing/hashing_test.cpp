@@ -0,0 +1,121 @@
+#include "hashing/cblake3hasher.h"
+#include "hashing/cxxhash64.h"
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Reference values computed with the official BLAKE3 and xxHash implementations for the input bytes i % 251
+static const struct {
+	size_t length;
+	const char* blake3;
+	uint64_t xxh64;
+} referenceValues[] = {
+	{0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262", 0xef46db3751d8e999ULL},
+	{1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213", 0xe934a84adb052768ULL},
+	{63, "e9bc37a594daad83be9470df7f7b3798297c3d834ce80ba85d6e207627b7db7b", 0xe26aa9e2a95f8e4fULL},
+	{64, "4eed7141ea4a5cd4b788606bd23f46e212af9cacebacdc7d1f4c6dc7f2511b98", 0xf7c67301db6713f0ULL},
+	{65, "de1e5fa0be70df6d2be8fffd0e99ceaa8eb6e8c93a63f2d8d1c30ecb6b263dee", 0xc31eb63b2ae4465bULL},
+	{1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11", 0xd66738f081c25cf4ULL},
+	{1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7", 0x138e26c65048ce29ULL},
+	{1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444", 0xcfd73aedd2d6a39dULL},
+	{2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a", 0xa69e05a7eff57800ULL},
+	{2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030", 0x27858160679416baULL},
+	{3072, "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2", 0x278f56bcf5b542feULL},
+	{3073, "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3", 0x9805379a726bf789ULL},
+	{8192, "aae792484c8efe4f19e2ca7d371d8c467ffb10748d8a5a1ae579948f718a2a63", 0x1a098375c6e66fd4ULL},
+	{8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b", 0x755e4befd10cccf4ULL},
+	{31744, "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47", 0x5fd04299cacedf8aULL},
+	{102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085", 0xeb1adcdd9e1369a6ULL},
+};
+
+static std::vector<uint8_t> testInput(size_t length)
+{
+	std::vector<uint8_t> data(length);
+	for (size_t i = 0; i < length; ++i)
+		data[i] = static_cast<uint8_t>(i % 251);
+	return data;
+}
+
+static std::string toHex(const CBlake3Hasher::Digest& digest)
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string result;
+	for (const uint8_t byte: digest)
+	{
+		result += digits[byte >> 4];
+		result += digits[byte & 0x0F];
+	}
+	return result;
+}
+
+TEST_CASE("BLAKE3 reference values", "[hashing]")
+{
+	for (const auto& reference: referenceValues)
+	{
+		const auto data = testInput(reference.length);
+
+		CBlake3Hasher oneShot;
+		oneShot.update(data.data(), data.size());
+		CHECK(toHex(oneShot.finalize()) == reference.blake3);
+
+		// Feeding the data in uneven pieces must not change the result
+		CBlake3Hasher incremental;
+		for (size_t pos = 0, step = 1; pos < data.size(); step = step * 3 + 7)
+		{
+			const size_t take = std::min(step, data.size() - pos);
+			incremental.update(data.data() + pos, take);
+			pos += take;
+		}
+		CHECK(toHex(incremental.finalize()) == reference.blake3);
+		CHECK(incremental.length() == reference.length);
+	}
+}
+
+TEST_CASE("BLAKE3 subtree hashing matches sequential hashing", "[hashing]")
+{
+	for (const uint64_t chunksPerSubtree: {1ULL, 2ULL, 4ULL, 16ULL})
+	{
+		const size_t subtreeLength = static_cast<size_t>(chunksPerSubtree) * CBlake3Hasher::ChunkLength;
+		for (const size_t length: {subtreeLength, subtreeLength + 1, 5 * subtreeLength, 7 * subtreeLength + 123, size_t{102400}})
+		{
+			const auto data = testInput(length);
+
+			CBlake3Hasher sequential;
+			sequential.update(data.data(), data.size());
+
+			// The last subtree must always go through update()
+			const size_t numSubtrees = (length - 1) / subtreeLength;
+			CBlake3Hasher subtrees;
+			for (size_t i = 0; i < numSubtrees; ++i)
+				subtrees.pushSubtree(CBlake3Hasher::subtreeChainingValue(data.data() + i * subtreeLength, subtreeLength, i * chunksPerSubtree), chunksPerSubtree);
+			subtrees.update(data.data() + numSubtrees * subtreeLength, length - numSubtrees * subtreeLength);
+
+			CHECK(subtrees.finalize() == sequential.finalize());
+		}
+	}
+}
+
+TEST_CASE("XXH64 reference values", "[hashing]")
+{
+	for (const auto& reference: referenceValues)
+	{
+		const auto data = testInput(reference.length);
+		CHECK(CXxHash64::hash(data.data(), data.size()) == reference.xxh64);
+
+		CXxHash64 incremental;
+		for (size_t pos = 0, step = 1; pos < data.size(); step = step * 2 + 1)
+		{
+			const size_t take = std::min(step, data.size() - pos);
+			incremental.update(data.data() + pos, take);
+			pos += take;
+		}
+		CHECK(incremental.digest() == reference.xxh64);
+	}
+
+	const auto data = testInput(100);
+	CHECK(CXxHash64::hash(data.data(), data.size(), 0x9E3779B97F4A7C15ULL) == 0x3b97d91eba03e785ULL);
+}
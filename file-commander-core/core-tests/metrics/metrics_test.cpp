@@ -0,0 +1,158 @@
+#include "metrics/cmetricsregistry.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QJsonArray>
+RESTORE_COMPILER_WARNINGS
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Histogram buckets", "[metrics]")
+{
+	// Exact below 16
+	for (uint64_t value = 0; value < CLatencyHistogram::NumSubBuckets; ++value)
+	{
+		CHECK(CLatencyHistogram::bucketIndex(value) == value);
+		CHECK(CLatencyHistogram::bucketUpperBound(value) == value);
+	}
+
+	// Every value is within its bucket, and the bucket is no wider than 1/16 of the value
+	for (uint64_t value = 1; value < (uint64_t{1} << 40); value = value * 3 / 2 + 1)
+	{
+		const size_t index = CLatencyHistogram::bucketIndex(value);
+		REQUIRE(index < CLatencyHistogram::NumBuckets);
+		const uint64_t upperBound = CLatencyHistogram::bucketUpperBound(index);
+		CHECK(upperBound >= value);
+		CHECK(upperBound - value <= value / CLatencyHistogram::NumSubBuckets);
+		if (index > 0)
+			CHECK(CLatencyHistogram::bucketUpperBound(index - 1) < value);
+	}
+
+	// Values beyond the range land in the last bucket
+	CHECK(CLatencyHistogram::bucketIndex(~uint64_t{0}) == CLatencyHistogram::NumBuckets - 1);
+}
+
+TEST_CASE("Histogram percentiles", "[metrics]")
+{
+	CLatencyHistogram histogram;
+	CHECK(histogram.snapshot().count == 0);
+	CHECK(histogram.snapshot().percentile(50) == 0);
+
+	for (uint64_t value = 1; value <= 1000; ++value)
+		histogram.record(value);
+
+	const auto snapshot = histogram.snapshot();
+	CHECK(snapshot.count == 1000);
+	CHECK(snapshot.sum == 500500);
+	CHECK(snapshot.max == 1000);
+	CHECK(snapshot.mean() == Approx(500.5));
+
+	const auto within = [](uint64_t actual, uint64_t expected) {
+		return actual >= expected && actual - expected <= expected / CLatencyHistogram::NumSubBuckets;
+	};
+	CHECK(within(snapshot.percentile(50), 500));
+	CHECK(within(snapshot.percentile(90), 900));
+	CHECK(within(snapshot.percentile(99), 990));
+	CHECK(snapshot.percentile(100) == 1000);
+	CHECK(snapshot.percentile(0) == 1);
+
+	SECTION("since")
+	{
+		for (int i = 0; i < 100; ++i)
+			histogram.record(5000);
+
+		const auto recent = histogram.snapshot().since(snapshot);
+		CHECK(recent.count == 100);
+		CHECK(recent.sum == 500000);
+		CHECK(within(recent.percentile(50), 5000));
+		CHECK(within(recent.percentile(0), 5000));
+	}
+}
+
+TEST_CASE("Concurrent recording", "[metrics]")
+{
+	CLatencyHistogram histogram;
+	CMetricCounter counter;
+
+	std::vector<std::thread> threads;
+	for (uint64_t t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&histogram, &counter, t] {
+			for (uint64_t i = 0; i < 10000; ++i)
+			{
+				histogram.record(t * 100 + i % 100);
+				counter.add(2);
+			}
+		});
+	}
+
+	for (auto& thread: threads)
+		thread.join();
+
+	const auto snapshot = histogram.snapshot();
+	CHECK(snapshot.count == 40000);
+	CHECK(snapshot.max == 399);
+	CHECK(counter.value() == 80000);
+}
+
+TEST_CASE("Scoped latency excludes the paused time", "[metrics]")
+{
+	CLatencyHistogram histogram;
+	{
+		CScopedLatency latency(histogram);
+		latency.pause();
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		latency.resume();
+	}
+
+	const auto snapshot = histogram.snapshot();
+	CHECK(snapshot.count == 1);
+	CHECK(snapshot.max < 100000);
+}
+
+TEST_CASE("Registry and JSON", "[metrics]")
+{
+	auto& registry = CMetricsRegistry::instance();
+
+	// The same name is the same metric
+	CHECK(&registry.counter("test.counter") == &registry.counter("test.counter"));
+	CHECK(&registry.gauge("test.gauge") == &registry.gauge("test.gauge"));
+	CHECK(&registry.histogram("test.histogram") == &registry.histogram("test.histogram"));
+
+	const QString deviceCounter = CMetricsRegistry::withDevice("test.bytes", "/mnt/data");
+	CHECK(deviceCounter == QStringLiteral("test.bytes{/mnt/data}"));
+
+	registry.counter(deviceCounter).add(4096);
+	registry.gauge("test.gauge").add(3);
+	registry.gauge("test.gauge").add(-1);
+	{
+		CScopedLatency latency(registry.histogram("test.histogram"));
+	}
+	{
+		CScopedLatency latency(registry.histogram("test.histogram"));
+		latency.cancel();
+	}
+
+	const auto snapshot = registry.snapshot();
+	CHECK(snapshot.counters.at(deviceCounter) == 4096);
+	CHECK(snapshot.gauges.at("test.gauge") == 2);
+	CHECK(snapshot.histograms.at("test.histogram").count == 1);
+
+	const QJsonObject json = CMetricsRegistry::toJson(snapshot, 1234);
+	CHECK(json["timestamp_ms"].toInt() == 1234);
+	CHECK(json["counters"].toObject()[deviceCounter].toInt() == 4096);
+	CHECK(json["gauges"].toObject()["test.gauge"].toInt() == 2);
+
+	const QJsonObject histogram = json["histograms"].toObject()["test.histogram"].toObject();
+	CHECK(histogram["count"].toInt() == 1);
+	const QJsonArray buckets = histogram["buckets"].toArray();
+	REQUIRE(buckets.size() == 1);
+	CHECK(buckets[0].toArray()[1].toInt() == 1);
+
+	CHECK(!CMetricsRegistry::deviceForPath(QDir::currentPath() + "/does/not/exist").isEmpty());
+}
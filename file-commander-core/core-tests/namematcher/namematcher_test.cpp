@@ -0,0 +1,87 @@
+#include "filesearchengine/cnamematcher.h"
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+static bool nameMatches(const QString& query, const QString& name, Qt::CaseSensitivity cs = Qt::CaseInsensitive)
+{
+	return CNameMatcher(query, cs).matches(name, "/home/user/" + name);
+}
+
+TEST_CASE("Plain text matches as a substring", "[namematcher]")
+{
+	CHECK(nameMatches("report", "annual_report_2020.pdf"));
+	CHECK(nameMatches("REPORT", "annual_report_2020.pdf"));
+	CHECK(!nameMatches("REPORT", "annual_report_2020.pdf", Qt::CaseSensitive));
+	CHECK(!nameMatches("reports", "annual_report_2020.pdf"));
+	CHECK(nameMatches("a", "a"));
+	CHECK(!nameMatches("ab", "a"));
+
+	// Long names go through the vectorized scan, the match can be anywhere including the tail
+	const QString longName = QString(100, 'x') + "needle" + QString(37, 'y');
+	CHECK(nameMatches("needle", longName));
+	CHECK(nameMatches("NeEdLe", longName));
+	CHECK(nameMatches("xneedley", longName));
+	CHECK(nameMatches("yyy", longName));
+	CHECK(!nameMatches("needlf", longName));
+	CHECK(!nameMatches("needle", QString(100, 'x') + "needl" + QString(37, 'y')));
+
+	// The case-insensitive search isn't limited to ASCII
+	CHECK(nameMatches(QString::fromUtf8("привет"), QString(20, '_') + QString::fromUtf8("ПРИВЕТ.txt")));
+	CHECK(nameMatches("kelvin", QString(20, '_') + QChar(0x212A) + "elvin"));
+}
+
+TEST_CASE("Wildcard patterns match the whole name", "[namematcher]")
+{
+	CHECK(nameMatches("*.txt", "notes.txt"));
+	CHECK(nameMatches("*.TXT", "notes.txt"));
+	CHECK(!nameMatches("*.txt", "notes.txt.bak"));
+	CHECK(nameMatches("notes*", "notes.txt"));
+	CHECK(!nameMatches("notes*", "my notes.txt"));
+	CHECK(nameMatches("n*.txt", "notes.txt"));
+	CHECK(!nameMatches("notes*s.txt", "notes.txt"));
+	CHECK(nameMatches("*te*", "notes.txt"));
+	CHECK(nameMatches("*", "anything"));
+	CHECK(nameMatches("**", "anything"));
+
+	CHECK(nameMatches("n?tes.txt", "notes.txt"));
+	CHECK(!nameMatches("n?tes.txt", "ntes.txt"));
+	CHECK(nameMatches("*.[ch]", "main.c"));
+	CHECK(nameMatches("*.[ch]", "main.h"));
+	CHECK(!nameMatches("*.[ch]", "main.cpp"));
+	CHECK(nameMatches("file[0-9].log", "file7.log"));
+	CHECK(!nameMatches("file[0-9].log", "fileA.log"));
+	CHECK(nameMatches("file[!0-9].log", "fileA.log"));
+	CHECK(nameMatches("*a*b*c*", "xxaxxbxxcxx"));
+	CHECK(!nameMatches("*a*b*c*", "xxaxxcxxbxx"));
+	CHECK(nameMatches("[abc", "[abc"));
+}
+
+TEST_CASE("Multiple and negated patterns", "[namematcher]")
+{
+	CHECK(nameMatches("*.cpp; *.h", "main.cpp"));
+	CHECK(nameMatches("*.cpp; *.h", "main.h"));
+	CHECK(!nameMatches("*.cpp; *.h", "main.c"));
+
+	CHECK(nameMatches("*.cpp;!test*", "main.cpp"));
+	CHECK(!nameMatches("*.cpp;!test*", "test_main.cpp"));
+	CHECK(!nameMatches("!*.o", "main.o"));
+	CHECK(nameMatches("!*.o", "main.cpp"));
+
+	CHECK(!CNameMatcher(";;", Qt::CaseInsensitive).isValid());
+	CHECK(CNameMatcher("a;", Qt::CaseInsensitive).isValid());
+}
+
+TEST_CASE("Patterns with a slash match the full path", "[namematcher]")
+{
+	const CNameMatcher matcher("*/build/*;!*/.git/*", Qt::CaseSensitive);
+	CHECK(matcher.matches(QStringLiteral("main.o"), QStringLiteral("/src/build/main.o")));
+	CHECK(!matcher.matches(QStringLiteral("main.o"), QStringLiteral("/src/main.o")));
+	CHECK(!matcher.matches(QStringLiteral("HEAD"), QStringLiteral("/src/build/.git/HEAD")));
+
+	// The trailing slash of a folder path is ignored
+	CHECK(CNameMatcher("*/build", Qt::CaseSensitive).matches(QStringLiteral("build"), QStringLiteral("/src/build/")));
+
+	// The name patterns don't look at the path
+	CHECK(!CNameMatcher("src", Qt::CaseSensitive).matches(QStringLiteral("main.cpp"), QStringLiteral("/src/main.cpp")));
+}
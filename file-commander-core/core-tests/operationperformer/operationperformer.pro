@@ -25,22 +25,45 @@ for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
 SOURCES += \
 	operationperformertest.cpp \
 	../../src/fileoperations/coperationperformer.cpp \
+	../../src/fileoperations/cattributechanger.cpp \
+	../../src/fileoperations/ccacheneutralcopier.cpp \
+	../../src/fileoperations/cdeltacopier.cpp \
+	../../src/hashing/cblake3hasher.cpp \
+	../../src/fileoperations/chardlinktracker.cpp \
+	../../src/fileoperations/cratelimiter.cpp \
+	../../src/fileoperations/csyncplanner.cpp \
+	../../src/fileoperations/iopriority.cpp \
 	../../src/cfilesystemobject.cpp \
 	../../src/iconprovider/ciconprovider.cpp \
 	../../src/iconprovider/ciconproviderimpl.cpp \
 	../../src/fasthash.c \
 	../../src/directoryscanner.cpp \
+	../../src/pruningrules/cpruningrules.cpp \
 	../../src/cfilemanipulator.cpp \
+	../../src/tracing/ctracer.cpp \
+	../../src/metrics/cmetricsregistry.cpp \
     ../../src/filecomparator/cfilecomparator.cpp
 
 HEADERS += \
 	../../src/fileoperations/cfileoperation.h \
+	../../src/fileoperations/cboundedqueue.hpp \
+	../../src/fileoperations/cattributechanger.h \
+	../../src/fileoperations/ccacheneutralcopier.h \
+	../../src/fileoperations/cdeltacopier.h \
+	../../src/hashing/cblake3hasher.h \
+	../../src/fileoperations/chardlinktracker.h \
 	../../src/fileoperations/coperationperformer.h \
+	../../src/fileoperations/cratelimiter.h \
+	../../src/fileoperations/csyncplanner.h \
+	../../src/fileoperations/iopriority.h \
 	../../src/fileoperations/operationcodes.h \
 	../../src/cfilesystemobject.h \
 	../../src/iconprovider/ciconprovider.h \
 	../../src/iconprovider/ciconproviderimpl.h \
 	../../src/fasthash.h \
 	../../src/directoryscanner.h \
+	../../src/pruningrules/cpruningrules.h \
 	../../src/cfilemanipulator.h \
+	../../src/tracing/ctracer.h \
+	../../src/metrics/cmetricsregistry.h \
     ../../src/filecomparator/cfilecomparator.h
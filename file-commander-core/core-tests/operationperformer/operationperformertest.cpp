@@ -22,6 +22,11 @@ RESTORE_COMPILER_WARNINGS
 #include <iostream>
 #include <string>
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define CATCH_CONFIG_RUNNER
 #include "../catch2/catch.hpp"
 
@@ -238,6 +243,346 @@ TEST_CASE((std::string("Delete test #") + std::to_string((srand(time(nullptr)),
 	REQUIRE(!CFileSystemObject(sourceDirectory.path()).exists());
 }
 
+#ifndef _WIN32
+
+static void runOperation(COperationPerformer& performer)
+{
+	ProgressObserver progressObserver;
+	performer.setObserver(&progressObserver);
+
+	CTimeElapsed timer(true);
+	performer.start();
+	while (!performer.done())
+	{
+		progressObserver.processEvents();
+		REQUIRE(timer.elapsed<std::chrono::seconds>() < 60);
+	}
+
+	progressObserver.processEvents();
+}
+
+static void createFile(const QString& path, int size)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::WriteOnly));
+	REQUIRE(file.write(QByteArray(size, 'x')) == size);
+}
+
+static struct stat linkStat(const QString& path)
+{
+	struct stat info;
+	REQUIRE(::lstat(QFile::encodeName(path).constData(), &info) == 0);
+	return info;
+}
+
+static QByteArray linkTarget(const QString& path)
+{
+	char target[4096];
+	const ssize_t length = ::readlink(QFile::encodeName(path).constData(), target, sizeof(target));
+	REQUIRE(length > 0);
+	return QByteArray(target, static_cast<int>(length));
+}
+
+static void createHardLink(const QString& existingPath, const QString& newPath)
+{
+	REQUIRE(::link(QFile::encodeName(existingPath).constData(), QFile::encodeName(newPath).constData()) == 0);
+}
+
+static void createSymLink(const char* target, const QString& linkPath)
+{
+	REQUIRE(::symlink(target, QFile::encodeName(linkPath).constData()) == 0);
+}
+
+TEST_CASE("Copying preserves hard links and symbolic links", "[operationperformer-links]")
+{
+	QTemporaryDir sourceDirectory(QDir::tempPath() + "/links_SOURCE_XXXXXX");
+	QTemporaryDir targetDirectory(QDir::tempPath() + "/links_TARGET_XXXXXX");
+	REQUIRE(sourceDirectory.isValid());
+	REQUIRE(targetDirectory.isValid());
+
+	const QString source = sourceDirectory.path() + "/tree";
+	REQUIRE(QDir().mkpath(source + "/subdir"));
+
+	static constexpr int fileSize = 300 * 1024;
+	createFile(source + "/a", fileSize);
+	createHardLink(source + "/a", source + "/b");
+	createHardLink(source + "/a", source + "/subdir/c");
+	createSymLink("a", source + "/relative_link");
+	createSymLink("subdir", source + "/folder_link");
+	createSymLink("nowhere", source + "/dangling_link");
+	createSymLink("..", source + "/subdir/loop");
+
+	COperationPerformer p(operationCopy, CFileSystemObject(source), targetDirectory.path());
+	p.setPreserveLinks(true);
+	runOperation(p);
+
+	const QString dest = targetDirectory.path() + "/tree";
+	const struct stat a = linkStat(dest + "/a");
+	CHECK(a.st_nlink == 3);
+	CHECK(linkStat(dest + "/b").st_ino == a.st_ino);
+	CHECK(linkStat(dest + "/subdir/c").st_ino == a.st_ino);
+	CHECK(a.st_ino != linkStat(source + "/a").st_ino);
+	CHECK(QFileInfo(dest + "/a").size() == fileSize);
+
+	CHECK(S_ISLNK(linkStat(dest + "/relative_link").st_mode));
+	CHECK(linkTarget(dest + "/relative_link") == "a");
+	CHECK(S_ISLNK(linkStat(dest + "/folder_link").st_mode));
+	CHECK(linkTarget(dest + "/folder_link") == "subdir");
+	CHECK(S_ISLNK(linkStat(dest + "/dangling_link").st_mode));
+	CHECK(linkTarget(dest + "/dangling_link") == "nowhere");
+	CHECK(S_ISLNK(linkStat(dest + "/subdir/loop").st_mode));
+
+	const auto statistics = p.linkStatistics();
+	CHECK(statistics.hardLinksRecreated == 2);
+	CHECK(statistics.symLinksRecreated == 4);
+	CHECK(statistics.bytesSaved == 2 * fileSize);
+}
+
+TEST_CASE("Copying with links followed skips link loops", "[operationperformer-links]")
+{
+	QTemporaryDir sourceDirectory(QDir::tempPath() + "/links_SOURCE_XXXXXX");
+	QTemporaryDir targetDirectory(QDir::tempPath() + "/links_TARGET_XXXXXX");
+	REQUIRE(sourceDirectory.isValid());
+	REQUIRE(targetDirectory.isValid());
+
+	const QString source = sourceDirectory.path() + "/tree";
+	REQUIRE(QDir().mkpath(source + "/subdir"));
+	createFile(source + "/subdir/file", 1000);
+	createSymLink("file", source + "/subdir/file_link");
+	createSymLink("..", source + "/subdir/loop");
+
+	COperationPerformer p(operationCopy, CFileSystemObject(source), targetDirectory.path());
+	p.setPreserveLinks(false);
+	runOperation(p);
+
+	const QString dest = targetDirectory.path() + "/tree";
+	CHECK(QFileInfo(dest + "/subdir/file").size() == 1000);
+	// Dereferenced: a regular file with the target's contents
+	CHECK(S_ISREG(linkStat(dest + "/subdir/file_link").st_mode));
+	CHECK(QFileInfo(dest + "/subdir/file_link").size() == 1000);
+	CHECK_FALSE(QFileInfo::exists(dest + "/subdir/loop"));
+}
+
+TEST_CASE("Deleting a folder doesn't touch what the links in it point to", "[operationperformer-links]")
+{
+	QTemporaryDir sourceDirectory(QDir::tempPath() + "/links_SOURCE_XXXXXX");
+	QTemporaryDir outsideDirectory(QDir::tempPath() + "/links_OUTSIDE_XXXXXX");
+	REQUIRE(sourceDirectory.isValid());
+	REQUIRE(outsideDirectory.isValid());
+
+	createFile(outsideDirectory.path() + "/file", 1000);
+	createFile(sourceDirectory.path() + "/file", 1000);
+	createSymLink(QFile::encodeName(outsideDirectory.path()).constData(), sourceDirectory.path() + "/folder_link");
+	createSymLink(QFile::encodeName(outsideDirectory.path() + "/file").constData(), sourceDirectory.path() + "/file_link");
+
+	COperationPerformer p(operationDelete, CFileSystemObject(sourceDirectory.path()));
+	runOperation(p);
+
+	CHECK_FALSE(QFileInfo::exists(sourceDirectory.path()));
+	CHECK(QFileInfo(outsideDirectory.path() + "/file").size() == 1000);
+}
+
+static QByteArray readFile(const QString& path)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::ReadOnly));
+	return file.readAll();
+}
+
+static void setModificationTime(const QString& path, const QDateTime& time)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::ReadWrite));
+	REQUIRE(file.setFileTime(time, QFileDevice::FileModificationTime));
+}
+
+TEST_CASE("Synchronization only copies what has changed", "[operationperformer-sync]")
+{
+	QTemporaryDir sourceDirectory(QDir::tempPath() + "/sync_SOURCE_XXXXXX");
+	QTemporaryDir targetDirectory(QDir::tempPath() + "/sync_TARGET_XXXXXX");
+	REQUIRE(sourceDirectory.isValid());
+	REQUIRE(targetDirectory.isValid());
+
+	const QString source = sourceDirectory.path() + "/tree";
+	const QString dest = targetDirectory.path() + "/tree";
+	REQUIRE(QDir().mkpath(source + "/subdir/nested"));
+	createFile(source + "/a", 1000);
+	createFile(source + "/subdir/b", 2000);
+	createFile(source + "/subdir/nested/c", 3000);
+
+	const auto synchronize = [&](bool deleteExtraneous, bool dryRun, bool compareContents = false) {
+		SyncOptions options;
+		options.deleteExtraneous = deleteExtraneous;
+		options.dryRun = dryRun;
+		options.compareContents = compareContents;
+
+		COperationPerformer p(operationSync, CFileSystemObject(source), targetDirectory.path());
+		p.setSyncOptions(options);
+		runOperation(p);
+		return p.syncReport();
+	};
+
+	// The dry run reports everything but doesn't touch the destination
+	SyncReport report = synchronize(false, true);
+	CHECK(report.numFoldersCreated == 3);
+	CHECK(report.numFilesCopied == 3);
+	CHECK(report.bytesCopied == 6000);
+	CHECK(report.entries.size() == 6);
+	CHECK_FALSE(QFileInfo::exists(dest));
+
+	report = synchronize(false, false);
+	CHECK(report.numFoldersCreated == 3);
+	CHECK(report.numFilesCopied == 3);
+	CHECK(report.entries.empty());
+	CHECK(QFileInfo(dest + "/subdir/nested/c").size() == 3000);
+
+	// Nothing has changed since
+	report = synchronize(true, false);
+	CHECK_FALSE(report.hasChanges());
+	CHECK(report.numItemsUpToDate == 3);
+
+	// A changed file, a new file and a couple of extraneous items
+	createFile(source + "/a", 1000);
+	setModificationTime(source + "/a", QDateTime::currentDateTime().addSecs(3600));
+	createFile(source + "/subdir/d", 500);
+	createFile(dest + "/extra", 100);
+	REQUIRE(QDir().mkpath(dest + "/extra_folder/inner"));
+	createFile(dest + "/extra_folder/inner/file", 100);
+
+	report = synchronize(false, false);
+	CHECK(report.numFilesUpdated == 1);
+	CHECK(report.numFilesCopied == 1);
+	CHECK(report.numItemsDeleted == 0);
+	CHECK(report.numItemsUpToDate == 2);
+	CHECK(timesAlmostMatch(QFileInfo(dest + "/a").lastModified(), QFileInfo(source + "/a").lastModified(), QFileDevice::FileModificationTime));
+	CHECK(QFileInfo(dest + "/subdir/d").size() == 500);
+	CHECK(QFileInfo::exists(dest + "/extra"));
+
+	report = synchronize(true, true);
+	CHECK(report.numItemsDeleted == 2);
+	CHECK(QFileInfo::exists(dest + "/extra_folder/inner/file"));
+
+	report = synchronize(true, false);
+	CHECK(report.numItemsDeleted == 2);
+	CHECK_FALSE(QFileInfo::exists(dest + "/extra"));
+	CHECK_FALSE(QFileInfo::exists(dest + "/extra_folder"));
+
+	// Same size and modification time, different contents: only found by comparing the contents
+	const QDateTime modificationTime = QFileInfo(dest + "/subdir/b").lastModified();
+	{
+		QFile file(dest + "/subdir/b");
+		REQUIRE(file.open(QFile::WriteOnly));
+		REQUIRE(file.write(QByteArray(2000, 'y')) == 2000);
+	}
+	setModificationTime(dest + "/subdir/b", modificationTime);
+
+	CHECK_FALSE(synchronize(false, false).hasChanges());
+	CHECK(synchronize(false, false, true).numFilesUpdated == 1);
+	CHECK(readFile(dest + "/subdir/b") == readFile(source + "/subdir/b"));
+}
+
+static mode_t permissions(const QString& path)
+{
+	return linkStat(path).st_mode & 07777;
+}
+
+TEST_CASE("Changing attributes recursively", "[operationperformer-attributes]")
+{
+	QTemporaryDir directory(QDir::tempPath() + "/attributes_XXXXXX");
+	REQUIRE(directory.isValid());
+
+	const QString root = directory.path() + "/tree";
+	for (int i = 0; i < 20; ++i)
+	{
+		const QString folder = root % "/folder" % QString::number(i) % "/nested";
+		REQUIRE(QDir().mkpath(folder));
+		for (int j = 0; j < 10; ++j)
+		{
+			createFile(folder % "/file" % QString::number(j) % ".txt", 10);
+			createFile(folder % "/file" % QString::number(j) % ".bin", 10);
+		}
+	}
+	REQUIRE(QDir().mkpath(root + "/.git"));
+	createFile(root + "/.git/config", 10);
+	createFile(root + "/script", 10);
+	REQUIRE(::chmod(QFile::encodeName(root + "/script").constData(), 0700) == 0);
+	createSymLink("script", root + "/link");
+
+	const auto changeAttributes = [&root](const AttributeChange& change) {
+		COperationPerformer p(operationChangeAttributes, CFileSystemObject(root));
+		p.setAttributeChange(change);
+		runOperation(p);
+		return p.numItemsChanged();
+	};
+
+	for (const QString& path: {root + "/folder3/nested/file1.txt", root + "/folder3/nested/file1.bin", root + "/.git/config"})
+		REQUIRE(::chmod(QFile::encodeName(path).constData(), 0600) == 0);
+
+	AttributeChange change;
+	change.modeToSet = 0755;
+	change.modeToClear = 0022;
+	change.executeOnlyIfExecutable = true;
+	change.modificationTime = 1000000000;
+	change.includeMasks = QStringList{"*.txt", "script"};
+	change.excludeMasks = QStringList{".git"};
+	CHECK(changeAttributes(change) > 0);
+
+	CHECK(permissions(root + "/folder3/nested/file1.txt") == 0644);
+	CHECK(permissions(root + "/folder3/nested/file1.bin") == 0600);
+	CHECK(permissions(root + "/folder3/nested") == 0755);
+	CHECK(permissions(root + "/script") == 0755);
+	CHECK(permissions(root + "/.git/config") == 0600);
+	CHECK(linkStat(root + "/folder3/nested/file1.txt").st_mtime == 1000000000);
+	CHECK(linkStat(root + "/folder3/nested").st_mtime == 1000000000);
+	CHECK(linkStat(root + "/folder3/nested/file1.bin").st_mtime != 1000000000);
+	CHECK(S_ISLNK(linkStat(root + "/link").st_mode));
+
+	// Nothing left to change
+	CHECK(changeAttributes(change) == 0);
+
+	// The folders' permissions are only taken away after their contents have been changed
+	AttributeChange folderChange;
+	folderChange.modeToClear = 0777;
+	folderChange.applyToFiles = false;
+	changeAttributes(folderChange);
+	CHECK(permissions(root + "/folder3/nested") == 0);
+
+	folderChange.modeToSet = 0755;
+	folderChange.modeToClear = 0;
+	changeAttributes(folderChange);
+	CHECK(permissions(root + "/folder3/nested") == 0755);
+	CHECK(permissions(root + "/folder3/nested/file1.txt") == 0644);
+}
+
+TEST_CASE("An invalid attribute change root only skips itself", "[operationperformer-attributes]")
+{
+	QTemporaryDir directory(QDir::tempPath() + "/attributes_XXXXXX");
+	REQUIRE(directory.isValid());
+
+	const QString file = directory.path() + "/file";
+	createFile(file, 10);
+	REQUIRE(::chmod(QFile::encodeName(file).constData(), 0600) == 0);
+
+	AttributeChange change;
+	change.modeToSet = 0044;
+	CAttributeChanger changer(change);
+
+	std::vector<QString> failedPaths;
+	changer.setErrorHandler([&failedPaths](const QString& path, const QString& /*errorMessage*/) {
+		failedPaths.push_back(path);
+		return false;
+	});
+
+	const std::atomic<bool> abort {false};
+	changer.apply({"relative/path", file}, abort);
+
+	CHECK(failedPaths == std::vector<QString>{"relative/path"});
+	CHECK(permissions(file) == 0644);
+	CHECK(changer.numItemsChanged() == 1);
+}
+
+#endif
+
 int main(int argc, char* argv[])
 {
 	Catch::Session session; // There must be exactly one instance
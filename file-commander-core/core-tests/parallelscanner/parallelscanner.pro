@@ -0,0 +1,44 @@
+TEMPLATE = app
+CONFIG += console
+TARGET = parallelscanner_test
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libqtutils.a $${DESTDIR}/libcpputils.a $${DESTDIR}/libtest_utils.a
+}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+
+INCLUDEPATH += \
+	../../src/ \
+	../test-utils/src/
+
+LIBS += -L$${DESTDIR} -lcpputils -lqtutils -ltest_utils
+
+SOURCES += \
+	parallelscanner_test.cpp \
+	../../src/parallelscanner/cparalleldirectoryscanner.cpp \
+	../../src/pruningrules/cpruningrules.cpp \
+	../../src/directoryscanner.cpp \
+	../../src/statistics/coccupiedspacecalculator.cpp \
+	../../src/cfilesystemobject.cpp \
+	../../src/fasthash.c \
+	../../src/iconprovider/ciconprovider.cpp \
+	../../src/iconprovider/ciconproviderimpl.cpp
+
+HEADERS += \
+	../../src/parallelscanner/cparalleldirectoryscanner.h \
+	../../src/pruningrules/cpruningrules.h \
+	../../src/directoryscanner.h \
+	../../src/statistics/coccupiedspacecalculator.h \
+	../../src/cfilesystemobject.h \
+	../../src/fasthash.h \
+	../../src/iconprovider/ciconprovider.h \
+	../../src/iconprovider/ciconproviderimpl.h
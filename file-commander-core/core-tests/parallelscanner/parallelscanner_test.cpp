@@ -0,0 +1,291 @@
+#include "parallelscanner/cparalleldirectoryscanner.h"
+#include "statistics/coccupiedspacecalculator.h"
+#include "directoryscanner.h"
+
+// test_utils
+#include "cfolderenumeratorrecursive.h"
+#include "ctestfoldergenerator.h"
+#include "catch2_utils.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#define CATCH_CONFIG_RUNNER
+#include "../catch2/catch.hpp"
+
+static uint32_t g_randomSeed = 0;
+
+static QString withoutTrailingSlash(QString path)
+{
+	if (path.length() > 1 && path.endsWith('/'))
+		path.chop(1);
+	return path;
+}
+
+static void writeFile(const QString& path, int size)
+{
+	QFile file(path);
+	REQUIRE(file.open(QFile::WriteOnly));
+	REQUIRE(file.write(QByteArray(size, 'x')) == size);
+}
+
+TEST_CASE("CParallelDirectoryScanner finds every item", "[parallelscanner]")
+{
+	QTemporaryDir root(QDir::tempPath() + "/" + CURRENT_TEST_NAME.c_str() + "_XXXXXX");
+	REQUIRE(root.isValid());
+
+	CTestFolderGenerator generator;
+	generator.setSeed(g_randomSeed);
+	REQUIRE(generator.generateRandomTree(root.path(), 1000, 200));
+
+	std::vector<CFileSystemObject> expectedItems;
+	CFolderEnumeratorRecursive::enumerateFolder(root.path(), expectedItems);
+
+	std::mutex mutex;
+	std::map<QString, ScannedItemInfo> scannedItems;
+	std::atomic<bool> abort {false};
+	CParallelDirectoryScanner(8).scan({root.path()}, [&](const ScannedItemInfo& item) {
+		std::lock_guard<std::mutex> lock(mutex);
+		CHECK(scannedItems.emplace(withoutTrailingSlash(item.fullPath), item).second); // Every item must be reported exactly once
+	}, abort);
+
+	// The root itself is reported, too
+	REQUIRE(scannedItems.size() == expectedItems.size() + 1);
+	const auto rootIt = scannedItems.find(withoutTrailingSlash(QDir::cleanPath(root.path())));
+	REQUIRE(rootIt != scannedItems.end());
+	CHECK(rootIt->second.depth == 0);
+	CHECK(rootIt->second.isDir());
+
+	for (const CFileSystemObject& expected: expectedItems)
+	{
+		const auto it = scannedItems.find(withoutTrailingSlash(expected.fullAbsolutePath()));
+		REQUIRE(it != scannedItems.end());
+		CHECK(it->second.isDir() == expected.isDir());
+		CHECK(it->second.depth > 0);
+		if (expected.isFile())
+			CHECK(it->second.size == expected.size());
+	}
+}
+
+TEST_CASE("CParallelDirectoryScanner abort", "[parallelscanner]")
+{
+	QTemporaryDir root(QDir::tempPath() + "/" + CURRENT_TEST_NAME.c_str() + "_XXXXXX");
+	REQUIRE(root.isValid());
+
+	CTestFolderGenerator generator;
+	generator.setSeed(g_randomSeed);
+	REQUIRE(generator.generateRandomTree(root.path(), 100, 20));
+
+	size_t numItemsReported = 0;
+	std::atomic<bool> abort {true};
+	CParallelDirectoryScanner().scan({root.path()}, [&](const ScannedItemInfo&) {
+		++numItemsReported;
+	}, abort);
+
+	CHECK(numItemsReported == 1); // Only the root
+}
+
+TEST_CASE("CPruningRules patterns", "[pruningrules]")
+{
+	CPruningRules rules;
+	rules.setPatterns({"# comment", "", ".git/", "*.o", "/build", "docs/**/*.tmp", "!keep.o", "[Tt]emp?"});
+
+	// Unanchored patterns match the name at any level
+	CHECK(rules.excludes(u"", u".git", true, true, false));
+	CHECK(rules.excludes(u"src/module/", u".git", true, true, false));
+	CHECK(!rules.excludes(u"", u".git", false, true, false)); // Folders only
+	CHECK(rules.excludes(u"src/", u"main.o", false, false, false));
+	CHECK(!rules.excludes(u"src/", u"main.cpp", false, false, false));
+
+	// The last matching pattern wins
+	CHECK(!rules.excludes(u"src/", u"keep.o", false, false, false));
+
+	// Anchored patterns only match at the root
+	CHECK(rules.excludes(u"", u"build", true, false, false));
+	CHECK(!rules.excludes(u"src/", u"build", true, false, false));
+
+	// "**" spans any number of folders, including none
+	CHECK(rules.excludes(u"docs/", u"a.tmp", false, false, false));
+	CHECK(rules.excludes(u"docs/x/y/", u"a.tmp", false, false, false));
+	CHECK(!rules.excludes(u"src/docs/", u"a.tmp", false, false, false));
+
+	CHECK(rules.excludes(u"", u"Temp1", true, false, false));
+	CHECK(rules.excludes(u"", u"temp2", false, false, false));
+	CHECK(!rules.excludes(u"", u"temp", false, false, false));
+
+	CHECK(!rules.excludes(u"", u".hidden", false, true, false));
+	rules.setSkipHidden(true);
+	CHECK(rules.excludes(u"", u".hidden", false, true, false));
+
+	CHECK(rules.descendsInto(100, false));
+	rules.setMaxDepth(2);
+	rules.setSameFileSystemOnly(true);
+	CHECK(rules.descendsInto(1, true));
+	CHECK(!rules.descendsInto(2, true));
+	CHECK(!rules.descendsInto(1, false));
+
+	CHECK(CPruningRules().isEmpty());
+	CHECK(!rules.isEmpty());
+}
+
+TEST_CASE("CParallelDirectoryScanner pruning", "[parallelscanner]")
+{
+	QTemporaryDir root(QDir::tempPath() + "/" + CURRENT_TEST_NAME.c_str() + "_XXXXXX");
+	REQUIRE(root.isValid());
+
+	const QString rootPath = QDir::cleanPath(root.path());
+	REQUIRE(QDir(rootPath).mkpath("src/.git/objects"));
+	REQUIRE(QDir(rootPath).mkpath("src/lib/deep/deeper"));
+	REQUIRE(QDir(rootPath).mkpath("node_modules/package"));
+	writeFile(rootPath + "/src/main.cpp", 10);
+	writeFile(rootPath + "/src/.git/objects/1234", 10);
+	writeFile(rootPath + "/src/lib/deep/deeper/file.txt", 10);
+	writeFile(rootPath + "/node_modules/package/index.js", 10);
+
+	const auto scan = [&](const CPruningRules& rules) {
+		std::mutex mutex;
+		std::set<QString> items;
+		std::atomic<bool> abort {false};
+		CParallelDirectoryScanner scanner(4);
+		scanner.setPruningRules(rules);
+		scanner.scan({rootPath}, [&](const ScannedItemInfo& item) {
+			std::lock_guard<std::mutex> lock(mutex);
+			items.insert(withoutTrailingSlash(item.fullPath).mid(rootPath.length()));
+		}, abort);
+		return items;
+	};
+
+	CPruningRules rules;
+	rules.setPatterns({".git/", "/node_modules/"});
+	const auto items = scan(rules);
+	CHECK(items.count("/src/main.cpp") == 1);
+	CHECK(items.count("/src/lib/deep/deeper/file.txt") == 1);
+	CHECK(items.count("/src/.git") == 0);
+	CHECK(items.count("/src/.git/objects/1234") == 0);
+	CHECK(items.count("/node_modules") == 0);
+	CHECK(items.count("/node_modules/package/index.js") == 0);
+
+	rules.setPatterns({});
+	rules.setMaxDepth(2);
+	const auto shallowItems = scan(rules);
+	CHECK(shallowItems.count("/src/lib") == 1);
+	CHECK(shallowItems.count("/src/main.cpp") == 1);
+	CHECK(shallowItems.count("/src/lib/deep") == 0);
+}
+
+TEST_CASE("Overlapping search roots", "[directoryscanner]")
+{
+	QTemporaryDir root(QDir::tempPath() + "/" + CURRENT_TEST_NAME.c_str() + "_XXXXXX");
+	REQUIRE(root.isValid());
+
+	// The temporary folder itself may be behind a link
+	const QString rootPath = QFileInfo(root.path()).canonicalFilePath();
+	REQUIRE(QDir(rootPath).mkpath("a/b/c"));
+	REQUIRE(QDir(rootPath).mkpath("a-sibling"));
+	REQUIRE(QDir(rootPath).mkpath("d"));
+
+	const auto roots = independentScanRoots({
+		rootPath + "/a/b/c",
+		rootPath + "/d",
+		" " + rootPath + "/a ",
+		rootPath + "/a-sibling",
+		rootPath + "/a/../a/b",
+		rootPath + "/d/",
+		rootPath + "/nonexistent"
+	});
+
+	// The paths are kept as given, in the original order
+	CHECK(roots == std::vector<QString>{rootPath + "/d", rootPath + "/a", rootPath + "/a-sibling"});
+
+	// A parent of all the others is the only root left
+	CHECK(independentScanRoots({rootPath + "/d", rootPath + "/a/b", rootPath}) == std::vector<QString>{rootPath});
+	CHECK(independentScanRoots({}).empty());
+
+#ifndef _WIN32
+	// A link is scanned under its own path, and counts as a duplicate of its target
+	REQUIRE(QFile::link(rootPath + "/a/b", rootPath + "/link"));
+	CHECK(independentScanRoots({rootPath + "/link", rootPath + "/d"}) == std::vector<QString>{rootPath + "/link", rootPath + "/d"});
+	CHECK(independentScanRoots({rootPath + "/link", rootPath + "/a/b/c"}) == std::vector<QString>{rootPath + "/link"});
+	CHECK(independentScanRoots({rootPath + "/a", rootPath + "/link"}) == std::vector<QString>{rootPath + "/a"});
+#endif
+}
+
+TEST_CASE("COccupiedSpaceCalculator totals and breakdown", "[occupiedspace]")
+{
+	QTemporaryDir root(QDir::tempPath() + "/" + CURRENT_TEST_NAME.c_str() + "_XXXXXX");
+	REQUIRE(root.isValid());
+
+	REQUIRE(QDir(root.path()).mkpath("big/nested"));
+	REQUIRE(QDir(root.path()).mkpath("small"));
+	writeFile(root.path() + "/big/a", 3000);
+	writeFile(root.path() + "/big/nested/b", 5000);
+	writeFile(root.path() + "/small/c", 10);
+	writeFile(root.path() + "/d", 100);
+
+	uint64_t expectedHardLinks = 0;
+#ifndef _WIN32
+	// In the same folder so that the breakdown doesn't depend on which of the two links is found first
+	REQUIRE(::link(QFile::encodeName(root.path() + "/big/a").constData(), QFile::encodeName(root.path() + "/big/a_link").constData()) == 0);
+	expectedHardLinks = 1;
+#endif
+
+	COccupiedSpaceCalculator calculator({root.path()});
+	calculator.start();
+	while (!calculator.finished())
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+	const auto results = calculator.snapshot();
+	CHECK(results.finished);
+	CHECK(!results.cancelled);
+	CHECK(results.totals.files == 4 + expectedHardLinks);
+	CHECK(results.totals.folders == 4); // Including the root
+	CHECK(results.totals.occupiedSpace == 8110);
+	CHECK(results.hardLinksSkipped == expectedHardLinks);
+
+	REQUIRE(results.breakdown.size() == 3);
+	CHECK(results.breakdown[0].name == "big");
+	CHECK(results.breakdown[0].isDir);
+	CHECK(results.breakdown[0].stats.occupiedSpace == 8000);
+	CHECK(results.breakdown[0].stats.files == 2 + expectedHardLinks);
+	CHECK(results.breakdown[0].stats.folders == 2);
+	CHECK(results.breakdown[1].name == "d");
+	CHECK(!results.breakdown[1].isDir);
+	CHECK(results.breakdown[2].name == "small");
+	CHECK(results.breakdown[2].stats.occupiedSpace == 10);
+}
+
+int main(int argc, char* argv[])
+{
+	Catch::Session session; // There must be exactly one instance
+
+	// Build a new parser on top of Catch's
+	using namespace Catch::clara;
+	auto cli
+		= session.cli() // Get Catch's composite command line parser
+		| Opt(g_randomSeed, "std::random seed") // bind variable to a new option, with a hint string
+		["--std-seed"]        // the option names it will respond to
+	("std::random seed"); // description string for the help output
+
+	// Now pass the new composite back to Catch so it uses that
+	session.cli(cli);
+
+	// Let Catch (using Clara) parse the command line
+	const int returnCode = session.applyCommandLine(argc, argv);
+	if (returnCode != 0) // Indicates a command line error
+		return returnCode;
+
+	return session.run();
+}
@@ -0,0 +1,23 @@
+TEMPLATE = app
+CONFIG += console
+TARGET = ratelimiter_test
+
+include(../../config.pri)
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+for (included_item, INCLUDEPATH): INCLUDEPATH += ../../$${included_item}
+
+INCLUDEPATH += \
+	../../src/
+
+SOURCES += \
+	ratelimiter_test.cpp \
+	../../src/fileoperations/cratelimiter.cpp
+
+HEADERS += \
+	../../src/fileoperations/cratelimiter.h
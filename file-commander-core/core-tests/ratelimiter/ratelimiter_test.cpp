@@ -0,0 +1,86 @@
+#include "fileoperations/cratelimiter.h"
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+#include <chrono>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+TEST_CASE("An unlimited rate limiter never waits", "[ratelimiter]")
+{
+	CRateLimiter limiter;
+	const std::atomic<bool> abort{false};
+
+	const auto start = Clock::now();
+	for (int i = 0; i < 1000; ++i)
+		REQUIRE(limiter.consume(1024 * 1024, abort));
+
+	CHECK(secondsSince(start) < 0.5);
+	CHECK(limiter.measuredRate() > 0);
+}
+
+TEST_CASE("The rate is held to the limit", "[ratelimiter]")
+{
+	CRateLimiter limiter;
+	limiter.setRate(10 * 1024 * 1024);
+	const std::atomic<bool> abort{false};
+
+	// 5 MiB at 10 MiB/s
+	const auto start = Clock::now();
+	for (int i = 0; i < 80; ++i)
+		REQUIRE(limiter.consume(64 * 1024, abort));
+
+	const double elapsed = secondsSince(start);
+	INFO("Elapsed: " << elapsed << " s");
+	CHECK(elapsed > 0.4);
+	CHECK(elapsed < 1.5);
+
+	const uint64_t measuredRate = limiter.measuredRate();
+	INFO("Measured rate: " << measuredRate);
+	CHECK(measuredRate > 5 * 1024 * 1024);
+	CHECK(measuredRate < 15 * 1024 * 1024);
+}
+
+TEST_CASE("A waiting thread picks up the rate change", "[ratelimiter]")
+{
+	CRateLimiter limiter;
+	limiter.setRate(10);
+	const std::atomic<bool> abort{false};
+
+	std::thread liftLimit([&limiter]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		limiter.setRate(0);
+	});
+
+	// Would take 100 s at the original rate
+	const auto start = Clock::now();
+	CHECK(limiter.consume(1000, abort));
+	CHECK(secondsSince(start) < 2.0);
+
+	liftLimit.join();
+}
+
+TEST_CASE("Waiting is interrupted by the abort flag", "[ratelimiter]")
+{
+	CRateLimiter limiter;
+	limiter.setRate(10);
+	std::atomic<bool> abort{false};
+
+	std::thread abortThread([&abort]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		abort = true;
+	});
+
+	const auto start = Clock::now();
+	CHECK_FALSE(limiter.consume(1000, abort));
+	CHECK(secondsSince(start) < 2.0);
+
+	abortThread.join();
+}
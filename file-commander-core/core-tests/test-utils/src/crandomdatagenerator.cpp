@@ -26,3 +26,8 @@ int CRandomDataGenerator::randomInt(int min, int max)
 {
 	return std::uniform_int_distribution<int>(min, max)(_rng);
 }
+
+uint64_t CRandomDataGenerator::randomUint64(uint64_t min, uint64_t max)
+{
+	return std::uniform_int_distribution<uint64_t>(min, max)(_rng);
+}
@@ -12,6 +12,7 @@ public:
 
 	QString randomString(const size_t length);
 	int randomInt(int min, int max);
+	uint64_t randomUint64(uint64_t min, uint64_t max);
 
 private:
 	std::mt19937 _rng;
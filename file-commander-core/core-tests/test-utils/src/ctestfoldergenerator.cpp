@@ -9,12 +9,25 @@ DISABLE_COMPILER_WARNINGS
 #include <QStringBuilder>
 RESTORE_COMPILER_WARNINGS
 
+#include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <utility>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 void CTestFolderGenerator::setSeed(const uint32_t seed)
 {
 	_randomGenerator.setSeed(seed);
+	_seed = seed;
 }
 
 bool CTestFolderGenerator::generateRandomTree(const QString& parentDir, size_t numFiles, size_t numFolders)
@@ -103,3 +116,391 @@ std::vector<QString> CTestFolderGenerator::generateRandomFolders(const QString&
 
 	return newFolderNames;
 }
+
+static uint64_t splitMix64(uint64_t& state)
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+	return z ^ (z >> 31);
+}
+
+// The seed of the 'index'-th child (a subfolder or a file) of the folder with 'seed'
+static uint64_t childSeed(const uint64_t seed, const uint64_t index)
+{
+	uint64_t indexState = index;
+	uint64_t state = seed ^ splitMix64(indexState);
+	return splitMix64(state);
+}
+
+static void fillWithRandomData(char* buffer, const size_t size, uint64_t& state)
+{
+	for (size_t i = 0; i < size; i += 8)
+	{
+		const uint64_t word = splitMix64(state);
+		for (size_t b = 0; b < 8 && i + b < size; ++b)
+			buffer[i + b] = static_cast<char>(word >> (8 * b));
+	}
+}
+
+namespace {
+
+// Runs CTestFolderGenerator::generateTree(). The contents of every folder are planned by a single thread,
+// and the files are then written in batches, so that the threads can share the work on a large folder, too.
+class TreeBuilder
+{
+public:
+	TreeBuilder(const QString& root, const CTestFolderGenerator::TreeProfile& profile) : _root{root}, _profile{profile}
+	{
+		for (const auto& sizeClass: _profile.fileSizes)
+			_totalSizeWeight += sizeClass.weight;
+	}
+
+	bool run(const uint64_t seed, size_t numThreads, TestTreeManifest* manifest)
+	{
+		if (manifest)
+			manifest->entries.clear();
+
+		if (_profile.levels.empty())
+			return true;
+
+		_collectManifest = manifest != nullptr;
+		_jobs.push_back(Job{QString(), seed, 0, nullptr, 0, 0});
+
+		std::vector<std::thread> workers;
+		for (size_t i = 0; i < numThreads; ++i)
+			workers.emplace_back(&TreeBuilder::workerThread, this);
+
+		for (auto& worker: workers)
+			worker.join();
+
+		if (manifest)
+		{
+			std::sort(_entries.begin(), _entries.end(), [](const TestTreeManifest::Entry& l, const TestTreeManifest::Entry& r) {
+				return l.path < r.path;
+			});
+			manifest->entries = std::move(_entries);
+		}
+
+		return !_failed;
+	}
+
+private:
+	struct PlannedFile {
+		TestTreeManifest::Entry entry;
+		uint64_t seed = 0;
+		bool sparse = false;
+		size_t linkTarget = 0; // The index of the file a link points to
+	};
+
+	// The files of a folder. The links are only created once all the batches are written, as they need the files they point to.
+	struct FolderFiles {
+		std::vector<PlannedFile> files;
+		std::atomic<size_t> pendingBatches {0};
+	};
+
+	// Either a folder to fill, or a batch of files to write
+	struct Job {
+		QString relativePath; // Empty for the root
+		uint64_t seed = 0;
+		size_t level = 0;
+
+		std::shared_ptr<FolderFiles> folderFiles;
+		size_t batchBegin = 0, batchEnd = 0;
+	};
+
+	static constexpr size_t BatchFiles = 256;
+	static constexpr uint64_t BatchBytes = 64 * 1024 * 1024;
+	static constexpr uint64_t SparseBlockSize = 64 * 1024;
+
+	void enqueue(Job&& job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_jobsMutex);
+			_jobs.push_back(std::move(job));
+		}
+		_jobsCondition.notify_one();
+	}
+
+	void workerThread()
+	{
+		std::vector<TestTreeManifest::Entry> entries;
+		std::vector<char> buffer;
+
+		for (;;)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(_jobsMutex);
+				_jobsCondition.wait(lock, [this] {
+					return !_jobs.empty() || _numBusyWorkers == 0 || _failed;
+				});
+
+				if (_jobs.empty() || _failed)
+					break; // Nothing else is coming
+
+				job = std::move(_jobs.back());
+				_jobs.pop_back();
+				++_numBusyWorkers;
+			}
+
+			const bool success = job.folderFiles ? writeBatch(*job.folderFiles, job.batchBegin, job.batchEnd, entries, buffer) : processFolder(job, entries, buffer);
+			if (!success)
+				_failed = true;
+
+			if (!_collectManifest)
+				entries.clear();
+
+			{
+				std::lock_guard<std::mutex> lock(_jobsMutex);
+				--_numBusyWorkers;
+			}
+			_jobsCondition.notify_all();
+		}
+
+		_jobsCondition.notify_all();
+
+		std::lock_guard<std::mutex> lock(_jobsMutex);
+		_entries.insert(_entries.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+	}
+
+	// Everything in here only depends on job.seed, which is what makes the result independent of the number of threads
+	bool processFolder(const Job& job, std::vector<TestTreeManifest::Entry>& entries, std::vector<char>& buffer)
+	{
+		CRandomDataGenerator random;
+		random.setSeed(static_cast<uint32_t>(job.seed ^ (job.seed >> 32)));
+
+		const auto& level = _profile.levels[job.level];
+		const auto numFolders = random.randomUint64(level.minFolders, level.maxFolders);
+		const auto numFiles = random.randomUint64(level.minFiles, level.maxFiles);
+
+		const QString prefix = job.relativePath.isEmpty() ? QString() : job.relativePath + '/';
+		std::set<QString> namesTaken; // Lower case, for the case-insensitive file systems
+
+		const auto uniqueName = [&namesTaken](const std::function<QString ()>& generateName) {
+			for (;;)
+			{
+				QString name = generateName();
+				if (namesTaken.insert(name.toLower()).second)
+					return name;
+			}
+		};
+
+		for (uint64_t i = 0; i < numFolders; ++i)
+		{
+			const QString name = uniqueName([&] {
+				return random.randomString(_profile.nameLength).toUpper();
+			});
+
+			TestTreeManifest::Entry entry;
+			entry.type = TestTreeManifest::Entry::Folder;
+			entry.path = prefix + name;
+			assert_and_return_r(QDir().mkdir(_root + '/' + entry.path), false);
+
+			if (job.level + 1 < _profile.levels.size())
+				enqueue(Job{entry.path, childSeed(job.seed, i), job.level + 1, nullptr, 0, 0});
+
+			entries.push_back(std::move(entry));
+		}
+
+		auto folderFiles = std::make_shared<FolderFiles>();
+		auto& files = folderFiles->files;
+		files.reserve(static_cast<size_t>(numFiles));
+		std::vector<size_t> regularFiles; // The links point to these
+
+		for (uint64_t i = 0; i < numFiles; ++i)
+		{
+			const QString name = uniqueName([&] {
+				for (;;)
+				{
+					const QString extension = random.randomString(3);
+					if (extension != QLatin1String("lnk")) // Windows shortcut
+						return QString(random.randomString(_profile.nameLength - 4) % '.' % extension);
+				}
+			});
+
+			const double roll = random.randomInt(0, 999999) / 1000000.0;
+			PlannedFile file;
+			file.entry.path = prefix + name;
+
+#ifndef _WIN32
+			if (!regularFiles.empty() && roll < _profile.hardLinkProbability + _profile.symLinkProbability)
+			{
+				file.linkTarget = regularFiles[static_cast<size_t>(random.randomUint64(0, regularFiles.size() - 1))];
+				const auto& target = files[file.linkTarget].entry;
+				if (roll < _profile.hardLinkProbability)
+				{
+					file.entry.type = TestTreeManifest::Entry::HardLink;
+					file.entry.linkTarget = target.path;
+				}
+				else
+				{
+					file.entry.type = TestTreeManifest::Entry::SymLink;
+					file.entry.linkTarget = target.path.mid(prefix.length());
+				}
+
+				files.push_back(std::move(file));
+				continue;
+			}
+#else
+			(void)roll;
+#endif
+
+			uint64_t sizeClassRoll = random.randomUint64(0, _totalSizeWeight - 1);
+			const auto sizeClass = std::find_if(_profile.fileSizes.begin(), _profile.fileSizes.end(), [&sizeClassRoll](const CTestFolderGenerator::TreeProfile::SizeClass& c) {
+				if (sizeClassRoll < c.weight)
+					return true;
+
+				sizeClassRoll -= c.weight;
+				return false;
+			});
+			assert_and_return_r(sizeClass != _profile.fileSizes.end(), false);
+
+			file.entry.type = TestTreeManifest::Entry::File;
+			file.entry.size = random.randomUint64(sizeClass->minSize, sizeClass->maxSize);
+			file.seed = childSeed(job.seed, numFolders + i);
+			file.sparse = sizeClass->sparse;
+
+			regularFiles.push_back(files.size());
+			files.push_back(std::move(file));
+		}
+
+		if (files.empty())
+			return true;
+
+		// Splitting the files into batches of roughly the same amount of work
+		std::vector<std::pair<size_t, size_t>> batches;
+		size_t batchBegin = 0, batchFiles = 0;
+		uint64_t batchBytes = 0;
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			if (files[i].entry.type == TestTreeManifest::Entry::File)
+			{
+				++batchFiles;
+				batchBytes += files[i].sparse ? 2 * SparseBlockSize : files[i].entry.size;
+			}
+
+			if (batchFiles >= BatchFiles || batchBytes >= BatchBytes || i + 1 == files.size())
+			{
+				batches.emplace_back(batchBegin, i + 1);
+				batchBegin = i + 1;
+				batchFiles = 0;
+				batchBytes = 0;
+			}
+		}
+
+		folderFiles->pendingBatches = batches.size();
+		for (size_t i = 1; i < batches.size(); ++i)
+			enqueue(Job{QString(), 0, 0, folderFiles, batches[i].first, batches[i].second});
+
+		return writeBatch(*folderFiles, batches.front().first, batches.front().second, entries, buffer);
+	}
+
+	bool writeBatch(FolderFiles& folderFiles, const size_t begin, const size_t end, std::vector<TestTreeManifest::Entry>& entries, std::vector<char>& buffer)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			auto& entry = folderFiles.files[i].entry;
+			if (entry.type == TestTreeManifest::Entry::File)
+				assert_and_return_r(writeFile(_root + '/' + entry.path, entry.size, folderFiles.files[i].sparse, folderFiles.files[i].seed, buffer, entry.contentHash), false);
+		}
+
+		// The last batch to finish creates the links
+		if (--folderFiles.pendingBatches != 0)
+			return true;
+
+#ifndef _WIN32
+		for (auto& file: folderFiles.files)
+		{
+			auto& entry = file.entry;
+			const QByteArray linkPath = QFile::encodeName(_root + '/' + entry.path);
+			if (entry.type == TestTreeManifest::Entry::HardLink)
+			{
+				const auto& target = folderFiles.files[file.linkTarget].entry;
+				assert_and_return_r(::link(QFile::encodeName(_root + '/' + target.path).constData(), linkPath.constData()) == 0, false);
+				entry.size = target.size;
+				entry.contentHash = target.contentHash;
+			}
+			else if (entry.type == TestTreeManifest::Entry::SymLink)
+				assert_and_return_r(::symlink(QFile::encodeName(entry.linkTarget).constData(), linkPath.constData()) == 0, false);
+		}
+#endif
+
+		// Not before all the links are created as they refer to the paths of their targets
+		if (_collectManifest)
+		{
+			for (auto& file: folderFiles.files)
+				entries.push_back(std::move(file.entry));
+		}
+
+		return true;
+	}
+
+	static bool writeFile(const QString& path, const uint64_t size, const bool sparse, uint64_t seed, std::vector<char>& buffer, uint64_t& contentHash)
+	{
+		static constexpr uint64_t ChunkSize = 1024 * 1024;
+
+		QFile file(path);
+		assert_and_return_r(file.open(QFile::WriteOnly), false);
+
+		ContentHasher hasher;
+		const auto writeRandomBlock = [&](const uint64_t blockSize) {
+			buffer.resize(static_cast<size_t>(blockSize));
+			fillWithRandomData(buffer.data(), buffer.size(), seed);
+			hasher.update(buffer.data(), buffer.size());
+			return file.write(buffer.data(), static_cast<qint64>(buffer.size())) == static_cast<qint64>(buffer.size());
+		};
+
+		if (!sparse)
+		{
+			for (uint64_t written = 0; written < size; written += ChunkSize)
+				assert_and_return_r(writeRandomBlock(std::min(ChunkSize, size - written)), false);
+		}
+		else
+		{
+			// A block of data at the start and at the end, a hole in between
+			const uint64_t blockSize = std::min(SparseBlockSize, size / 2);
+			assert_and_return_r(file.resize(static_cast<qint64>(size)), false);
+			assert_and_return_r(writeRandomBlock(blockSize), false);
+			hasher.updateZeros(size - 2 * blockSize);
+			assert_and_return_r(file.seek(static_cast<qint64>(size - blockSize)), false);
+			assert_and_return_r(writeRandomBlock(blockSize), false);
+		}
+
+		contentHash = hasher.result();
+		return true;
+	}
+
+private:
+	const QString _root;
+	const CTestFolderGenerator::TreeProfile& _profile;
+	uint64_t _totalSizeWeight = 0;
+	bool _collectManifest = false;
+
+	std::vector<Job> _jobs;
+	std::mutex _jobsMutex;
+	std::condition_variable _jobsCondition;
+	size_t _numBusyWorkers = 0;
+	std::atomic<bool> _failed {false};
+
+	std::vector<TestTreeManifest::Entry> _entries;
+};
+
+}
+
+bool CTestFolderGenerator::generateTree(const QString& parentDir, const TreeProfile& profile, TestTreeManifest* manifest, size_t numThreads)
+{
+	assert_and_return_r(QDir(parentDir).exists(), false);
+	assert_and_return_r(!profile.fileSizes.empty() && profile.nameLength >= 4, false);
+	for (const auto& level: profile.levels)
+		assert_and_return_r(level.minFolders <= level.maxFolders && level.minFiles <= level.maxFiles, false);
+	for (const auto& sizeClass: profile.fileSizes)
+		assert_and_return_r(sizeClass.minSize <= sizeClass.maxSize && sizeClass.weight > 0, false);
+
+	if (numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 4u);
+
+	uint64_t rootSeedState = _seed;
+	TreeBuilder builder(QDir(parentDir).absolutePath(), profile);
+	return builder.run(splitMix64(rootSeedState), numThreads, manifest);
+}
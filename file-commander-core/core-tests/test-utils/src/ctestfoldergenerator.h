@@ -1,5 +1,6 @@
 #pragma once
 #include "crandomdatagenerator.h"
+#include "testtreemanifest.h"
 
 class QString;
 
@@ -8,9 +9,42 @@ class QString;
 class CTestFolderGenerator
 {
 public:
+	// The shape of the tree made by generateTree()
+	struct TreeProfile {
+		// The number of subfolders and files in a folder, picked uniformly from the ranges
+		struct Level {
+			size_t minFolders = 0, maxFolders = 0;
+			size_t minFiles = 0, maxFiles = 0;
+		};
+
+		// A range of file sizes, picked with a probability proportional to its weight. The size is uniform within the range.
+		struct SizeClass {
+			uint64_t minSize = 10, maxSize = 100;
+			uint32_t weight = 1;
+			// Only a few blocks of the file are written, the rest is a hole, so that multi-GB files take no time or space.
+			// Where the file system doesn't support holes, they are written out as zeros.
+			bool sparse = false;
+		};
+
+		// levels[0] is the contents of the root folder, levels[1] of each of its subfolders, and so on. The folders on the last level are empty.
+		std::vector<Level> levels {{1, 5, 1, 20}, {0, 5, 0, 20}, {0, 0, 0, 20}};
+		std::vector<SizeClass> fileSizes {SizeClass{}};
+
+		// The share of the files that are hard links to, or symbolic links to, another file in the same folder. Ignored on Windows.
+		double hardLinkProbability = 0.0;
+		double symLinkProbability = 0.0;
+
+		size_t nameLength = 12;
+	};
+
 	void setSeed(uint32_t seed);
 	bool generateRandomTree(const QString& parentDir, size_t numFiles, size_t numFolders);
 
+	// Generates a tree in 'parentDir' (which must exist) with the specified number of threads, 0 meaning one per CPU core but no less than 4.
+	// Every folder has its own seed derived from the seed of its parent, so the result only depends on the seed and the profile, not on the number of threads.
+	// 'manifest', if not null, receives the description of everything that has been generated.
+	bool generateTree(const QString& parentDir, const TreeProfile& profile, TestTreeManifest* manifest = nullptr, size_t numThreads = 0);
+
 private:
 	QString randomFileName(const size_t length);
 	QString randomDirName(const size_t length);
@@ -20,4 +54,5 @@ private:
 
 private:
 	CRandomDataGenerator _randomGenerator;
+	uint32_t _seed = 0;
 };
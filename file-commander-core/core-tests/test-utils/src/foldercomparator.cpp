@@ -1,15 +1,28 @@
 #include "foldercomparator.h"
 #include "qt_helpers.hpp"
+#include "testtreemanifest.h"
 
 #include "compiler/compiler_warnings_control.h"
 #include "container/set_operations.hpp"
 #include "cfilesystemobject.h"
 
 DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
 #include <QStringList>
 RESTORE_COMPILER_WARNINGS
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <set>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // TODO: also compare all the files by contents.
 bool compareFolderContents(const std::vector<CFileSystemObject>& source, const std::vector<CFileSystemObject>& dest)
@@ -57,3 +70,104 @@ bool compareFolderContents(const std::vector<CFileSystemObject>& source, const s
 
 	return !differenceDetected;
 }
+
+static bool contentsMatch(const QString& path, const TestTreeManifest::Entry& expected)
+{
+	QFile file(path);
+	if (!file.open(QFile::ReadOnly) || static_cast<uint64_t>(file.size()) != expected.size)
+		return false;
+
+	static constexpr qint64 BufferSize = 1024 * 1024;
+	const auto buffer = std::make_unique<char[]>(BufferSize);
+	ContentHasher hasher;
+	for (qint64 bytesRead = file.read(buffer.get(), BufferSize); bytesRead > 0; bytesRead = file.read(buffer.get(), BufferSize))
+		hasher.update(buffer.get(), static_cast<size_t>(bytesRead));
+
+	return file.atEnd() && hasher.result() == expected.contentHash;
+}
+
+#ifndef _WIN32
+static bool sameInode(const QString& pathA, const QString& pathB)
+{
+	struct stat a, b;
+	return ::lstat(QFile::encodeName(pathA).constData(), &a) == 0 && ::lstat(QFile::encodeName(pathB).constData(), &b) == 0 && a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+#endif
+
+bool verifyFolderContents(const QString& rootPath, const TestTreeManifest& manifest, const bool checkLinks)
+{
+	const QString root = QDir(rootPath).absolutePath() + '/';
+
+	std::set<QString> unexpectedItems;
+	QDirIterator it(root, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+	while (it.hasNext())
+		unexpectedItems.insert(it.next().mid(root.length()));
+
+#ifndef _WIN32
+	const auto findEntry = [&manifest](const QString& path) -> const TestTreeManifest::Entry* {
+		const auto entry = std::lower_bound(manifest.entries.begin(), manifest.entries.end(), path, [](const TestTreeManifest::Entry& e, const QString& p) {
+			return e.path < p;
+		});
+		return entry != manifest.entries.end() && entry->path == path ? &*entry : nullptr;
+	};
+#endif
+
+	bool differenceDetected = false;
+	for (const auto& entry: manifest.entries)
+	{
+		if (unexpectedItems.erase(entry.path) == 0)
+		{
+			differenceDetected = true;
+			std::cout << "Missing item: " << entry.path << std::endl;
+			continue;
+		}
+
+		const QString path = root + entry.path;
+		const QFileInfo info(path);
+		bool match = false;
+		switch (entry.type)
+		{
+		case TestTreeManifest::Entry::Folder:
+			match = info.isDir() && !info.isSymLink();
+			break;
+		case TestTreeManifest::Entry::File:
+			match = info.isFile() && !info.isSymLink() && contentsMatch(path, entry);
+			break;
+		case TestTreeManifest::Entry::HardLink:
+			match = info.isFile() && !info.isSymLink() && contentsMatch(path, entry);
+#ifndef _WIN32
+			match = match && (!checkLinks || sameInode(path, root + entry.linkTarget));
+#endif
+			break;
+		case TestTreeManifest::Entry::SymLink:
+#ifndef _WIN32
+			if (info.isSymLink())
+			{
+				char target[4096];
+				const auto length = ::readlink(QFile::encodeName(path).constData(), target, sizeof(target));
+				match = length > 0 && QFile::decodeName(QByteArray(target, static_cast<int>(length))) == entry.linkTarget;
+			}
+			else if (!checkLinks)
+			{
+				const auto* targetEntry = findEntry(entry.path.left(entry.path.lastIndexOf('/') + 1) + entry.linkTarget);
+				match = targetEntry && info.isFile() && contentsMatch(path, *targetEntry);
+			}
+#endif
+			break;
+		}
+
+		if (!match)
+		{
+			differenceDetected = true;
+			std::cout << "Item doesn't match the manifest: " << entry.path << std::endl;
+		}
+	}
+
+	for (const auto& item: unexpectedItems)
+	{
+		differenceDetected = true;
+		std::cout << "Unexpected item: " << item << std::endl;
+	}
+
+	return !differenceDetected;
+}
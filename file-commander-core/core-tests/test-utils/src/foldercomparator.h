@@ -3,5 +3,11 @@
 #include <vector>
 
 class CFileSystemObject;
+class QString;
+struct TestTreeManifest;
 
 bool compareFolderContents(const std::vector<CFileSystemObject>& source, const std::vector<CFileSystemObject>& dest);
+
+// Checks that 'rootPath' holds exactly the items from the manifest, with the same contents, and reports the differences.
+// If 'checkLinks' is false, a hard link may also be a separate copy of the data, and a symbolic link a copy of the file it points to.
+bool verifyFolderContents(const QString& rootPath, const TestTreeManifest& manifest, bool checkLinks = true);
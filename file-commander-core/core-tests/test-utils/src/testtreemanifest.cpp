@@ -0,0 +1,126 @@
+#include "testtreemanifest.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFile>
+#include <QTextStream>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+
+static constexpr uint64_t HashPrime = 0x100000001B3;
+
+void ContentHasher::update(const char* data, size_t size)
+{
+	// Bytes are packed into little-endian words explicitly so that the result is the same on any platform and for any split of the data
+	while (size > 0 && _numBytes % 8 != 0)
+	{
+		_pendingWord |= uint64_t{static_cast<uint8_t>(*data++)} << (8 * (_numBytes % 8));
+		++_numBytes;
+		--size;
+		if (_numBytes % 8 == 0)
+			addWord(_pendingWord);
+	}
+
+	for (; size >= 8; size -= 8, data += 8)
+	{
+		uint64_t word = 0;
+		for (int i = 7; i >= 0; --i)
+			word = (word << 8) | static_cast<uint8_t>(data[i]);
+
+		addWord(word);
+		_numBytes += 8;
+	}
+
+	for (; size > 0; --size)
+	{
+		_pendingWord |= uint64_t{static_cast<uint8_t>(*data++)} << (8 * (_numBytes % 8));
+		++_numBytes;
+	}
+}
+
+void ContentHasher::updateZeros(uint64_t size)
+{
+	static const char zeros[64 * 1024] = {0};
+	for (; size > 0; size -= std::min<uint64_t>(size, sizeof(zeros)))
+		update(zeros, static_cast<size_t>(std::min<uint64_t>(size, sizeof(zeros))));
+}
+
+uint64_t ContentHasher::result() const
+{
+	uint64_t hash = _hash;
+	if (_numBytes % 8 != 0)
+		hash = (hash ^ _pendingWord) * HashPrime;
+
+	hash = (hash ^ _numBytes) * HashPrime;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+void ContentHasher::addWord(uint64_t word)
+{
+	_hash = (_hash ^ word) * HashPrime;
+	_hash ^= _hash >> 29;
+	_pendingWord = 0;
+}
+
+uint64_t TestTreeManifest::numFiles() const
+{
+	return static_cast<uint64_t>(std::count_if(entries.begin(), entries.end(), [](const Entry& entry) {
+		return entry.type == Entry::File || entry.type == Entry::HardLink;
+	}));
+}
+
+uint64_t TestTreeManifest::totalSize() const
+{
+	uint64_t size = 0;
+	for (const auto& entry: entries)
+		size += entry.size;
+
+	return size;
+}
+
+// Type, size, hash, link target and path separated with tabs, which the generated names never contain
+bool TestTreeManifest::save(const QString& filePath) const
+{
+	QFile file(filePath);
+	assert_and_return_r(file.open(QFile::WriteOnly | QFile::Truncate), false);
+
+	QTextStream stream(&file);
+	stream.setCodec("UTF-8");
+	for (const auto& entry: entries)
+		stream << static_cast<int>(entry.type) << '\t' << entry.size << '\t' << QString::number(entry.contentHash, 16) << '\t' << entry.linkTarget << '\t' << entry.path << '\n';
+
+	stream.flush();
+	return stream.status() == QTextStream::Ok;
+}
+
+bool TestTreeManifest::load(const QString& filePath)
+{
+	entries.clear();
+
+	QFile file(filePath);
+	assert_and_return_r(file.open(QFile::ReadOnly), false);
+
+	QTextStream stream(&file);
+	stream.setCodec("UTF-8");
+	for (QString line = stream.readLine(); !line.isNull(); line = stream.readLine())
+	{
+		const auto fields = line.split('\t');
+		assert_and_return_r(fields.size() == 5, false);
+
+		Entry entry;
+		bool typeValid = false, sizeValid = false, hashValid = false;
+		const int type = fields[0].toInt(&typeValid);
+		entry.type = static_cast<Entry::Type>(type);
+		entry.size = fields[1].toULongLong(&sizeValid);
+		entry.contentHash = fields[2].toULongLong(&hashValid, 16);
+		entry.linkTarget = fields[3];
+		entry.path = fields[4];
+		assert_and_return_r(typeValid && sizeValid && hashValid && type >= Entry::Folder && type <= Entry::SymLink, false);
+
+		entries.push_back(std::move(entry));
+	}
+
+	return true;
+}
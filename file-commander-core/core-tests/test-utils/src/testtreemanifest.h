@@ -0,0 +1,53 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <stdint.h>
+#include <vector>
+
+// A non-cryptographic 64-bit hash of the file contents. Doesn't depend on how the data is split into the update() calls.
+class ContentHasher
+{
+public:
+	void update(const char* data, size_t size);
+	// The same as update() with 'size' zero bytes, for the holes in the sparse files
+	void updateZeros(uint64_t size);
+	uint64_t result() const;
+
+private:
+	void addWord(uint64_t word);
+
+private:
+	uint64_t _hash = 0xCBF29CE484222325;
+	uint64_t _pendingWord = 0;
+	uint64_t _numBytes = 0;
+};
+
+// Everything CTestFolderGenerator::generateTree() has created, for checking a copy of the tree later (see verifyFolderContents())
+struct TestTreeManifest
+{
+	struct Entry {
+		enum Type {Folder, File, HardLink, SymLink};
+
+		Type type = File;
+		QString path; // Relative to the root of the tree, '/'-separated
+		uint64_t size = 0;
+		uint64_t contentHash = 0;
+		// HardLink: the path of the file (relative to the root) that shares the data with this one; SymLink: the contents of the link
+		QString linkTarget;
+	};
+
+	// Sorted by path
+	std::vector<Entry> entries;
+
+	uint64_t numFiles() const; // Including the hard links
+	uint64_t totalSize() const;
+
+	// A text file with one entry per line
+	bool save(const QString& filePath) const;
+	bool load(const QString& filePath);
+};
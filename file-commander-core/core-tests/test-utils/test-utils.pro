@@ -25,11 +25,13 @@ HEADERS += \
     src/catch2_utils.hpp \
     src/foldercomparator.h \
     src/qt_helpers.hpp \
-    src/crandomdatagenerator.h
+    src/crandomdatagenerator.h \
+    src/testtreemanifest.h
 
 SOURCES += \
 	src/cfolderenumeratorrecursive.cpp \
 	src/ctestfoldergenerator.cpp \
     src/foldercomparator.cpp \
     src/qt_helpers.cpp \
-    src/crandomdatagenerator.cpp
+    src/crandomdatagenerator.cpp \
+    src/testtreemanifest.cpp
@@ -0,0 +1,169 @@
+#include "ctestfoldergenerator.h"
+#include "foldercomparator.h"
+#include "testtreemanifest.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+static CTestFolderGenerator::TreeProfile testProfile()
+{
+	CTestFolderGenerator::TreeProfile profile;
+	profile.levels = {{2, 4, 5, 10}, {1, 3, 5, 10}, {0, 2, 0, 10}};
+	profile.fileSizes = {
+		{0, 100, 10, false},
+		{4 * 1024, 3 * 1024 * 1024, 3, false},
+		{64 * 1024 * 1024, 64 * 1024 * 1024, 1, true}
+	};
+	profile.hardLinkProbability = 0.1;
+	profile.symLinkProbability = 0.1;
+	return profile;
+}
+
+static bool sameEntries(const TestTreeManifest& a, const TestTreeManifest& b)
+{
+	return std::equal(a.entries.begin(), a.entries.end(), b.entries.begin(), b.entries.end(), [](const TestTreeManifest::Entry& l, const TestTreeManifest::Entry& r) {
+		return l.type == r.type && l.path == r.path && l.size == r.size && l.contentHash == r.contentHash && l.linkTarget == r.linkTarget;
+	});
+}
+
+TEST_CASE("The generated tree doesn't depend on the number of threads", "[testtreegenerator]")
+{
+	QTemporaryDir sequentialDir(QDir::currentPath() + "/testtreegenerator_XXXXXX");
+	QTemporaryDir parallelDir(QDir::currentPath() + "/testtreegenerator_XXXXXX");
+	REQUIRE(sequentialDir.isValid());
+	REQUIRE(parallelDir.isValid());
+
+	const auto profile = testProfile();
+
+	CTestFolderGenerator generator;
+	generator.setSeed(12345);
+	TestTreeManifest sequential, parallel;
+	REQUIRE(generator.generateTree(sequentialDir.path(), profile, &sequential, 1));
+	REQUIRE(generator.generateTree(parallelDir.path(), profile, &parallel, 8));
+
+	REQUIRE(!sequential.entries.empty());
+	CHECK(sameEntries(sequential, parallel));
+
+	CHECK(verifyFolderContents(sequentialDir.path(), sequential));
+	CHECK(verifyFolderContents(parallelDir.path(), sequential));
+
+	// A different seed makes a different tree
+	generator.setSeed(54321);
+	QTemporaryDir otherDir(QDir::currentPath() + "/testtreegenerator_XXXXXX");
+	TestTreeManifest other;
+	REQUIRE(generator.generateTree(otherDir.path(), profile, &other));
+	CHECK(!sameEntries(sequential, other));
+	CHECK(!verifyFolderContents(otherDir.path(), sequential));
+}
+
+TEST_CASE("The manifest catches the changes", "[testtreegenerator]")
+{
+	QTemporaryDir dir(QDir::currentPath() + "/testtreegenerator_XXXXXX");
+	REQUIRE(dir.isValid());
+
+	CTestFolderGenerator generator;
+	generator.setSeed(1);
+	TestTreeManifest manifest;
+	REQUIRE(generator.generateTree(dir.path(), testProfile(), &manifest));
+	REQUIRE(verifyFolderContents(dir.path(), manifest));
+
+	// Saving and loading
+	QTemporaryDir manifestDir(QDir::currentPath() + "/testtreegenerator_XXXXXX");
+	REQUIRE(manifest.save(manifestDir.path() + "/manifest.txt"));
+	TestTreeManifest loaded;
+	REQUIRE(loaded.load(manifestDir.path() + "/manifest.txt"));
+	CHECK(sameEntries(manifest, loaded));
+	CHECK(loaded.numFiles() == manifest.numFiles());
+	CHECK(loaded.totalSize() == manifest.totalSize());
+
+	const auto file = std::find_if(manifest.entries.begin(), manifest.entries.end(), [](const TestTreeManifest::Entry& entry) {
+		return entry.type == TestTreeManifest::Entry::File && entry.size > 0;
+	});
+	REQUIRE(file != manifest.entries.end());
+
+	SECTION("Modified file")
+	{
+		QFile f(dir.path() + '/' + file->path);
+		REQUIRE(f.open(QFile::ReadWrite));
+		const char c = f.read(1).at(0);
+		REQUIRE(f.seek(0));
+		REQUIRE(f.write(QByteArray(1, static_cast<char>(~c))) == 1);
+		f.close();
+
+		CHECK(!verifyFolderContents(dir.path(), manifest));
+	}
+
+	SECTION("Missing file")
+	{
+		REQUIRE(QFile::remove(dir.path() + '/' + file->path));
+		CHECK(!verifyFolderContents(dir.path(), manifest));
+	}
+
+	SECTION("Extra file")
+	{
+		QFile f(dir.path() + "/extra.txt");
+		REQUIRE(f.open(QFile::WriteOnly));
+		f.close();
+
+		CHECK(!verifyFolderContents(dir.path(), manifest));
+	}
+}
+
+#ifndef _WIN32
+TEST_CASE("Links are created within the folder", "[testtreegenerator]")
+{
+	QTemporaryDir dir(QDir::currentPath() + "/testtreegenerator_XXXXXX");
+	REQUIRE(dir.isValid());
+
+	auto profile = testProfile();
+	profile.hardLinkProbability = 0.3;
+	profile.symLinkProbability = 0.3;
+
+	CTestFolderGenerator generator;
+	generator.setSeed(7);
+	TestTreeManifest manifest;
+	REQUIRE(generator.generateTree(dir.path(), profile, &manifest));
+
+	size_t numHardLinks = 0, numSymLinks = 0;
+	for (const auto& entry: manifest.entries)
+	{
+		if (entry.type == TestTreeManifest::Entry::HardLink)
+		{
+			++numHardLinks;
+			CHECK(QFileInfo(dir.path() + '/' + entry.linkTarget).path() == QFileInfo(dir.path() + '/' + entry.path).path());
+		}
+		else if (entry.type == TestTreeManifest::Entry::SymLink)
+		{
+			++numSymLinks;
+			CHECK(QFileInfo(dir.path() + '/' + entry.path).isSymLink());
+			CHECK(!entry.linkTarget.contains('/'));
+		}
+	}
+
+	CHECK(numHardLinks > 0);
+	CHECK(numSymLinks > 0);
+	CHECK(verifyFolderContents(dir.path(), manifest));
+
+	// A copy that doesn't preserve the links still has the same data
+	const auto symLink = std::find_if(manifest.entries.begin(), manifest.entries.end(), [](const TestTreeManifest::Entry& entry) {
+		return entry.type == TestTreeManifest::Entry::SymLink;
+	});
+	REQUIRE(symLink != manifest.entries.end());
+	const QString linkPath = dir.path() + '/' + symLink->path;
+	const QString targetPath = QFileInfo(linkPath).path() + '/' + symLink->linkTarget;
+	REQUIRE(QFile::remove(linkPath));
+	REQUIRE(QFile::copy(targetPath, linkPath));
+
+	CHECK(!verifyFolderContents(dir.path(), manifest));
+	CHECK(verifyFolderContents(dir.path(), manifest, false));
+}
+#endif
@@ -0,0 +1,151 @@
+#include "tracing/ctracer.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#define CATCH_CONFIG_MAIN
+#include "../catch2/catch.hpp"
+
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <vector>
+
+static QJsonArray exportedEvents()
+{
+	QTemporaryDir dir(QDir::currentPath() + "/tracer_XXXXXX");
+	REQUIRE(dir.isValid());
+
+	const QString path = dir.path() + "/trace.json";
+	REQUIRE(CTracer::exportChromeTrace(path));
+
+	QFile file(path);
+	REQUIRE(file.open(QFile::ReadOnly));
+	QJsonParseError error;
+	const auto document = QJsonDocument::fromJson(file.readAll(), &error);
+	REQUIRE(error.error == QJsonParseError::NoError);
+
+	return document.object().value("traceEvents").toArray();
+}
+
+static size_t countSpans(const QJsonArray& events, const QString& name)
+{
+	return static_cast<size_t>(std::count_if(events.begin(), events.end(), [&name](const QJsonValue& event) {
+		return event.toObject().value("ph").toString() == "X" && event.toObject().value("name").toString() == name;
+	}));
+}
+
+TEST_CASE("Nothing is recorded while disabled", "[tracer]")
+{
+	CTracer::setEnabled(false);
+	CTracer::clear();
+
+	{
+		TRACE_SCOPE("Disabled span");
+	}
+
+	CHECK(countSpans(exportedEvents(), "Disabled span") == 0);
+}
+
+TEST_CASE("Spans from all threads are exported", "[tracer]")
+{
+	CTracer::clear();
+	CTracer::setEnabled(true);
+
+	{
+		TRACE_SCOPE("Outer span");
+		TRACE_SCOPE_CATEGORY("Inner span", "test");
+	}
+
+	// The spans of the threads that have exited are kept
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; ++i)
+	{
+		threads.emplace_back([] {
+			for (int j = 0; j < 100; ++j)
+				TRACE_SCOPE("Worker span");
+		});
+	}
+
+	for (auto& thread: threads)
+		thread.join();
+
+	CTracer::setEnabled(false);
+
+	const auto events = exportedEvents();
+	CHECK(countSpans(events, "Outer span") == 1);
+	CHECK(countSpans(events, "Inner span") == 1);
+	CHECK(countSpans(events, "Worker span") == 400);
+
+	QJsonObject outer, inner;
+	std::set<int> workerThreadIds;
+	for (const auto& value: events)
+	{
+		const auto event = value.toObject();
+		if (event.value("name").toString() == "Outer span")
+			outer = event;
+		else if (event.value("name").toString() == "Inner span")
+			inner = event;
+		else if (event.value("name").toString() == "Worker span")
+			workerThreadIds.insert(event.value("tid").toInt());
+	}
+
+	CHECK(inner.value("cat").toString() == "test");
+	CHECK(outer.value("cat").toString() == "core");
+	CHECK(inner.value("tid").toInt() == outer.value("tid").toInt());
+	CHECK(workerThreadIds.size() == 4);
+	CHECK(workerThreadIds.count(outer.value("tid").toInt()) == 0);
+
+	// The inner span is nested in the outer one
+	const double outerStart = outer.value("ts").toDouble(), innerStart = inner.value("ts").toDouble();
+	CHECK(innerStart >= outerStart);
+	CHECK(innerStart + inner.value("dur").toDouble() <= outerStart + outer.value("dur").toDouble());
+
+	CTracer::clear();
+	CHECK(countSpans(exportedEvents(), "Worker span") == 0);
+}
+
+TEST_CASE("The ring buffer keeps the latest spans", "[tracer]")
+{
+	CTracer::clear();
+	CTracer::setEnabled(true);
+
+	for (int i = 0; i < 100000; ++i)
+		TRACE_SCOPE("Old span");
+
+	for (int i = 0; i < 10; ++i)
+		TRACE_SCOPE("New span");
+
+	CTracer::setEnabled(false);
+
+	const auto events = exportedEvents();
+	CHECK(countSpans(events, "New span") == 10);
+	CHECK(countSpans(events, "Old span") < 100000);
+}
+
+TEST_CASE("The exited threads are dropped once exported", "[tracer]")
+{
+	CTracer::clear();
+	CTracer::setEnabled(true);
+
+	// Short-lived threads, one after another
+	for (int i = 0; i < 200; ++i)
+	{
+		std::thread([] {
+			for (int j = 0; j < 10; ++j)
+				TRACE_SCOPE("Short-lived thread span");
+		}).join();
+	}
+
+	CTracer::setEnabled(false);
+
+	CHECK(countSpans(exportedEvents(), "Short-lived thread span") == 2000);
+	// Already written out, and the threads are gone
+	CHECK(countSpans(exportedEvents(), "Short-lived thread span") == 0);
+}
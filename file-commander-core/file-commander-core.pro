@@ -19,11 +19,20 @@ HEADERS += \
 	src/cfilesystemobject.h \
 	src/ccontroller.h \
 	src/fileoperationresultcode.h \
+	src/activitystate.h \
 	src/cpanel.h \
 	src/iconprovider/ciconprovider.h \
 	src/fileoperations/operationcodes.h \
 	src/fileoperations/coperationperformer.h \
 	src/fileoperations/cfileoperation.h \
+	src/fileoperations/cboundedqueue.hpp \
+	src/fileoperations/cattributechanger.h \
+	src/fileoperations/ccacheneutralcopier.h \
+	src/fileoperations/cdeltacopier.h \
+	src/fileoperations/chardlinktracker.h \
+	src/fileoperations/cratelimiter.h \
+	src/fileoperations/csyncplanner.h \
+	src/fileoperations/iopriority.h \
 	src/shell/cshell.h \
 	include/settings.h \
 	src/favoritelocationslist/cfavoritelocations.h \
@@ -31,6 +40,8 @@ HEADERS += \
 	src/iconprovider/ciconproviderimpl.h \
 	src/fasthash.h \
 	src/filesearchengine/cfilesearchengine.h \
+	src/filesearchengine/cnamematcher.h \
+	src/filesearchengine/cattributefilter.h \
 	src/directoryscanner.h \
 	src/diskenumerator/volumeinfo.hpp \
 	src/diskenumerator/cvolumeenumerator.h \
@@ -38,7 +49,18 @@ HEADERS += \
 	src/diskenumerator/volumeinfohelper.hpp \
 	src/cfilemanipulator.h \
 	src/filecomparator/cfilecomparator.h \
-	src/filesystemhelpers/filesystemhelpers.hpp
+	src/filesystemhelpers/filesystemhelpers.hpp \
+	src/parallelscanner/cparalleldirectoryscanner.h \
+	src/statistics/coccupiedspacecalculator.h \
+	src/hashing/cblake3hasher.h \
+	src/hashing/cxxhash64.h \
+	src/tracing/ctracer.h \
+	src/logging/casynclogger.h \
+	src/logging/cmpscqueue.hpp \
+	src/metrics/cmetricsregistry.h \
+	src/contentindex/ctrigramindex.h \
+	src/contentindex/ccontentindexer.h \
+	src/pruningrules/cpruningrules.h
 
 SOURCES += \
 	src/cfilesystemobject.cpp \
@@ -47,16 +69,35 @@ SOURCES += \
 	src/iconprovider/ciconprovider.cpp \
 	src/iconprovider/ciconproviderimpl.cpp \
 	src/fileoperations/coperationperformer.cpp \
+	src/fileoperations/cattributechanger.cpp \
+	src/fileoperations/ccacheneutralcopier.cpp \
+	src/fileoperations/cdeltacopier.cpp \
+	src/fileoperations/chardlinktracker.cpp \
+	src/fileoperations/cratelimiter.cpp \
+	src/fileoperations/csyncplanner.cpp \
+	src/fileoperations/iopriority.cpp \
 	src/shell/cshell.cpp \
 	src/favoritelocationslist/cfavoritelocations.cpp \
 	src/fasthash.c \
 	src/filesearchengine/cfilesearchengine.cpp \
+	src/filesearchengine/cnamematcher.cpp \
+	src/filesearchengine/cattributefilter.cpp \
 	src/directoryscanner.cpp \
 	src/diskenumerator/cvolumeenumerator.cpp \
 	src/filesystemwatcher/cfilesystemwatcher.cpp \
 	src/cfilemanipulator.cpp \
 	src/filecomparator/cfilecomparator.cpp \
-	src/filesystemhelpers/filesystemhelpers.cpp
+	src/filesystemhelpers/filesystemhelpers.cpp \
+	src/parallelscanner/cparalleldirectoryscanner.cpp \
+	src/statistics/coccupiedspacecalculator.cpp \
+	src/hashing/cblake3hasher.cpp \
+	src/hashing/cxxhash64.cpp \
+	src/tracing/ctracer.cpp \
+	src/logging/casynclogger.cpp \
+	src/metrics/cmetricsregistry.cpp \
+	src/contentindex/ctrigramindex.cpp \
+	src/contentindex/ccontentindexer.cpp \
+	src/pruningrules/cpruningrules.cpp
 
 win*{
 	SOURCES += \
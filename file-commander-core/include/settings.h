@@ -41,6 +41,11 @@ constexpr const char* KEY_INTERFACE_STYLE_SHEET = "Interface/Style/StylesheetTex
 
 // Operations
 constexpr const char* KEY_OPERATIONS_ASK_FOR_COPY_MOVE_CONFIRMATION = "Operations/CopyMove/AskForConfirmation";
+constexpr const char* KEY_OPERATIONS_CACHE_NEUTRAL_COPYING = "Operations/CopyMove/CacheNeutralCopying";
+constexpr const char* KEY_OPERATIONS_PRESERVE_LINKS = "Operations/CopyMove/PreserveLinks";
+constexpr const char* KEY_OPERATIONS_DELTA_TRANSFER = "Operations/CopyMove/DeltaTransfer";
+constexpr const char* KEY_OPERATIONS_SYNC_DELETE_EXTRANEOUS = "Operations/Sync/DeleteExtraneous";
+constexpr const char* KEY_OPERATIONS_SYNC_COMPARE_CONTENTS = "Operations/Sync/CompareContents";
 
 // Editing
 constexpr const char* KEY_EDITOR_PATH = "Edit/EditorProgramPath";
@@ -48,3 +53,10 @@ constexpr const char* KEY_EDITOR_PATH = "Edit/EditorProgramPath";
 // Other
 constexpr const char* KEY_OTHER_SHELL_COMMAND_NAME = "Other/Shell/ShellCommandName";
 constexpr const char* KEY_OTHER_CHECK_FOR_UPDATES_AUTOMATICALLY = "Other/UpdateChecking/CheckAutomatically";
+constexpr const char* KEY_OTHER_CONTENT_INDEX_ENABLED = "Other/ContentIndex/Enabled";
+constexpr const char* KEY_OTHER_CONTENT_INDEX_FOLDERS = "Other/ContentIndex/Folders";
+constexpr const char* KEY_OTHER_CONTENT_INDEX_MAX_FILE_SIZE_MB = "Other/ContentIndex/MaxFileSizeMb";
+constexpr int CONTENT_INDEX_MAX_FILE_SIZE_MB_DEFAULT = 16;
+constexpr const char* KEY_OTHER_SCAN_EXCLUSION_PATTERNS = "Other/Scanning/ExclusionPatterns";
+constexpr const char* KEY_OTHER_SCAN_SAME_FILE_SYSTEM_ONLY = "Other/Scanning/SameFileSystemOnly";
+constexpr const char* KEY_OTHER_SCAN_SKIP_SYSTEM_ITEMS = "Other/Scanning/SkipSystemItems";
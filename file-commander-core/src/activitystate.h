@@ -0,0 +1,10 @@
+#pragma once
+
+// How much of the application the user can see, which decides how eagerly the core polls the file system.
+// Foreground: the application is active. Background: the main window is visible, but another application has the focus.
+// Suspended: the main window is minimized or hidden; nothing is polled, and what is shown gets revalidated once it's back.
+enum class ActivityState {
+	Foreground,
+	Background,
+	Suspended
+};
@@ -5,6 +5,7 @@
 #include "pluginengine/cpluginengine.h"
 #include "filesystemhelperfunctions.h"
 #include "iconprovider/ciconprovider.h"
+#include "tracing/ctracer.h"
 
 #include "system/ctimeelapsed.h"
 
@@ -13,6 +14,8 @@ DISABLE_COMPILER_WARNINGS
 #include <QClipboard>
 #include <QDebug>
 #include <QDesktopServices>
+#include <QDir>
+#include <QStandardPaths>
 #include <QUrl>
 RESTORE_COMPILER_WARNINGS
 
@@ -22,6 +25,7 @@ CController* CController::_instance = nullptr;
 
 CController::CController() :
 	_favoriteLocations{KEY_FAVORITES},
+	_contentIndexer{QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/content-index.bin"},
 	_fileSearchEngine{*this},
 	_leftPanel{LeftPanel},
 	_rightPanel{RightPanel},
@@ -36,12 +40,31 @@ CController::CController() :
 	_leftPanel.addPanelContentsChangedListener(&CPluginEngine::get());
 	_rightPanel.addPanelContentsChangedListener(&CPluginEngine::get());
 
+	_pluginProxy.setNavigationImplementation([this](PanelPosition pluginPanel, const QString& path) {
+		CPanel& targetPanel = panel(pluginPanel == PluginLeftPanel ? LeftPanel : RightPanel);
+		const CFileSystemObject item(path);
+		if (item.isDir())
+			targetPanel.setPath(item.fullAbsolutePath(), refreshCauseOther);
+		else
+			targetPanel.goToItem(item);
+	});
+
 	// Manual update for the CPanels to get the volumes list
 	_volumeEnumerator.updateSynchronously();
 
 	_leftPanel.restoreFromSettings();
 	_rightPanel.restoreFromSettings();
 
+	// The changes the panels' watchers detect in the indexed folders are picked up right away rather than on the next rescan
+	for (CPanel* p : {&_leftPanel, &_rightPanel})
+	{
+		p->addChangedItemsListener([this](const std::vector<QString>& paths) {
+			_contentIndexer.filesChanged(paths);
+		});
+	}
+
+	applyContentIndexSettings();
+
 	_volumeEnumerator.startEnumeratorThread();
 }
 
@@ -72,9 +95,12 @@ void CController::setVolumesChangedListener(CController::IVolumeListObserver *li
 
 void CController::uiThreadTimerTick()
 {
+	TRACE_SCOPE("CController::uiThreadTimerTick");
+
 	_leftPanel.uiThreadTimerTick();
 	_rightPanel.uiThreadTimerTick();
 
+	TRACE_SCOPE("Executing the UI queue");
 	_uiQueue.exec(CExecutionQueue::execAll);
 }
 
@@ -146,6 +172,7 @@ bool CController::switchToVolume(Panel p, size_t index)
 void CController::settingsChanged()
 {
 	CIconProvider::settingsChanged();
+	applyContentIndexSettings();
 }
 
 void CController::activePanelChanged(Panel p)
@@ -153,6 +180,25 @@ void CController::activePanelChanged(Panel p)
 	_activePanel = p;
 }
 
+void CController::setActivityState(ActivityState state)
+{
+	if (state == _activityState)
+		return;
+
+	static const char* stateNames[] {"foreground", "background", "suspended"};
+	qInfo() << "Activity state:" << stateNames[static_cast<int>(_activityState)] << "->" << stateNames[static_cast<int>(state)];
+	_activityState = state;
+
+	_leftPanel.setActivityState(state);
+	_rightPanel.setActivityState(state);
+	_volumeEnumerator.setActivityState(state);
+}
+
+ActivityState CController::activityState() const
+{
+	return _activityState;
+}
+
 // Navigates specified panel up the directory tree
 void CController::navigateUp(Panel p)
 {
@@ -473,6 +519,11 @@ CFileSearchEngine& CController::fileSearchEngine()
 	return _fileSearchEngine;
 }
 
+CContentIndexer& CController::contentIndexer()
+{
+	return _contentIndexer;
+}
+
 // Returns hash of an item that was the last selected in the specified dir
 qulonglong CController::currentItemHashForFolder(Panel p, const QString &dir) const
 {
@@ -515,3 +566,17 @@ void CController::saveDirectoryForCurrentVolume(Panel p)
 	const QString drivePath = _volumeEnumerator.drives().at(*currentVolume).rootObjectInfo.fullAbsolutePath();
 	CSettings().setValue(p == LeftPanel ? QString{KEY_LAST_PATH_FOR_DRIVE_L}.arg(drivePath.toHtmlEscaped()) : QString{KEY_LAST_PATH_FOR_DRIVE_R}.arg(drivePath.toHtmlEscaped()), path.fullAbsolutePath());
 }
+
+void CController::applyContentIndexSettings()
+{
+	CSettings s;
+	if (!s.value(KEY_OTHER_CONTENT_INDEX_ENABLED, false).toBool())
+	{
+		_contentIndexer.configure({}, 0);
+		return;
+	}
+
+	QDir().mkpath(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+	const uint64_t maxFileSizeMb = s.value(KEY_OTHER_CONTENT_INDEX_MAX_FILE_SIZE_MB, CONTENT_INDEX_MAX_FILE_SIZE_MB_DEFAULT).toULongLong();
+	_contentIndexer.configure(s.value(KEY_OTHER_CONTENT_INDEX_FOLDERS).toStringList(), maxFileSizeMb * 1024 * 1024);
+}
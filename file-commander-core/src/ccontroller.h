@@ -6,6 +6,7 @@
 #include "plugininterface/cpluginproxy.h"
 #include "favoritelocationslist/cfavoritelocations.h"
 #include "filesearchengine/cfilesearchengine.h"
+#include "contentindex/ccontentindexer.h"
 
 #include <functional>
 #include <optional>
@@ -48,6 +49,9 @@ public:
 	void settingsChanged();
 	// Focus is set to a panel
 	void activePanelChanged(Panel p);
+	// The main window has been minimized, restored, activated or deactivated: the panels and the volume list are watched accordingly
+	void setActivityState(ActivityState state);
+	ActivityState activityState() const;
 
 // Operations
 	// Navigates specified panel up the directory tree
@@ -110,6 +114,7 @@ public:
 
 	CFavoriteLocations& favoriteLocations();
 	CFileSearchEngine& fileSearchEngine();
+	CContentIndexer& contentIndexer();
 
 	// Returns hash of an item that was the last selected in the specified dir
 	qulonglong currentItemHashForFolder(Panel p, const QString& dir) const;
@@ -120,10 +125,12 @@ private:
 	void volumesChanged(bool drivesListOrReadinessChanged) noexcept override;
 
 	void saveDirectoryForCurrentVolume(Panel p);
+	void applyContentIndexSettings();
 
 private:
 	static CController * _instance;
 	CFavoriteLocations   _favoriteLocations;
+	CContentIndexer      _contentIndexer;
 	CFileSearchEngine    _fileSearchEngine;
 	CPanel               _leftPanel;
 	CPanel               _rightPanel;
@@ -131,6 +138,7 @@ private:
 	CVolumeEnumerator    _volumeEnumerator;
 	std::vector<IVolumeListObserver*> _volumesChangedListeners;
 	Panel                _activePanel = UnknownPanel;
+	ActivityState        _activityState = ActivityState::Foreground;
 
 	CWorkerThreadPool _workerThreadPool; // The thread used to execute tasks out of the UI thread
 	CExecutionQueue   _uiQueue;      // The queue for actions that must be executed on the UI thread
@@ -1,6 +1,8 @@
 #include "cfilemanipulator.h"
 #include "filesystemhelperfunctions.h"
 #include "assert/advanced_assert.h"
+#include "tracing/ctracer.h"
+#include "metrics/cmetricsregistry.h"
 
 DISABLE_COMPILER_WARNINGS
 #include <QDebug>
@@ -17,6 +19,14 @@ RESTORE_COMPILER_WARNINGS
 #include <unistd.h>
 #endif
 
+#include <errno.h>
+
+static CMetricCounter& ioOperationsCounter()
+{
+	static CMetricCounter& counter = CMetricsRegistry::instance().counter(Metrics::IoOperations);
+	return counter;
+}
+
 static constexpr QFileDevice::FileTime supportedFileTimeTypes[] {
 	QFileDevice::FileAccessTime,
 #ifndef __linux__
@@ -120,6 +130,8 @@ FileOperationResultCode CFileManipulator::moveAtomically(const CFileSystemObject
 // Requests copying the next (or the first if copyOperationInProgress() returns false) chunk of the file.
 FileOperationResultCode CFileManipulator::copyChunk(size_t chunkSize, const QString& destFolder, const QString& newName /*= QString()*/, const bool transferPermissions, const bool transferDates)
 {
+	TRACE_SCOPE("CFileManipulator::copyChunk");
+
 	assert_debug_only(bool(_thisFile) == bool(_destFile));
 	assert_debug_only(_object.isFile());
 	assert_debug_only(QFileInfo(destFolder).isDir());
@@ -127,33 +139,45 @@ FileOperationResultCode CFileManipulator::copyChunk(size_t chunkSize, const QStr
 	if (!copyOperationInProgress())
 	{
 		_pos = 0;
+		_bytesSkipped = 0;
+		_deltaTransferUsed = false;
 
 		// Creating files
 		_thisFile = std::make_unique<QFile>(_object.fullAbsolutePath());
 		_destFile = std::make_unique<QFile>(destFolder + (newName.isEmpty() ? _object.fullName() : newName));
 
+		// Must be checked before the destination is opened, which creates it
+		const QFileInfo existingDestInfo(_destFile->fileName());
+		const bool updateInPlace = _deltaTransfer && CDeltaCopier::supported() && existingDestInfo.isFile() && existingDestInfo.size() > 0 && _object.size() >= CDeltaCopier::MinFileSize;
+
 		for (const auto fileTimeType: supportedFileTimeTypes)
 			_sourceFileTime[fileTimeType] = _thisFile->fileTime(fileTimeType);
 
 		// Initializing - opening files
-		if (!_thisFile->open(QFile::ReadOnly))
 		{
-			_lastErrorMessage = _thisFile->errorString();
+			static CLatencyHistogram& openLatency = CMetricsRegistry::instance().histogram(Metrics::FileOpenLatency);
+			const CScopedLatency openLatencyMeasurement(openLatency);
+			ioOperationsCounter().add(2);
 
-			_thisFile.reset();
-			_destFile.reset();
+			if (!_thisFile->open(QFile::ReadOnly))
+			{
+				_lastErrorMessage = _thisFile->errorString();
 
-			return FileOperationResultCode::Fail;
-		}
+				_thisFile.reset();
+				_destFile.reset();
 
-		if (!_destFile->open(QFile::ReadWrite))
-		{
-			_lastErrorMessage = _destFile->errorString();
+				return FileOperationResultCode::Fail;
+			}
 
-			_thisFile.reset();
-			_destFile.reset();
+			if (!_destFile->open(QFile::ReadWrite))
+			{
+				_lastErrorMessage = _destFile->errorString();
 
-			return FileOperationResultCode::Fail;
+				_thisFile.reset();
+				_destFile.reset();
+
+				return FileOperationResultCode::Fail;
+			}
 		}
 
 		if (!_destFile->resize(_object.size()))
@@ -168,6 +192,40 @@ FileOperationResultCode CFileManipulator::copyChunk(size_t chunkSize, const QStr
 			return FileOperationResultCode::NotEnoughSpaceAvailable;
 		}
 
+		if (updateInPlace)
+		{
+			_deltaTransferUsed = true;
+			_deltaCopier = std::make_unique<CDeltaCopier>();
+			if (!_deltaCopier->open(_thisFile->fileName(), _destFile->fileName(), _object.size()))
+			{
+				_lastErrorMessage = _deltaCopier->lastErrorMessage();
+				_deltaCopier.reset();
+				_destFile->close();
+				assert_r(_destFile->remove());
+
+				_thisFile.reset();
+				_destFile.reset();
+
+				return FileOperationResultCode::Fail;
+			}
+		}
+		else if (_cacheNeutralCopying && CCacheNeutralCopier::supported())
+		{
+			_cacheNeutralCopier = std::make_unique<CCacheNeutralCopier>();
+			if (!_cacheNeutralCopier->open(_thisFile->fileName(), _destFile->fileName(), _object.size()))
+			{
+				_lastErrorMessage = _cacheNeutralCopier->lastErrorMessage();
+				_cacheNeutralCopier.reset();
+				_destFile->close();
+				assert_r(_destFile->remove());
+
+				_thisFile.reset();
+				_destFile.reset();
+
+				return FileOperationResultCode::Fail;
+			}
+		}
+
 		// Store the original file's attributes to later mirror them onto the copy
 
 	}
@@ -175,8 +233,31 @@ FileOperationResultCode CFileManipulator::copyChunk(size_t chunkSize, const QStr
 	assert_r(_destFile->isOpen() == _thisFile->isOpen());
 
 	const auto actualChunkSize = std::min(chunkSize, (size_t)(_object.size() - _pos));
-
 	if (actualChunkSize != 0)
+		ioOperationsCounter().add();
+
+	if (actualChunkSize != 0 && _deltaCopier)
+	{
+		if (!_deltaCopier->update(_pos, actualChunkSize))
+		{
+			_lastErrorMessage = _deltaCopier->lastErrorMessage();
+			return FileOperationResultCode::Fail;
+		}
+
+		_pos += actualChunkSize;
+		_bytesSkipped = _deltaCopier->bytesSkipped();
+	}
+	else if (actualChunkSize != 0 && _cacheNeutralCopier)
+	{
+		if (!_cacheNeutralCopier->copy(_pos, actualChunkSize))
+		{
+			_lastErrorMessage = _cacheNeutralCopier->lastErrorMessage();
+			return FileOperationResultCode::Fail;
+		}
+
+		_pos += actualChunkSize;
+	}
+	else if (actualChunkSize != 0)
 	{
 		const auto src = _thisFile->map(_pos, actualChunkSize);
 		if (!src)
@@ -203,6 +284,33 @@ FileOperationResultCode CFileManipulator::copyChunk(size_t chunkSize, const QStr
 	if (actualChunkSize < chunkSize)
 	{
 		// Copying complete
+		// Both the cache-neutral and the delta copier flush the data to the disk when finishing
+		static CLatencyHistogram& fsyncLatency = CMetricsRegistry::instance().histogram(Metrics::FileFsyncLatency);
+		if (_cacheNeutralCopier)
+		{
+			const CScopedLatency fsyncLatencyMeasurement(fsyncLatency);
+			// Must be done before the file times are set
+			if (!_cacheNeutralCopier->finish())
+			{
+				_lastErrorMessage = _cacheNeutralCopier->lastErrorMessage();
+				return FileOperationResultCode::Fail;
+			}
+
+			_cacheNeutralCopier.reset();
+		}
+		else if (_deltaCopier)
+		{
+			const CScopedLatency fsyncLatencyMeasurement(fsyncLatency);
+			// Verifies the data written, and must also be done before the file times are set
+			if (!_deltaCopier->finish())
+			{
+				_lastErrorMessage = _deltaCopier->lastErrorMessage();
+				return FileOperationResultCode::Fail;
+			}
+
+			_deltaCopier.reset();
+		}
+
 		if (transferPermissions)
 			_lastErrorMessage = copyPermissions(*_thisFile, *_destFile);
 
@@ -254,6 +362,8 @@ FileOperationResultCode CFileManipulator::cancelCopy()
 	if (!copyOperationInProgress())
 		return FileOperationResultCode::Ok;
 
+	_cacheNeutralCopier.reset();
+	_deltaCopier.reset();
 	_thisFile->close();
 	_destFile->close();
 
@@ -263,6 +373,26 @@ FileOperationResultCode CFileManipulator::cancelCopy()
 	return succ ? FileOperationResultCode::Ok : FileOperationResultCode::Fail;
 }
 
+void CFileManipulator::setCacheNeutralCopying(bool cacheNeutral)
+{
+	_cacheNeutralCopying = cacheNeutral;
+}
+
+void CFileManipulator::setDeltaTransfer(bool deltaTransfer)
+{
+	_deltaTransfer = deltaTransfer;
+}
+
+bool CFileManipulator::deltaTransferUsed() const
+{
+	return _deltaTransferUsed;
+}
+
+uint64_t CFileManipulator::bytesSkipped() const
+{
+	return _bytesSkipped;
+}
+
 bool CFileManipulator::makeWritable(bool writable)
 {
 	assert_and_return_message_r(_object.isFile(), "This method only works for files", false);
@@ -312,9 +442,18 @@ FileOperationResultCode CFileManipulator::remove()
 {
 	assert_and_return_message_r(_object.exists(), "Object doesn't exist", FileOperationResultCode::ObjectDoesntExist);
 
-	if (_object.isFile())
+	static CLatencyHistogram& unlinkLatency = CMetricsRegistry::instance().histogram(Metrics::FileUnlinkLatency);
+	const CScopedLatency unlinkLatencyMeasurement(unlinkLatency);
+	ioOperationsCounter().add();
+
+	// A link is removed by itself, never the object it points to
+	if (_object.isFile() || _object.isSymLink())
 	{
-		QFile file(_object.fullAbsolutePath());
+		QString path = _object.fullAbsolutePath();
+		if (path.endsWith('/')) // A link to a folder
+			path.chop(1);
+
+		QFile file(path);
 		if (file.remove())
 			return FileOperationResultCode::Ok;
 		else
@@ -350,6 +489,111 @@ FileOperationResultCode CFileManipulator::remove(const CFileSystemObject& object
 	return CFileManipulator(object).remove();
 }
 
+#ifndef _WIN32
+// The caller has already got the user's consent to overwrite the destination. Folders are never replaced.
+static bool removeExistingLinkDestination(const QByteArray& path)
+{
+	struct stat info;
+	if (::lstat(path.constData(), &info) != 0)
+		return errno == ENOENT;
+
+	if (S_ISDIR(info.st_mode))
+	{
+		errno = EISDIR;
+		return false;
+	}
+
+	return ::unlink(path.constData()) == 0;
+}
+#endif
+
+// QFileInfo::symLinkTarget() resolves the target to an absolute path, the original form has to be read directly
+QByteArray CFileManipulator::storedSymLinkTarget(const QString& linkPath, int* error)
+{
+#ifndef _WIN32
+	QString path = linkPath;
+	if (path.endsWith('/')) // A link to a folder is treated as a folder
+		path.chop(1);
+
+	QByteArray target(4096, Qt::Uninitialized);
+	for (;;)
+	{
+		const ssize_t length = ::readlink(QFile::encodeName(path).constData(), target.data(), static_cast<size_t>(target.size()));
+		if (length < 0)
+		{
+			// Has to be captured right away, freeing the temporaries may change errno
+			if (error)
+				*error = errno;
+			return {};
+		}
+		else if (length < target.size())
+		{
+			target.truncate(static_cast<int>(length));
+			return target;
+		}
+
+		// The target may have been truncated
+		target.resize(target.size() * 2);
+	}
+#else
+	(void)linkPath;
+	if (error)
+		*error = ENOSYS;
+	return {};
+#endif
+}
+
+FileOperationResultCode CFileManipulator::copySymLink(const QString& destFolder, const QString& newName)
+{
+	assert_and_return_r(_object.isSymLink(), FileOperationResultCode::Fail);
+
+#ifndef _WIN32
+	int readError = 0;
+	const QByteArray target = storedSymLinkTarget(_object.fullAbsolutePath(), &readError);
+	if (target.isEmpty())
+	{
+		_lastErrorMessage = QString::fromLocal8Bit(::strerror(readError != 0 ? readError : EINVAL));
+		return FileOperationResultCode::Fail;
+	}
+
+	const QByteArray destPath = QFile::encodeName(destFolder + (newName.isEmpty() ? _object.fullName() : newName));
+	if (!removeExistingLinkDestination(destPath) || ::symlink(target.constData(), destPath.constData()) != 0)
+	{
+		const int error = errno;
+		_lastErrorMessage = QString::fromLocal8Bit(::strerror(error));
+		return error == EEXIST ? FileOperationResultCode::TargetAlreadyExists : FileOperationResultCode::Fail;
+	}
+
+	return FileOperationResultCode::Ok;
+#else
+	(void)destFolder;
+	(void)newName;
+	_lastErrorMessage = QStringLiteral("Copying links is not supported on this platform");
+	return FileOperationResultCode::Fail;
+#endif
+}
+
+FileOperationResultCode CFileManipulator::createHardLink(const QString& existingFilePath, const QString& destFolder, const QString& newName)
+{
+#ifndef _WIN32
+	const QByteArray destPath = QFile::encodeName(destFolder + (newName.isEmpty() ? _object.fullName() : newName));
+	if (!removeExistingLinkDestination(destPath) || ::link(QFile::encodeName(existingFilePath).constData(), destPath.constData()) != 0)
+	{
+		const int error = errno;
+		_lastErrorMessage = QString::fromLocal8Bit(::strerror(error));
+		return error == EEXIST ? FileOperationResultCode::TargetAlreadyExists : FileOperationResultCode::Fail;
+	}
+
+	return FileOperationResultCode::Ok;
+#else
+	(void)existingFilePath;
+	(void)destFolder;
+	(void)newName;
+	_lastErrorMessage = QStringLiteral("Creating hard links is not supported on this platform");
+	return FileOperationResultCode::Fail;
+#endif
+}
+
 QString CFileManipulator::lastErrorMessage() const
 {
 	return _lastErrorMessage;
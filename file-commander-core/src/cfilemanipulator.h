@@ -1,6 +1,8 @@
 #pragma once
 
 #include "fileoperationresultcode.h"
+#include "fileoperations/ccacheneutralcopier.h"
+#include "fileoperations/cdeltacopier.h"
 #include "cfilesystemobject.h"
 #include "compiler/compiler_warnings_control.h"
 
@@ -33,6 +35,14 @@ public:
 	static bool makeWritable(const CFileSystemObject& object, bool writable = true);
 	static FileOperationResultCode remove(const CFileSystemObject& object);
 
+// Link-preserving copy (not supported on Windows)
+	// Creates a symbolic link at the destination with the same target as this one; relative targets stay relative. The link is not followed.
+	FileOperationResultCode copySymLink(const QString& destFolder, const QString& newName = QString());
+	// Creates the destination as a hard link to 'existingFilePath' instead of copying this file's contents
+	FileOperationResultCode createHardLink(const QString& existingFilePath, const QString& destFolder, const QString& newName = QString());
+	// The target of a symbolic link exactly as stored in the link, without resolving it. Empty on failure, with the errno value stored in 'error'.
+	static QByteArray storedSymLinkTarget(const QString& linkPath, int* error = nullptr);
+
 // Non-blocking file copy API
 	// Requests copying the next (or the first if copyOperationInProgress() returns false) chunk of the file.
 	FileOperationResultCode copyChunk(size_t chunkSize, const QString& destFolder, const QString& newName = QString(), bool transferPermissions = true, bool transferDates = true);
@@ -41,6 +51,17 @@ public:
 	uint64_t bytesCopied() const;
 	FileOperationResultCode cancelCopy();
 
+	// Keeps the copied data out of the OS page cache (see CCacheNeutralCopier) so that copying huge amounts of data doesn't evict everything else.
+	// Only takes effect for the copy operations started after the call. Has no effect on the platforms that don't support it.
+	void setCacheNeutralCopying(bool cacheNeutral);
+	// When overwriting an existing file of at least CDeltaCopier::MinFileSize, only write the blocks that differ (see CDeltaCopier).
+	// Takes precedence over cache-neutral copying. Only takes effect for the copy operations started after the call, has no effect where not supported.
+	void setDeltaTransfer(bool deltaTransfer);
+	// Whether the current or the last copy operation updates the destination by delta transfer
+	bool deltaTransferUsed() const;
+	// How much of the data copied so far by delta transfer was already identical at the destination and didn't need writing
+	uint64_t bytesSkipped() const;
+
 // State
 	QString lastErrorMessage() const;
 
@@ -55,6 +76,12 @@ private:
 	std::array<QDateTime, 4> _sourceFileTime;
 	std::unique_ptr<QFile> _thisFile;
 	std::unique_ptr<QFile> _destFile;
+	std::unique_ptr<CCacheNeutralCopier> _cacheNeutralCopier;
+	bool                   _cacheNeutralCopying = false;
+	std::unique_ptr<CDeltaCopier> _deltaCopier;
+	bool                   _deltaTransfer = false;
+	bool                   _deltaTransferUsed = false;
 	uint64_t               _pos = 0;
+	uint64_t               _bytesSkipped = 0;
 	mutable QString        _lastErrorMessage;
 };
@@ -80,6 +80,21 @@ CFileSystemObject::CFileSystemObject(const QString& path) : _fileInfo(expandEnvi
 	refreshInfo();
 }
 
+CFileSystemObject::CFileSystemObject(const QString& path, FileSystemObjectType type) : _fileInfo(path)
+{
+	assert_r(type != UnknownType);
+
+	// absoluteFilePath() and the name-related QFileInfo methods only work with the path string
+	_properties.exists = true;
+	_properties.metadataPending = true;
+	_properties.type = type;
+	_properties.fullPath = _fileInfo.absoluteFilePath();
+	if (type != File && !_properties.fullPath.endsWith('/'))
+		_properties.fullPath.append('/');
+
+	refreshNameProperties();
+}
+
 static QString parentForAbsolutePath(QString absolutePath)
 {
 	if (absolutePath.endsWith('/'))
@@ -104,6 +119,7 @@ void CFileSystemObject::refreshInfo()
 	// TODO: is this always correct?
 	// Should there be a special "Symlink" object type? Then it could be handled properly (e. g. delete = unlink)
 	_properties.exists = !_fileInfo.isSymLink() ? _fileInfo.exists() : true;
+	_properties.metadataPending = false;
 
 	_properties.fullPath = _fileInfo.absoluteFilePath();
 
@@ -138,6 +154,18 @@ void CFileSystemObject::refreshInfo()
 #endif
 	}
 
+	refreshNameProperties();
+
+	if (!_properties.exists)
+		return;
+
+	_properties.creationDate = (time_t) _fileInfo.birthTime().toTime_t();
+	_properties.modificationDate = _fileInfo.lastModified().toTime_t();
+	_properties.size = _properties.type == File ? static_cast<uint64_t>(_fileInfo.size()) : 0ULL;
+}
+
+void CFileSystemObject::refreshNameProperties()
+{
 	_properties.hash = fasthash64(_properties.fullPath.constData(), static_cast<uint64_t>(_properties.fullPath.size()) * sizeof(QChar), 0);
 
 
@@ -173,13 +201,6 @@ void CFileSystemObject::refreshInfo()
 	_properties.isCdUp = _properties.fullName == QLatin1String("..");
 	// QFileInfo::canonicalPath() / QFileInfo::absolutePath are undefined for non-files
 	_properties.parentFolder = parentForAbsolutePath(_properties.fullPath);
-
-	if (!_properties.exists)
-		return;
-
-	_properties.creationDate = (time_t) _fileInfo.birthTime().toTime_t();
-	_properties.modificationDate = _fileInfo.lastModified().toTime_t();
-	_properties.size = _properties.type == File ? static_cast<uint64_t>(_fileInfo.size()) : 0ULL;
 }
 
 void CFileSystemObject::setPath(const QString& path)
@@ -40,6 +40,8 @@ struct CFileSystemObjectProperties {
 	FileSystemObjectType type = UnknownType;
 	bool isCdUp = false;
 	bool exists = false;
+	// Only the name and the type are known so far, the size and the dates are not
+	bool metadataPending = false;
 };
 
 class QIcon;
@@ -52,6 +54,8 @@ public:
 
 	explicit CFileSystemObject(const QFileInfo & fileInfo);
 	explicit CFileSystemObject(const QString& path);
+	// Doesn't query the file system: for the items just read from a folder whose metadata is yet to arrive
+	CFileSystemObject(const QString& path, FileSystemObjectType type);
 
 	inline explicit CFileSystemObject(const QDir& dir) : CFileSystemObject(QString(dir.absolutePath())) {}
 
@@ -109,6 +113,9 @@ public:
 	QString sizeString() const;
 	QString modificationDateString() const;
 
+private:
+	void refreshNameProperties();
+
 private:
 	CFileSystemObjectProperties _properties;
 	// Can be used to determine whether two objects are on the same drive
@@ -0,0 +1,373 @@
+#include "ccontentindexer.h"
+#include "cfilesystemobject.h"
+#include "directoryscanner.h"
+#include "fileoperations/iopriority.h"
+#include "assert/advanced_assert.h"
+#include "threading/thread_helpers.h"
+#include "tracing/ctracer.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+
+// Gives the application a chance to start up before the disk is scanned
+static constexpr auto InitialRescanDelay = std::chrono::seconds(15);
+static constexpr auto RescanPeriod = std::chrono::minutes(30);
+// A file with a zero byte in its beginning is considered binary
+static constexpr qint64 BinaryDetectionBlockSize = 8 * 1024;
+static constexpr qint64 ReadBlockSize = 256 * 1024;
+
+CContentIndexer::ContentFilter::ContentFilter(const CContentIndexer& indexer, const QString& query, bool wildcards) :
+	_indexer{indexer}
+{
+	std::shared_lock<std::shared_mutex> indexLocker(_indexer._indexMutex);
+	if (_indexer._index.empty())
+		return;
+
+	_candidates = _indexer._index.documentsContaining(CTrigramExtractor::queryTrigrams(query, wildcards));
+	_indexGeneration = _indexer._index.generation();
+	_nextDocumentId = _indexer._index.nextDocumentId();
+}
+
+bool CContentIndexer::ContentFilter::mayContain(const CFileSystemObject& file) const
+{
+	if (!_candidates)
+		return true;
+
+	const QString path = file.fullAbsolutePath();
+	const auto stamp = fileStamp(path);
+	if (!stamp)
+		return true;
+
+	CTrigramIndex::DocumentId id = 0;
+	{
+		std::shared_lock<std::shared_mutex> indexLocker(_indexer._indexMutex);
+		if (_indexer._index.generation() != _indexGeneration)
+			return true; // The IDs have been reassigned
+
+		const auto* document = _indexer._index.document(path, &id);
+		if (!document || !document->indexed || document->stamp != *stamp || id >= _nextDocumentId)
+			return true; // Not indexed, or changed since
+	}
+
+	return std::binary_search(_candidates->begin(), _candidates->end(), id);
+}
+
+CContentIndexer::CContentIndexer(QString indexFilePath) : _indexFilePath{std::move(indexFilePath)}
+{
+}
+
+CContentIndexer::~CContentIndexer()
+{
+	stopThread();
+}
+
+void CContentIndexer::configure(QStringList roots, uint64_t maxFileSize)
+{
+	for (QString& root : roots)
+		root = CFileSystemObject(root).fullAbsolutePath();
+
+	roots.removeAll(QString());
+	roots.removeDuplicates();
+
+	if (roots.empty())
+	{
+		stopThread();
+
+		{
+			std::lock_guard<std::shared_mutex> indexLocker(_indexMutex);
+			_index.clear();
+			_indexModified = false;
+		}
+
+		QFile::remove(_indexFilePath);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> locker(_mutex);
+		if (roots == _roots && maxFileSize == _maxFileSize && _thread.joinable())
+			return;
+
+		_roots = roots;
+		_maxFileSize = maxFileSize;
+		// On startup, the initial rescan is delayed; a reconfiguration calls for an immediate one
+		_rescanRequested = _thread.joinable();
+	}
+
+	if (!_thread.joinable())
+	{
+		_stopRequested = false;
+		_abortRescan = false;
+		_thread = std::thread(&CContentIndexer::threadFunc, this);
+	}
+	else
+	{
+		_abortRescan = true;
+		_wakeUp.notify_one();
+	}
+}
+
+void CContentIndexer::filesChanged(const std::vector<QString>& paths)
+{
+	if (paths.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> locker(_mutex);
+		if (!_thread.joinable())
+			return;
+
+		for (const QString& path : paths)
+		{
+			const bool underRoots = std::any_of(_roots.cbegin(), _roots.cend(), [&path](const QString& root) {
+				return isSameOrParentFolder(root, path);
+			});
+
+			if (underRoots)
+				_changedFiles.push_back(path);
+		}
+	}
+
+	_wakeUp.notify_one();
+}
+
+CContentIndexer::ContentFilter CContentIndexer::contentFilter(const QString& query, bool wildcards) const
+{
+	return ContentFilter(*this, query, wildcards);
+}
+
+void CContentIndexer::threadFunc()
+{
+	setThreadName("Content indexer thread");
+	setCurrentThreadIoPriority(IoPriority::Idle);
+
+	{
+		std::lock_guard<std::shared_mutex> indexLocker(_indexMutex);
+		if (!_index.load(_indexFilePath) && QFile::exists(_indexFilePath))
+			qInfo() << "The content index at" << _indexFilePath << "is damaged or outdated, rebuilding";
+	}
+
+	auto nextRescanTime = std::chrono::steady_clock::now() + InitialRescanDelay;
+	while (!_stopRequested)
+	{
+		std::vector<QString> changedFiles;
+		QStringList roots;
+		uint64_t maxFileSize = 0;
+		bool rescanDue = false;
+
+		{
+			std::unique_lock<std::mutex> locker(_mutex);
+			_wakeUp.wait_until(locker, nextRescanTime, [this] {
+				return _stopRequested || _rescanRequested || !_changedFiles.empty();
+			});
+
+			if (_stopRequested)
+				break;
+
+			changedFiles.swap(_changedFiles);
+			roots = _roots;
+			maxFileSize = _maxFileSize;
+			rescanDue = _rescanRequested || std::chrono::steady_clock::now() >= nextRescanTime;
+			_rescanRequested = false;
+			_abortRescan = false;
+		}
+
+		for (const QString& path : changedFiles)
+		{
+			if (_stopRequested)
+				break;
+
+			updateFile(CFileSystemObject(path), maxFileSize);
+		}
+
+		if (rescanDue)
+		{
+			rescan(roots, maxFileSize);
+			nextRescanTime = std::chrono::steady_clock::now() + RescanPeriod;
+		}
+
+		if (_indexModified)
+			save();
+	}
+
+	if (_indexModified)
+		save();
+}
+
+void CContentIndexer::stopThread()
+{
+	if (!_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> locker(_mutex);
+		_stopRequested = true;
+		_abortRescan = true;
+	}
+
+	_wakeUp.notify_one();
+	_thread.join();
+
+	std::lock_guard<std::mutex> locker(_mutex);
+	_roots.clear();
+	_changedFiles.clear();
+	_rescanRequested = false;
+}
+
+void CContentIndexer::rescan(const QStringList& roots, uint64_t maxFileSize)
+{
+	TRACE_SCOPE("CContentIndexer::rescan");
+
+	QSet<QString> filesFound;
+	for (const QString& root : roots)
+	{
+		scanDirectory(CFileSystemObject(root), [&](const CFileSystemObject& item) {
+			if (!item.isFile())
+				return;
+
+			filesFound.insert(item.fullAbsolutePath());
+			updateFile(item, maxFileSize);
+		}, _abortRescan, false);
+	}
+
+	if (_abortRescan)
+		return;
+
+	// Forgetting the files that are gone, along with the files from the folders no longer indexed
+	std::vector<QString> filesGone;
+	{
+		std::shared_lock<std::shared_mutex> indexLocker(_indexMutex);
+		_index.forEachDocument([&](const CTrigramIndex::Document& document) {
+			if (!filesFound.contains(document.path))
+				filesGone.push_back(document.path);
+		});
+	}
+
+	std::lock_guard<std::shared_mutex> indexLocker(_indexMutex);
+	for (const QString& path : filesGone)
+		_index.removeDocument(path);
+
+	if (!filesGone.empty())
+		_indexModified = true;
+
+	if (_index.compactionRecommended())
+		_index.compact();
+}
+
+void CContentIndexer::updateFile(const CFileSystemObject& file, uint64_t maxFileSize)
+{
+	const QString path = file.fullAbsolutePath();
+	const auto stamp = file.exists() && file.isFile() ? fileStamp(path) : std::nullopt;
+	if (!stamp)
+	{
+		std::lock_guard<std::shared_mutex> indexLocker(_indexMutex);
+		if (_index.document(path))
+		{
+			_index.removeDocument(path);
+			_indexModified = true;
+		}
+
+		return;
+	}
+
+	{
+		std::shared_lock<std::shared_mutex> indexLocker(_indexMutex);
+		const auto* document = _index.document(path);
+		if (document && document->stamp == *stamp)
+			return;
+	}
+
+	QFile f(path);
+	if (stamp->size > maxFileSize || !f.open(QFile::ReadOnly))
+	{
+		std::lock_guard<std::shared_mutex> indexLocker(_indexMutex);
+		_index.addUnindexedDocument(path, *stamp);
+		_indexModified = true;
+		return;
+	}
+
+	bool binary = false;
+	for (qint64 offset = 0; !_abortRescan; )
+	{
+		const QByteArray block = f.read(ReadBlockSize);
+		if (block.isEmpty())
+			break;
+
+		if (offset == 0 && block.left(static_cast<int>(BinaryDetectionBlockSize)).contains('\0'))
+		{
+			binary = true;
+			break;
+		}
+
+		_extractor.add(block.constData(), static_cast<size_t>(block.size()));
+		offset += block.size();
+	}
+
+	// Must be called even if the file is not going to be indexed, to reset the extractor
+	const auto trigrams = _extractor.takeTrigrams();
+	if (_abortRescan)
+		return;
+
+	std::lock_guard<std::shared_mutex> indexLocker(_indexMutex);
+	if (binary)
+		_index.addUnindexedDocument(path, *stamp);
+	else
+		_index.addDocument(path, *stamp, trigrams);
+
+	_indexModified = true;
+}
+
+void CContentIndexer::save()
+{
+	TRACE_SCOPE("CContentIndexer::save");
+
+	std::shared_lock<std::shared_mutex> indexLocker(_indexMutex);
+	if (_index.save(_indexFilePath))
+		_indexModified = false;
+	else
+		qInfo() << "Failed to save the content index to" << _indexFilePath;
+}
+
+std::optional<CTrigramIndex::FileStamp> CContentIndexer::fileStamp(const QString& path)
+{
+	CTrigramIndex::FileStamp stamp;
+
+#ifndef _WIN32
+	struct stat st;
+	if (::stat(QFile::encodeName(path).constData(), &st) != 0)
+		return std::nullopt;
+
+	stamp.size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+	stamp.modificationTimeNs = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+	stamp.statusChangeTimeNs = static_cast<int64_t>(st.st_ctimespec.tv_sec) * 1000000000 + st.st_ctimespec.tv_nsec;
+#else
+	stamp.modificationTimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+	stamp.statusChangeTimeNs = static_cast<int64_t>(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+#endif
+	stamp.inode = static_cast<uint64_t>(st.st_ino);
+#else
+	// Millisecond resolution and no inode
+	const QFileInfo info(path);
+	if (!info.exists())
+		return std::nullopt;
+
+	stamp.size = static_cast<uint64_t>(info.size());
+	stamp.modificationTimeNs = info.lastModified().toMSecsSinceEpoch() * 1000000;
+	stamp.statusChangeTimeNs = info.metadataChangeTime().toMSecsSinceEpoch() * 1000000;
+#endif
+
+	return stamp;
+}
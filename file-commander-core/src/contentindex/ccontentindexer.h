@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ctrigramindex.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QStringList>
+RESTORE_COMPILER_WARNINGS
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+class CFileSystemObject;
+
+// Maintains the trigram index of the text files under the configured folders on a background thread, and keeps it on disk between the sessions.
+// The periodic rescan only re-reads the files whose stamp (size, modification and status change times in nanoseconds, inode) has changed; in between the rescans, the index is updated from the change notifications passed to filesChanged().
+// The binary files and the files larger than the limit are recorded but not indexed, and the content search reads them as before.
+class CContentIndexer
+{
+public:
+	// Narrows down the files that need to be read when searching for the text.
+	// The index is only locked for the duration of each call, so the indexer isn't held up by a long search.
+	class ContentFilter
+	{
+	public:
+		// False only if the file is indexed, hasn't changed since, and lacks some of the query's trigrams.
+		// The files (re-)indexed after the filter was created, and all of them once the index is compacted, are reported as possible matches.
+		bool mayContain(const CFileSystemObject& file) const;
+
+	private:
+		friend class CContentIndexer;
+		ContentFilter(const CContentIndexer& indexer, const QString& query, bool wildcards);
+
+	private:
+		const CContentIndexer& _indexer;
+		std::optional<std::vector<CTrigramIndex::DocumentId>> _candidates;
+		// The candidates are only valid for the documents that existed at the time
+		uint64_t _indexGeneration = 0;
+		CTrigramIndex::DocumentId _nextDocumentId = 0;
+	};
+
+	explicit CContentIndexer(QString indexFilePath);
+	~CContentIndexer();
+
+	// Starts indexing the specified folders. An empty list stops the indexer and deletes the index.
+	void configure(QStringList roots, uint64_t maxFileSize);
+	// Queues the files that have been added, modified or removed for re-indexing; the ones outside the indexed folders are ignored
+	void filesChanged(const std::vector<QString>& paths);
+
+	ContentFilter contentFilter(const QString& query, bool wildcards) const;
+
+private:
+	void threadFunc();
+	void stopThread();
+
+	void rescan(const QStringList& roots, uint64_t maxFileSize);
+	void updateFile(const CFileSystemObject& file, uint64_t maxFileSize);
+	void save();
+
+	// std::nullopt if the file can't be stat()'ed
+	static std::optional<CTrigramIndex::FileStamp> fileStamp(const QString& path);
+
+private:
+	const QString _indexFilePath;
+
+	CTrigramIndex _index;
+	mutable std::shared_mutex _indexMutex;
+	CTrigramExtractor _extractor; // Only used on the indexer thread
+	bool _indexModified = false;
+
+	std::mutex _mutex; // Guards the fields below
+	std::condition_variable _wakeUp;
+	QStringList _roots;
+	uint64_t _maxFileSize = 0;
+	std::vector<QString> _changedFiles;
+	bool _rescanRequested = false;
+
+	std::atomic<bool> _stopRequested {false};
+	std::atomic<bool> _abortRescan {false};
+	std::thread _thread;
+};
@@ -0,0 +1,426 @@
+#include "ctrigramindex.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+static constexpr size_t NumPossibleTrigrams = size_t{1} << 24;
+static constexpr quint32 IndexFileSignature = 0x46435449; // "FCTI"
+static constexpr quint32 IndexFileVersion = 2;
+
+// Calls sink(trigram) for every trigram of the data, continuing the window left over from the previous chunk
+template <typename Sink>
+static void forEachTrigram(const char* data, size_t size, uint32_t& window, size_t& windowLength, Sink&& sink)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		auto c = static_cast<uint8_t>(data[i]);
+		if (c >= 0x80)
+		{
+			windowLength = 0;
+			continue;
+		}
+
+		if (c >= 'A' && c <= 'Z')
+			c = static_cast<uint8_t>(c - 'A' + 'a');
+
+		window = ((window << 8) | c) & 0xFFFFFFu;
+		if (++windowLength >= 3)
+			sink(window);
+	}
+}
+
+void CTrigramExtractor::add(const char* data, size_t size)
+{
+	if (_seen.empty())
+		_seen.resize(NumPossibleTrigrams / 64, 0);
+
+	forEachTrigram(data, size, _window, _windowLength, [this](Trigram trigram) {
+		uint64_t& word = _seen[trigram / 64];
+		const uint64_t bit = uint64_t{1} << (trigram % 64);
+		if ((word & bit) == 0)
+		{
+			word |= bit;
+			_trigrams.push_back(trigram);
+		}
+	});
+}
+
+std::vector<CTrigramExtractor::Trigram> CTrigramExtractor::takeTrigrams()
+{
+	// Clearing only the bits that have been set is much cheaper than clearing the whole 2 MB bitmap
+	for (const Trigram trigram : _trigrams)
+		_seen[trigram / 64] = 0;
+
+	std::sort(_trigrams.begin(), _trigrams.end());
+
+	std::vector<Trigram> result;
+	result.swap(_trigrams);
+	_window = 0;
+	_windowLength = 0;
+	return result;
+}
+
+std::vector<CTrigramExtractor::Trigram> CTrigramExtractor::queryTrigrams(const QString& query, bool wildcards)
+{
+	std::vector<QString> fragments;
+	if (!wildcards)
+		fragments.push_back(query);
+	else
+	{
+		// Same syntax as QRegExp::Wildcard: '*' and '?' match anything, [...] is a set of characters
+		QString fragment;
+		for (int i = 0; i < query.size(); ++i)
+		{
+			const QChar c = query[i];
+			if (c == '*' || c == '?' || c == '[')
+			{
+				fragments.push_back(fragment);
+				fragment.clear();
+
+				if (c == '[')
+				{
+					const int closingBracket = query.indexOf(']', i + 1);
+					i = closingBracket < 0 ? query.size() : closingBracket;
+				}
+			}
+			else
+				fragment.append(c);
+		}
+
+		fragments.push_back(fragment);
+	}
+
+	std::set<Trigram> trigrams;
+	for (const QString& fragment : fragments)
+	{
+		const QByteArray utf8 = fragment.toUtf8();
+		uint32_t window = 0;
+		size_t windowLength = 0;
+		forEachTrigram(utf8.constData(), static_cast<size_t>(utf8.size()), window, windowLength, [&trigrams](Trigram trigram) {
+			trigrams.insert(trigram);
+		});
+	}
+
+	return std::vector<Trigram>(trigrams.begin(), trigrams.end());
+}
+
+
+
+void CTrigramIndex::PostingList::append(DocumentId id)
+{
+	assert_debug_only(count == 0 || id > last);
+
+	uint32_t delta = count == 0 ? id : id - last;
+	while (delta >= 0x80)
+	{
+		encoded.push_back(static_cast<uint8_t>(delta | 0x80));
+		delta >>= 7;
+	}
+	encoded.push_back(static_cast<uint8_t>(delta));
+
+	last = id;
+	++count;
+}
+
+std::vector<CTrigramIndex::DocumentId> CTrigramIndex::PostingList::decode() const
+{
+	std::vector<DocumentId> ids;
+	ids.reserve(count);
+
+	DocumentId id = 0;
+	uint32_t delta = 0;
+	int shift = 0;
+	for (const uint8_t byte : encoded)
+	{
+		delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+		if (byte & 0x80)
+		{
+			shift += 7;
+			continue;
+		}
+
+		id += delta;
+		ids.push_back(id);
+		delta = 0;
+		shift = 0;
+	}
+
+	return ids;
+}
+
+bool CTrigramIndex::FileStamp::operator==(const FileStamp& other) const
+{
+	return size == other.size && modificationTimeNs == other.modificationTimeNs && statusChangeTimeNs == other.statusChangeTimeNs && inode == other.inode;
+}
+
+CTrigramIndex::DocumentId CTrigramIndex::addDocument(const QString& path, const FileStamp& stamp, const std::vector<Trigram>& trigrams)
+{
+	const DocumentId id = newDocument(path, stamp, true);
+	for (const Trigram trigram : trigrams)
+		_postings[trigram].append(id);
+
+	return id;
+}
+
+CTrigramIndex::DocumentId CTrigramIndex::addUnindexedDocument(const QString& path, const FileStamp& stamp)
+{
+	return newDocument(path, stamp, false);
+}
+
+void CTrigramIndex::removeDocument(const QString& path)
+{
+	const auto it = _documentIdByPath.find(path);
+	if (it == _documentIdByPath.end())
+		return;
+
+	Document& document = _documents[it.value()];
+	document.removed = true;
+	document.path.clear();
+	++_numRemovedDocuments;
+
+	_documentIdByPath.erase(it);
+}
+
+const CTrigramIndex::Document* CTrigramIndex::document(const QString& path, DocumentId* id) const
+{
+	const auto it = _documentIdByPath.find(path);
+	if (it == _documentIdByPath.end())
+		return nullptr;
+
+	if (id)
+		*id = it.value();
+
+	return &_documents[it.value()];
+}
+
+std::optional<std::vector<CTrigramIndex::DocumentId>> CTrigramIndex::documentsContaining(const std::vector<Trigram>& trigrams) const
+{
+	if (trigrams.empty())
+		return std::nullopt;
+
+	std::vector<const PostingList*> lists;
+	lists.reserve(trigrams.size());
+	for (const Trigram trigram : trigrams)
+	{
+		const auto it = _postings.find(trigram);
+		if (it == _postings.end())
+			return std::vector<DocumentId>{};
+
+		lists.push_back(&it->second);
+	}
+
+	// Starting with the shortest list keeps the intermediate results small
+	std::sort(lists.begin(), lists.end(), [](const PostingList* l, const PostingList* r) {
+		return l->count < r->count;
+	});
+
+	std::vector<DocumentId> result = lists.front()->decode();
+	for (size_t i = 1; i < lists.size() && !result.empty(); ++i)
+	{
+		const std::vector<DocumentId> ids = lists[i]->decode();
+		std::vector<DocumentId> intersection;
+		std::set_intersection(result.begin(), result.end(), ids.begin(), ids.end(), std::back_inserter(intersection));
+		result.swap(intersection);
+	}
+
+	result.erase(std::remove_if(result.begin(), result.end(), [this](DocumentId id) {
+		return _documents[id].removed;
+	}), result.end());
+
+	return result;
+}
+
+size_t CTrigramIndex::numDocuments() const
+{
+	return _documents.size() - _numRemovedDocuments;
+}
+
+size_t CTrigramIndex::numPostings() const
+{
+	size_t total = 0;
+	for (const auto& item : _postings)
+		total += item.second.count;
+
+	return total;
+}
+
+CTrigramIndex::DocumentId CTrigramIndex::nextDocumentId() const
+{
+	return static_cast<DocumentId>(_documents.size());
+}
+
+uint64_t CTrigramIndex::generation() const
+{
+	return _generation;
+}
+
+bool CTrigramIndex::empty() const
+{
+	return numDocuments() == 0;
+}
+
+void CTrigramIndex::clear()
+{
+	_documents.clear();
+	_documentIdByPath.clear();
+	_postings.clear();
+	_numRemovedDocuments = 0;
+	++_generation;
+}
+
+void CTrigramIndex::compact()
+{
+	if (_numRemovedDocuments == 0)
+		return;
+
+	static constexpr DocumentId NoId = std::numeric_limits<DocumentId>::max();
+	std::vector<DocumentId> newIds(_documents.size(), NoId);
+	std::vector<Document> documents;
+	documents.reserve(numDocuments());
+	_documentIdByPath.clear();
+
+	for (size_t i = 0; i < _documents.size(); ++i)
+	{
+		if (_documents[i].removed)
+			continue;
+
+		newIds[i] = static_cast<DocumentId>(documents.size());
+		_documentIdByPath.insert(_documents[i].path, newIds[i]);
+		documents.push_back(std::move(_documents[i]));
+	}
+
+	for (auto it = _postings.begin(); it != _postings.end();)
+	{
+		PostingList compacted;
+		for (const DocumentId id : it->second.decode())
+		{
+			if (newIds[id] != NoId)
+				compacted.append(newIds[id]);
+		}
+
+		if (compacted.count == 0)
+			it = _postings.erase(it);
+		else
+		{
+			it->second = std::move(compacted);
+			++it;
+		}
+	}
+
+	_documents = std::move(documents);
+	_numRemovedDocuments = 0;
+	++_generation;
+}
+
+bool CTrigramIndex::compactionRecommended() const
+{
+	return _numRemovedDocuments > 1024 && _numRemovedDocuments * 4 > _documents.size();
+}
+
+bool CTrigramIndex::save(const QString& filePath) const
+{
+	QSaveFile file(filePath);
+	if (!file.open(QFile::WriteOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_12);
+	stream << IndexFileSignature << IndexFileVersion;
+
+	stream << static_cast<quint64>(_documents.size());
+	for (const Document& document : _documents)
+		stream << document.path << static_cast<quint64>(document.stamp.size) << static_cast<qint64>(document.stamp.modificationTimeNs) << static_cast<qint64>(document.stamp.statusChangeTimeNs)
+			<< static_cast<quint64>(document.stamp.inode) << static_cast<quint8>((document.indexed ? 1 : 0) | (document.removed ? 2 : 0));
+
+	stream << static_cast<quint64>(_postings.size());
+	for (const auto& item : _postings)
+	{
+		const PostingList& list = item.second;
+		stream << static_cast<quint32>(item.first) << static_cast<quint32>(list.last) << static_cast<quint32>(list.count) << static_cast<quint32>(list.encoded.size());
+		stream.writeRawData(reinterpret_cast<const char*>(list.encoded.data()), static_cast<int>(list.encoded.size()));
+	}
+
+	return stream.status() == QDataStream::Ok && file.commit();
+}
+
+bool CTrigramIndex::load(const QString& filePath)
+{
+	clear();
+
+	QFile file(filePath);
+	if (!file.open(QFile::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_12);
+
+	quint32 signature = 0, version = 0;
+	stream >> signature >> version;
+	if (signature != IndexFileSignature || version != IndexFileVersion)
+		return false;
+
+	quint64 numDocuments = 0;
+	stream >> numDocuments;
+	for (quint64 i = 0; i < numDocuments && stream.status() == QDataStream::Ok; ++i)
+	{
+		Document document;
+		quint64 size = 0, inode = 0;
+		qint64 modificationTimeNs = 0, statusChangeTimeNs = 0;
+		quint8 flags = 0;
+		stream >> document.path >> size >> modificationTimeNs >> statusChangeTimeNs >> inode >> flags;
+		document.stamp.size = size;
+		document.stamp.modificationTimeNs = modificationTimeNs;
+		document.stamp.statusChangeTimeNs = statusChangeTimeNs;
+		document.stamp.inode = inode;
+		document.indexed = (flags & 1) != 0;
+		document.removed = (flags & 2) != 0;
+
+		if (document.removed)
+			++_numRemovedDocuments;
+		else
+			_documentIdByPath.insert(document.path, static_cast<DocumentId>(_documents.size()));
+
+		_documents.push_back(std::move(document));
+	}
+
+	quint64 numPostingLists = 0;
+	stream >> numPostingLists;
+	for (quint64 i = 0; i < numPostingLists && stream.status() == QDataStream::Ok; ++i)
+	{
+		quint32 trigram = 0, last = 0, count = 0, encodedSize = 0;
+		stream >> trigram >> last >> count >> encodedSize;
+
+		PostingList& list = _postings[trigram];
+		list.last = last;
+		list.count = count;
+		list.encoded.resize(encodedSize);
+		if (stream.readRawData(reinterpret_cast<char*>(list.encoded.data()), static_cast<int>(encodedSize)) != static_cast<int>(encodedSize))
+			break;
+	}
+
+	if (stream.status() != QDataStream::Ok || _postings.size() != numPostingLists)
+	{
+		clear();
+		return false;
+	}
+
+	return true;
+}
+
+CTrigramIndex::DocumentId CTrigramIndex::newDocument(const QString& path, const FileStamp& stamp, bool indexed)
+{
+	removeDocument(path);
+
+	const auto id = static_cast<DocumentId>(_documents.size());
+	_documents.push_back(Document{path, stamp, indexed, false});
+	_documentIdByPath.insert(path, id);
+	return id;
+}
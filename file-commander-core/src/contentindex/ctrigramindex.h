@@ -0,0 +1,131 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <stdint.h>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Collects the distinct trigrams (sequences of 3 bytes) of the data fed to it, possibly in several chunks.
+// ASCII letters are folded to lower case, and the trigrams with non-ASCII bytes are ignored: ASCII is the same in UTF-8 and in all the 8-bit code pages,
+// so the trigrams of a query are found in a file regardless of its encoding, and a single index serves both the case-sensitive and the case-insensitive search.
+class CTrigramExtractor
+{
+public:
+	using Trigram = uint32_t;
+
+	void add(const char* data, size_t size);
+	// Every distinct trigram added since the previous call, sorted. Resets the extractor.
+	std::vector<Trigram> takeTrigrams();
+
+	// The trigrams that every line matching the query must contain. Empty if the query is too short to narrow anything down.
+	// For a wildcard query ('*' and '?'), the trigrams of the literal fragments between the wildcards.
+	static std::vector<Trigram> queryTrigrams(const QString& query, bool wildcards);
+
+private:
+	std::vector<uint64_t> _seen; // A bit per possible trigram
+	std::vector<Trigram> _trigrams;
+	uint32_t _window = 0;
+	size_t _windowLength = 0;
+};
+
+// An inverted index from the trigrams to the files containing them.
+// A file that's re-indexed gets a new document ID, so that the posting lists are only ever appended to and stay sorted.
+// The posting lists are delta- and varint-encoded both in memory and on disk.
+// Not thread-safe.
+class CTrigramIndex
+{
+public:
+	using Trigram = CTrigramExtractor::Trigram;
+	using DocumentId = uint32_t;
+
+	// What a stat() of the file says. A file whose stamp is unchanged is assumed to have the same contents.
+	struct FileStamp
+	{
+		uint64_t size = 0;
+		int64_t modificationTimeNs = 0;
+		int64_t statusChangeTimeNs = 0;
+		uint64_t inode = 0;
+
+		bool operator==(const FileStamp& other) const;
+		bool operator!=(const FileStamp& other) const { return !(*this == other); }
+	};
+
+	struct Document
+	{
+		QString path;
+		FileStamp stamp;
+		// False for the binary and the oversized files: they have been looked at, but their contents are unknown to the index
+		bool indexed = false;
+		bool removed = false;
+	};
+
+	// Replaces the previous version of the document, if any
+	DocumentId addDocument(const QString& path, const FileStamp& stamp, const std::vector<Trigram>& trigrams);
+	// Records a file whose contents are not indexed
+	DocumentId addUnindexedDocument(const QString& path, const FileStamp& stamp);
+	void removeDocument(const QString& path);
+
+	// nullptr if the path is unknown
+	const Document* document(const QString& path, DocumentId* id = nullptr) const;
+	// Calls f(const Document&) for every live document
+	template <typename F>
+	void forEachDocument(F&& f) const;
+
+	// The sorted IDs of the documents containing all the trigrams. std::nullopt means "any document" (no trigrams to go by).
+	std::optional<std::vector<DocumentId>> documentsContaining(const std::vector<Trigram>& trigrams) const;
+
+	size_t numDocuments() const;
+	size_t numPostings() const;
+	// The ID the next document added will get. The IDs below it keep referring to the same documents until the generation changes.
+	DocumentId nextDocumentId() const;
+	// Changes whenever the document IDs are reassigned: by compact(), clear() and load()
+	uint64_t generation() const;
+	bool empty() const;
+	void clear();
+
+	// Renumbers the documents and drops the postings of the removed ones
+	void compact();
+	// Worth compacting when the removed documents make up a large share of all
+	bool compactionRecommended() const;
+
+	bool save(const QString& filePath) const;
+	bool load(const QString& filePath);
+
+private:
+	struct PostingList
+	{
+		std::vector<uint8_t> encoded;
+		DocumentId last = 0;
+		uint32_t count = 0;
+
+		void append(DocumentId id);
+		std::vector<DocumentId> decode() const;
+	};
+
+	DocumentId newDocument(const QString& path, const FileStamp& stamp, bool indexed);
+
+private:
+	std::vector<Document> _documents; // Indexed by DocumentId
+	QHash<QString, DocumentId> _documentIdByPath;
+	std::unordered_map<Trigram, PostingList> _postings;
+	size_t _numRemovedDocuments = 0;
+	uint64_t _generation = 0;
+};
+
+template <typename F>
+void CTrigramIndex::forEachDocument(F&& f) const
+{
+	for (const Document& document : _documents)
+	{
+		if (!document.removed)
+			f(document);
+	}
+}
@@ -7,17 +7,24 @@
 #include "filesystemwatcher/cfilesystemwatcher.h"
 #include "std_helpers/qt_container_helpers.hpp"
 #include "filesystemhelpers/filesystemhelpers.hpp"
+#include "tracing/ctracer.h"
 
 DISABLE_COMPILER_WARNINGS
 #include <QDebug>
 #include <QVector>
 RESTORE_COMPILER_WARNINGS
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <string.h>
+#include <thread>
 #include <time.h>
 
 #ifdef _WIN32
 #include <Windows.h>
 #else
+#include <dirent.h>
 #include <unistd.h> // access()
 #endif
 
@@ -26,13 +33,72 @@ enum {
 	ItemDiscoveryProgressNotificationTag
 };
 
+static constexpr int ForegroundRefreshPeriodMs = 200;
+static constexpr int BackgroundRefreshPeriodMs = 1000;
+
+// A mount can become slow, or fast again, while it's being browsed
+static constexpr auto LatencyClassificationLifetime = std::chrono::seconds(10);
+
+// The number of stat() calls in flight when listing a folder on a network mount
+static constexpr size_t MaxConcurrentMetadataQueries = 48;
+// A small folder doesn't need many threads to hide the latency
+static constexpr size_t MinItemsPerMetadataQueryThread = 8;
+// How often the metadata received so far is published while listing a folder on a network mount
+static constexpr auto MetadataPublishingPeriod = std::chrono::milliseconds(150);
+
+struct DirectoryEntry
+{
+	QString name;
+	FileSystemObjectType type;
+};
+
+// Reads the names of the items without querying their metadata.
+// The type is UnknownType for symlinks and wherever the file system doesn't report it; sockets, pipes and devices are left out.
+static std::vector<DirectoryEntry> readDirectoryEntries(const QString& dirPath)
+{
+	std::vector<DirectoryEntry> entries;
+
+#ifdef _WIN32
+	// FindFirstFile() returns the metadata along with the names anyway
+	for (const QFileInfo& info: QDir{dirPath}.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDot | QDir::Hidden | QDir::System))
+		entries.push_back({info.fileName(), info.isDir() ? Directory : File});
+#else
+	DIR* dir = ::opendir(QFile::encodeName(dirPath).constData());
+	if (dir == nullptr)
+		return entries;
+
+	while (const dirent* entry = ::readdir(dir))
+	{
+		if (::strcmp(entry->d_name, ".") == 0)
+			continue;
+		// Same as QDir::entryInfoList(): ".." is listed for every folder but the root
+		if (::strcmp(entry->d_name, "..") == 0 && dirPath == QLatin1String("/"))
+			continue;
+
+		FileSystemObjectType type = UnknownType;
+		if (entry->d_type == DT_DIR)
+			type = Directory;
+		else if (entry->d_type == DT_REG)
+			type = File;
+		else if (entry->d_type != DT_LNK && entry->d_type != DT_UNKNOWN)
+			continue;
+
+		entries.push_back({QFile::decodeName(entry->d_name), type});
+	}
+
+	::closedir(dir);
+#endif
+
+	return entries;
+}
+
 CPanel::CPanel(Panel position) :
 	_watcher(std::make_shared<CFileSystemWatcher>()),
 	_panelPosition(position),
 	_workerThreadPool(4, std::string(position == LeftPanel ? "Left panel" : "Right panel") + " file list refresh thread pool")
 {
 	// The list of items in the current folder is being refreshed asynchronously, not every time a change is detected, to avoid refresh tasks queuing up out of control
-	_fileListRefreshTimer.start(200);
+	_fileListRefreshTimer.start(ForegroundRefreshPeriodMs);
 	connect(&_fileListRefreshTimer, &QTimer::timeout, this, &CPanel::processContentsChangedEvent);
 
 	_watcher->addCallback([this](const transparent_set<QFileInfo>&, const transparent_set<QFileInfo>&, const transparent_set<QFileInfo>&) {
@@ -183,11 +249,15 @@ void CPanel::showAllFilesFromCurrentFolderAndBelow()
 
 		//locker.unlock();
 		// TODO: synchronization and lock-ups
-		const bool showHiddenFiles = CSettings().value(KEY_INTERFACE_SHOW_HIDDEN_FILES, true).toBool();
-		scanDirectory(CFileSystemObject(path), [showHiddenFiles, this](const CFileSystemObject& item) {
-			if (item.isFile() && item.exists() && (showHiddenFiles || !item.isHidden()))
+		// The hidden folders are pruned along with their contents rather than entered only to have every item inside them filtered out
+		CPruningRules pruningRules = CPruningRules::fromSettings();
+		pruningRules.setSkipHidden(!CSettings().value(KEY_INTERFACE_SHOW_HIDDEN_FILES, true).toBool());
+
+		const std::atomic<bool> abort{false};
+		scanDirectory(CFileSystemObject(path), [this](const CFileSystemObject& item) {
+			if (item.isFile() && item.exists())
 				_items[item.hash()] = item;
-		});
+		}, abort, true, pruningRules);
 		//locker.lock();
 
 		sendContentsChangedNotification(refreshCauseOther);
@@ -260,6 +330,9 @@ qulonglong CPanel::currentItemForFolder(const QString &dir) const
 void CPanel::refreshFileList(FileListRefreshCause operation)
 {
 	_workerThreadPool.enqueue([this, operation]() {
+		TRACE_SCOPE("CPanel::refreshFileList");
+
+		const uint64_t generation = ++_fileListGeneration;
 		QFileInfoList list;
 
 		bool currentPathIsAccessible = false;
@@ -278,7 +351,15 @@ void CPanel::refreshFileList(FileListRefreshCause operation)
 			return;
 		}
 
+		// Constructing the objects one by one costs several network round trips per item
+		if (isHighLatencyLocation(currentDirPath))
+		{
+			refreshFileListConcurrently(currentDirPath, operation, generation);
+			return;
+		}
+
 		{
+			TRACE_SCOPE("Listing the folder");
 			std::lock_guard<std::recursive_mutex> locker(_fileListAndCurrentDirMutex);
 
 			list = QDir{currentDirPath}.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDot | QDir::Hidden | QDir::System);
@@ -291,6 +372,7 @@ void CPanel::refreshFileList(FileListRefreshCause operation)
 		const size_t numItemsFound = (size_t)list.size();
 		objectsList.reserve(numItemsFound);
 
+		TRACE_SCOPE("Creating the objects");
 		for (size_t i = 0; i < numItemsFound; ++i)
 		{
 #ifndef _WIN32
@@ -319,6 +401,146 @@ void CPanel::refreshFileList(FileListRefreshCause operation)
 	});
 }
 
+bool CPanel::isHighLatencyLocation(const QString& dirPath)
+{
+	// A single stat() instead of a statfs() and a stat() on every refresh
+	const uint64_t device = CPruningRules::deviceId(dirPath);
+	const auto now = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> locker(_latencyClassificationMutex);
+		const auto it = _latencyClassificationByDevice.find(device);
+		if (it != _latencyClassificationByDevice.end() && now - it->second.time < LatencyClassificationLifetime)
+			return it->second.highLatency;
+	}
+
+	const bool highLatency = FileSystemHelpers::isHighLatencyLocation(dirPath);
+
+	std::lock_guard<std::mutex> locker(_latencyClassificationMutex);
+	_latencyClassificationByDevice[device] = {highLatency, now};
+	return highLatency;
+}
+
+void CPanel::refreshFileListConcurrently(const QString& dirPath, FileListRefreshCause operation, uint64_t generation)
+{
+	TRACE_SCOPE("CPanel::refreshFileListConcurrently");
+
+	const bool showHiddenFiles = CSettings().value(KEY_INTERFACE_SHOW_HIDDEN_FILES, true).toBool();
+	std::vector<QString> paths;
+
+	{
+		TRACE_SCOPE("Listing the folder");
+		const auto entries = readDirectoryEntries(dirPath);
+		paths.reserve(entries.size());
+
+		std::lock_guard<std::recursive_mutex> locker(_fileListAndCurrentDirMutex);
+		_items.clear();
+
+		for (const auto& entry : entries)
+		{
+			QString path = dirPath + entry.name;
+			// Whether a symlink points to a file or a folder will only be known after stat()
+			// Unix hidden files are the ones starting with a dot, no need to wait for stat() to filter them out
+			if (entry.type != UnknownType && (showHiddenFiles || !entry.name.startsWith('.')))
+			{
+				CFileSystemObject object(path, entry.type);
+				const auto hash = object.hash();
+				_items[hash] = std::move(object);
+			}
+
+			paths.push_back(std::move(path));
+		}
+	}
+
+	sendContentsChangedNotification(operation);
+
+	if (paths.empty())
+		return;
+
+	const auto superseded = [this, generation] {
+		return _fileListGeneration != generation;
+	};
+
+	std::call_once(_metadataQueryThreadPoolCreated, [this] {
+		_metadataQueryThreadPool = std::make_unique<CWorkerThreadPool>(MaxConcurrentMetadataQueries, std::string(_panelPosition == LeftPanel ? "Left panel" : "Right panel") + " metadata query thread pool");
+	});
+
+	std::mutex resultsMutex;
+	std::vector<CFileSystemObject> results;
+	std::atomic<size_t> nextItem{0};
+	std::atomic<size_t> numItemsDone{0};
+
+	// The tasks refer to the local variables, so this function can't return before all of them have finished
+	std::mutex tasksMutex;
+	std::condition_variable tasksFinished;
+	const size_t numTasks = std::min((paths.size() + MinItemsPerMetadataQueryThread - 1) / MinItemsPerMetadataQueryThread, MaxConcurrentMetadataQueries);
+	size_t numTasksRunning = numTasks;
+
+	for (size_t i = 0; i < numTasks; ++i)
+	{
+		_metadataQueryThreadPool->enqueue([&] {
+			for (size_t index = nextItem++; index < paths.size() && !superseded(); index = nextItem++)
+			{
+				CFileSystemObject object{QFileInfo{paths[index]}};
+
+				std::lock_guard<std::mutex> resultsLocker(resultsMutex);
+				results.push_back(std::move(object));
+				++numItemsDone;
+			}
+
+			// Notifying under the lock: the waiting thread may destroy the condition variable as soon as it sees the counter reach 0
+			std::lock_guard<std::mutex> tasksLocker(tasksMutex);
+			--numTasksRunning;
+			tasksFinished.notify_all();
+		});
+	}
+
+	const auto publishResults = [&] {
+		std::vector<CFileSystemObject> newResults;
+		{
+			std::lock_guard<std::mutex> resultsLocker(resultsMutex);
+			newResults.swap(results);
+		}
+
+		if (newResults.empty())
+			return;
+
+		{
+			std::lock_guard<std::recursive_mutex> locker(_fileListAndCurrentDirMutex);
+			if (superseded())
+				return;
+
+			for (auto& object : newResults)
+			{
+				if (object.exists() && (object.isFile() || object.isDir()) && (showHiddenFiles || !object.isHidden()))
+				{
+					const auto hash = object.hash();
+					_items[hash] = std::move(object);
+				}
+				else
+					_items.erase(object.hash()); // Deleted since listed, or turned out to be a socket
+			}
+		}
+
+		sendItemDiscoveryProgressNotification(_currentDirObject.hash(), 20 + 80 * numItemsDone / paths.size(), dirPath);
+		sendContentsChangedNotification(refreshCauseOther);
+	};
+
+	while (numItemsDone < paths.size() && !superseded())
+	{
+		std::this_thread::sleep_for(MetadataPublishingPeriod);
+		publishResults();
+	}
+
+	{
+		std::unique_lock<std::mutex> tasksLocker(tasksMutex);
+		tasksFinished.wait(tasksLocker, [&numTasksRunning] {
+			return numTasksRunning == 0;
+		});
+	}
+
+	publishResults();
+}
+
 // Returns the current list of objects on this panel
 std::map<qulonglong, CFileSystemObject> CPanel::list() const
 {
@@ -431,8 +653,43 @@ void CPanel::volumesChanged(const std::vector<VolumeInfo>& volumes, bool drivesL
 		setPath(_currentDirObject.fullAbsolutePath(), refreshCauseOther);
 }
 
+void CPanel::addChangedItemsListener(std::function<void (const std::vector<QString>&)> listener)
+{
+	_watcher->addCallback([listener{std::move(listener)}](const transparent_set<QFileInfo>& added, const transparent_set<QFileInfo>& removed, const transparent_set<QFileInfo>& changed) {
+		std::vector<QString> paths;
+		paths.reserve(added.size() + removed.size() + changed.size());
+		for (const auto* items : {&added, &removed, &changed})
+		{
+			for (const QFileInfo& item : *items)
+				paths.push_back(item.absoluteFilePath());
+		}
+
+		listener(paths);
+	});
+}
+
+void CPanel::setActivityState(ActivityState state)
+{
+	_watcher->setActivityState(state);
+
+	// The refreshes are only ever requested by the watcher, so the timer doesn't need to run more often than the watcher polls
+	switch (state)
+	{
+	case ActivityState::Foreground:
+		_fileListRefreshTimer.start(ForegroundRefreshPeriodMs);
+		break;
+	case ActivityState::Background:
+		_fileListRefreshTimer.start(BackgroundRefreshPeriodMs);
+		break;
+	case ActivityState::Suspended:
+		_fileListRefreshTimer.stop();
+		break;
+	}
+}
+
 void CPanel::uiThreadTimerTick()
 {
+	TRACE_SCOPE("CPanel::uiThreadTimerTick");
 	_uiThreadQueue.exec();
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "activitystate.h"
 #include "cfilesystemobject.h"
 #include "diskenumerator/cvolumeenumerator.h"
 #include "historylist/chistorylist.h"
@@ -9,6 +10,8 @@
 #include "utility/callback_caller.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -49,6 +52,7 @@ struct FilesystemObjectsStatistics
 	uint64_t files;
 	uint64_t folders;
 	uint64_t occupiedSpace;
+	uint64_t allocatedSpace = 0; // On-disk size, may differ from occupiedSpace due to block size rounding and sparse files
 };
 
 struct CursorPositionListener {
@@ -110,12 +114,24 @@ public:
 
 	void volumesChanged(const std::vector<VolumeInfo>& volumes, bool drivesListOrReadinessChanged);
 
+	// Receives the paths of the items the watcher has found added, removed or modified in the current folder. Called on the UI thread.
+	void addChangedItemsListener(std::function<void (const std::vector<QString>&)> listener);
+
+	// Slows down or stops watching the current folder and refreshing the list while the window is not in the foreground
+	void setActivityState(ActivityState state);
+
 	void uiThreadTimerTick();
 
 private:
 	const VolumeInfo& volumeInfoForObject(const CFileSystemObject& object) const;
 	bool pathIsAccessible(const QString& path) const;
 
+	// FileSystemHelpers::isHighLatencyLocation() costs a statfs() and a timed stat(), so its answer is cached per device for a while
+	bool isHighLatencyLocation(const QString& dirPath);
+
+	// For the network mounts: lists the names right away and fills in the metadata as the concurrent stat() calls complete
+	void refreshFileListConcurrently(const QString& dirPath, FileListRefreshCause operation, uint64_t generation);
+
 	void contentsChanged();
 	void processContentsChangedEvent();
 
@@ -138,10 +154,23 @@ private:
 
 	std::vector<VolumeInfo> _volumes;
 
+	struct LatencyClassification {
+		bool highLatency;
+		std::chrono::steady_clock::time_point time;
+	};
+	std::map<uint64_t /*device id*/, LatencyClassification> _latencyClassificationByDevice;
+	std::mutex                                 _latencyClassificationMutex;
+
+	// For querying the metadata of the items on network mounts; created the first time it's needed.
+	// Used by the tasks of '_workerThreadPool', so it has to be destroyed after that one.
+	std::unique_ptr<CWorkerThreadPool>         _metadataQueryThreadPool;
+	std::once_flag                             _metadataQueryThreadPoolCreated;
 	CWorkerThreadPool                          _workerThreadPool;
 	mutable CExecutionQueue                    _uiThreadQueue;
 	mutable std::recursive_mutex               _fileListAndCurrentDirMutex;
 
 	QTimer                                     _fileListRefreshTimer;
 	std::atomic<bool>                          _bContentsChangedEventPending{false};
+	// Incremented by every refresh so that a refresh still in progress can tell it's been superseded
+	std::atomic<uint64_t>                      _fileListGeneration{0};
 };
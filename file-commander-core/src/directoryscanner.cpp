@@ -1,19 +1,155 @@
 #include "directoryscanner.h"
 
-void scanDirectory(const CFileSystemObject& root, const std::function<void(const CFileSystemObject&)>& observer, const std::atomic<bool>& abort)
+DISABLE_COMPILER_WARNINGS
+#include <QDebug>
+#include <QFileInfo>
+#include <QStringList>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <vector>
+
+bool isSameOrParentFolder(const QString& folder, const QString& path)
+{
+	if (!path.startsWith(folder))
+		return false;
+
+	return path.length() == folder.length() || folder.endsWith('/') || path.at(folder.length()) == '/';
+}
+
+std::vector<QString> independentScanRoots(const QStringList& roots)
+{
+	struct Root {
+		QString path;
+		QString canonicalPath;
+		size_t index;
+	};
+
+	std::vector<Root> existingRoots;
+	existingRoots.reserve(static_cast<size_t>(roots.size()));
+	for (const QString& root: roots)
+	{
+		QString path = root.trimmed();
+		// Empty for the paths that don't exist
+		QString canonicalPath = QFileInfo(path).canonicalFilePath();
+		if (!canonicalPath.isEmpty())
+			existingRoots.push_back({std::move(path), std::move(canonicalPath), existingRoots.size()});
+	}
+
+	// A folder sorts before everything inside it, so only the roots already accepted have to be checked.
+	// Of the duplicates, the one listed first is kept.
+	std::stable_sort(existingRoots.begin(), existingRoots.end(), [](const Root& l, const Root& r) {
+		return l.canonicalPath < r.canonicalPath;
+	});
+
+	std::vector<Root> acceptedRoots;
+	for (Root& root: existingRoots)
+	{
+		const bool covered = std::any_of(acceptedRoots.cbegin(), acceptedRoots.cend(), [&root](const Root& acceptedRoot) {
+			return isSameOrParentFolder(acceptedRoot.canonicalPath, root.canonicalPath);
+		});
+
+		if (!covered)
+			acceptedRoots.push_back(std::move(root));
+	}
+
+	std::sort(acceptedRoots.begin(), acceptedRoots.end(), [](const Root& l, const Root& r) {
+		return l.index < r.index;
+	});
+
+	std::vector<QString> independentRoots;
+	independentRoots.reserve(acceptedRoots.size());
+	for (Root& root: acceptedRoots)
+		independentRoots.push_back(std::move(root.path));
+
+	return independentRoots;
+}
+
+namespace {
+
+struct ScanContext {
+	const std::function<void(const CFileSystemObject&)>& observer;
+	const std::atomic<bool>& abort;
+	const bool followSymlinks;
+	const CPruningRules& pruningRules;
+	const uint64_t rootDeviceId;
+
+	// The canonical paths of the folders in which the links on the way from the scan root to the current folder were found.
+	// Together with the folder where a new link is found, they cover every folder being scanned: following a link to any of them, or to a parent of any of them, would loop.
+	std::vector<QString> linkParentFolders;
+};
+
+}
+
+// 'relativePath' is the path of 'root' relative to the scan root, empty for the scan root and ending with a '/' otherwise
+static void scanDirectory(ScanContext& context, const CFileSystemObject& root, const QString& relativePath, uint32_t depth)
 {
-	if (observer)
-		observer(root);
+	if (context.observer)
+		context.observer(root);
 
-	if (!root.isDir() || abort)
+	if (!root.isDir() || context.abort)
 		return;
 
+	const CPruningRules& rules = context.pruningRules;
+	const bool pruning = !rules.isEmpty();
+	if (pruning)
+	{
+		const bool onRootFileSystem = depth == 0 || !rules.sameFileSystemOnly() || CPruningRules::deviceId(root.fullAbsolutePath()) == context.rootDeviceId;
+		if (!rules.descendsInto(depth, onRootFileSystem))
+			return;
+	}
+
 	const auto list = QDir{root.fullAbsolutePath()}.entryInfoList(QDir::Files | QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot | QDir::System);
 	for (const auto& entry : list)
 	{
-		scanDirectory(CFileSystemObject(entry), observer, abort);
+		const bool isDir = entry.isDir() && (context.followSymlinks || !entry.isSymLink());
+		if (pruning && rules.excludes(relativePath, entry.fileName(), isDir, entry.isHidden(), rules.skipsSystemItems() && CPruningRules::isSystemItem(entry)))
+			continue;
+
+		const QString entryRelativePath = isDir ? relativePath + entry.fileName() + '/' : QString();
+		if (entry.isSymLink() && entry.isDir())
+		{
+			if (!context.followSymlinks)
+			{
+				if (context.observer)
+					context.observer(CFileSystemObject(entry));
+				continue;
+			}
 
-		if (abort)
+			const QString targetPath = entry.canonicalFilePath();
+			const QString linkParentFolder = QFileInfo(root.fullAbsolutePath()).canonicalFilePath();
+			const bool loop = isSameOrParentFolder(targetPath, linkParentFolder) || std::any_of(context.linkParentFolders.cbegin(), context.linkParentFolders.cend(), [&targetPath](const QString& folder) {
+				return isSameOrParentFolder(targetPath, folder);
+			});
+
+			if (loop)
+			{
+				qInfo() << "Skipping" << entry.absoluteFilePath() << "as it links back to" << targetPath;
+				continue;
+			}
+
+			context.linkParentFolders.push_back(linkParentFolder);
+			scanDirectory(context, CFileSystemObject(entry), entryRelativePath, depth + 1);
+			context.linkParentFolders.pop_back();
+		}
+		else
+			scanDirectory(context, CFileSystemObject(entry), entryRelativePath, depth + 1);
+
+		if (context.abort)
 			return;
 	}
 }
+
+void scanDirectory(const CFileSystemObject& root, const std::function<void(const CFileSystemObject&)>& observer, const std::atomic<bool>& abort, bool followSymlinks, const CPruningRules& pruningRules)
+{
+	if (!followSymlinks && root.isSymLink())
+	{
+		if (observer)
+			observer(root);
+		return;
+	}
+
+	const uint64_t rootDeviceId = pruningRules.sameFileSystemOnly() ? CPruningRules::deviceId(root.fullAbsolutePath()) : 0;
+	ScanContext context{observer, abort, followSymlinks, pruningRules, rootDeviceId, {}};
+	scanDirectory(context, root, QString(), 0);
+}
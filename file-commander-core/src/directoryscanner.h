@@ -1,8 +1,22 @@
 #pragma once
 
 #include "cfilesystemobject.h"
+#include "pruningrules/cpruningrules.h"
 
 #include <atomic>
 #include <functional>
+#include <vector>
 
-void scanDirectory(const CFileSystemObject& root, const std::function<void (const CFileSystemObject&)>& observer, const std::atomic<bool>& abort = std::atomic<bool>{false});
+class QStringList;
+
+// Symbolic links to folders are followed unless 'followSymlinks' is false, in which case they are reported like any other item but not entered.
+// A link that leads back to one of the folders being scanned (a link loop) is skipped.
+// The items excluded by 'pruningRules' are neither reported nor entered; the root itself is always reported.
+void scanDirectory(const CFileSystemObject& root, const std::function<void (const CFileSystemObject&)>& observer, const std::atomic<bool>& abort = std::atomic<bool>{false}, bool followSymlinks = true, const CPruningRules& pruningRules = CPruningRules{});
+
+// True if 'folder' is 'path' itself or one of its parents. Both paths must be canonical.
+bool isSameOrParentFolder(const QString& folder, const QString& path);
+
+// Drops the folders that don't exist, the duplicates and the ones inside another listed folder, so that no item is scanned twice.
+// The canonical paths are only used for the comparison: the remaining folders are returned as given (minus the surrounding whitespace), in the same order.
+std::vector<QString> independentScanRoots(const QStringList& roots);
@@ -42,10 +42,28 @@ void CVolumeEnumerator::startEnumeratorThread()
 {
 	// Starting the worker thread that actually enumerates the volumes
 	_enumeratorThread.start([this]() {
+		const ActivityState state = _activityState;
+		if (state == ActivityState::Suspended)
+			return;
+		else if (state == ActivityState::Background && ++_numUpdatesSkipped < _backgroundUpdateInterval / _updateInterval)
+			return;
+
+		_numUpdatesSkipped = 0;
 		enumerateVolumes(true);
 	}, 4000);
 }
 
+void CVolumeEnumerator::setActivityState(ActivityState state)
+{
+	_activityState = state;
+
+	// No notifications can come while suspended; the ones queued before are delivered on coming back
+	if (state == ActivityState::Suspended)
+		_timer.stop();
+	else if (!_timer.isActive())
+		_timer.start(_updateInterval / 3);
+}
+
 // Refresh the list of available volumes
 void CVolumeEnumerator::enumerateVolumes(bool async)
 {
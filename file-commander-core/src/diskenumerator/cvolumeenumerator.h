@@ -1,6 +1,7 @@
 #pragma once
 
 #include "volumeinfo.hpp"
+#include "activitystate.h"
 #include "threading/cexecutionqueue.h"
 #include "threading/cperiodicexecutionthread.h"
 
@@ -8,6 +9,7 @@ DISABLE_COMPILER_WARNINGS
 #include <QTimer>
 RESTORE_COMPILER_WARNINGS
 
+#include <atomic>
 #include <mutex>
 #include <vector>
 
@@ -37,6 +39,9 @@ public:
 	// Forces an update in this thread
 	void updateSynchronously();
 
+	// Checks for the volume changes less often in the background, and not at all when suspended
+	void setActivityState(ActivityState state);
+
 private:
 	// Refresh the list of available volumes
 	void enumerateVolumes(bool async);
@@ -56,5 +61,9 @@ private:
 	CPeriodicExecutionThread         _enumeratorThread;
 	QTimer                           _timer;
 
+	std::atomic<ActivityState>       _activityState {ActivityState::Foreground};
+	unsigned int                     _numUpdatesSkipped = 0; // Only accessed by the enumerator thread
+
 	static constexpr unsigned int _updateInterval = 1000; // ms
+	static constexpr unsigned int _backgroundUpdateInterval = 10000; // ms
 };
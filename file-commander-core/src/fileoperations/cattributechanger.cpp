@@ -0,0 +1,440 @@
+#include "cattributechanger.h"
+#include "assert/advanced_assert.h"
+#include "threading/thread_helpers.h"
+#include "metrics/cmetricsregistry.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <thread>
+
+bool AttributeChange::changesMode() const
+{
+	return modeToSet != 0 || modeToClear != 0;
+}
+
+bool AttributeChange::changesOwner() const
+{
+	return ownerId >= 0 || groupId >= 0;
+}
+
+bool AttributeChange::changesTimes() const
+{
+	return modificationTime >= 0 || accessTime >= 0;
+}
+
+struct CAttributeChanger::Folder {
+	~Folder()
+	{
+#ifndef _WIN32
+		if (fd >= 0)
+			::close(fd);
+#endif
+	}
+
+	int fd = -1;
+	std::shared_ptr<Folder> parent; // Not set for the folders that contain the roots, which are not changed themselves
+	QByteArray name;
+	QString path; // Ends with a '/'
+	struct stat info; // As listed in the parent folder
+	uint32_t currentMode = 0;
+	bool changed = false;
+	// The folder's own listing plus the subfolders not finished yet
+	std::atomic<size_t> pendingWork {1};
+};
+
+CAttributeChanger::CAttributeChanger(const AttributeChange& change) :
+	_change(change)
+{
+	for (const QString& mask: change.includeMasks)
+		_includeMasks.push_back(QFile::encodeName(mask));
+	for (const QString& mask: change.excludeMasks)
+		_excludeMasks.push_back(QFile::encodeName(mask));
+}
+
+CAttributeChanger::~CAttributeChanger() = default;
+
+void CAttributeChanger::setErrorHandler(ErrorHandler handler)
+{
+	_errorHandler = std::move(handler);
+}
+
+void CAttributeChanger::setProgressHandler(ProgressHandler handler)
+{
+	_progressHandler = std::move(handler);
+}
+
+size_t CAttributeChanger::numItemsDiscovered() const
+{
+	return _numItemsDiscovered;
+}
+
+size_t CAttributeChanger::numItemsProcessed() const
+{
+	return _numItemsProcessed;
+}
+
+size_t CAttributeChanger::numItemsChanged() const
+{
+	return _numItemsChanged;
+}
+
+#ifndef _WIN32
+
+namespace {
+
+// Lists the names of the items in the folder, except for "." and ".."
+bool listFolder(int folderFd, std::vector<QByteArray>& names)
+{
+	// closedir() closes the descriptor, and the folder's own one is still needed
+	const int listingFd = ::dup(folderFd);
+	if (listingFd < 0)
+		return false;
+
+	DIR* dir = ::fdopendir(listingFd);
+	if (!dir)
+	{
+		const int error = errno;
+		::close(listingFd);
+		errno = error;
+		return false;
+	}
+
+	names.clear();
+	for (;;)
+	{
+		errno = 0;
+		const dirent* entry = ::readdir(dir);
+		if (!entry)
+			break;
+
+		if (::strcmp(entry->d_name, ".") != 0 && ::strcmp(entry->d_name, "..") != 0)
+			names.emplace_back(entry->d_name);
+	}
+
+	const int error = errno;
+	::closedir(dir);
+	errno = error;
+	return error == 0;
+}
+
+bool matchesAny(const std::vector<QByteArray>& masks, const QByteArray& name)
+{
+	return std::any_of(masks.cbegin(), masks.cend(), [&name](const QByteArray& mask) {
+		return ::fnmatch(mask.constData(), name.constData(), 0) == 0;
+	});
+}
+
+timespec fileTime(int64_t time)
+{
+	timespec result;
+	result.tv_sec = static_cast<time_t>(time);
+	result.tv_nsec = time >= 0 ? 0 : UTIME_OMIT;
+	return result;
+}
+
+}
+
+void CAttributeChanger::apply(const std::vector<QString>& roots, const std::atomic<bool>& abort, size_t numThreads)
+{
+	_abort = &abort;
+	if (numThreads == 0)
+		numThreads = std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t{4});
+
+	for (const QString& root: roots)
+	{
+		if (abort)
+			break;
+
+		QString rootPath = root;
+		while (rootPath.length() > 1 && rootPath.endsWith('/'))
+			rootPath.chop(1);
+
+		// The file system root has no parent to be opened from, it serves as its own container and is referred to as "."
+		const bool fileSystemRoot = rootPath == QLatin1String("/");
+		const int separatorIndex = rootPath.lastIndexOf('/');
+		if (!fileSystemRoot && (separatorIndex < 0 || separatorIndex == rootPath.length() - 1))
+		{
+			// Only this root is skipped, the rest are processed as usual
+			++_numItemsDiscovered;
+			++_numItemsProcessed;
+
+			std::lock_guard<std::mutex> lock(_errorHandlerMutex);
+			if (_errorHandler)
+				_errorHandler(root, QStringLiteral("Not an absolute path"));
+
+			continue;
+		}
+
+		auto container = std::make_shared<Folder>();
+		container->path = fileSystemRoot ? rootPath : rootPath.left(separatorIndex + 1);
+		const QByteArray containerPath = QFile::encodeName(container->path);
+		if (perform("open()", *container, QByteArray(), [&container, &containerPath]() {
+			container->fd = ::open(containerPath.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			return container->fd >= 0 ? 0 : -1;
+		}))
+		{
+			++_numItemsDiscovered;
+			processItem(container, fileSystemRoot ? QByteArray(".") : QFile::encodeName(rootPath.mid(separatorIndex + 1)));
+		}
+
+		finishFolder(std::move(container));
+	}
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < numThreads; ++i)
+	{
+		threads.emplace_back([this]() {
+			setThreadName("CAttributeChanger worker thread");
+			workerThread();
+		});
+	}
+
+	workerThread();
+
+	for (std::thread& thread: threads)
+		thread.join();
+
+	// Only left over if aborted
+	_jobs.clear();
+	_abort = nullptr;
+}
+
+void CAttributeChanger::workerThread()
+{
+	static CMetricGauge& workers = CMetricsRegistry::instance().gauge(Metrics::Workers);
+	static CMetricGauge& busyWorkers = CMetricsRegistry::instance().gauge(Metrics::BusyWorkers);
+	workers.add(1);
+	EXEC_ON_SCOPE_EXIT([]() {workers.add(-1);});
+
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_jobsMutex);
+			_jobsCondition.wait(lock, [this]() {
+				return !_jobs.empty() || _numBusyWorkers == 0 || *_abort;
+			});
+
+			if (*_abort || _jobs.empty())
+			{
+				_jobsCondition.notify_all();
+				return;
+			}
+
+			job = std::move(_jobs.back());
+			_jobs.pop_back();
+			++_numBusyWorkers;
+		}
+
+		busyWorkers.add(1);
+		processFolder(job);
+		busyWorkers.add(-1);
+		job = Job();
+
+		std::lock_guard<std::mutex> lock(_jobsMutex);
+		--_numBusyWorkers;
+		// Wakes up the idle workers if there's nothing left to do, so that they can quit
+		if (_numBusyWorkers == 0 && _jobs.empty())
+			_jobsCondition.notify_all();
+	}
+}
+
+void CAttributeChanger::processFolder(const Job& job)
+{
+	auto folder = std::make_shared<Folder>();
+	folder->parent = job.parent;
+	folder->name = job.name;
+	folder->path = job.name == "." ? job.parent->path : job.parent->path + QFile::decodeName(job.name) + '/';
+	folder->info = job.info;
+	folder->currentMode = job.info.st_mode & 07777;
+
+	// The permissions are added right away so that a folder that can't be read or entered yet can be; they're only taken away once its contents are done
+	if (_change.applyToFolders && _change.changesMode())
+	{
+		const uint32_t mode = folder->currentMode | newMode(job.info.st_mode, true);
+		if (mode != folder->currentMode && perform("chmod()", *job.parent, job.name, [&job, mode]() {
+			return ::fchmodat(job.parent->fd, job.name.constData(), mode, 0);
+		}))
+		{
+			folder->currentMode = mode;
+			folder->changed = true;
+		}
+	}
+
+	std::vector<QByteArray> names;
+	const bool listed = perform("open()", *job.parent, job.name, [&folder, &job]() {
+		folder->fd = ::openat(job.parent->fd, job.name.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		return folder->fd >= 0 ? 0 : -1;
+	}) && perform("readdir()", *job.parent, job.name, [&folder, &names]() {
+		return listFolder(folder->fd, names) ? 0 : -1;
+	});
+
+	if (listed)
+	{
+		_numItemsDiscovered += names.size();
+		if (_progressHandler)
+			_progressHandler(folder->path, names.size());
+
+		for (const QByteArray& name: names)
+		{
+			if (*_abort)
+				return;
+
+			if (excluded(name))
+				++_numItemsProcessed;
+			else
+				processItem(folder, name);
+		}
+	}
+
+	finishFolder(std::move(folder));
+}
+
+void CAttributeChanger::processItem(const std::shared_ptr<Folder>& parent, const QByteArray& name)
+{
+	Job job;
+	if (!perform("stat()", *parent, name, [&parent, &name, &job]() {
+		return ::fstatat(parent->fd, name.constData(), &job.info, AT_SYMLINK_NOFOLLOW);
+	}))
+	{
+		++_numItemsProcessed;
+		return;
+	}
+
+	if (S_ISDIR(job.info.st_mode))
+	{
+		job.parent = parent;
+		job.name = name;
+		++parent->pendingWork;
+
+		std::lock_guard<std::mutex> lock(_jobsMutex);
+		_jobs.push_back(std::move(job));
+		_jobsCondition.notify_one();
+		return;
+	}
+
+	if (_change.applyToFiles && included(name) && changeItem(*parent, name, job.info, job.info.st_mode & 07777, false))
+		++_numItemsChanged;
+
+	++_numItemsProcessed;
+}
+
+void CAttributeChanger::finishFolder(std::shared_ptr<Folder> folder)
+{
+	while (folder && --folder->pendingWork == 0)
+	{
+		if (folder->parent)
+		{
+			const bool changed = _change.applyToFolders && !*_abort && changeItem(*folder->parent, folder->name, folder->info, folder->currentMode, true);
+			if (changed || folder->changed)
+				++_numItemsChanged;
+
+			++_numItemsProcessed;
+		}
+
+		// Releases the folder, which closes its descriptor unless a subfolder is still being processed
+		folder = folder->parent;
+	}
+}
+
+bool CAttributeChanger::excluded(const QByteArray& name) const
+{
+	return matchesAny(_excludeMasks, name);
+}
+
+bool CAttributeChanger::included(const QByteArray& name) const
+{
+	return _includeMasks.empty() || matchesAny(_includeMasks, name);
+}
+
+uint32_t CAttributeChanger::newMode(uint32_t mode, bool isFolder) const
+{
+	uint32_t modeToSet = _change.modeToSet;
+	if (_change.executeOnlyIfExecutable && !isFolder && (mode & 0111) == 0)
+		modeToSet &= ~0111u;
+
+	return ((mode & 07777) | modeToSet) & ~_change.modeToClear;
+}
+
+bool CAttributeChanger::changeItem(const Folder& parent, const QByteArray& name, const struct stat& info, uint32_t currentMode, bool isFolder)
+{
+	bool changed = false;
+
+	// The owner goes first as changing it may clear the setuid and setgid bits
+	if (_change.changesOwner())
+	{
+		const uid_t owner = _change.ownerId >= 0 ? static_cast<uid_t>(_change.ownerId) : info.st_uid;
+		const gid_t group = _change.groupId >= 0 ? static_cast<gid_t>(_change.groupId) : info.st_gid;
+		if (owner != info.st_uid || group != info.st_gid)
+		{
+			changed |= perform("chown()", parent, name, [&parent, &name, owner, group]() {
+				return ::fchownat(parent.fd, name.constData(), owner, group, AT_SYMLINK_NOFOLLOW);
+			});
+		}
+	}
+
+	// A link's own mode can't be changed, and fchmodat() would change the mode of what it points to
+	if (_change.changesMode() && !S_ISLNK(info.st_mode))
+	{
+		const uint32_t mode = newMode(info.st_mode, isFolder);
+		if (mode != currentMode)
+		{
+			changed |= perform("chmod()", parent, name, [&parent, &name, mode]() {
+				return ::fchmodat(parent.fd, name.constData(), mode, 0);
+			});
+		}
+	}
+
+	if (_change.changesTimes())
+	{
+		const bool accessTimeDiffers = _change.accessTime >= 0 && info.st_atime != static_cast<time_t>(_change.accessTime);
+		const bool modificationTimeDiffers = _change.modificationTime >= 0 && info.st_mtime != static_cast<time_t>(_change.modificationTime);
+		if (accessTimeDiffers || modificationTimeDiffers)
+		{
+			const timespec times[2] {fileTime(_change.accessTime), fileTime(_change.modificationTime)};
+			changed |= perform("utimensat()", parent, name, [&parent, &name, &times]() {
+				return ::utimensat(parent.fd, name.constData(), times, AT_SYMLINK_NOFOLLOW);
+			});
+		}
+	}
+
+	return changed;
+}
+
+bool CAttributeChanger::perform(const char* operationName, const Folder& parent, const QByteArray& name, const std::function<int ()>& operation)
+{
+	for (;;)
+	{
+		if (operation() == 0)
+			return true;
+		else if (errno == EINTR)
+			continue;
+
+		const QString errorMessage = QLatin1String(operationName) + QStringLiteral(" failed: ") + QString::fromLocal8Bit(::strerror(errno));
+		std::lock_guard<std::mutex> lock(_errorHandlerMutex);
+		const QString path = name == "." ? parent.path : parent.path + QFile::decodeName(name);
+		if (*_abort || !_errorHandler || !_errorHandler(path, errorMessage))
+			return false;
+	}
+}
+
+#else // _WIN32
+
+void CAttributeChanger::apply(const std::vector<QString>& /*roots*/, const std::atomic<bool>& /*abort*/, size_t /*numThreads*/)
+{
+	assert_unconditional_r("Changing attributes is not supported on this platform");
+}
+
+#endif // _WIN32
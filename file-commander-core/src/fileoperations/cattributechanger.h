@@ -0,0 +1,130 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QStringList>
+RESTORE_COMPILER_WARNINGS
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+// What operationChangeAttributes does to every item it visits
+struct AttributeChange {
+	// Permission bits (the 07777 part of st_mode) to add and to remove
+	uint32_t modeToSet = 0;
+	uint32_t modeToClear = 0;
+	// Like chmod's 'X': the execute bits of modeToSet are only added to folders and to the files that are already executable by someone
+	bool executeOnlyIfExecutable = false;
+
+	// -1 leaves the owner / the group unchanged
+	int64_t ownerId = -1;
+	int64_t groupId = -1;
+
+	// Seconds since the epoch, -1 leaves the time unchanged
+	int64_t modificationTime = -1;
+	int64_t accessTime = -1;
+
+	bool applyToFiles = true;
+	bool applyToFolders = true;
+	// Wildcard masks matched against the item names. A file is only changed if it matches one of the include masks, or if there are none.
+	// An item that matches an exclude mask is left alone, and so is everything inside an excluded folder.
+	QStringList includeMasks;
+	QStringList excludeMasks;
+
+	bool changesMode() const;
+	bool changesOwner() const;
+	bool changesTimes() const;
+};
+
+// Applies an AttributeChange to whole trees, with the folders processed in parallel by a pool of threads.
+// Every folder is opened once, and all the items in it are listed and changed with fstatat() / fchownat() / fchmodat() / utimensat() relative to its descriptor:
+// no path is ever resolved from the root again, and a folder that is renamed or replaced with a link while the operation is running can't redirect it elsewhere.
+// Symbolic links are never followed. Their own owner and times are changed, their mode can't be. Not supported on Windows.
+class CAttributeChanger
+{
+public:
+	// Called when an item can't be changed. Returns true to retry, false to skip the item.
+	// Called from the worker threads, but never from two of them at the same time.
+	using ErrorHandler = std::function<bool (const QString& path, const QString& errorMessage)>;
+	// Called from the worker threads before the items of a folder are processed, e. g. to pause or throttle the operation
+	using ProgressHandler = std::function<void (const QString& folderPath, size_t numItems)>;
+
+	static constexpr bool supported() noexcept
+	{
+#ifdef _WIN32
+		return false;
+#else
+		return true;
+#endif
+	}
+
+	explicit CAttributeChanger(const AttributeChange& change);
+	~CAttributeChanger();
+
+	void setErrorHandler(ErrorHandler handler);
+	void setProgressHandler(ProgressHandler handler);
+
+	// Changes every item in 'roots' (absolute paths to files or folders) and, for the folders, everything inside.
+	// A root that isn't an absolute path is reported to the error handler and skipped.
+	// Blocks until done or aborted. 0 threads means one per CPU core, but no less than 4: the threads mostly wait for the file system.
+	void apply(const std::vector<QString>& roots, const std::atomic<bool>& abort, size_t numThreads = 0);
+
+	// The items seen so far, the items already dealt with, and the items that have actually been changed
+	size_t numItemsDiscovered() const;
+	size_t numItemsProcessed() const;
+	size_t numItemsChanged() const;
+
+private:
+	struct Folder;
+	// A folder waiting to be processed
+	struct Job {
+		std::shared_ptr<Folder> parent;
+		QByteArray name;
+		struct stat info;
+	};
+
+	void workerThread();
+	void processFolder(const Job& job);
+	// Changes a file or a link right away, queues a folder
+	void processItem(const std::shared_ptr<Folder>& parent, const QByteArray& name);
+	// Called when a folder or one of its subfolders has been processed; the folder itself is changed once all of them have been
+	void finishFolder(std::shared_ptr<Folder> folder);
+
+	bool excluded(const QByteArray& name) const;
+	bool included(const QByteArray& name) const;
+	uint32_t newMode(uint32_t mode, bool isFolder) const;
+	// 'currentMode' may differ from the one in 'info' if the item has already been changed. Returns true if anything has been changed.
+	bool changeItem(const Folder& parent, const QByteArray& name, const struct stat& info, uint32_t currentMode, bool isFolder);
+	// Runs 'operation' until it succeeds or the error handler gives up on it
+	bool perform(const char* operationName, const Folder& parent, const QByteArray& name, const std::function<int ()>& operation);
+
+private:
+	const AttributeChange _change;
+	std::vector<QByteArray> _includeMasks;
+	std::vector<QByteArray> _excludeMasks;
+
+	ErrorHandler _errorHandler;
+	ProgressHandler _progressHandler;
+	std::mutex _errorHandlerMutex;
+
+	// The folders waiting to be processed. Taken from the back, so that the tree is walked roughly depth-first
+	// and only the folders on the current paths are open.
+	std::vector<Job> _jobs;
+	std::mutex _jobsMutex;
+	std::condition_variable _jobsCondition;
+	size_t _numBusyWorkers = 0;
+
+	const std::atomic<bool>* _abort = nullptr;
+	std::atomic<size_t> _numItemsDiscovered {0};
+	std::atomic<size_t> _numItemsProcessed {0};
+	std::atomic<size_t> _numItemsChanged {0};
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stddef.h>
+
+// A simple blocking producer / consumer queue with a capacity limit.
+// The producer blocks in push() while the queue is full, the consumer blocks in pop() while it's empty.
+// close() wakes everybody up: push() starts failing immediately, pop() keeps returning the remaining items and fails once the queue is drained.
+template <typename T>
+class CBoundedQueue
+{
+public:
+	explicit CBoundedQueue(size_t capacity) noexcept : _capacity(capacity > 0 ? capacity : 1)
+	{}
+
+	CBoundedQueue& operator=(const CBoundedQueue&) = delete;
+
+	// Returns false if the queue has been closed
+	bool push(T&& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_notFull.wait(lock, [this]() {return _closed || _items.size() < _capacity;});
+		if (_closed)
+			return false;
+
+		_items.emplace_back(std::move(item));
+		lock.unlock();
+
+		_notEmpty.notify_one();
+		return true;
+	}
+
+	// Returns false if the queue has been closed and there are no more items
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_notEmpty.wait(lock, [this]() {return _closed || !_items.empty();});
+		if (_items.empty())
+			return false;
+
+		item = std::move(_items.front());
+		_items.pop_front();
+		lock.unlock();
+
+		_notFull.notify_one();
+		return true;
+	}
+
+	// No more items will be accepted; the ones already queued can still be popped
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_closed = true;
+		}
+
+		_notFull.notify_all();
+		_notEmpty.notify_all();
+	}
+
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _items.size();
+	}
+
+private:
+	std::deque<T> _items;
+	const size_t _capacity;
+	bool _closed = false;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _notFull, _notEmpty;
+};
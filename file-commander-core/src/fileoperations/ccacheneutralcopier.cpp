@@ -0,0 +1,347 @@
+#include "ccacheneutralcopier.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+inline size_t alignUp(size_t size) noexcept
+{
+	return (size + CCacheNeutralCopier::Alignment - 1) / CCacheNeutralCopier::Alignment * CCacheNeutralCopier::Alignment;
+}
+
+#ifndef _WIN32
+
+int openFile(const QString& path, int flags, bool& directIo) noexcept
+{
+	const QByteArray encodedPath = QFile::encodeName(path);
+
+#ifdef O_DIRECT
+	const int directFd = ::open(encodedPath.constData(), flags | O_DIRECT | O_CLOEXEC);
+	if (directFd >= 0)
+	{
+		directIo = true;
+		return directFd;
+	}
+	else if (errno != EINVAL)
+		return -1;
+
+	// EINVAL means the file system doesn't support O_DIRECT (e. g. tmpfs), fall back to cached access
+#endif
+
+	directIo = false;
+	const int fd = ::open(encodedPath.constData(), flags | O_CLOEXEC);
+#ifdef __APPLE__
+	if (fd >= 0)
+		::fcntl(fd, F_NOCACHE, 1);
+#endif
+
+	return fd;
+}
+
+// Some file systems accept O_DIRECT on open() but then reject the actual I/O, the only remedy is to continue without it
+bool disableDirectIo(int fd) noexcept
+{
+#ifdef O_DIRECT
+	const int flags = ::fcntl(fd, F_GETFL);
+	return flags != -1 && ::fcntl(fd, F_SETFL, flags & ~O_DIRECT) == 0;
+#else
+	(void)fd;
+	return false;
+#endif
+}
+
+#endif // !_WIN32
+
+}
+
+CCacheNeutralCopier::~CCacheNeutralCopier() noexcept
+{
+	close();
+}
+
+#ifndef _WIN32
+
+bool CCacheNeutralCopier::open(const QString& sourcePath, const QString& destPath, uint64_t fileSize) noexcept
+{
+	close();
+	_fileSize = fileSize;
+
+	_sourceFd = openFile(sourcePath, O_RDONLY, _sourceDirectIo);
+	if (_sourceFd < 0)
+		return setError("open() source");
+
+	_destFd = openFile(destPath, O_WRONLY, _destDirectIo);
+	if (_destFd < 0)
+	{
+		setError("open() destination");
+		close();
+		return false;
+	}
+
+#if defined __linux__ || defined __FreeBSD__
+	if (!_sourceDirectIo)
+		::posix_fadvise(_sourceFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	return true;
+}
+
+bool CCacheNeutralCopier::copy(uint64_t offset, size_t length) noexcept
+{
+	assert_and_return_r(isOpen(), false);
+	if (length == 0)
+		return true;
+
+	const size_t alignedLength = alignUp(length);
+	if (!ensureBufferCapacity(alignedLength))
+		return false;
+
+	if (!read(offset, length, alignedLength) || !write(offset, length))
+		return false;
+
+	evictCopiedRange(offset, length);
+	return true;
+}
+
+bool CCacheNeutralCopier::finish() noexcept
+{
+	assert_and_return_r(isOpen(), false);
+
+#ifdef __linux__
+	if (_pendingWritebackLength > 0)
+	{
+		::sync_file_range(_destFd, static_cast<off_t>(_pendingWritebackOffset), static_cast<off_t>(_pendingWritebackLength), SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+		::posix_fadvise(_destFd, static_cast<off_t>(_pendingWritebackOffset), static_cast<off_t>(_pendingWritebackLength), POSIX_FADV_DONTNEED);
+		_pendingWritebackLength = 0;
+	}
+#endif
+
+	// Direct writes are padded to the alignment, the padding has to be cut off
+	if (::ftruncate(_destFd, static_cast<off_t>(_fileSize)) != 0)
+		return setError("ftruncate()");
+
+	return true;
+}
+
+void CCacheNeutralCopier::close() noexcept
+{
+	if (_sourceFd >= 0)
+		::close(_sourceFd);
+	if (_destFd >= 0)
+		::close(_destFd);
+
+	_sourceFd = _destFd = -1;
+	_sourceDirectIo = _destDirectIo = false;
+	_pendingWritebackOffset = 0;
+	_pendingWritebackLength = 0;
+
+	::free(_buffer);
+	_buffer = nullptr;
+	_bufferSize = 0;
+}
+
+bool CCacheNeutralCopier::ensureBufferCapacity(size_t size) noexcept
+{
+	if (_bufferSize >= size)
+		return true;
+
+	::free(_buffer);
+	_buffer = nullptr;
+	_bufferSize = 0;
+
+	void* buffer = nullptr;
+	if (::posix_memalign(&buffer, Alignment, size) != 0)
+	{
+		_lastErrorMessage = QStringLiteral("Failed to allocate the copy buffer");
+		return false;
+	}
+
+	_buffer = static_cast<char*>(buffer);
+	_bufferSize = size;
+	return true;
+}
+
+bool CCacheNeutralCopier::read(uint64_t offset, size_t length, size_t alignedLength) noexcept
+{
+	size_t bytesRead = 0;
+	while (bytesRead < length)
+	{
+		// Direct reads must be aligned in size as well; at the end of the file the read simply comes out short
+		const size_t requestedLength = (_sourceDirectIo ? alignedLength : length) - bytesRead;
+		const ssize_t result = ::pread(_sourceFd, _buffer + bytesRead, requestedLength, static_cast<off_t>(offset + bytesRead));
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			else if (errno == EINVAL && _sourceDirectIo && disableDirectIo(_sourceFd))
+			{
+				_sourceDirectIo = false;
+				continue;
+			}
+
+			return setError("read()");
+		}
+		else if (result == 0)
+		{
+			_lastErrorMessage = QStringLiteral("The source file is shorter than expected");
+			return false;
+		}
+
+		bytesRead += static_cast<size_t>(result);
+	}
+
+	return true;
+}
+
+bool CCacheNeutralCopier::write(uint64_t offset, size_t length) noexcept
+{
+	// Direct writes must be aligned in size, the padding is cut off by finish()
+	if (_destDirectIo)
+		::memset(_buffer + length, 0, alignUp(length) - length);
+
+	size_t bytesWritten = 0;
+	for (;;)
+	{
+		const size_t totalLength = _destDirectIo ? alignUp(length) : length;
+		if (bytesWritten >= totalLength)
+			return true;
+
+		const ssize_t result = ::pwrite(_destFd, _buffer + bytesWritten, totalLength - bytesWritten, static_cast<off_t>(offset + bytesWritten));
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			else if (errno == EINVAL && _destDirectIo && disableDirectIo(_destFd))
+			{
+				_destDirectIo = false;
+				continue;
+			}
+
+			return setError("write()");
+		}
+
+		bytesWritten += static_cast<size_t>(result);
+	}
+}
+
+void CCacheNeutralCopier::evictCopiedRange(uint64_t offset, size_t length) noexcept
+{
+#if defined __linux__ || defined __FreeBSD__
+	const auto fileOffset = static_cast<off_t>(offset);
+	const auto rangeLength = static_cast<off_t>(length);
+
+	if (!_sourceDirectIo)
+		::posix_fadvise(_sourceFd, fileOffset, rangeLength, POSIX_FADV_DONTNEED);
+
+	if (_destDirectIo)
+		return;
+
+	// Dirty pages can't be dropped, they have to be written back first
+#ifdef __linux__
+	// Start the writeback of this chunk, then wait for the previous one. This keeps the disk busy and no more than two chunks dirty at any time.
+	::sync_file_range(_destFd, fileOffset, rangeLength, SYNC_FILE_RANGE_WRITE);
+	if (_pendingWritebackLength > 0)
+	{
+		::sync_file_range(_destFd, static_cast<off_t>(_pendingWritebackOffset), static_cast<off_t>(_pendingWritebackLength), SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+		::posix_fadvise(_destFd, static_cast<off_t>(_pendingWritebackOffset), static_cast<off_t>(_pendingWritebackLength), POSIX_FADV_DONTNEED);
+	}
+
+	_pendingWritebackOffset = offset;
+	_pendingWritebackLength = length;
+#else
+	::fdatasync(_destFd);
+	::posix_fadvise(_destFd, fileOffset, rangeLength, POSIX_FADV_DONTNEED);
+#endif
+
+#else
+	// F_NOCACHE (macOS) doesn't need any further help
+	(void)offset;
+	(void)length;
+#endif
+}
+
+bool CCacheNeutralCopier::setError(const char* operation) noexcept
+{
+	_lastErrorMessage = QLatin1String(operation) + QStringLiteral(" failed: ") + QString::fromLocal8Bit(::strerror(errno));
+	return false;
+}
+
+#else // _WIN32
+
+bool CCacheNeutralCopier::open(const QString& /*sourcePath*/, const QString& /*destPath*/, uint64_t /*fileSize*/) noexcept
+{
+	_lastErrorMessage = QStringLiteral("Cache-neutral copying is not supported on this platform");
+	return false;
+}
+
+bool CCacheNeutralCopier::copy(uint64_t /*offset*/, size_t /*length*/) noexcept
+{
+	return false;
+}
+
+bool CCacheNeutralCopier::finish() noexcept
+{
+	return false;
+}
+
+void CCacheNeutralCopier::close() noexcept
+{
+}
+
+bool CCacheNeutralCopier::ensureBufferCapacity(size_t /*size*/) noexcept
+{
+	return false;
+}
+
+bool CCacheNeutralCopier::read(uint64_t /*offset*/, size_t /*length*/, size_t /*alignedLength*/) noexcept
+{
+	return false;
+}
+
+bool CCacheNeutralCopier::write(uint64_t /*offset*/, size_t /*length*/) noexcept
+{
+	return false;
+}
+
+void CCacheNeutralCopier::evictCopiedRange(uint64_t /*offset*/, size_t /*length*/) noexcept
+{
+}
+
+bool CCacheNeutralCopier::setError(const char* /*operation*/) noexcept
+{
+	return false;
+}
+
+#endif // _WIN32
+
+bool CCacheNeutralCopier::isOpen() const noexcept
+{
+	return _sourceFd >= 0 && _destFd >= 0;
+}
+
+bool CCacheNeutralCopier::sourceDirectIo() const noexcept
+{
+	return _sourceDirectIo;
+}
+
+bool CCacheNeutralCopier::destDirectIo() const noexcept
+{
+	return _destDirectIo;
+}
+
+QString CCacheNeutralCopier::lastErrorMessage() const
+{
+	return _lastErrorMessage;
+}
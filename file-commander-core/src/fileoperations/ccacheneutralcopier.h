@@ -0,0 +1,77 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Copies file data while keeping the OS page cache out of it as much as possible, so that a huge copy doesn't evict the working set of every other process.
+// Where the file system allows it, both files are accessed with O_DIRECT through aligned buffers and no caching takes place at all.
+// Otherwise the data goes through the cache but is pushed out right behind the copy: written pages are flushed with sync_file_range()
+// so that no more than two chunks are ever dirty, and the ranges already copied are dropped with posix_fadvise(POSIX_FADV_DONTNEED).
+// On macOS the same effect is achieved with F_NOCACHE. Not supported on Windows.
+class CCacheNeutralCopier
+{
+public:
+	// O_DIRECT requires the buffer address, file offsets and transfer sizes to be multiples of the logical block size; 4K covers all the common devices
+	static constexpr size_t Alignment = 4096;
+
+	static constexpr bool supported() noexcept
+	{
+#if defined __linux__ || defined __FreeBSD__ || defined __APPLE__
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	CCacheNeutralCopier() noexcept = default;
+	~CCacheNeutralCopier() noexcept;
+
+	CCacheNeutralCopier(const CCacheNeutralCopier&) = delete;
+	CCacheNeutralCopier& operator=(const CCacheNeutralCopier&) = delete;
+
+	// The destination file must already exist, it's neither created nor truncated here
+	bool open(const QString& sourcePath, const QString& destPath, uint64_t fileSize) noexcept;
+	// The ranges must be consecutive, and all the chunks except the last one must be multiples of Alignment in size
+	bool copy(uint64_t offset, size_t length) noexcept;
+	// Flushes the data still in flight and trims the destination to the exact file size. Must be called once the last chunk has been copied.
+	bool finish() noexcept;
+	void close() noexcept;
+
+	bool isOpen() const noexcept;
+	// Whether the data is actually bypassing the cache rather than being evicted after the fact
+	bool sourceDirectIo() const noexcept;
+	bool destDirectIo() const noexcept;
+
+	QString lastErrorMessage() const;
+
+private:
+	bool ensureBufferCapacity(size_t size) noexcept;
+	// Reads 'length' bytes into the buffer. 'alignedLength' is 'length' rounded up to Alignment, the size of a direct read.
+	bool read(uint64_t offset, size_t length, size_t alignedLength) noexcept;
+	// Writes 'length' bytes from the buffer. The length need not be aligned: for direct I/O, the data is padded to Alignment here.
+	bool write(uint64_t offset, size_t length) noexcept;
+	void evictCopiedRange(uint64_t offset, size_t length) noexcept;
+	bool setError(const char* operation) noexcept;
+
+private:
+	int _sourceFd = -1;
+	int _destFd = -1;
+	bool _sourceDirectIo = false;
+	bool _destDirectIo = false;
+
+	uint64_t _fileSize = 0;
+	// The previous chunk written through the cache; its writeback is waited for after the next chunk has been submitted
+	uint64_t _pendingWritebackOffset = 0;
+	size_t _pendingWritebackLength = 0;
+
+	char* _buffer = nullptr;
+	size_t _bufferSize = 0;
+
+	QString _lastErrorMessage;
+};
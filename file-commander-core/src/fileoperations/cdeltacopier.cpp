@@ -0,0 +1,436 @@
+#include "cdeltacopier.h"
+#include "assert/advanced_assert.h"
+#include "threading/thread_helpers.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <errno.h>
+#include <functional>
+#include <string.h>
+
+namespace {
+
+#ifndef _WIN32
+
+// Returns 0 or the errno value
+int readFully(int fd, char* buffer, size_t length, uint64_t offset) noexcept
+{
+	size_t bytesRead = 0;
+	while (bytesRead < length)
+	{
+		const ssize_t result = ::pread(fd, buffer + bytesRead, length - bytesRead, static_cast<off_t>(offset + bytesRead));
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return errno;
+		}
+		else if (result == 0)
+			return ENODATA; // The file is shorter than expected
+
+		bytesRead += static_cast<size_t>(result);
+	}
+
+	return 0;
+}
+
+int writeFully(int fd, const char* buffer, size_t length, uint64_t offset) noexcept
+{
+	size_t bytesWritten = 0;
+	while (bytesWritten < length)
+	{
+		const ssize_t result = ::pwrite(fd, buffer + bytesWritten, length - bytesWritten, static_cast<off_t>(offset + bytesWritten));
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return errno;
+		}
+
+		bytesWritten += static_cast<size_t>(result);
+	}
+
+	return 0;
+}
+
+CBlake3Hasher::Digest digestOf(const std::vector<char>& data) noexcept
+{
+	CBlake3Hasher hasher;
+	hasher.update(data.data(), data.size());
+	return hasher.finalize();
+}
+
+#endif // !_WIN32
+
+}
+
+CDeltaCopier::~CDeltaCopier() noexcept
+{
+	close();
+}
+
+#ifndef _WIN32
+
+bool CDeltaCopier::open(const QString& sourcePath, const QString& destPath, uint64_t fileSize) noexcept
+{
+	close();
+	_fileSize = fileSize;
+	_digest = {};
+
+	_sourceFd = ::open(QFile::encodeName(sourcePath).constData(), O_RDONLY | O_CLOEXEC);
+	if (_sourceFd < 0)
+		return setError("open() source", errno);
+
+	_destFd = ::open(QFile::encodeName(destPath).constData(), O_RDWR | O_CLOEXEC);
+	if (_destFd < 0)
+	{
+		setError("open() destination", errno);
+		close();
+		return false;
+	}
+
+#if defined __linux__ || defined __FreeBSD__
+	::posix_fadvise(_sourceFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	::posix_fadvise(_destFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	startWorkers();
+	return true;
+}
+
+bool CDeltaCopier::update(uint64_t offset, size_t length) noexcept
+{
+	assert_and_return_r(isOpen(), false);
+	assert_and_return_r(offset == _nextOffset && offset + length <= _fileSize, false);
+	if (length == 0)
+		return true;
+
+	// Splitting the range at the block boundaries
+	size_t numSegments = 0;
+	for (uint64_t segmentOffset = offset; segmentOffset < offset + length; ++numSegments)
+	{
+		if (_segments.size() <= numSegments)
+			_segments.emplace_back();
+
+		Segment& segment = _segments[numSegments];
+		const uint64_t blockEnd = (segmentOffset / BlockSize + 1) * BlockSize;
+		segment.offset = segmentOffset;
+		segment.length = static_cast<size_t>(std::min(blockEnd, offset + length) - segmentOffset);
+		segmentOffset += segment.length;
+	}
+
+	if (numSegments == 1 || _workers.empty())
+	{
+		for (size_t i = 0; i < numSegments; ++i)
+			processSegment(_segments[i]);
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(_workMutex);
+			_numSegmentsToProcess = numSegments;
+			_nextSegment = 0;
+			_numBusyWorkers = _workers.size();
+			++_workGeneration;
+		}
+		_workAvailable.notify_all();
+
+		processPendingSegments();
+
+		std::unique_lock<std::mutex> lock(_workMutex);
+		_workDone.wait(lock, [this] {
+			return _numBusyWorkers == 0;
+		});
+	}
+
+	// Collecting the results in order
+	for (size_t i = 0; i < numSegments; ++i)
+	{
+		Segment& segment = _segments[i];
+		if (segment.error != 0)
+			return setError(segment.failedOperation, segment.error);
+
+		if (segment.hashedAsSubtree)
+			_hasher.pushSubtree(segment.chainingValue, BlockSize / CBlake3Hasher::ChunkLength);
+		else
+			hashPartialBlock(segment.sourceData, segment.offset);
+
+		if (segment.written)
+		{
+			_bytesWritten += segment.length;
+			_writtenRanges.push_back({segment.offset, segment.length, segment.digest});
+		}
+		else
+			_bytesSkipped += segment.length;
+	}
+
+	_nextOffset += length;
+	return true;
+}
+
+bool CDeltaCopier::finish() noexcept
+{
+	assert_and_return_r(isOpen(), false);
+	assert_and_return_r(_nextOffset == _fileSize, false);
+
+	if (::ftruncate(_destFd, static_cast<off_t>(_fileSize)) != 0)
+		return setError("ftruncate()", errno);
+
+	// The written data must be verified as stored on the disk, not as still sitting in the cache
+	if (!_writtenRanges.empty())
+	{
+		if (::fdatasync(_destFd) != 0)
+			return setError("fdatasync()", errno);
+
+#if defined __linux__ || defined __FreeBSD__
+		::posix_fadvise(_destFd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+	}
+
+	std::vector<char> buffer;
+	for (const WrittenRange& range: _writtenRanges)
+	{
+		buffer.resize(range.length);
+		const int error = readFully(_destFd, buffer.data(), range.length, range.offset);
+		if (error != 0)
+			return setError("read() for verification", error);
+
+		if (digestOf(buffer) != range.digest)
+		{
+			_lastErrorMessage = QStringLiteral("Verification failed: the data read back from the destination at offset %1 doesn't match the source").arg(range.offset);
+			return false;
+		}
+	}
+
+	// The skipped blocks have been compared byte for byte and the written ones verified, so the destination now hashes to the same digest as the source
+	_digest = _hasher.finalize();
+	return true;
+}
+
+void CDeltaCopier::close() noexcept
+{
+	stopWorkers();
+
+	if (_sourceFd >= 0)
+		::close(_sourceFd);
+	if (_destFd >= 0)
+		::close(_destFd);
+
+	_sourceFd = _destFd = -1;
+	_fileSize = 0;
+	_nextOffset = 0;
+	_bytesWritten = 0;
+	_bytesSkipped = 0;
+
+	_segments.clear();
+	_writtenRanges.clear();
+	_partialBlock.clear();
+	_hasher = CBlake3Hasher();
+}
+
+void CDeltaCopier::processSegment(Segment& segment) const noexcept
+{
+	segment.written = false;
+	segment.hashedAsSubtree = false;
+	segment.error = 0;
+	segment.sourceData.resize(segment.length);
+	segment.destData.resize(segment.length);
+
+	if ((segment.error = readFully(_sourceFd, segment.sourceData.data(), segment.length, segment.offset)) != 0)
+	{
+		segment.failedOperation = "read() source";
+		return;
+	}
+
+	if ((segment.error = readFully(_destFd, segment.destData.data(), segment.length, segment.offset)) != 0)
+	{
+		segment.failedOperation = "read() destination";
+		return;
+	}
+
+	if (::memcmp(segment.sourceData.data(), segment.destData.data(), segment.length) != 0)
+	{
+		if ((segment.error = writeFully(_destFd, segment.sourceData.data(), segment.length, segment.offset)) != 0)
+		{
+			segment.failedOperation = "write()";
+			return;
+		}
+
+		segment.written = true;
+		segment.digest = digestOf(segment.sourceData);
+	}
+
+	// The last block has to go through CBlake3Hasher::update() because it contains the root node
+	if (segment.length == BlockSize && segment.offset + BlockSize < _fileSize)
+	{
+		segment.chainingValue = CBlake3Hasher::subtreeChainingValue(segment.sourceData.data(), BlockSize, segment.offset / CBlake3Hasher::ChunkLength);
+		segment.hashedAsSubtree = true;
+	}
+}
+
+void CDeltaCopier::processPendingSegments() noexcept
+{
+	for (size_t i = _nextSegment++; i < _numSegmentsToProcess; i = _nextSegment++)
+		processSegment(_segments[i]);
+}
+
+void CDeltaCopier::workerThread() noexcept
+{
+	setThreadName("CDeltaCopier worker thread");
+
+	uint64_t lastGeneration = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_workMutex);
+			_workAvailable.wait(lock, [this, lastGeneration] {
+				return _stopWorkers || _workGeneration != lastGeneration;
+			});
+
+			if (_stopWorkers)
+				return;
+
+			lastGeneration = _workGeneration;
+		}
+
+		processPendingSegments();
+
+		std::lock_guard<std::mutex> lock(_workMutex);
+		if (--_numBusyWorkers == 0)
+			_workDone.notify_one();
+	}
+}
+
+void CDeltaCopier::startWorkers() noexcept
+{
+	assert_r(_workers.empty());
+
+	const size_t numWorkers = std::min(static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 2u)) - 1, MaxWorkerThreads);
+	_workGeneration = 0;
+	_stopWorkers = false;
+	_workers.reserve(numWorkers);
+	for (size_t i = 0; i < numWorkers; ++i)
+		_workers.emplace_back(&CDeltaCopier::workerThread, this);
+}
+
+void CDeltaCopier::stopWorkers() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock(_workMutex);
+		_stopWorkers = true;
+	}
+	_workAvailable.notify_all();
+
+	for (auto& worker: _workers)
+		worker.join();
+
+	_workers.clear();
+}
+
+bool CDeltaCopier::setError(const char* operation, int error) noexcept
+{
+	_lastErrorMessage = QLatin1String(operation) + QStringLiteral(" failed: ") + QString::fromLocal8Bit(::strerror(error));
+	return false;
+}
+
+#else // _WIN32
+
+bool CDeltaCopier::open(const QString& /*sourcePath*/, const QString& /*destPath*/, uint64_t /*fileSize*/) noexcept
+{
+	_lastErrorMessage = QStringLiteral("Delta transfer is not supported on this platform");
+	return false;
+}
+
+bool CDeltaCopier::update(uint64_t /*offset*/, size_t /*length*/) noexcept
+{
+	return false;
+}
+
+bool CDeltaCopier::finish() noexcept
+{
+	return false;
+}
+
+void CDeltaCopier::close() noexcept
+{
+}
+
+void CDeltaCopier::processSegment(Segment& /*segment*/) const noexcept
+{
+}
+
+void CDeltaCopier::processPendingSegments() noexcept
+{
+}
+
+void CDeltaCopier::workerThread() noexcept
+{
+}
+
+void CDeltaCopier::startWorkers() noexcept
+{
+}
+
+void CDeltaCopier::stopWorkers() noexcept
+{
+}
+
+bool CDeltaCopier::setError(const char* /*operation*/, int /*error*/) noexcept
+{
+	return false;
+}
+
+#endif // _WIN32
+
+void CDeltaCopier::hashPartialBlock(const std::vector<char>& data, uint64_t offset) noexcept
+{
+	_partialBlock.insert(_partialBlock.end(), data.begin(), data.end());
+
+	const uint64_t blockOffset = offset / BlockSize * BlockSize;
+	const uint64_t blockEnd = std::min(blockOffset + BlockSize, _fileSize);
+	if (offset + data.size() < blockEnd)
+		return; // More of this block to come
+
+	assert_r(_partialBlock.size() == blockEnd - blockOffset);
+	if (blockEnd == _fileSize)
+		_hasher.update(_partialBlock.data(), _partialBlock.size());
+	else
+		_hasher.pushSubtree(CBlake3Hasher::subtreeChainingValue(_partialBlock.data(), BlockSize, blockOffset / CBlake3Hasher::ChunkLength), BlockSize / CBlake3Hasher::ChunkLength);
+
+	_partialBlock.clear();
+}
+
+bool CDeltaCopier::isOpen() const noexcept
+{
+	return _sourceFd >= 0 && _destFd >= 0;
+}
+
+uint64_t CDeltaCopier::bytesWritten() const noexcept
+{
+	return _bytesWritten;
+}
+
+uint64_t CDeltaCopier::bytesSkipped() const noexcept
+{
+	return _bytesSkipped;
+}
+
+CBlake3Hasher::Digest CDeltaCopier::digest() const noexcept
+{
+	return _digest;
+}
+
+QString CDeltaCopier::lastErrorMessage() const
+{
+	return _lastErrorMessage;
+}
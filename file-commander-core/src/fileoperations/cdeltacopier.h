@@ -0,0 +1,126 @@
+#pragma once
+
+#include "hashing/cblake3hasher.h"
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Brings an existing destination file up to date with the source by writing only the parts that differ ("update in place").
+// Meant for huge files with few changes, such as VM images: both files are still read in full, but the unchanged blocks are not written,
+// and writing is what's slow on a network share or a USB drive, and what wears out an SSD.
+// The blocks are compared at the same offsets, several at a time on a pool of worker threads that lives as long as the file is open. Searching for moved data with a rolling checksum, as rsync does,
+// would not save anything here: rsync uses it to avoid sending data over the network, but data that has moved has to be written at its new offset either way.
+// The BLAKE3 digest of the file is calculated in the same pass, and once the copy is complete the written blocks are read back from the disk and verified.
+// Not supported on Windows.
+class CDeltaCopier
+{
+public:
+	// A power of two multiple of the BLAKE3 chunk length so that the blocks can be hashed as independent subtrees
+	static constexpr size_t BlockSize = 1024 * 1024;
+	// The calling thread processes segments as well
+	static constexpr size_t MaxWorkerThreads = 7;
+	// Smaller files are simply rewritten, reading the destination first wouldn't pay off
+	static constexpr uint64_t MinFileSize = 16 * 1024 * 1024;
+
+	static constexpr bool supported() noexcept
+	{
+#ifdef _WIN32
+		return false;
+#else
+		return true;
+#endif
+	}
+
+	CDeltaCopier() noexcept = default;
+	~CDeltaCopier() noexcept;
+
+	CDeltaCopier(const CDeltaCopier&) = delete;
+	CDeltaCopier& operator=(const CDeltaCopier&) = delete;
+
+	// The destination must already exist and have the same size as the source
+	bool open(const QString& sourcePath, const QString& destPath, uint64_t fileSize) noexcept;
+	// The ranges must be consecutive, starting from 0
+	bool update(uint64_t offset, size_t length) noexcept;
+	// Must be called once the whole file has been processed. Flushes the destination and verifies the blocks written.
+	bool finish() noexcept;
+	void close() noexcept;
+
+	bool isOpen() const noexcept;
+
+	uint64_t bytesWritten() const noexcept;
+	// The data that was already identical at the destination
+	uint64_t bytesSkipped() const noexcept;
+	// The BLAKE3 digest of the file, available after finish()
+	CBlake3Hasher::Digest digest() const noexcept;
+
+	QString lastErrorMessage() const;
+
+private:
+	// A part of a block processed by one thread
+	struct Segment {
+		uint64_t offset = 0;
+		size_t length = 0;
+		bool written = false;
+		bool hashedAsSubtree = false;
+		int error = 0;
+		const char* failedOperation = nullptr;
+		CBlake3Hasher::ChainingValue chainingValue;
+		CBlake3Hasher::Digest digest; // Of the data written, for verification
+		std::vector<char> sourceData;
+		std::vector<char> destData;
+	};
+
+	struct WrittenRange {
+		uint64_t offset;
+		size_t length;
+		CBlake3Hasher::Digest digest;
+	};
+
+	void processSegment(Segment& segment) const noexcept;
+	// Takes the segments of the current update() one by one until none are left
+	void processPendingSegments() noexcept;
+	void workerThread() noexcept;
+	void startWorkers() noexcept;
+	void stopWorkers() noexcept;
+	// Blocks that were processed in several parts are hashed once complete
+	void hashPartialBlock(const std::vector<char>& data, uint64_t offset) noexcept;
+	bool setError(const char* operation, int error) noexcept;
+
+private:
+	int _sourceFd = -1;
+	int _destFd = -1;
+	uint64_t _fileSize = 0;
+	uint64_t _nextOffset = 0;
+
+	uint64_t _bytesWritten = 0;
+	uint64_t _bytesSkipped = 0;
+
+	std::vector<Segment> _segments;
+
+	std::vector<std::thread> _workers;
+	std::mutex _workMutex;
+	std::condition_variable _workAvailable;
+	std::condition_variable _workDone;
+	uint64_t _workGeneration = 0; // Incremented by each update() that needs the workers
+	size_t _numBusyWorkers = 0;
+	size_t _numSegmentsToProcess = 0;
+	std::atomic<size_t> _nextSegment {0};
+	bool _stopWorkers = false;
+
+	std::vector<WrittenRange> _writtenRanges;
+	CBlake3Hasher _hasher;
+	std::vector<char> _partialBlock;
+	CBlake3Hasher::Digest _digest {};
+
+	QString _lastErrorMessage;
+};
@@ -0,0 +1,41 @@
+#include "chardlinktracker.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+bool CHardLinkTracker::multiplyLinkedFileId(const CFileSystemObject& file, FileId& id)
+{
+#ifndef _WIN32
+	if (!file.isFile() || file.isSymLink())
+		return false;
+
+	struct stat info;
+	// lstat() rather than stat(): the link count of a symlink's target is of no interest
+	if (::lstat(QFile::encodeName(file.fullAbsolutePath()).constData(), &info) != 0 || !S_ISREG(info.st_mode) || info.st_nlink < 2)
+		return false;
+
+	id.device = static_cast<uint64_t>(info.st_dev);
+	id.inode = static_cast<uint64_t>(info.st_ino);
+	return true;
+#else
+	(void)file;
+	(void)id;
+	return false;
+#endif
+}
+
+QString CHardLinkTracker::copyOf(const FileId& id) const
+{
+	const auto it = _copies.find(id);
+	return it != _copies.end() ? it->second : QString();
+}
+
+void CHardLinkTracker::registerCopy(const FileId& id, const QString& copyPath)
+{
+	_copies.emplace(id, copyPath);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "cfilesystemobject.h"
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <stdint.h>
+#include <unordered_map>
+
+// Remembers where the files that have more than one hard link have been copied to,
+// so that the other links to the same file can be recreated as hard links to that copy instead of copying the data again.
+// Files are identified by their device and inode numbers. Hard links are not tracked on Windows.
+class CHardLinkTracker
+{
+public:
+	struct FileId {
+		uint64_t device = 0;
+		uint64_t inode = 0;
+
+		bool operator==(const FileId& other) const noexcept {
+			return device == other.device && inode == other.inode;
+		}
+	};
+
+	// Returns false if the file only has one link (there's nothing to track), if it's not a regular file, or if it can't be queried.
+	// The type known from the scan rules out the folders and the links without a query; QFileInfo has no link count or inode, so a file still costs an lstat().
+	static bool multiplyLinkedFileId(const CFileSystemObject& file, FileId& id);
+
+	// The path of the copy made for the first link to the file, or an empty string if there's none yet
+	QString copyOf(const FileId& id) const;
+	void registerCopy(const FileId& id, const QString& copyPath);
+
+private:
+	struct FileIdHash {
+		size_t operator()(const FileId& id) const noexcept {
+			return std::hash<uint64_t>{}(id.inode * 31 + id.device);
+		}
+	};
+
+	std::unordered_map<FileId, QString, FileIdHash> _copies;
+};
@@ -3,6 +3,8 @@
 #include "filesystemhelperfunctions.h"
 #include "directoryscanner.h"
 #include "threading/thread_helpers.h"
+#include "tracing/ctracer.h"
+#include "metrics/cmetricsregistry.h"
 #include "utility/on_scope_exit.hpp"
 #include "utility/integer_literals.hpp"
 
@@ -10,6 +12,8 @@ DISABLE_COMPILER_WARNINGS
 #include <QStringBuilder>
 RESTORE_COMPILER_WARNINGS
 
+#include <algorithm>
+
 inline HaltReason haltReasonForOperationError(FileOperationResultCode errorCode)
 {
 	assert_without_abort(errorCode != FileOperationResultCode::Ok);
@@ -27,6 +31,17 @@ inline HaltReason haltReasonForOperationError(FileOperationResultCode errorCode)
 	}
 }
 
+// With a bandwidth cap, a chunk is about 1/10 s worth of data so that the throttling is smooth and the progress keeps updating
+inline size_t copyChunkSize(uint64_t bandwidthLimit)
+{
+	constexpr uint64_t maxChunkSize = 5 * 1024 * 1024, minChunkSize = 64 * 1024;
+	if (bandwidthLimit == 0)
+		return maxChunkSize;
+
+	// A multiple of 64K keeps the chunks aligned for cache-neutral copying
+	return (size_t)(std::clamp(bandwidthLimit / 10, minChunkSize, maxChunkSize) / minChunkSize * minChunkSize);
+}
+
 COperationPerformer::COperationPerformer(const Operation operation, std::vector<CFileSystemObject>&& source, QString destination) :
 	_destFileSystemObject(destination),
 	_op(operation)
@@ -55,6 +70,123 @@ void COperationPerformer::setObserver(CFileOperationObserver *observer)
 	_observer = observer;
 }
 
+void COperationPerformer::setCacheNeutralCopying(bool cacheNeutral)
+{
+	assert_r(!_inProgress);
+	_cacheNeutralCopying = cacheNeutral;
+}
+
+void COperationPerformer::setPreserveLinks(bool preserve)
+{
+	assert_r(!_inProgress);
+#ifndef _WIN32
+	_preserveLinks = preserve;
+#else
+	(void)preserve;
+#endif
+}
+
+void COperationPerformer::setDeltaTransfer(bool deltaTransfer)
+{
+	assert_r(!_inProgress);
+	_deltaTransfer = deltaTransfer;
+}
+
+void COperationPerformer::setPruningRules(CPruningRules rules)
+{
+	assert_r(!_inProgress);
+	assert_r(_op == operationCopy || rules.isEmpty());
+	_pruningRules = std::move(rules);
+}
+
+void COperationPerformer::setSyncOptions(const SyncOptions& options)
+{
+	assert_r(!_inProgress);
+	_syncOptions = options;
+}
+
+SyncReport COperationPerformer::syncReport() const
+{
+	std::lock_guard<std::mutex> lock(_syncReportMutex);
+	return _syncReport;
+}
+
+void COperationPerformer::setAttributeChange(const AttributeChange& change)
+{
+	assert_r(!_inProgress);
+	_attributeChange = change;
+}
+
+size_t COperationPerformer::numItemsChanged() const
+{
+	return _numItemsChanged;
+}
+
+void COperationPerformer::setGlobalResponse(HaltReason reason, UserResponse response)
+{
+	assert_r(!_inProgress);
+	assert_and_return_r(response == urSkipAll || response == urProceedWithAll, );
+	_globalResponses[reason] = response;
+}
+
+void COperationPerformer::setIoPriority(IoPriority priority)
+{
+	_ioPriority = priority;
+}
+
+IoPriority COperationPerformer::ioPriority() const
+{
+	return _ioPriority;
+}
+
+void COperationPerformer::setBandwidthLimit(uint64_t bytesPerSecond)
+{
+	_bandwidthLimiter.setRate(bytesPerSecond);
+}
+
+uint64_t COperationPerformer::bandwidthLimit() const
+{
+	return _bandwidthLimiter.rate();
+}
+
+void COperationPerformer::setOperationsPerSecondLimit(uint64_t operationsPerSecond)
+{
+	_operationsLimiter.setRate(operationsPerSecond);
+}
+
+uint64_t COperationPerformer::operationsPerSecondLimit() const
+{
+	return _operationsLimiter.rate();
+}
+
+uint64_t COperationPerformer::currentBytesPerSecond() const
+{
+	return _bandwidthLimiter.measuredRate();
+}
+
+uint64_t COperationPerformer::currentOperationsPerSecond() const
+{
+	return _operationsLimiter.measuredRate();
+}
+
+COperationPerformer::LinkStatistics COperationPerformer::linkStatistics() const
+{
+	LinkStatistics statistics;
+	statistics.hardLinksRecreated = _hardLinksRecreated;
+	statistics.symLinksRecreated = _symLinksRecreated;
+	statistics.bytesSaved = _bytesSavedByHardLinks;
+	return statistics;
+}
+
+COperationPerformer::DeltaTransferStatistics COperationPerformer::deltaTransferStatistics() const
+{
+	DeltaTransferStatistics statistics;
+	statistics.filesUpdated = _filesUpdatedByDeltaTransfer;
+	statistics.bytesWritten = _bytesWrittenByDeltaTransfer;
+	statistics.bytesSkipped = _bytesSkippedByDeltaTransfer;
+	return statistics;
+}
+
 bool COperationPerformer::togglePause()
 {
 	_paused = !_paused;
@@ -98,6 +230,12 @@ void COperationPerformer::cancel()
 	_cancelRequested = true;
 }
 
+static CMetricGauge& busyWorkersGauge()
+{
+	static CMetricGauge& gauge = CMetricsRegistry::instance().gauge(Metrics::BusyWorkers);
+	return gauge;
+}
+
 void COperationPerformer::threadFunc()
 {
 	_inProgress = true;
@@ -105,6 +243,26 @@ void COperationPerformer::threadFunc()
 	EXEC_ON_SCOPE_EXIT([this]() {finalize();});
 
 	setThreadName("COperationPerformer thread");
+	applyIoPriority();
+
+	auto& metrics = CMetricsRegistry::instance();
+	static CMetricGauge& runningOperations = metrics.gauge(Metrics::RunningOperations);
+	static CMetricGauge& workers = metrics.gauge(Metrics::Workers);
+	runningOperations.add(1);
+	workers.add(1);
+	busyWorkersGauge().add(1);
+	EXEC_ON_SCOPE_EXIT([]() {
+		runningOperations.add(-1);
+		workers.add(-1);
+		busyWorkersGauge().add(-1);
+	});
+
+	if (_op == operationCopy || _op == operationMove || _op == operationSync)
+	{
+		const QString sourcePath = _source.empty() ? QString() : _source.front().object.fullAbsolutePath();
+		_bytesReadCounter = &metrics.counter(CMetricsRegistry::withDevice(Metrics::BytesRead, CMetricsRegistry::deviceForPath(sourcePath)));
+		_bytesWrittenCounter = &metrics.counter(CMetricsRegistry::withDevice(Metrics::BytesWritten, CMetricsRegistry::deviceForPath(_destFileSystemObject.fullAbsolutePath())));
+	}
 
 	switch (_op)
 	{
@@ -117,6 +275,12 @@ void COperationPerformer::threadFunc()
 	case operationDelete:
 		deleteFiles();
 		break;
+	case operationSync:
+		syncFiles();
+		break;
+	case operationChangeAttributes:
+		changeAttributes();
+		break;
 	default:
 		assert_and_return_r("Uknown operation", );
 	}
@@ -126,9 +290,11 @@ void COperationPerformer::waitForResponse()
 {
 	std::unique_lock<std::mutex> lock(_waitForResponseMutex);
 	_totalTimeElapsed.pause();
+	busyWorkersGauge().add(-1);
 	while (_userResponse == urNone)
 		_waitForResponseCondition.wait(lock);
 
+	busyWorkersGauge().add(1);
 	_totalTimeElapsed.resume();
 }
 
@@ -141,6 +307,8 @@ inline QDebug& operator<<(QDebug& stream, const std::vector<COperationPerformer:
 
 void COperationPerformer::copyFiles()
 {
+	TRACE_SCOPE("COperationPerformer::copyFiles");
+
 	if (_source.empty())
 		return;
 
@@ -203,37 +371,73 @@ void COperationPerformer::copyFiles()
 		return;
 	}
 
-	uint64_t totalSize = 0;
 	uint64_t sizeProcessed = 0;
 
-	const auto destination = enumerateSourcesAndCalcDest(totalSize);
-	assert_r(destination.size() == _source.size());
+	_totalSizeDiscovered = 0;
+	_numItemsDiscovered = 0;
+	_lastEnsuredDestFolder.clear();
+
+	// Copying starts as soon as the first item is discovered rather than after the whole source tree has been enumerated.
+	// The capacity limit keeps the memory footprint bounded no matter how large the tree is.
+	CBoundedQueue<CopyWorkItem> workQueue(4096);
+	std::atomic<bool> stopEnumeration{ false };
+	std::thread enumerationThread([this, &workQueue, &stopEnumeration]() {
+		setThreadName("COperationPerformer enumeration thread");
+		applyIoPriority();
+		enumerateSources(workQueue, stopEnumeration);
+		workQueue.close();
+	});
+
+	EXEC_ON_SCOPE_EXIT([&workQueue, &stopEnumeration, &enumerationThread]() {
+		stopEnumeration = true;
+		workQueue.close(); // Unblocks the producer if it's waiting for free space in the queue
+		enumerationThread.join();
+	});
 
 	std::vector<CFileSystemObject> dirsToCleanUp;
 
 	_totalTimeElapsed.start();
 
-	for (auto sourceIterator = _source.begin(); sourceIterator != _source.end() && !_cancelRequested; _userResponse = urNone /* needed for normal operation of condition variable */)
+	// This operation's share of the total queue depth of all the running operations
+	static CMetricGauge& queueDepthGauge = CMetricsRegistry::instance().gauge(Metrics::CopyQueueDepth);
+	int64_t queueDepth = 0;
+	EXEC_ON_SCOPE_EXIT([&queueDepth]() {queueDepthGauge.add(-queueDepth);});
+
+	CopyWorkItem workItem;
+	bool itemPending = false;
+	for (currentItemIndex = 0; !_cancelRequested; _userResponse = urNone /* needed for normal operation of condition variable */)
 	{
-		if (sourceIterator->object.isCdUp())
+		if (!itemPending)
 		{
-			++sourceIterator;
+			if (!workQueue.pop(workItem))
+				break; // All done
+
+			itemPending = true;
+
+			const auto newQueueDepth = static_cast<int64_t>(workQueue.size());
+			queueDepthGauge.add(newQueueDepth - queueDepth);
+			queueDepth = newQueueDepth;
+		}
+
+		CFileSystemObject& sourceObject = workItem.object;
+		if (sourceObject.isCdUp())
+		{
+			itemPending = false;
 			++currentItemIndex;
 			continue;
 		}
 
 #if defined _DEBUG
-		qInfo() << __FUNCTION__ << "Processing" << (sourceIterator->object.isFile() ? "file" : "DIR ") << sourceIterator->object.fullAbsolutePath();
+		qInfo() << __FUNCTION__ << "Processing" << (sourceObject.isFile() ? "file" : "DIR ") << sourceObject.fullAbsolutePath();
 #endif
-		if (_observer) _observer->onCurrentFileChangedCallback(sourceIterator->object.fullName());
+		if (_observer) _observer->onCurrentFileChangedCallback(sourceObject.fullName());
 
-		const QFileInfo& sourceFileInfo = sourceIterator->object.qFileInfo();
-		if (!sourceFileInfo.exists())
+		if (!sourceObject.exists())
 		{
-			const auto response = getUserResponse(hrFileDoesntExit, sourceIterator->object, CFileSystemObject(), QString());
+			const auto response = getUserResponse(hrFileDoesntExit, sourceObject, CFileSystemObject(), QString());
 			if (response == urSkipThis || response == urSkipAll)
 			{
-				++sourceIterator;
+				itemPending = false;
 				++currentItemIndex;
 				continue;
 			}
@@ -243,27 +447,65 @@ void COperationPerformer::copyFiles()
 				assert_unconditional_r("Unknown response");
 		}
 
-		QFileInfo destInfo(destination[currentItemIndex].absoluteFilePath(_newName.isEmpty() ? sourceIterator->object.fullName() : _newName));
+		const QString destFileName = _newName.isEmpty() ? sourceObject.fullName() : _newName;
 		_newName.clear();
-		if (destInfo.absoluteFilePath() == sourceFileInfo.absoluteFilePath())
+
+		QString sourcePath = sourceObject.fullAbsolutePath();
+		if (sourcePath.endsWith('/'))
+			sourcePath.chop(1);
+
+		if (workItem.destFolderPath + destFileName == sourcePath)
 		{
-			++sourceIterator;
+			itemPending = false;
 			++currentItemIndex;
 			continue;
 		}
 
-		if (sourceIterator->object.isFile())
+		if (_preserveLinks && sourceObject.isSymLink())
 		{
+			// Recreated as a link no matter what it points to, or whether the target exists at all
 			NextAction nextAction;
-			while ((nextAction = copyItem(sourceIterator->object, destInfo, destination[currentItemIndex], sizeProcessed, totalSize, currentItemIndex)) == naRetryOperation);
+			while ((nextAction = copySymLink(sourceObject, workItem.destFolderPath, destFileName)) == naRetryOperation);
 			switch (nextAction)
 			{
 			case naProceed:
-				sourceIterator->copiedSuccessfully = true;
+				workItem.copiedSuccessfully = true;
 				break;
 			case naSkip:
-				sizeProcessed += sourceIterator->object.size();
-				++sourceIterator;
+				itemPending = false;
+				++currentItemIndex;
+				continue;
+			case naRetryItem:
+				continue;
+			case naAbort:
+				return;
+			default:
+				assert_unconditional_r(QString("Unexpected copySymLink() return value %1").arg(nextAction).toUtf8().constData());
+				continue; // Retry
+			}
+
+			if (_op == operationMove)
+			{
+				while ((nextAction = deleteItem(sourceObject)) == naRetryOperation);
+
+				if (nextAction == naRetryItem)
+					continue;
+				else if (nextAction == naAbort)
+					return;
+			}
+		}
+		else if (sourceObject.isFile())
+		{
+			NextAction nextAction;
+			while ((nextAction = copyItem(sourceObject, workItem.destFolderPath, destFileName, sizeProcessed, currentItemIndex)) == naRetryOperation);
+			switch (nextAction)
+			{
+			case naProceed:
+				workItem.copiedSuccessfully = true;
+				break;
+			case naSkip:
+				sizeProcessed += sourceObject.size();
+				itemPending = false;
 				++currentItemIndex;
 				continue;
 			case naRetryItem:
@@ -278,21 +520,21 @@ void COperationPerformer::copyFiles()
 
 			if (_op == operationMove) // result == ok
 			{
-				if (!sourceIterator->copiedSuccessfully) // A fix for #270 (Cancelling a move operation deletes the original file nonetheless)
+				if (!workItem.copiedSuccessfully) // A fix for #270 (Cancelling a move operation deletes the original file nonetheless)
 				{
-					++sourceIterator;
+					itemPending = false;
 					++currentItemIndex;
 					continue;
 				}
 
-				while ((nextAction = deleteItem(sourceIterator->object)) == naRetryOperation);
+				while ((nextAction = deleteItem(sourceObject)) == naRetryOperation);
 
 				switch (nextAction)
 				{
 				case naProceed:
 					break;
 				case naSkip:
-					++sourceIterator;
+					itemPending = false;
 					++currentItemIndex;
 					continue;
 				case naRetryItem:
@@ -305,20 +547,20 @@ void COperationPerformer::copyFiles()
 				}
 			}
 		}
-		else if (sourceIterator->object.isDir())
+		else if (sourceObject.isDir())
 		{
 			// Creating the folder - empty folders will not be copied without this code
-			CFileSystemObject destObject(destInfo);
-			if (!destObject.exists())
+			const QString destFolderPath = workItem.destFolderPath % destFileName % '/';
+			if (!QFileInfo::exists(destFolderPath))
 			{
 				NextAction nextAction;
-				while ((nextAction = mkPath(QDir(destObject.fullAbsolutePath()))) == naRetryOperation);
+				while ((nextAction = mkPath(QDir(destFolderPath))) == naRetryOperation);
 				if (nextAction == naRetryItem)
 					continue;
 				else if (nextAction == naSkip)
 				{
+					itemPending = false;
 					++currentItemIndex;
-					++sourceIterator;
 					continue;
 				}
 				else if (nextAction == naRetryOperation)
@@ -326,28 +568,32 @@ void COperationPerformer::copyFiles()
 				else if (nextAction != naProceed)
 					assert_unconditional_r("Unexpected next action");
 				else
-					sourceIterator->copiedSuccessfully = true;
+				{
+					workItem.copiedSuccessfully = true;
+					// The folder's children are coming up next, and they don't need to check for its existence again
+					_lastEnsuredDestFolder = destFolderPath;
+				}
 			}
 
 			if (_op == operationMove)
 			{
-				if (!sourceIterator->copiedSuccessfully) // A fix for #270 (Cancelling a move operation deletes the original file nonetheless)
+				if (!workItem.copiedSuccessfully) // A fix for #270 (Cancelling a move operation deletes the original file nonetheless)
 				{
-					++sourceIterator;
+					itemPending = false;
 					++currentItemIndex;
 					continue;
 				}
 
-				if (sourceIterator->object.isEmptyDir())
+				if (sourceObject.isEmptyDir())
 				{
-					CFileManipulator manipulator(sourceIterator->object);
+					CFileManipulator manipulator(sourceObject);
 					const auto result = manipulator.remove();
 					if (result != FileOperationResultCode::Ok)
 					{
-						const auto action = getUserResponse(hrFailedToDelete, sourceIterator->object, CFileSystemObject(), manipulator.lastErrorMessage());
+						const auto action = getUserResponse(hrFailedToDelete, sourceObject, CFileSystemObject(), manipulator.lastErrorMessage());
 						if (action == urSkipThis || action == urSkipAll)
 						{
-							++sourceIterator;
+							itemPending = false;
 							++currentItemIndex;
 							continue;
 						}
@@ -363,19 +609,20 @@ void COperationPerformer::copyFiles()
 					}
 				}
 				else // not empty
-					dirsToCleanUp.emplace_back(sourceIterator->object);
+					dirsToCleanUp.emplace_back(sourceObject);
 			}
 		}
 
-		sizeProcessed += sourceIterator->object.size();
+		sizeProcessed += sourceObject.size();
 
-		++sourceIterator;
+		itemPending = false;
 		++currentItemIndex;
 	}
 
-	for (auto& dir : dirsToCleanUp)
+	// The folders were enumerated parent-first, so they need to be removed in reverse order, children first
+	for (auto dir = dirsToCleanUp.rbegin(); dir != dirsToCleanUp.rend() && !_cancelRequested; ++dir)
 	{
-		CFileManipulator dirManipulator(dir);
+		CFileManipulator dirManipulator(*dir);
 		assert_message_r(dirManipulator.remove() == FileOperationResultCode::Ok, dirManipulator.lastErrorMessage().toUtf8().constData());
 	}
 
@@ -384,6 +631,8 @@ void COperationPerformer::copyFiles()
 
 void COperationPerformer::deleteFiles()
 {
+	TRACE_SCOPE("COperationPerformer::deleteFiles");
+
 	std::vector<CFileSystemObject> fileSystemObjectsList;
 	fileSystemObjectsList.reserve(500);
 
@@ -391,9 +640,10 @@ void COperationPerformer::deleteFiles()
 	{
 		if (!it->object.isCdUp())
 		{
+			// Links must be deleted themselves, not the contents of the folders they point to
 			scanDirectory(it->object, [&fileSystemObjectsList](const CFileSystemObject& item) {
 				fileSystemObjectsList.emplace_back(item);
-			});
+			}, _cancelRequested, false);
 		}
 	}
 
@@ -404,6 +654,7 @@ void COperationPerformer::deleteFiles()
 	for (auto it = fileSystemObjectsList.begin(); it != fileSystemObjectsList.end() && !_cancelRequested; _userResponse = urNone /* needed for normal condition variable operation */)
 	{
 		handlePause();
+		applyIoPriority();
 
 		if (!it->isFile())
 		{
@@ -465,6 +716,7 @@ void COperationPerformer::deleteFiles()
 	for (auto it = fileSystemObjectsList.rbegin(); it != fileSystemObjectsList.rend() && !_cancelRequested; _userResponse = urNone /* needed for normal condition variable operation */)
 	{
 		handlePause();
+		applyIoPriority();
 
 		if (!it->isDir())
 		{
@@ -521,6 +773,11 @@ void COperationPerformer::deleteFiles()
 
 void COperationPerformer::finalize()
 {
+	if (_hardLinksRecreated > 0 || _symLinksRecreated > 0)
+		qInfo() << "COperationPerformer:" << _hardLinksRecreated << "hard links and" << _symLinksRecreated << "symbolic links recreated," << _bytesSavedByHardLinks << "bytes not copied thanks to the hard links";
+	if (_filesUpdatedByDeltaTransfer > 0)
+		qInfo() << "COperationPerformer:" << _filesUpdatedByDeltaTransfer << "files updated in place," << _bytesWrittenByDeltaTransfer << "bytes written," << _bytesSkippedByDeltaTransfer << "bytes already up to date";
+
 	_done = true;
 	_paused   = false;
 	if (_observer) _observer->onProcessFinishedCallback();
@@ -535,52 +792,292 @@ inline bool isAbsolutePath(const QString& path)
 #endif
 }
 
-inline QDir destinationFolder(const QString &absoluteSourcePath, const QString &originPath, const QString &destPath, bool /*sourceIsDir*/)
+inline QString withTrailingSlash(const QString& path)
+{
+	return path.endsWith('/') ? path : (path + '/');
+}
+
+// Composes the path of the folder where the item must be copied to purely by string manipulation, without querying the file system.
+// The returned path always ends with a '/'.
+inline QString destinationFolderPath(const QString& absoluteSourcePath, const QString& originPath, const QString& destRootPath)
 {
+	assert_debug_only(isAbsolutePath(destRootPath) && destRootPath.endsWith('/'));
+
 	QString localPath = absoluteSourcePath.mid(originPath.length());
 	assert_r(!localPath.isEmpty());
 	if (localPath.startsWith('\\') || localPath.startsWith('/'))
-		localPath = localPath.remove(0, 1);
+		localPath.remove(0, 1);
+	if (localPath.endsWith('/'))
+		localPath.chop(1); // Folder paths end with a slash
 
-	assert_debug_only(isAbsolutePath(destPath));
-	return CFileSystemObject(destPath % '/' % localPath).parentDirPath();
+	const int lastSlash = localPath.lastIndexOf('/');
+	return lastSlash < 0 ? destRootPath : (destRootPath % localPath.leftRef(lastSlash + 1));
 }
 
-// Iterates over all dirs in the source vector, and their subdirs, and so on and replaces _sources with a flat list of files. Returns a list of destination folders where each of the files must be copied to according to _dest
-// Also counts the total size of all the files to monitor progress
-
-// TODO: refactor to a separate algorithm that iterates recursively over subdirs.
-// Then I would no longer need to calculate the total size of all files in the same method just to avoid code duplication.
-std::vector<QDir> COperationPerformer::enumerateSourcesAndCalcDest(uint64_t &totalSize)
+// Iterates over all dirs in the source vector, and their subdirs, and so on, and feeds every item along with its destination folder into the queue as soon as it's discovered.
+// Also counts the total size of the files discovered so far to monitor progress
+void COperationPerformer::enumerateSources(CBoundedQueue<CopyWorkItem>& queue, const std::atomic<bool>& abort)
 {
-	totalSize = 0;
-	std::vector<ObjectToProcess> newSourceVector;
-	std::vector<QDir> destinations;
+	TRACE_SCOPE("COperationPerformer::enumerateSources");
+
 	const bool destIsFileName = _source.size() == 1 && !_destFileSystemObject.isDir();
-	for (auto& o: _source)
+	const QString destRootPath = withTrailingSlash(_destFileSystemObject.fullAbsolutePath());
+
+	std::atomic<bool> stop{ false };
+	const auto enqueue = [this, &queue, &stop, &abort](const CFileSystemObject& item, QString&& destFolderPath) {
+		applyIoPriority();
+
+		if (item.isFile())
+			_totalSizeDiscovered += item.size();
+		++_numItemsDiscovered;
+
+		if (abort || !queue.push(CopyWorkItem{ item, std::move(destFolderPath) }))
+			stop = true;
+	};
+
+	for (const auto& o: _source)
 	{
+		if (stop)
+			break;
+
 		if (o.object.isFile())
 		{
-			totalSize += o.object.size();
 			// Ignoring the new file name here if it was supplied. We're only calculating dest dir here, not the file name
-			destinations.emplace_back(destinationFolder(o.object.fullAbsolutePath(), o.object.parentDirPath(), destIsFileName ? _destFileSystemObject.parentDirPath() : _destFileSystemObject.fullAbsolutePath(), false));
-			newSourceVector.emplace_back(o.object);
+			enqueue(o.object, destIsFileName ? withTrailingSlash(_destFileSystemObject.parentDirPath()) : destinationFolderPath(o.object.fullAbsolutePath(), o.object.parentDirPath(), destRootPath));
 		}
 		else if (o.object.isDir())
 		{
-			scanDirectory(o.object, [&destinations, &newSourceVector, &totalSize, &o, this](const CFileSystemObject& item) {
-				destinations.emplace_back(destinationFolder(item.fullAbsolutePath(), o.object.parentDirPath(), _destFileSystemObject.fullAbsolutePath(), item.isDir() /* TODO: 'false' ? */));
+			const QString originPath = o.object.parentDirPath();
+			// With links preserved, a link to a folder is copied as a link and its contents aren't enumerated
+			scanDirectory(o.object, [&enqueue, &originPath, &destRootPath](const CFileSystemObject& item) {
+				enqueue(item, destinationFolderPath(item.fullAbsolutePath(), originPath, destRootPath));
+			}, stop, !_preserveLinks, _op == operationCopy ? _pruningRules : CPruningRules{});
+		}
+	}
+}
+
+void COperationPerformer::syncFiles()
+{
+	assert_and_return_r(_destFileSystemObject.isDir() || !_destFileSystemObject.exists(), );
+	qInfo() << __FUNCTION__ << (_syncOptions.dryRun ? "Comparing" : "Synchronizing") << _source << "with" << _destFileSystemObject.fullAbsolutePath();
+
+	// Overwriting the outdated files is the whole point, there's nothing to ask
+	_globalResponses[hrFileExists] = urProceedWithAll;
+
+	_totalSizeDiscovered = 0;
+	_numItemsDiscovered = 0;
+	_lastEnsuredDestFolder.clear();
+	{
+		std::lock_guard<std::mutex> lock(_syncReportMutex);
+		_syncReport = SyncReport();
+	}
+
+	// The changes are applied while the trees are still being compared
+	CBoundedQueue<SyncAction> actionQueue(4096);
+	std::atomic<bool> stopComparison{ false };
+	std::thread comparisonThread([this, &actionQueue, &stopComparison]() {
+		setThreadName("COperationPerformer comparison thread");
+		applyIoPriority();
+
+		const QString destRootPath = withTrailingSlash(_destFileSystemObject.fullAbsolutePath());
+		CSyncPlanner planner(_syncOptions, _preserveLinks);
+		for (const auto& o: _source)
+		{
+			if (stopComparison)
+				break;
+			else if (o.object.isCdUp())
+				continue;
+
+			planner.compare(o.object, destRootPath, [this, &actionQueue, &stopComparison](SyncAction&& action) {
+				applyIoPriority();
 
-				if (item.isFile())
-					totalSize += item.size();
+				if (action.type == SyncAction::CopyNew || action.type == SyncAction::Update)
+					_totalSizeDiscovered += action.source.size();
+				++_numItemsDiscovered;
 
-				newSourceVector.emplace_back(std::move(item));
-			});
+				if (!actionQueue.push(std::move(action)))
+					stopComparison = true;
+			}, stopComparison);
 		}
+
+		{
+			std::lock_guard<std::mutex> lock(_syncReportMutex);
+			_syncReport.numItemsUpToDate = planner.numItemsUpToDate();
+		}
+
+		actionQueue.close();
+	});
+
+	EXEC_ON_SCOPE_EXIT([&actionQueue, &stopComparison, &comparisonThread]() {
+		stopComparison = true;
+		actionQueue.close(); // Unblocks the producer if it's waiting for free space in the queue
+		comparisonThread.join();
+	});
+
+	_totalTimeElapsed.start();
+
+	uint64_t sizeProcessed = 0;
+	size_t currentItemIndex = 0;
+	SyncAction action;
+	bool actionPending = false;
+	for (; !_cancelRequested; _userResponse = urNone /* needed for normal operation of condition variable */)
+	{
+		if (!actionPending)
+		{
+			if (!actionQueue.pop(action))
+				break; // All done
+
+			actionPending = true;
+		}
+
+		handlePause();
+		applyIoPriority();
+
+		const bool isCopy = action.type == SyncAction::CopyNew || action.type == SyncAction::Update;
+		if (_observer) _observer->onCurrentFileChangedCallback(action.type == SyncAction::Delete ? action.dest.fullName() : action.source.fullName());
+
+		NextAction nextAction = naProceed;
+		if (!_syncOptions.dryRun)
+		{
+			switch (action.type)
+			{
+			case SyncAction::CreateFolder:
+				while ((nextAction = mkPath(QDir(action.destPath()))) == naRetryOperation);
+				if (nextAction == naProceed)
+					_lastEnsuredDestFolder = action.destPath() + '/';
+				break;
+			case SyncAction::CopyNew:
+			case SyncAction::Update:
+				if (_preserveLinks && action.source.isSymLink())
+					while ((nextAction = copySymLink(action.source, action.destFolderPath, action.source.fullName())) == naRetryOperation);
+				else
+					while ((nextAction = copyItem(action.source, action.destFolderPath, action.source.fullName(), sizeProcessed, currentItemIndex)) == naRetryOperation);
+				break;
+			case SyncAction::Delete:
+				nextAction = deleteTree(action.dest);
+				break;
+			}
+		}
+
+		if (nextAction == naRetryItem)
+			continue;
+		else if (nextAction == naAbort || _cancelRequested)
+			return;
+
+		if (nextAction == naProceed)
+		{
+			std::lock_guard<std::mutex> lock(_syncReportMutex);
+			if (_syncOptions.dryRun && _syncReport.entries.size() < SyncReport::MaxEntries)
+				_syncReport.entries.push_back({action.type, action.destPath()});
+
+			switch (action.type)
+			{
+			case SyncAction::CreateFolder:
+				++_syncReport.numFoldersCreated;
+				break;
+			case SyncAction::CopyNew:
+				++_syncReport.numFilesCopied;
+				break;
+			case SyncAction::Update:
+				++_syncReport.numFilesUpdated;
+				break;
+			case SyncAction::Delete:
+				++_syncReport.numItemsDeleted;
+				break;
+			}
+
+			if (isCopy)
+				_syncReport.bytesCopied += action.source.size();
+		}
+
+		if (isCopy)
+			sizeProcessed += action.source.size();
+
+		actionPending = false;
+		++currentItemIndex;
+
+		// Copying reports its own progress as it goes
+		if (!isCopy || _syncOptions.dryRun)
+		{
+			const uint64_t totalSize = _totalSizeDiscovered;
+			const size_t numItems = _numItemsDiscovered;
+			const float totalPercentage = totalSize > 0 ? std::min(sizeProcessed * 100.0f / totalSize, 100.0f) : (numItems > 0 ? currentItemIndex * 100.0f / numItems : 0.0f);
+			const uint64_t meanSpeed = sizeProcessed * 1000000 / std::max(_totalTimeElapsed.elapsed<std::chrono::microseconds>(), 1_u64);
+			if (_observer) _observer->onProgressChangedCallback(totalPercentage, currentItemIndex, numItems, 0.0f, meanSpeed, 0);
+		}
+	}
+
+	const SyncReport report = syncReport();
+	qInfo() << __FUNCTION__ << (_syncOptions.dryRun ? "would create" : "created") << report.numFoldersCreated << "folders, copied" << report.numFilesCopied << "new and" << report.numFilesUpdated << "changed files (" << report.bytesCopied << "bytes), deleted"
+		<< report.numItemsDeleted << "items," << report.numItemsUpToDate << "items up to date; took" << _totalTimeElapsed.elapsed() << "ms";
+}
+
+void COperationPerformer::changeAttributes()
+{
+	assert_and_return_r(CAttributeChanger::supported(), );
+	qInfo() << __FUNCTION__ << "Changing the attributes of" << _source;
+
+	std::vector<QString> roots;
+	for (const auto& o: _source)
+	{
+		if (!o.object.isCdUp())
+			roots.push_back(o.object.fullAbsolutePath());
+	}
+
+	CAttributeChanger changer(_attributeChange);
+	// Called by one worker thread at a time
+	changer.setErrorHandler([this](const QString& path, const QString& errorMessage) {
+		const auto response = getUserResponse(hrFailedToChangeAttributes, CFileSystemObject(path), CFileSystemObject(), errorMessage);
+		if (response == urAbort)
+			_cancelRequested = true;
+
+		return response == urRetry;
+	});
+
+	changer.setProgressHandler([this, &changer](const QString& folderPath, size_t numItems) {
+		handlePause();
+		applyIoPriority();
+		_operationsLimiter.consume(numItems, _cancelRequested);
+
+		// The total is only the number of items discovered so far
+		const size_t numItemsProcessed = changer.numItemsProcessed();
+		const size_t numItemsDiscovered = std::max(changer.numItemsDiscovered(), numItemsProcessed);
+		const uint64_t speed = numItemsProcessed * 1000000 / std::max(_totalTimeElapsed.elapsed<std::chrono::microseconds>(), 1_u64);
+		const float totalPercentage = numItemsDiscovered > 0 ? numItemsProcessed * 100.0f / numItemsDiscovered : 0.0f;
+		if (_observer)
+		{
+			_observer->onCurrentFileChangedCallback(folderPath);
+			_observer->onProgressChangedCallback(totalPercentage, numItemsProcessed, numItemsDiscovered, 0.0f, speed, 0);
+		}
+	});
+
+	_totalTimeElapsed.start();
+	changer.apply(roots, _cancelRequested);
+	_numItemsChanged = changer.numItemsChanged();
+
+	qInfo() << __FUNCTION__ << "Changed" << changer.numItemsChanged() << "of" << changer.numItemsProcessed() << "items in" << _totalTimeElapsed.elapsed() << "ms";
+}
+
+COperationPerformer::NextAction COperationPerformer::deleteTree(const CFileSystemObject& root)
+{
+	std::vector<CFileSystemObject> items;
+	// Links must be deleted themselves, not the contents of the folders they point to
+	scanDirectory(root, [&items](const CFileSystemObject& item) {
+		items.emplace_back(item);
+	}, _cancelRequested, false);
+
+	// The items are enumerated parent-first, so the reverse order deletes the contents of every folder before the folder itself
+	for (auto it = items.rbegin(); it != items.rend() && !_cancelRequested; ++it)
+	{
+		if (_observer) _observer->onCurrentFileChangedCallback(it->fullName());
+
+		NextAction nextAction;
+		while ((nextAction = deleteItem(*it)) == naRetryOperation);
+		if (nextAction == naAbort)
+			return naAbort;
 	}
 
-	_source = std::move(newSourceVector);
-	return destinations;
+	return naProceed;
 }
 
 UserResponse COperationPerformer::getUserResponse(HaltReason hr, const CFileSystemObject& src, const CFileSystemObject& dst, const QString& message)
@@ -599,7 +1096,7 @@ UserResponse COperationPerformer::getUserResponse(HaltReason hr, const CFileSyst
 COperationPerformer::NextAction COperationPerformer::deleteItem(CFileSystemObject& item)
 {
 	CFileManipulator itemManipulator(item);
-	if (item.isFile() && !item.isWriteable())
+	if (item.isFile() && !item.isSymLink() && !item.isWriteable())
 	{
 		const auto response = getUserResponse(hrSourceFileIsReadOnly, item, CFileSystemObject(), itemManipulator.lastErrorMessage()); // TODO: is the message "itemManipulator.lastErrorMessage()" correct here? No operation had been attempted yet
 		if (response == urSkipThis || response == urSkipAll)
@@ -634,6 +1131,7 @@ COperationPerformer::NextAction COperationPerformer::deleteItem(CFileSystemObjec
 		}
 	}
 
+	_operationsLimiter.consume(1, _cancelRequested);
 	return naProceed;
 }
 
@@ -657,12 +1155,12 @@ COperationPerformer::NextAction COperationPerformer::makeItemWriteable(CFileSyst
 	return naProceed;
 }
 
-COperationPerformer::NextAction COperationPerformer::copyItem(CFileSystemObject& item, const QFileInfo& destInfo, const QDir& destDir, uint64_t sizeProcessedPreviously, uint64_t totalSize, size_t currentItemIndex)
+COperationPerformer::NextAction COperationPerformer::copyItem(CFileSystemObject& item, const QString& destFolderPath, const QString& destFileName, uint64_t sizeProcessedPreviously, size_t currentItemIndex)
 {
 	if (!item.isFile())
 		return naProceed;
 
-	CFileSystemObject destFile(destInfo);
+	CFileSystemObject destFile(destFolderPath % destFileName);
 
 	if (destFile.exists() && destFile.isFile())
 	{
@@ -704,35 +1202,76 @@ COperationPerformer::NextAction COperationPerformer::copyItem(CFileSystemObject&
 		}
 	}
 
-	if (!destDir.exists())
 	{
 		NextAction nextAction;
-		while ((nextAction = mkPath(destDir)) == naRetryOperation);
+		while ((nextAction = ensureDestFolderExists(destFolderPath)) == naRetryOperation);
 		if (nextAction != naProceed)
 			return nextAction;
 	}
 
-	const int chunkSize = 5 * 1024 * 1024;
-	const QString destPath = destDir.absolutePath() + '/';
+	const QString destName = _newName.isEmpty() ? (!destFile.isDir() ? destFile.fullName() : QString()) : _newName;
+
+	// Another link to a file that has already been copied becomes a hard link to that copy
+	CHardLinkTracker::FileId fileId;
+	const bool multiplyLinked = _preserveLinks && CHardLinkTracker::multiplyLinkedFileId(item, fileId);
+	if (multiplyLinked)
+	{
+		const QString existingCopyPath = _hardLinkTracker.copyOf(fileId);
+		if (!existingCopyPath.isEmpty())
+		{
+			CFileManipulator linkManipulator(item);
+			if (linkManipulator.createHardLink(existingCopyPath, destFolderPath, destName) == FileOperationResultCode::Ok)
+			{
+				++_hardLinksRecreated;
+				_bytesSavedByHardLinks += item.size();
+				return naProceed;
+			}
+
+			// E. g. the destination file system doesn't support hard links; the data has to be copied after all
+			qInfo() << "Failed to create a hard link to" << existingCopyPath << ", copying the data instead:" << linkManipulator.lastErrorMessage();
+		}
+	}
+
 	auto result = FileOperationResultCode::Fail;
 	CFileManipulator itemManipulator(item);
+	itemManipulator.setCacheNeutralCopying(_cacheNeutralCopying);
+	itemManipulator.setDeltaTransfer(_deltaTransfer);
+
+	// Only the copying itself is measured: the prompts above are done with, and the time spent paused is excluded
+	static CLatencyHistogram& copyLatency = CMetricsRegistry::instance().histogram(Metrics::FileCopyLatency);
+	CScopedLatency copyLatencyMeasurement(copyLatency);
 
 	do
 	{
-		handlePause();
+		handlePause(&copyLatencyMeasurement);
+		applyIoPriority();
 
-		result = itemManipulator.copyChunk(chunkSize, destPath, _newName.isEmpty() ? (!destFile.isDir() ? destFile.fullName() : QString()) : _newName);
+		const uint64_t bytesCopiedBefore = itemManipulator.bytesCopied();
+		const uint64_t bytesSkippedBefore = itemManipulator.bytesSkipped();
+		result = itemManipulator.copyChunk(copyChunkSize(_bandwidthLimiter.rate()), destFolderPath, destName);
 		// Error handling
 		if (result != FileOperationResultCode::Ok)
 			break;
 
+		// The total is only the size of the files discovered so far while the source tree is still being enumerated
+		const uint64_t totalSize = _totalSizeDiscovered;
 		const auto actualSizeProcessed = static_cast<float>(sizeProcessedPreviously + itemManipulator.bytesCopied());
-		const float totalPercentage = totalSize > 0 ? actualSizeProcessed * 100.0f / totalSize : 0.0f; // Bytes
+		const float totalPercentage = totalSize > 0 ? std::min(actualSizeProcessed * 100.0f / totalSize, 100.0f) : 0.0f; // Bytes
 		const float filePercentage = item.size() > 0 ? itemManipulator.bytesCopied() * 100.0f / item.size() : 0.0f;
 
-		const uint64_t meanSpeed = uint64_t(totalPercentage / 100.0f * actualSizeProcessed * 1e6f) / std::max(_totalTimeElapsed.elapsed<std::chrono::microseconds>(), 1_u64); // Bytes / sec
-		const uint32_t secondsRemaining = (uint32_t)((100.0f - totalPercentage) / 100.0f * totalSize / meanSpeed);
-		if (_observer) _observer->onProgressChangedCallback(totalPercentage, currentItemIndex, _source.size(), filePercentage, meanSpeed, secondsRemaining);
+		const uint64_t meanSpeed = uint64_t(actualSizeProcessed * 1e6f) / std::max(_totalTimeElapsed.elapsed<std::chrono::microseconds>(), 1_u64); // Bytes / sec
+		const uint32_t secondsRemaining = meanSpeed > 0 ? (uint32_t)((100.0f - totalPercentage) / 100.0f * totalSize / meanSpeed) : 0;
+		if (_observer) _observer->onProgressChangedCallback(totalPercentage, currentItemIndex, _numItemsDiscovered, filePercentage, meanSpeed, secondsRemaining);
+
+		const uint64_t bytesCopied = itemManipulator.bytesCopied() - bytesCopiedBefore;
+		if (_bytesReadCounter && _bytesWrittenCounter)
+		{
+			_bytesReadCounter->add(bytesCopied);
+			// The blocks that the delta transfer found identical at the destination were not written
+			_bytesWrittenCounter->add(bytesCopied - (itemManipulator.bytesSkipped() - bytesSkippedBefore));
+		}
+
+		_bandwidthLimiter.consume(bytesCopied, _cancelRequested);
 
 		// TODO: why isn't this block at the start of 'do-while'?
 		if (_cancelRequested)
@@ -744,17 +1283,17 @@ COperationPerformer::NextAction COperationPerformer::copyItem(CFileSystemObject&
 	} while (itemManipulator.copyOperationInProgress());
 
 
+	if (result != FileOperationResultCode::Ok || _cancelRequested)
+		copyLatencyMeasurement.cancel(); // Only the complete copies are of interest
+
 	if (result != FileOperationResultCode::Ok)
 	{
 		itemManipulator.cancelCopy();
 
-		QString actualNewName = _newName;
-		if (actualNewName.isEmpty() && destInfo.isFile())
-			actualNewName = destInfo.isFile();
-
+		const QString actualNewName = _newName.isEmpty() ? destFileName : _newName;
 		const QString errorMessage =
 			"Error copying file " % item.fullAbsolutePath() %
-			" to " % destPath %
+			" to " % destFolderPath %
 			actualNewName %
 			", error: " % itemManipulator.lastErrorMessage();
 
@@ -771,6 +1310,64 @@ COperationPerformer::NextAction COperationPerformer::copyItem(CFileSystemObject&
 			assert_and_return_unconditional_r("Unexpected user response", naRetryOperation);
 	}
 
+	if (_cancelRequested)
+		return naProceed;
+
+	if (itemManipulator.deltaTransferUsed())
+	{
+		++_filesUpdatedByDeltaTransfer;
+		_bytesSkippedByDeltaTransfer += itemManipulator.bytesSkipped();
+		_bytesWrittenByDeltaTransfer += item.size() - itemManipulator.bytesSkipped();
+	}
+
+	if (multiplyLinked)
+		_hardLinkTracker.registerCopy(fileId, destFolderPath % (destName.isEmpty() ? item.fullName() : destName));
+
+	return naProceed;
+}
+
+COperationPerformer::NextAction COperationPerformer::copySymLink(CFileSystemObject& link, const QString& destFolderPath, const QString& destFileName)
+{
+	const CFileSystemObject destObject(destFolderPath % destFileName);
+	if (destObject.exists())
+	{
+		const auto response = getUserResponse(hrFileExists, link, destObject, QString());
+		if (response == urSkipThis || response == urSkipAll)
+			return naSkip;
+		else if (response == urAbort)
+			return naAbort;
+		else if (response == urRetry || response == urRename)
+			return naRetryItem; // The new name, if any, is picked up when the item is retried
+		else if (response != urProceedWithThis && response != urProceedWithAll)
+		{
+			assert_unconditional_r("Unexpected user response");
+			return naRetryItem;
+		}
+	}
+
+	{
+		NextAction nextAction;
+		while ((nextAction = ensureDestFolderExists(destFolderPath)) == naRetryOperation);
+		if (nextAction != naProceed)
+			return nextAction;
+	}
+
+	CFileManipulator linkManipulator(link);
+	const auto result = linkManipulator.copySymLink(destFolderPath, destFileName);
+	if (result != FileOperationResultCode::Ok)
+	{
+		const auto response = getUserResponse(haltReasonForOperationError(result), link, destObject, linkManipulator.lastErrorMessage());
+		if (response == urSkipThis || response == urSkipAll)
+			return naSkip;
+		else if (response == urAbort)
+			return naAbort;
+		else if (response == urRetry)
+			return naRetryOperation;
+		else
+			assert_and_return_unconditional_r("Unexpected user response", naRetryOperation);
+	}
+
+	++_symLinksRecreated;
 	return naProceed;
 }
 
@@ -793,14 +1390,50 @@ COperationPerformer::NextAction COperationPerformer::mkPath(const QDir& dir)
 	}
 }
 
-void COperationPerformer::handlePause()
+// Only touches the file system if the folder is different from the one checked last time
+COperationPerformer::NextAction COperationPerformer::ensureDestFolderExists(const QString& destFolderPath)
+{
+	if (destFolderPath == _lastEnsuredDestFolder)
+		return naProceed;
+
+	if (!QFileInfo::exists(destFolderPath))
+	{
+		const auto nextAction = mkPath(QDir(destFolderPath));
+		if (nextAction != naProceed)
+			return nextAction;
+	}
+
+	_lastEnsuredDestFolder = destFolderPath;
+	return naProceed;
+}
+
+void COperationPerformer::applyIoPriority() const
+{
+	// Every thread starts with the normal priority; a std::thread is never reused for another operation
+	static thread_local IoPriority currentThreadPriority = IoPriority::Normal;
+
+	const IoPriority requestedPriority = _ioPriority;
+	if (requestedPriority != currentThreadPriority)
+	{
+		setCurrentThreadIoPriority(requestedPriority);
+		currentThreadPriority = requestedPriority;
+	}
+}
+
+void COperationPerformer::handlePause(CScopedLatency* latency)
 {
 	if (_paused) // This code is not strictly thread-safe (the value of _paused may change between 'if' and 'while'), but in this context I'm OK with that
 	{
 		_totalTimeElapsed.pause();
+		if (latency)
+			latency->pause();
+		busyWorkersGauge().add(-1);
 		while (_paused)
 			std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
+		busyWorkersGauge().add(1);
 		_totalTimeElapsed.resume();
+		if (latency)
+			latency->resume();
 	}
 }
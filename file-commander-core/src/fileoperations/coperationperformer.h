@@ -1,6 +1,13 @@
 #pragma once
 
 #include "operationcodes.h"
+#include "cboundedqueue.hpp"
+#include "chardlinktracker.h"
+#include "cattributechanger.h"
+#include "csyncplanner.h"
+#include "cratelimiter.h"
+#include "iopriority.h"
+#include "pruningrules/cpruningrules.h"
 #include "cfilesystemobject.h"
 #include "system/ctimeelapsed.h"
 #include "assert/advanced_assert.h"
@@ -17,6 +24,9 @@ DISABLE_COMPILER_WARNINGS
 #include <QDebug>
 RESTORE_COMPILER_WARNINGS
 
+class CMetricCounter;
+class CScopedLatency;
+
 class CFileOperationObserver
 {
 friend class COperationPerformer;
@@ -57,6 +67,7 @@ private:
 			{hrCreatingFolderFailed, QObject::tr("Failed to create a folder")},
 			{hrFailedToDelete, QObject::tr("Failed to delete the item")},
 			{hrNotEnoughSpace, QObject::tr("Not enough space on the destination drive")},
+			{hrFailedToChangeAttributes, QObject::tr("Failed to change the attributes")},
 			{hrUnknownError, QObject::tr("Unknown error")}
 		};
 
@@ -100,6 +111,55 @@ public:
 	~COperationPerformer();
 
 	void setObserver(CFileOperationObserver *observer);
+	// Copy the files without filling the OS page cache with their contents (see CFileManipulator::setCacheNeutralCopying). Must be set before start().
+	void setCacheNeutralCopying(bool cacheNeutral);
+	// Copy symbolic links as links rather than the objects they point to, and recreate the hard links between the copied files instead of copying the same data again.
+	// Off by default, not supported on Windows. Must be set before start().
+	void setPreserveLinks(bool preserve);
+	// Update the existing large files in place by writing only the blocks that differ (see CFileManipulator::setDeltaTransfer). Must be set before start().
+	void setDeltaTransfer(bool deltaTransfer);
+	// Leave out the source items excluded by the rules (see CPruningRules). Only applies to operationCopy: a move would lose the excluded items along with the source.
+	// Must be set before start().
+	void setPruningRules(CPruningRules rules);
+	// For operationSync, which makes the destination folder a mirror of the source items by only copying the new and the changed files (see CSyncPlanner). Must be set before start().
+	void setSyncOptions(const SyncOptions& options);
+	// The changes made by operationSync so far, or the changes that would be made in a dry run
+	SyncReport syncReport() const;
+	// For operationChangeAttributes, which applies the change to the source items and everything inside them (see CAttributeChanger). Must be set before start().
+	void setAttributeChange(const AttributeChange& change);
+	// The number of items whose attributes have actually been changed
+	size_t numItemsChanged() const;
+	// Answers every halt for 'reason' with 'response' (urSkipAll or urProceedWithAll) without asking the observer, as if the user had already chosen it for all the items.
+	// For running without anyone to ask. Must be set before start().
+	void setGlobalResponse(HaltReason reason, UserResponse response);
+
+	// I/O scheduling and throttling. Can be changed at any time, including while the operation is running.
+	void setIoPriority(IoPriority priority);
+	IoPriority ioPriority() const;
+	// Bytes per second for copying and moving, 0 means unlimited
+	void setBandwidthLimit(uint64_t bytesPerSecond);
+	uint64_t bandwidthLimit() const;
+	// Items per second for deleting and changing attributes, 0 means unlimited
+	void setOperationsPerSecondLimit(uint64_t operationsPerSecond);
+	uint64_t operationsPerSecondLimit() const;
+
+	// The rates actually achieved over the last couple of seconds
+	uint64_t currentBytesPerSecond() const;
+	uint64_t currentOperationsPerSecond() const;
+
+	struct LinkStatistics {
+		size_t hardLinksRecreated = 0;
+		size_t symLinksRecreated = 0;
+		uint64_t bytesSaved = 0; // The data that didn't have to be copied thanks to the recreated hard links
+	};
+	LinkStatistics linkStatistics() const;
+
+	struct DeltaTransferStatistics {
+		size_t filesUpdated = 0;
+		uint64_t bytesWritten = 0;
+		uint64_t bytesSkipped = 0; // Already identical at the destination
+	};
+	DeltaTransferStatistics deltaTransferStatistics() const;
 
 	bool togglePause();
 	bool paused()  const;
@@ -119,12 +179,20 @@ private:
 
 	void copyFiles();
 	void deleteFiles();
+	void syncFiles();
+	void changeAttributes();
 
 	void finalize();
 
-	// Iterates over all dirs in the source vector, and their subdirs, and so on and replaces _sources with a flat list of files. Returns a list of destination folders where each of the files must be copied to according to _dest
-	// Also counts the total size of all the files to monitor progress
-	std::vector<QDir> enumerateSourcesAndCalcDest(uint64_t& totalSize);
+	struct CopyWorkItem {
+		CFileSystemObject object;
+		QString destFolderPath; // Always ends with a '/'
+		bool copiedSuccessfully = false;
+	};
+
+	// Iterates over all dirs in the source vector, and their subdirs, and so on, and feeds every item along with its destination folder into the queue as soon as it's discovered.
+	// Also counts the total size of the files discovered so far to monitor progress
+	void enumerateSources(CBoundedQueue<CopyWorkItem>& queue, const std::atomic<bool>& abort);
 
 	UserResponse getUserResponse(HaltReason hr, const CFileSystemObject& src, const CFileSystemObject& dst, const QString& message);
 
@@ -132,10 +200,18 @@ private:
 	enum NextAction {naProceed, naRetryItem, naRetryOperation, naSkip, naAbort};
 	NextAction deleteItem(CFileSystemObject& item);
 	NextAction makeItemWriteable(CFileSystemObject& item);
-	NextAction copyItem(CFileSystemObject& item, const QFileInfo& destInfo, const QDir& destDir, uint64_t sizeProcessedPreviously, uint64_t totalSize, size_t currentItemIndex);
+	NextAction copyItem(CFileSystemObject& item, const QString& destFolderPath, const QString& destFileName, uint64_t sizeProcessedPreviously, size_t currentItemIndex);
+	NextAction copySymLink(CFileSystemObject& link, const QString& destFolderPath, const QString& destFileName);
+	// Deletes an item at the sync destination, with all of its contents if it's a folder
+	NextAction deleteTree(const CFileSystemObject& root);
 	NextAction mkPath(const QDir& dir);
+	// Only touches the file system if the folder is different from the one checked last time
+	NextAction ensureDestFolderExists(const QString& destFolderPath);
 
-	void handlePause();
+	// Excludes the time spent paused from 'latency', if specified
+	void handlePause(CScopedLatency* latency = nullptr);
+	// Brings the calling thread's I/O priority in line with the one requested
+	void applyIoPriority() const;
 
 private:
 	struct ObjectToProcess {
@@ -159,12 +235,42 @@ private:
 	CFileSystemObject              _destFileSystemObject;
 	QString                        _newName;
 	Operation                      _op;
+	bool                           _cacheNeutralCopying = false;
+	bool                           _deltaTransfer = false;
+	CPruningRules                  _pruningRules;
+	SyncOptions                    _syncOptions;
+	SyncReport                     _syncReport;
+	mutable std::mutex             _syncReportMutex;
+	AttributeChange                _attributeChange;
+	std::atomic<size_t>            _numItemsChanged {0};
+	bool                           _preserveLinks = false;
+	std::atomic<IoPriority>        _ioPriority {IoPriority::Normal};
+	CRateLimiter                   _bandwidthLimiter;
+	CRateLimiter                   _operationsLimiter;
 	std::atomic<bool>              _paused {false};
 	std::atomic<bool>              _inProgress {false};
 	std::atomic<bool>              _done {false};
 	std::atomic<bool>              _cancelRequested {false};
 	UserResponse                   _userResponse = urNone;
 
+	// The source tree is being enumerated concurrently with copying, so the totals are only the ones known so far until enumeration completes
+	std::atomic<uint64_t>          _totalSizeDiscovered {0};
+	std::atomic<size_t>            _numItemsDiscovered {0};
+	QString                        _lastEnsuredDestFolder;
+
+	CHardLinkTracker               _hardLinkTracker;
+	std::atomic<size_t>            _hardLinksRecreated {0};
+	std::atomic<size_t>            _symLinksRecreated {0};
+	std::atomic<uint64_t>          _bytesSavedByHardLinks {0};
+
+	std::atomic<size_t>            _filesUpdatedByDeltaTransfer {0};
+	std::atomic<uint64_t>          _bytesWrittenByDeltaTransfer {0};
+	std::atomic<uint64_t>          _bytesSkippedByDeltaTransfer {0};
+
+	// The throughput of the source and the destination devices, see CMetricsRegistry
+	CMetricCounter               * _bytesReadCounter = nullptr;
+	CMetricCounter               * _bytesWrittenCounter = nullptr;
+
 	std::thread                    _thread;
 	std::mutex                     _waitForResponseMutex;
 	std::condition_variable        _waitForResponseCondition;
@@ -0,0 +1,104 @@
+#include "cratelimiter.h"
+
+#include <algorithm>
+#include <thread>
+
+// The bucket can't hold more than this many seconds' worth of units, so that a pause or a slow stretch isn't followed by a burst at full speed
+static constexpr double MaxBurstDuration = 0.2;
+// How often a waiting thread checks for the rate change and abort request
+static constexpr std::chrono::milliseconds MaxWaitSlice {50};
+
+void CRateLimiter::setRate(uint64_t unitsPerSecond)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	refill(Clock::now()); // Whatever has accumulated so far was accumulated at the old rate
+	_rate = unitsPerSecond;
+	if (_rate == 0)
+		_tokens = 0.0;
+	else
+		_tokens = std::min(_tokens, MaxBurstDuration * (double)_rate);
+}
+
+uint64_t CRateLimiter::rate() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _rate;
+}
+
+bool CRateLimiter::consume(uint64_t units, const std::atomic<bool>& abort)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	const auto now = Clock::now();
+	advanceMeasurementWindow(now);
+	if (_measurementStartTime == Clock::time_point{})
+		_measurementStartTime = now;
+	_slots[(size_t)_currentSlot % NumSlots] += units;
+
+	refill(now);
+	if (_rate == 0)
+		return true;
+
+	_tokens -= (double)units;
+	while (_tokens < 0.0)
+	{
+		const auto debtDuration = std::chrono::duration<double>(-_tokens / (double)_rate);
+		lock.unlock();
+
+		if (abort)
+			return false;
+
+		std::this_thread::sleep_for(std::min(std::chrono::duration_cast<std::chrono::milliseconds>(debtDuration) + std::chrono::milliseconds(1), MaxWaitSlice));
+
+		lock.lock();
+		refill(Clock::now());
+		if (_rate == 0) // The limit has been lifted while waiting
+			break;
+	}
+
+	return true;
+}
+
+uint64_t CRateLimiter::measuredRate() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_currentSlot < 0)
+		return 0;
+
+	const auto now = Clock::now();
+	advanceMeasurementWindow(now);
+
+	uint64_t total = 0;
+	for (const uint64_t units: _slots)
+		total += units;
+
+	// Until the window has filled up, the rate is averaged over the time elapsed so far
+	const double elapsedSeconds = std::chrono::duration<double>(now - _measurementStartTime).count();
+	const double windowDuration = std::clamp(elapsedSeconds, std::chrono::duration<double>(SlotDuration).count(), std::chrono::duration<double>(SlotDuration * NumSlots).count());
+	return (uint64_t)((double)total / windowDuration);
+}
+
+void CRateLimiter::refill(Clock::time_point now)
+{
+	if (_rate != 0 && _lastRefillTime != Clock::time_point{})
+	{
+		const double elapsedSeconds = std::chrono::duration<double>(now - _lastRefillTime).count();
+		_tokens = std::min(_tokens + elapsedSeconds * (double)_rate, MaxBurstDuration * (double)_rate);
+	}
+
+	_lastRefillTime = now;
+}
+
+void CRateLimiter::advanceMeasurementWindow(Clock::time_point now) const
+{
+	const int64_t slot = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() / SlotDuration.count();
+	if (_currentSlot >= 0)
+	{
+		// Clearing the slots that have expired since the last call
+		const int64_t numExpiredSlots = std::min(slot - _currentSlot, (int64_t)NumSlots);
+		for (int64_t i = 1; i <= numExpiredSlots; ++i)
+			_slots[(size_t)(_currentSlot + i) % NumSlots] = 0;
+	}
+
+	_currentSlot = slot;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+
+// A token bucket for throttling an operation to a given number of units (bytes, files) per second.
+// The work is accounted for after it's been done: the bucket is allowed to go into debt, and the next consume() call waits until the debt is paid off.
+// The rate can be changed at any time from any thread, the waiting thread picks the new value up within a few dozen milliseconds.
+// Also measures the rate actually achieved, whether a limit is set or not.
+class CRateLimiter
+{
+public:
+	// 0 means unlimited
+	void setRate(uint64_t unitsPerSecond);
+	uint64_t rate() const;
+
+	// Blocks until the average rate is back under the limit. Returns false if interrupted by 'abort'.
+	bool consume(uint64_t units, const std::atomic<bool>& abort);
+
+	// The average rate over the last couple of seconds
+	uint64_t measuredRate() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void refill(Clock::time_point now);
+	void advanceMeasurementWindow(Clock::time_point now) const;
+
+private:
+	mutable std::mutex _mutex;
+
+	uint64_t _rate = 0;
+	double _tokens = 0.0; // Negative means debt
+	Clock::time_point _lastRefillTime;
+
+	// The measurement window is split into slots of SlotDuration, each one holding the number of units consumed during that period
+	static constexpr std::chrono::milliseconds SlotDuration {100};
+	static constexpr size_t NumSlots = 20;
+	mutable std::array<uint64_t, NumSlots> _slots {};
+	mutable int64_t _currentSlot = -1;
+	Clock::time_point _measurementStartTime;
+};
@@ -0,0 +1,277 @@
+#include "csyncplanner.h"
+#include "cfilemanipulator.h"
+#include "directoryscanner.h"
+#include "filecomparator/cfilecomparator.h"
+#include "filesystemhelperfunctions.h"
+#include "assert/advanced_assert.h"
+#include "threading/thread_helpers.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <stdlib.h>
+
+static QFileInfoList listFolder(const QString& path)
+{
+	return QDir{path}.entryInfoList(QDir::Files | QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot | QDir::System);
+}
+
+// The same item may be spelled differently at the destination if the file system ignores the letter case
+static QString comparisonKey(const QString& name)
+{
+	return caseSensitiveFilesystem() ? name : name.toLower();
+}
+
+static bool contentsEqual(const CFileSystemObject& a, const CFileSystemObject& b)
+{
+	QFile fileA(a.fullAbsolutePath()), fileB(b.fullAbsolutePath());
+	if (!fileA.open(QFile::ReadOnly) || !fileB.open(QFile::ReadOnly))
+		return false; // Whatever the problem is, copying will report it
+
+	bool equal = false;
+	CFileComparator().compareFiles(fileA, fileB, [](int) {}, [&equal](CFileComparator::ComparisonResult result) {
+		equal = result == CFileComparator::Equal;
+	});
+
+	return equal;
+}
+
+QString SyncAction::destPath() const
+{
+	return type == Delete ? dest.fullAbsolutePath() : destFolderPath + source.fullName();
+}
+
+bool SyncReport::hasChanges() const
+{
+	return numFoldersCreated > 0 || numFilesCopied > 0 || numFilesUpdated > 0 || numItemsDeleted > 0;
+}
+
+CSyncPlanner::CSyncPlanner(const SyncOptions& options, bool preserveLinks) :
+	_options(options),
+	_preserveLinks(preserveLinks)
+{
+}
+
+CSyncPlanner::~CSyncPlanner()
+{
+	if (!_lister.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(_listerMutex);
+		_stopLister = true;
+	}
+	_listerCondition.notify_all();
+	_lister.join();
+}
+
+void CSyncPlanner::compare(const CFileSystemObject& source, const QString& destFolderPath, const std::function<void (SyncAction&&)>& observer, const std::atomic<bool>& abort)
+{
+	assert_and_return_r(destFolderPath.endsWith('/'), );
+
+	_observer = &observer;
+	_abort = &abort;
+
+	const CFileSystemObject dest(destFolderPath + source.fullName());
+	// A dangling link doesn't "exist", but it's still in the way
+	const bool destExists = dest.exists() || dest.isSymLink();
+	compareItems(source, destExists ? &dest : nullptr, destFolderPath);
+
+	_observer = nullptr;
+	_abort = nullptr;
+	_sourceFolderStack.clear();
+}
+
+size_t CSyncPlanner::numItemsUpToDate() const
+{
+	return _numItemsUpToDate;
+}
+
+void CSyncPlanner::compareItems(const CFileSystemObject& source, const CFileSystemObject* dest, const QString& destFolderPath)
+{
+	if (*_abort)
+		return;
+
+	// A file replaced by a folder or vice versa. This is not an extraneous item, so it's deleted regardless of the options.
+	if (dest && isFolder(source) != isFolder(*dest))
+	{
+		report(SyncAction::Delete, CFileSystemObject(), *dest, destFolderPath);
+		dest = nullptr;
+	}
+
+	if (isFolder(source))
+	{
+		if (leadsToLoop(source))
+		{
+			qInfo() << "Skipping" << source.fullAbsolutePath() << "as it links back to a folder being synchronized";
+			return;
+		}
+
+		_sourceFolderStack.push_back(source.fullAbsolutePath());
+		const QString destPath = destFolderPath + source.fullName() + '/';
+		if (dest)
+			compareFolders(source, destPath);
+		else
+		{
+			report(SyncAction::CreateFolder, source, CFileSystemObject(), destFolderPath);
+			copyFolder(source, destPath);
+		}
+		_sourceFolderStack.pop_back();
+	}
+	else if (!dest)
+		report(SyncAction::CopyNew, source, CFileSystemObject(), destFolderPath);
+	else if (upToDate(source, *dest))
+		++_numItemsUpToDate;
+	else
+		report(SyncAction::Update, source, CFileSystemObject(), destFolderPath);
+}
+
+void CSyncPlanner::compareFolders(const CFileSystemObject& sourceFolder, const QString& destFolderPath)
+{
+	requestListing(destFolderPath);
+	const QFileInfoList sourceEntries = listFolder(sourceFolder.fullAbsolutePath());
+	const QFileInfoList destEntries = takeListing();
+
+	QHash<QString, CFileSystemObject> destItems;
+	destItems.reserve(destEntries.size());
+	for (const QFileInfo& entry: destEntries)
+		destItems.insert(comparisonKey(entry.fileName()), CFileSystemObject(entry));
+
+	// The extraneous items go first to free up the space for the new ones
+	if (_options.deleteExtraneous)
+	{
+		QSet<QString> sourceKeys;
+		sourceKeys.reserve(sourceEntries.size());
+		for (const QFileInfo& entry: sourceEntries)
+			sourceKeys.insert(comparisonKey(entry.fileName()));
+
+		for (auto it = destItems.cbegin(); it != destItems.cend() && !*_abort; ++it)
+		{
+			if (!sourceKeys.contains(it.key()))
+				report(SyncAction::Delete, CFileSystemObject(), it.value(), destFolderPath);
+		}
+	}
+
+	for (const QFileInfo& entry: sourceEntries)
+	{
+		if (*_abort)
+			return;
+
+		const auto dest = destItems.constFind(comparisonKey(entry.fileName()));
+		compareItems(CFileSystemObject(entry), dest != destItems.cend() ? &dest.value() : nullptr, destFolderPath);
+	}
+}
+
+void CSyncPlanner::copyFolder(const CFileSystemObject& sourceFolder, const QString& destFolderPath)
+{
+	for (const QFileInfo& entry: listFolder(sourceFolder.fullAbsolutePath()))
+	{
+		if (*_abort)
+			return;
+
+		// There's nothing at the destination to compare with
+		compareItems(CFileSystemObject(entry), nullptr, destFolderPath);
+	}
+}
+
+bool CSyncPlanner::upToDate(const CFileSystemObject& source, const CFileSystemObject& dest) const
+{
+	if (_preserveLinks && (source.isSymLink() || dest.isSymLink()))
+		return source.isSymLink() && dest.isSymLink() && CFileManipulator::storedSymLinkTarget(source.fullAbsolutePath()) == CFileManipulator::storedSymLinkTarget(dest.fullAbsolutePath());
+
+	if (source.size() != dest.size())
+		return false;
+	else if (_options.compareContents)
+		return contentsEqual(source, dest);
+
+	const auto timeDifference = static_cast<long long>(source.properties().modificationDate) - static_cast<long long>(dest.properties().modificationDate);
+	return ::llabs(timeDifference) <= ModificationTimeTolerance;
+}
+
+bool CSyncPlanner::isFolder(const CFileSystemObject& item) const
+{
+	return item.isDir() && !(_preserveLinks && item.isSymLink());
+}
+
+bool CSyncPlanner::leadsToLoop(const CFileSystemObject& folder) const
+{
+	if (!folder.isSymLink())
+		return false;
+
+	// Rare enough for resolving all the paths on the spot to not matter
+	const QString targetPath = folder.qFileInfo().canonicalFilePath();
+	return std::any_of(_sourceFolderStack.cbegin(), _sourceFolderStack.cend(), [&targetPath](const QString& path) {
+		return isSameOrParentFolder(targetPath, QFileInfo(path).canonicalFilePath());
+	});
+}
+
+void CSyncPlanner::report(SyncAction::Type type, const CFileSystemObject& source, const CFileSystemObject& dest, const QString& destFolderPath)
+{
+	SyncAction action;
+	action.type = type;
+	action.source = source;
+	action.dest = dest;
+	action.destFolderPath = destFolderPath;
+	(*_observer)(std::move(action));
+}
+
+void CSyncPlanner::requestListing(const QString& folderPath)
+{
+	if (!_lister.joinable())
+		_lister = std::thread(&CSyncPlanner::listerThread, this);
+
+	{
+		std::lock_guard<std::mutex> lock(_listerMutex);
+		assert_r(!_listingRequested && !_listingReady);
+		_listingRequest = folderPath;
+		_listingRequested = true;
+	}
+	_listerCondition.notify_all();
+}
+
+QFileInfoList CSyncPlanner::takeListing()
+{
+	std::unique_lock<std::mutex> lock(_listerMutex);
+	_listerCondition.wait(lock, [this] {
+		return _listingReady;
+	});
+
+	_listingReady = false;
+	return std::move(_listingResult);
+}
+
+void CSyncPlanner::listerThread()
+{
+	setThreadName("CSyncPlanner lister thread");
+
+	for (;;)
+	{
+		QString folderPath;
+		{
+			std::unique_lock<std::mutex> lock(_listerMutex);
+			_listerCondition.wait(lock, [this] {
+				return _stopLister || _listingRequested;
+			});
+
+			if (_stopLister)
+				return;
+
+			folderPath = std::move(_listingRequest);
+			_listingRequested = false;
+		}
+
+		QFileInfoList entries = listFolder(folderPath);
+
+		{
+			std::lock_guard<std::mutex> lock(_listerMutex);
+			_listingResult = std::move(entries);
+			_listingReady = true;
+		}
+		_listerCondition.notify_all();
+	}
+}
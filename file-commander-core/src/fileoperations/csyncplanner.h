@@ -0,0 +1,115 @@
+#pragma once
+
+#include "cfilesystemobject.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+struct SyncOptions {
+	// Files of the same size are compared byte by byte instead of by modification time: slower, but catches the changes that didn't touch the time
+	bool compareContents = false;
+	// Remove the items at the destination that don't exist in the source, making it an exact mirror
+	bool deleteExtraneous = false;
+	// Only report the changes, don't make them
+	bool dryRun = false;
+};
+
+// One step of bringing the destination in line with the source
+struct SyncAction {
+	enum Type { CreateFolder, CopyNew, Update, Delete };
+
+	Type type = CopyNew;
+	CFileSystemObject source; // Not set for Delete
+	CFileSystemObject dest; // The item to delete; not set for the other types
+	QString destFolderPath; // Where the source item goes, always ends with a '/'
+
+	// The full path of the item at the destination
+	QString destPath() const;
+};
+
+struct SyncReport {
+	struct Entry {
+		SyncAction::Type type;
+		QString path; // At the destination
+	};
+
+	// Only recorded for a dry run, and only up to MaxEntries
+	static constexpr size_t MaxEntries = 10000;
+	std::vector<Entry> entries;
+
+	size_t numFoldersCreated = 0;
+	size_t numFilesCopied = 0;
+	size_t numFilesUpdated = 0;
+	size_t numItemsDeleted = 0;
+	uint64_t bytesCopied = 0; // New and updated files
+	size_t numItemsUpToDate = 0;
+
+	bool hasChanges() const;
+};
+
+// Compares a source tree with its copy and works out the actions that make the copy an exact mirror of the source.
+// Both trees are walked together, one folder at a time: the destination folder is listed on a separate thread while the source folder is being listed.
+// That thread is started on the first folder comparison and lives as long as the planner.
+// Files are considered up to date if both the size and the modification time match, so a second pass over an unchanged tree costs no more than listing the two trees.
+// Only the folders that exist on both sides are compared; a new folder's contents are simply copied, and an extraneous folder is deleted as a whole.
+class CSyncPlanner
+{
+public:
+	// FAT only stores the modification time with a 2 seconds resolution
+	static constexpr time_t ModificationTimeTolerance = 2;
+
+	// With 'preserveLinks' symbolic links are compared and copied as links (see COperationPerformer::setPreserveLinks), otherwise they're followed
+	CSyncPlanner(const SyncOptions& options, bool preserveLinks);
+	~CSyncPlanner();
+
+	CSyncPlanner(const CSyncPlanner&) = delete;
+	CSyncPlanner& operator=(const CSyncPlanner&) = delete;
+
+	// Compares 'source' with the item of the same name in 'destFolderPath' (which must end with a '/').
+	// The actions are reported in the order they must be performed: a folder is created before its contents are copied, and an extraneous item is deleted before anything is copied into its folder.
+	void compare(const CFileSystemObject& source, const QString& destFolderPath, const std::function<void (SyncAction&&)>& observer, const std::atomic<bool>& abort);
+
+	size_t numItemsUpToDate() const;
+
+private:
+	// 'dest' is the item at the destination with the same name as 'source', or nullptr if there's none
+	void compareItems(const CFileSystemObject& source, const CFileSystemObject* dest, const QString& destFolderPath);
+	// 'destFolderPath' is the counterpart of 'sourceFolder' here, not its parent
+	void compareFolders(const CFileSystemObject& sourceFolder, const QString& destFolderPath);
+	void copyFolder(const CFileSystemObject& sourceFolder, const QString& destFolderPath);
+	bool upToDate(const CFileSystemObject& source, const CFileSystemObject& dest) const;
+	// Links to folders are leaves if the links are preserved
+	bool isFolder(const CFileSystemObject& item) const;
+	// Following a link to one of the folders being compared, or to their parent, would never end
+	bool leadsToLoop(const CFileSystemObject& folder) const;
+	void report(SyncAction::Type type, const CFileSystemObject& source, const CFileSystemObject& dest, const QString& destFolderPath);
+
+	// Hands the folder over to the lister thread; the result must be collected with takeListing() before the next request
+	void requestListing(const QString& folderPath);
+	QFileInfoList takeListing();
+	void listerThread();
+
+private:
+	const SyncOptions _options;
+	const bool _preserveLinks;
+	size_t _numItemsUpToDate = 0;
+
+	// Only valid during compare()
+	const std::function<void (SyncAction&&)>* _observer = nullptr;
+	const std::atomic<bool>* _abort = nullptr;
+	std::vector<QString> _sourceFolderStack; // The folders currently being compared, from the root down
+
+	std::thread _lister;
+	std::mutex _listerMutex;
+	std::condition_variable _listerCondition;
+	QString _listingRequest;
+	QFileInfoList _listingResult;
+	bool _listingRequested = false;
+	bool _listingReady = false;
+	bool _stopLister = false;
+};
@@ -0,0 +1,78 @@
+#include "iopriority.h"
+
+#if defined __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined __APPLE__
+#include <sys/resource.h>
+#elif defined _WIN32
+#include <Windows.h>
+#endif
+
+#if defined __linux__
+
+// glibc provides no wrapper for ioprio_set(), the constants are from linux/ioprio.h
+namespace {
+
+enum {
+	IOPRIO_CLASS_NONE = 0,
+	IOPRIO_CLASS_BE = 2,
+	IOPRIO_CLASS_IDLE = 3
+};
+
+enum {
+	IOPRIO_WHO_PROCESS = 1
+};
+
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+
+constexpr int ioprioValue(int ioClass, int level) noexcept
+{
+	return (ioClass << IOPRIO_CLASS_SHIFT) | level;
+}
+
+}
+
+bool setCurrentThreadIoPriority(IoPriority priority) noexcept
+{
+	int value = ioprioValue(IOPRIO_CLASS_NONE, 0); // The default: derived from the CPU nice value
+	if (priority == IoPriority::Low)
+		value = ioprioValue(IOPRIO_CLASS_BE, 7);
+	else if (priority == IoPriority::Idle)
+		value = ioprioValue(IOPRIO_CLASS_IDLE, 0);
+
+	// With IOPRIO_WHO_PROCESS, the ID of 0 refers to the calling thread rather than the whole process
+	return ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, value) == 0;
+}
+
+#elif defined __APPLE__
+
+bool setCurrentThreadIoPriority(IoPriority priority) noexcept
+{
+	int policy = IOPOL_DEFAULT;
+	if (priority == IoPriority::Low)
+		policy = IOPOL_UTILITY;
+	else if (priority == IoPriority::Idle)
+		policy = IOPOL_THROTTLE;
+
+	return ::setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, policy) == 0;
+}
+
+#elif defined _WIN32
+
+bool setCurrentThreadIoPriority(IoPriority priority) noexcept
+{
+	if (priority != IoPriority::Normal)
+		return ::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN) != FALSE || ::GetLastError() == ERROR_THREAD_MODE_ALREADY_BACKGROUND;
+	else
+		return ::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_END) != FALSE || ::GetLastError() == ERROR_THREAD_MODE_NOT_BACKGROUND;
+}
+
+#else
+
+bool setCurrentThreadIoPriority(IoPriority priority) noexcept
+{
+	return priority == IoPriority::Normal;
+}
+
+#endif
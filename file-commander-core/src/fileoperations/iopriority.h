@@ -0,0 +1,15 @@
+#pragma once
+
+// The I/O scheduling class of a thread.
+// Normal: the OS default.
+// Low: still served in turn with everyone else, but at the lowest priority (Linux best-effort level 7, macOS IOPOL_UTILITY).
+// Idle: only served when no one else needs the disk (Linux idle class, macOS IOPOL_THROTTLE).
+// Windows only has the background mode, which is used for both Low and Idle.
+enum class IoPriority {
+	Normal,
+	Low,
+	Idle
+};
+
+// Only affects the calling thread. Returns false if the priority couldn't be set or isn't supported on this platform.
+bool setCurrentThreadIoPriority(IoPriority priority) noexcept;
@@ -1,7 +1,7 @@
 #pragma once
 
-enum Operation {operationCopy, operationMove, operationDelete};
+enum Operation {operationCopy, operationMove, operationDelete, operationSync, operationChangeAttributes};
 
 enum UserResponse {urSkipThis, urSkipAll, urProceedWithThis, urProceedWithAll, urRename, urAbort, urRetry, urNone};
 
-enum HaltReason {hrFileExists, hrSourceFileIsReadOnly, hrDestFileIsReadOnly, hrFailedToMakeItemWritable, hrFileDoesntExit, hrCreatingFolderFailed, hrFailedToDelete, hrUnknownError, hrNotEnoughSpace};
+enum HaltReason {hrFileExists, hrSourceFileIsReadOnly, hrDestFileIsReadOnly, hrFailedToMakeItemWritable, hrFileDoesntExit, hrCreatingFolderFailed, hrFailedToDelete, hrUnknownError, hrNotEnoughSpace, hrFailedToChangeAttributes};
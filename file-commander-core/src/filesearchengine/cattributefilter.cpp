@@ -0,0 +1,66 @@
+#include "cattributefilter.h"
+#include "cfilesystemobject.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDateTime>
+RESTORE_COMPILER_WARNINGS
+
+#include <utility>
+
+static uint32_t posixPermissions(QFileDevice::Permissions permissions)
+{
+	static constexpr std::pair<QFileDevice::Permission, uint32_t> bits[] {
+		{QFileDevice::ReadOwner, 0400}, {QFileDevice::WriteOwner, 0200}, {QFileDevice::ExeOwner, 0100},
+		{QFileDevice::ReadGroup, 0040}, {QFileDevice::WriteGroup, 0020}, {QFileDevice::ExeGroup, 0010},
+		{QFileDevice::ReadOther, 0004}, {QFileDevice::WriteOther, 0002}, {QFileDevice::ExeOther, 0001}
+	};
+
+	uint32_t mode = 0;
+	for (const auto& bit : bits)
+	{
+		if (permissions.testFlag(bit.first))
+			mode |= bit.second;
+	}
+
+	return mode;
+}
+
+bool AttributeFilter::isEmpty() const
+{
+	return types == AllTypes
+		&& minSize == 0 && maxSize == std::numeric_limits<uint64_t>::max()
+		&& modifiedAfter == std::numeric_limits<time_t>::min() && modifiedBefore == std::numeric_limits<time_t>::max()
+		&& changedAfter == std::numeric_limits<time_t>::min() && changedBefore == std::numeric_limits<time_t>::max()
+		&& permissionsSet == 0 && permissionsClear == 0;
+}
+
+bool AttributeFilter::matches(const CFileSystemObject& item) const
+{
+	// From the cheapest to the most expensive check: the properties are plain fields, the rest comes from the cached QFileInfo data
+	const CFileSystemObjectProperties& properties = item.properties();
+	const ItemType type = item.isSymLink() ? SymLinks : (item.isDir() ? Folders : Files);
+	if ((types & type) == 0)
+		return false;
+
+	if ((minSize > 0 || maxSize != std::numeric_limits<uint64_t>::max()) && (type != Files || properties.size < minSize || properties.size > maxSize))
+		return false;
+
+	if (properties.modificationDate < modifiedAfter || properties.modificationDate > modifiedBefore)
+		return false;
+
+	if (changedAfter != std::numeric_limits<time_t>::min() || changedBefore != std::numeric_limits<time_t>::max())
+	{
+		const auto changed = static_cast<time_t>(item.qFileInfo().metadataChangeTime().toSecsSinceEpoch());
+		if (changed < changedAfter || changed > changedBefore)
+			return false;
+	}
+
+	if (permissionsSet != 0 || permissionsClear != 0)
+	{
+		const uint32_t mode = posixPermissions(item.qFileInfo().permissions());
+		if ((mode & permissionsSet) != permissionsSet || (mode & permissionsClear) != 0)
+			return false;
+	}
+
+	return true;
+}
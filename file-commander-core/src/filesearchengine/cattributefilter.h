@@ -0,0 +1,38 @@
+#pragma once
+
+#include <limits>
+#include <stdint.h>
+#include <time.h>
+
+class CFileSystemObject;
+
+// Conditions on the item metadata for the file search. They are evaluated from the metadata the folder scan has already read, at no extra I/O,
+// which is why the search checks them before anything else. All the ranges are inclusive; the default values match everything.
+struct AttributeFilter
+{
+	enum ItemType : uint32_t {
+		Files = 1,
+		Folders = 2,
+		SymLinks = 4,
+		AllTypes = Files | Folders | SymLinks
+	};
+
+	uint32_t types = AllTypes;
+
+	// Only files can match once either of the size limits is set
+	uint64_t minSize = 0;
+	uint64_t maxSize = std::numeric_limits<uint64_t>::max();
+
+	time_t modifiedAfter = std::numeric_limits<time_t>::min();
+	time_t modifiedBefore = std::numeric_limits<time_t>::max();
+	// The status change time (ctime), the creation time on Windows
+	time_t changedAfter = std::numeric_limits<time_t>::min();
+	time_t changedBefore = std::numeric_limits<time_t>::max();
+
+	// The POSIX rwx bits for the owner, the group and the others (0777): all of 'permissionsSet' must be set, and all of 'permissionsClear' must be clear
+	uint32_t permissionsSet = 0;
+	uint32_t permissionsClear = 0;
+
+	bool isEmpty() const;
+	bool matches(const CFileSystemObject& item) const;
+};
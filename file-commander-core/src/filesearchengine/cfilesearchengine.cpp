@@ -1,6 +1,9 @@
 #include "../ccontroller.h"
+#include "cnamematcher.h"
 #include "system/ctimeelapsed.h"
 #include "directoryscanner.h"
+#include "threading/thread_helpers.h"
+#include "tracing/ctracer.h"
 
 DISABLE_COMPILER_WARNINGS
 #include <QDebug>
@@ -8,10 +11,27 @@ DISABLE_COMPILER_WARNINGS
 #include <QTextStream>
 RESTORE_COMPILER_WARNINGS
 
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
 const int tag = abs((int)qHash(QString("CFileSearchEngine")));
 
+static constexpr uint64_t matchesBatchIntervalMs = 50;
+
 CFileSearchEngine::CFileSearchEngine(CController& controller) :
-	_controller(controller),
+	CFileSearchEngine([&controller](std::function<void ()> task, int taskTag) {
+		controller.execOnUiThread(std::move(task), taskTag);
+	}, &controller.contentIndexer())
+{
+}
+
+CFileSearchEngine::CFileSearchEngine(NotificationExecutor executor, const CContentIndexer* contentIndexer) :
+	_executor(std::move(executor)),
+	_contentIndexer(contentIndexer),
 	_workerThread("File search thread")
 {
 }
@@ -32,7 +52,7 @@ bool CFileSearchEngine::searchInProgress() const
 	return _workerThread.running();
 }
 
-void CFileSearchEngine::search(const QString& what, bool subjectCaseSensitive, const QStringList& where, const QString& contentsToFind, bool contentsCaseSensitive)
+void CFileSearchEngine::search(const QString& what, bool subjectCaseSensitive, const QStringList& where, const QString& contentsToFind, bool contentsCaseSensitive, const AttributeFilter& attributeFilter, const CPruningRules& pruningRules)
 {
 	if (_workerThread.running())
 	{
@@ -43,84 +63,157 @@ void CFileSearchEngine::search(const QString& what, bool subjectCaseSensitive, c
 	if (what.isEmpty() || where.empty())
 		return;
 
-	_workerThread.exec([this, what, subjectCaseSensitive, where, contentsToFind, contentsCaseSensitive](){
-		uint64_t itemCounter = 0;
+	_workerThread.exec([this, what, subjectCaseSensitive, where, contentsToFind, contentsCaseSensitive, attributeFilter, pruningRules](){
+		TRACE_SCOPE("CFileSearchEngine::search");
+
+		std::atomic<uint64_t> itemCounter{0};
 		CTimeElapsed timer;
 		timer.start();
 
-		const bool nameQueryHasWildcards = what.contains(QRegExp("[*?]"));
-		QRegExp queryRegExp;
-		if (nameQueryHasWildcards)
-		{
-			QString adjustedQuery = what;
-			if (!what.startsWith('*'))
-				adjustedQuery.prepend('*');
-			if (!what.endsWith('*'))
-				adjustedQuery.append('*');
-
-			queryRegExp.setPatternSyntax(QRegExp::Wildcard);
-			queryRegExp.setPattern(adjustedQuery);
-			queryRegExp.setCaseSensitivity(subjectCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
-		}
+		const CNameMatcher nameMatcher(what, subjectCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+		const bool filterByAttributes = !attributeFilter.isEmpty();
 
-		for (const QString& pathToLookIn: where)
+		const bool contentsQueryHasWildcards = contentsToFind.contains(QRegExp("[*?]"));
+		const auto subjectCaseSensitivity = subjectCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+		QRegExp fileContentsRegExp;
+		if (contentsQueryHasWildcards)
 		{
-			scanDirectory(CFileSystemObject(pathToLookIn),
-				[&](const CFileSystemObject& item) {
-
-				++itemCounter;
-
-				const QString path = item.fullAbsolutePath();
-				_controller.execOnUiThread([this, path, what](){
-					for (const auto& listener: _listeners)
-						listener->itemScanned(path);
-				}, tag);
+			fileContentsRegExp.setPatternSyntax(QRegExp::Wildcard);
+			fileContentsRegExp.setPattern(contentsToFind);
+			fileContentsRegExp.setCaseSensitivity(subjectCaseSensitivity);
+		}
 
-				// contains() is faster than RegEx match (as of Qt 5.4.2)
-				if ((nameQueryHasWildcards && queryRegExp.exactMatch(path)) || (!nameQueryHasWildcards && path.contains(what, subjectCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive)))
+		// The files known not to contain the text are skipped without being read
+		std::optional<CContentIndexer::ContentFilter> contentFilter;
+		if (!contentsToFind.isEmpty() && _contentIndexer)
+			contentFilter.emplace(_contentIndexer->contentFilter(contentsToFind, contentsQueryHasWildcards));
+
+		// The matches are handed over to the UI thread in batches rather than one task per match.
+		// All the roots add to the same batch as their matches are found, so the results from the different roots are interleaved in the order of discovery.
+		std::mutex pendingMatchesMutex;
+		std::vector<CFileSystemObject> pendingMatches;
+		std::atomic<bool> matchesPending{false};
+		std::atomic<uint64_t> nextDeliveryTime{matchesBatchIntervalMs}; // As measured by 'timer'
+		// Must be called with 'pendingMatchesMutex' locked
+		const auto deliverPendingMatches = [&]() {
+			nextDeliveryTime = timer.elapsed() + matchesBatchIntervalMs;
+			matchesPending = false;
+			if (pendingMatches.empty())
+				return;
+
+			_executor([this, matches{std::move(pendingMatches)}](){
+				for (const auto& listener : _listeners)
 				{
-					QFile file(path);
-					if (!contentsToFind.isEmpty())
+					for (const CFileSystemObject& match : matches)
+						listener->matchFound(match);
+				}
+			}, -1);
+			pendingMatches.clear();
+		};
+
+		// Is checked for every item scanned rather than only when the next match is found, so that the matches keep streaming through the stretches without any
+		const auto deliverPendingMatchesIfDue = [&]() {
+			if (!matchesPending || timer.elapsed() < nextDeliveryTime)
+				return;
+
+			std::lock_guard<std::mutex> lock(pendingMatchesMutex);
+			deliverPendingMatches();
+		};
+
+		// QRegExp keeps the state of the last match, so every thread needs its own copy
+		const auto scanRoots = [&](const std::vector<QString>& roots) {
+			QRegExp contentsRegExp = fileContentsRegExp;
+			for (const QString& pathToLookIn: roots)
+			{
+				scanDirectory(CFileSystemObject(pathToLookIn),
+					[&](const CFileSystemObject& item) {
+
+					++itemCounter;
+					deliverPendingMatchesIfDue();
+
+					const QString path = item.fullAbsolutePath();
+					_executor([this, path, what](){
+						for (const auto& listener: _listeners)
+							listener->itemScanned(path);
+					}, tag);
+
+					// The metadata is already at hand, the name has to be matched, and the contents have to be read
+					if ((!filterByAttributes || attributeFilter.matches(item)) && nameMatcher.matches(item.fullName(), path))
 					{
-						if (!file.open(QFile::ReadOnly))
+						TRACE_SCOPE("Matching the file contents");
+
+						if (contentFilter && !contentFilter->mayContain(item))
 							return;
-					}
 
-					QTextStream stream(&file);
-					bool match = contentsToFind.isEmpty();
-					QRegExp fileContentsRegExp;
-					const bool contentsQueryHasWildcards = contentsToFind.contains(QRegExp("[*?]"));
-					const auto subjectCaseSensitivity = subjectCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
-					if (contentsQueryHasWildcards)
-					{
-						fileContentsRegExp.setPatternSyntax(QRegExp::Wildcard);
-						fileContentsRegExp.setPattern(contentsToFind);
-						fileContentsRegExp.setCaseSensitivity(subjectCaseSensitivity);
+						bool match = contentsToFind.isEmpty();
+						if (!match)
+						{
+							QFile file(path);
+							if (!file.open(QFile::ReadOnly))
+								return;
+
+							QTextStream stream(&file);
+							while (!match && !_workerThread.terminationFlag() && !stream.atEnd())
+							{
+								deliverPendingMatchesIfDue();
+								const QString line = stream.readLine();
+								// contains() is faster than RegEx match (as of Qt 5.4.2)
+								match = contentsQueryHasWildcards ? contentsRegExp.exactMatch(line) : line.contains(contentsToFind, subjectCaseSensitivity);
+							}
+						}
+
+						if (match)
+						{
+							// The item goes along so that the listeners don't have to query the file system for what's already known
+							std::lock_guard<std::mutex> lock(pendingMatchesMutex);
+							pendingMatches.push_back(item);
+							matchesPending = true;
+						}
 					}
+				}, _workerThread.terminationFlag(), true, pruningRules);
 
-					while (!match && !_workerThread.terminationFlag() && !stream.atEnd())
-					{
-						const QString line = stream.readLine();
-						// contains() is faster than RegEx match (as of Qt 5.4.2)
-						match = contentsQueryHasWildcards ? fileContentsRegExp.exactMatch(line) : line.contains(contentsToFind, subjectCaseSensitivity);
-					}
+				if (_workerThread.terminationFlag())
+					return;
+			}
+		};
 
-					if (match)
-					{
-						_controller.execOnUiThread([this, path, what](){
-						for (const auto& listener : _listeners)
-							listener->matchFound(path);
-						});
-					}
-				}
-			}, _workerThread.terminationFlag());
+		// Overlapping roots would report the same items twice. The roots on different devices are scanned concurrently,
+		// the ones on the same device share a thread so as not to make a spinning disk seek back and forth between them.
+		std::map<uint64_t, std::vector<QString>> rootsByDevice;
+		for (QString& root: independentScanRoots(where))
+		{
+			const uint64_t device = CPruningRules::deviceId(root);
+			rootsByDevice[device].push_back(std::move(root));
+		}
+
+		std::vector<std::thread> deviceThreads;
+		for (auto it = rootsByDevice.cbegin(); it != rootsByDevice.cend(); ++it)
+		{
+			// The last group is scanned on this thread
+			if (std::next(it) == rootsByDevice.cend())
+				scanRoots(it->second);
+			else
+			{
+				deviceThreads.emplace_back([&scanRoots, &roots = it->second](){
+					setThreadName("File search thread");
+					scanRoots(roots);
+				});
+			}
+		}
+
+		for (auto& thread: deviceThreads)
+			thread.join();
+
+		{
+			std::lock_guard<std::mutex> lock(pendingMatchesMutex);
+			deliverPendingMatches();
 		}
 
 		const uint32_t speed = timer.elapsed() > 0 ? static_cast<uint32_t>(itemCounter * 1000u / timer.elapsed()) : 0;
-		_controller.execOnUiThread([this, speed](){
+		_executor([this, speed](){
 			for (const auto& listener: _listeners)
 				listener->searchFinished(_workerThread.terminationFlag() ? SearchCancelled : SearchFinished, speed);
-		});
+		}, -1);
 	});
 }
 
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "threading/cinterruptablethread.h"
+#include "cattributefilter.h"
+#include "pruningrules/cpruningrules.h"
 
+class CContentIndexer;
 class CController;
+class CFileSystemObject;
 
 class QString;
 class QStringList;
 
+#include <functional>
 #include <set>
 
 class CController;
@@ -24,21 +29,31 @@ public:
 		virtual ~FileSearchListener() {}
 
 		virtual void itemScanned(const QString& currentItem) = 0;
-		virtual void matchFound(const QString& path) = 0;
+		virtual void matchFound(const CFileSystemObject& match) = 0;
 		virtual void searchFinished(SearchStatus status, uint32_t itemsPerSecond) = 0;
 	};
 
+	// Runs a listener notification. 'tag' marks the notifications that may be coalesced, -1 means none.
+	using NotificationExecutor = std::function<void (std::function<void ()> task, int tag)>;
+
+	// Notifies the listeners on the controller's UI thread and narrows the content search down with its content index
 	CFileSearchEngine(CController& controller);
+	// Doesn't need a controller. The notifications are passed to 'executor' from the search threads, and 'contentIndexer' may be nullptr.
+	CFileSearchEngine(NotificationExecutor executor, const CContentIndexer* contentIndexer);
 	void addListener(FileSearchListener* listener);
 	void removeListener(FileSearchListener* listener);
 
 
 	bool searchInProgress() const;
-	void search(const QString& what, bool subjectCaseSensitive, const QStringList& where, const QString& contentsToFind, bool contentsCaseSensitive);
+	// Only the items matching 'attributeFilter' are reported. The subtrees excluded by 'pruningRules' aren't entered.
+	// The folders in 'where' that are inside other ones are dropped; the ones on different devices are scanned in parallel.
+	void search(const QString& what, bool subjectCaseSensitive, const QStringList& where, const QString& contentsToFind, bool contentsCaseSensitive,
+		const AttributeFilter& attributeFilter = AttributeFilter{}, const CPruningRules& pruningRules = CPruningRules{});
 	void stopSearching();
 
 private:
-	CController& _controller;
+	const NotificationExecutor _executor;
+	const CContentIndexer* const _contentIndexer;
 
 	CInterruptableThread _workerThread;
 	std::set<FileSearchListener*> _listeners;
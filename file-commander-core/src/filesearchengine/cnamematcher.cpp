@@ -0,0 +1,370 @@
+#include "cnamematcher.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QStringList>
+RESTORE_COMPILER_WARNINGS
+
+#include <string.h>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define NAME_MATCHER_SSE2
+#include <emmintrin.h>
+#endif
+
+static inline QChar foldedIf(QChar c, bool caseInsensitive)
+{
+	return caseInsensitive ? c.toCaseFolded() : c;
+}
+
+// Matches 'c' against the [...] set starting at 'pattern[start]'. Sets 'end' to the index of the closing bracket, or to -1 if there's none.
+static bool matchSet(QStringView pattern, qsizetype start, QChar c, qsizetype& end)
+{
+	qsizetype i = start + 1;
+	const bool negated = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+	if (negated)
+		++i;
+
+	bool match = false;
+	for (bool first = true; i < pattern.size(); first = false)
+	{
+		// A ']' right after the opening bracket is a part of the set
+		if (pattern[i] == ']' && !first)
+		{
+			end = i;
+			return match != negated;
+		}
+
+		if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']')
+		{
+			match = match || (c >= pattern[i] && c <= pattern[i + 2]);
+			i += 3;
+		}
+		else
+		{
+			match = match || c == pattern[i];
+			++i;
+		}
+	}
+
+	end = -1;
+	return false;
+}
+
+// Same syntax as QRegExp::Wildcard: '*', '?' and [...] sets. The pattern is expected to be case-folded already for the case-insensitive matching.
+static bool globMatch(QStringView pattern, QStringView text, bool caseInsensitive)
+{
+	static constexpr qsizetype None = -1;
+
+	qsizetype p = 0, t = 0, starP = None, starT = 0;
+	while (t < text.size())
+	{
+		if (p < pattern.size())
+		{
+			const QChar pc = pattern[p];
+			const QChar tc = foldedIf(text[t], caseInsensitive);
+			if (pc == '*')
+			{
+				starP = p++;
+				starT = t;
+				continue;
+			}
+			else if (pc == '?')
+			{
+				++p;
+				++t;
+				continue;
+			}
+			else if (pc == '[')
+			{
+				qsizetype end = None;
+				const bool setMatch = matchSet(pattern, p, tc, end);
+				if (end == None ? tc == pc : setMatch)
+				{
+					p = end == None ? p + 1 : end + 1;
+					++t;
+					continue;
+				}
+			}
+			else if (pc == tc)
+			{
+				++p;
+				++t;
+				continue;
+			}
+		}
+
+		// Mismatch: letting the last '*' consume one more character
+		if (starP == None)
+			return false;
+
+		p = starP + 1;
+		t = ++starT;
+	}
+
+	while (p < pattern.size() && pattern[p] == '*')
+		++p;
+
+	return p == pattern.size();
+}
+
+CNameMatcher::Literal::Literal(QString literalText, bool caseInsensitive) : text{std::move(literalText)}
+{
+	if (text.isEmpty())
+		return;
+
+	const QChar first = text.front(), last = text.back();
+	firstVariants[0] = first;
+	lastVariants[0] = last;
+	firstVariants[1] = caseInsensitive ? first.toUpper() : first;
+	lastVariants[1] = caseInsensitive ? last.toUpper() : last;
+}
+
+bool CNameMatcher::Literal::foundIn(QStringView haystack, bool caseInsensitive) const
+{
+	const qsizetype n = text.size();
+	if (n == 0)
+		return true;
+	else if (haystack.size() < n)
+		return false;
+
+	const QChar* h = haystack.data();
+	const auto matchesAt = [&](qsizetype pos) {
+		if (!caseInsensitive)
+			return ::memcmp(h + pos, text.constData(), static_cast<size_t>(n) * sizeof(QChar)) == 0;
+
+		for (qsizetype k = 0; k < n; ++k)
+		{
+			if (h[pos + k].toCaseFolded() != text[k])
+				return false;
+		}
+
+		return true;
+	};
+
+	// The candidate positions are the ones where both the first and the last character of the literal match.
+	// The non-ASCII characters are always candidates for the case-insensitive search since some of them fold into ASCII letters (e. g. the Kelvin sign).
+	const qsizetype lastPosition = haystack.size() - n;
+	qsizetype pos = 0;
+
+#ifdef NAME_MATCHER_SSE2
+	const __m128i first0 = _mm_set1_epi16(static_cast<short>(firstVariants[0].unicode()));
+	const __m128i first1 = _mm_set1_epi16(static_cast<short>(firstVariants[1].unicode()));
+	const __m128i last0 = _mm_set1_epi16(static_cast<short>(lastVariants[0].unicode()));
+	const __m128i last1 = _mm_set1_epi16(static_cast<short>(lastVariants[1].unicode()));
+	const __m128i asciiMax = _mm_set1_epi16(0x7F);
+	const __m128i zero = _mm_setzero_si128();
+
+	const auto candidates = [&](const QChar* block, __m128i variant0, __m128i variant1) {
+		const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+		__m128i result = _mm_or_si128(_mm_cmpeq_epi16(chars, variant0), _mm_cmpeq_epi16(chars, variant1));
+		if (caseInsensitive)
+		{
+			const __m128i isAscii = _mm_cmpeq_epi16(_mm_subs_epu16(chars, asciiMax), zero);
+			result = _mm_or_si128(result, _mm_andnot_si128(isAscii, _mm_cmpeq_epi16(zero, zero)));
+		}
+
+		return result;
+	};
+
+	for (; pos + 7 <= lastPosition; pos += 8)
+	{
+		const __m128i both = _mm_and_si128(candidates(h + pos, first0, first1), candidates(h + pos + n - 1, last0, last1));
+		const auto mask = static_cast<unsigned>(_mm_movemask_epi8(both));
+		if (mask == 0)
+			continue;
+
+		for (int bit = 0; bit < 16; bit += 2)
+		{
+			if ((mask & (1u << bit)) != 0 && matchesAt(pos + bit / 2))
+				return true;
+		}
+	}
+#endif
+
+	const auto isCandidate = [&](QChar c, const QChar (&variants)[2]) {
+		return c == variants[0] || c == variants[1] || (caseInsensitive && c.unicode() > 0x7F);
+	};
+
+	for (; pos <= lastPosition; ++pos)
+	{
+		if (isCandidate(h[pos], firstVariants) && isCandidate(h[pos + n - 1], lastVariants) && matchesAt(pos))
+			return true;
+	}
+
+	return false;
+}
+
+CNameMatcher::CNameMatcher(const QString& query, Qt::CaseSensitivity caseSensitivity) :
+	_caseInsensitive{caseSensitivity == Qt::CaseInsensitive}
+{
+	for (const QString& item : query.split(';', Qt::SkipEmptyParts))
+	{
+		const QString pattern = item.trimmed();
+		if (pattern.isEmpty() || pattern == QLatin1String("!"))
+			continue;
+
+		_patterns.push_back(compile(pattern, _caseInsensitive));
+		if (!_patterns.back().negated)
+			_hasInclusionPatterns = true;
+	}
+}
+
+bool CNameMatcher::isValid() const
+{
+	return !_patterns.empty();
+}
+
+bool CNameMatcher::matches(QStringView name, QStringView fullPath) const
+{
+	bool included = !_hasInclusionPatterns;
+	for (const Pattern& pattern : _patterns)
+	{
+		if (pattern.negated)
+		{
+			if (matches(pattern, name, fullPath))
+				return false;
+		}
+		else if (!included)
+			included = matches(pattern, name, fullPath);
+	}
+
+	return included;
+}
+
+CNameMatcher::Pattern CNameMatcher::compile(QString pattern, bool caseInsensitive)
+{
+	Pattern result;
+	if (pattern.startsWith('!'))
+	{
+		result.negated = true;
+		pattern.remove(0, 1);
+	}
+
+	result.matchFullPath = pattern.contains('/');
+	if (caseInsensitive)
+		pattern = pattern.toCaseFolded();
+
+	const bool hasWildcards = pattern.contains('*') || pattern.contains('?') || pattern.contains('[');
+	if (!hasWildcards)
+	{
+		result.kind = Pattern::Contains;
+		result.literal = Literal(pattern, caseInsensitive);
+		return result;
+	}
+
+	// Only '*'s: most of such patterns reduce to plain comparisons
+	if (!pattern.contains('?') && !pattern.contains('['))
+	{
+		const bool leadingStar = pattern.startsWith('*'), trailingStar = pattern.endsWith('*');
+		const QString inner = pattern.mid(leadingStar ? 1 : 0, pattern.size() - (leadingStar ? 1 : 0) - (trailingStar ? 1 : 0));
+
+		if (inner.isEmpty() || inner.count('*') == inner.size())
+		{
+			result.kind = Pattern::Anything;
+			return result;
+		}
+		else if (!inner.contains('*'))
+		{
+			if (leadingStar && trailingStar)
+			{
+				result.kind = Pattern::Contains;
+				result.literal = Literal(inner, caseInsensitive);
+			}
+			else if (leadingStar)
+			{
+				result.kind = Pattern::Suffix;
+				result.suffix = inner;
+			}
+			else if (trailingStar)
+			{
+				result.kind = Pattern::Prefix;
+				result.prefix = inner;
+			}
+			else
+			{
+				result.kind = Pattern::Exact;
+				result.literal = Literal(inner, caseInsensitive);
+			}
+
+			return result;
+		}
+		else if (!leadingStar && !trailingStar && inner.count('*') == 1)
+		{
+			result.kind = Pattern::PrefixSuffix;
+			result.prefix = inner.left(inner.indexOf('*'));
+			result.suffix = inner.mid(inner.indexOf('*') + 1);
+			return result;
+		}
+	}
+
+	// The general glob. The literal runs are collected for the quick rejection of the names that can't match.
+	result.kind = Pattern::Glob;
+	result.glob = pattern;
+
+	QString longestRun, currentRun;
+	bool atStart = true;
+	for (int i = 0; i < pattern.size(); ++i)
+	{
+		const QChar c = pattern[i];
+		if (c == '*' || c == '?' || c == '[')
+		{
+			if (atStart)
+				result.prefix = currentRun;
+			atStart = false;
+
+			if (currentRun.size() > longestRun.size())
+				longestRun = currentRun;
+			currentRun.clear();
+
+			if (c == '[')
+			{
+				qsizetype end = -1;
+				matchSet(pattern, i, QChar(), end);
+				if (end < 0)
+					currentRun.append(c); // Not a set, just a bracket
+				else
+					i = static_cast<int>(end);
+			}
+		}
+		else
+			currentRun.append(c);
+	}
+
+	result.suffix = currentRun;
+	if (currentRun.size() > longestRun.size())
+		longestRun = currentRun;
+
+	result.literal = Literal(longestRun, caseInsensitive);
+	return result;
+}
+
+bool CNameMatcher::matches(const Pattern& pattern, QStringView name, QStringView fullPath) const
+{
+	QStringView subject = pattern.matchFullPath ? fullPath : name;
+	if (pattern.matchFullPath && subject.size() > 1 && subject.endsWith('/'))
+		subject = subject.chopped(1); // Folders have a trailing slash
+
+	const auto cs = _caseInsensitive ? Qt::CaseInsensitive : Qt::CaseSensitive;
+	switch (pattern.kind)
+	{
+	case Pattern::Anything:
+		return true;
+	case Pattern::Contains:
+		return pattern.literal.foundIn(subject, _caseInsensitive);
+	case Pattern::Exact:
+		return subject.size() == pattern.literal.text.size() && subject.startsWith(pattern.literal.text, cs);
+	case Pattern::Prefix:
+		return subject.startsWith(pattern.prefix, cs);
+	case Pattern::Suffix:
+		return subject.endsWith(pattern.suffix, cs);
+	case Pattern::PrefixSuffix:
+		return subject.size() >= pattern.prefix.size() + pattern.suffix.size() && subject.startsWith(pattern.prefix, cs) && subject.endsWith(pattern.suffix, cs);
+	case Pattern::Glob:
+		if (!subject.startsWith(pattern.prefix, cs) || !subject.endsWith(pattern.suffix, cs) || !pattern.literal.foundIn(subject, _caseInsensitive))
+			return false;
+
+		return globMatch(pattern.glob, subject, _caseInsensitive);
+	}
+
+	return false;
+}
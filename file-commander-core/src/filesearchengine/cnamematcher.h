@@ -0,0 +1,63 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+#include <QStringView>
+RESTORE_COMPILER_WARNINGS
+
+#include <vector>
+
+// Matches the file names against a search query compiled once, before the scan.
+// The query is one or more patterns separated by ';'. A pattern starting with '!' excludes the items it matches.
+// A pattern without the wildcards ('*', '?' and [...] sets) matches any name containing it; a pattern with wildcards has to match the whole name.
+// The patterns are matched against the item's name, unless they contain a '/', in which case they're matched against the full path.
+// The common forms - "*.ext", "prefix*", "prefix*suffix", "*text*" - are reduced to plain string comparisons; the general globs are only evaluated
+// for the names that contain the longest literal fragment of the pattern.
+class CNameMatcher
+{
+public:
+	CNameMatcher(const QString& query, Qt::CaseSensitivity caseSensitivity);
+
+	// False if the query has no patterns
+	bool isValid() const;
+	// 'fullPath' is only looked at if there are path patterns
+	bool matches(QStringView name, QStringView fullPath) const;
+
+private:
+	// A literal fragment to search for, with the quick rejection by its first and last characters
+	struct Literal
+	{
+		QString text; // Case-folded for the case-insensitive matching
+		QChar firstVariants[2];
+		QChar lastVariants[2];
+
+		Literal() = default;
+		Literal(QString literalText, bool caseInsensitive);
+
+		bool foundIn(QStringView haystack, bool caseInsensitive) const;
+	};
+
+	struct Pattern
+	{
+		enum Kind {Anything, Contains, Exact, Prefix, Suffix, PrefixSuffix, Glob};
+
+		Kind kind = Anything;
+		bool negated = false;
+		bool matchFullPath = false;
+
+		QString prefix;
+		QString suffix;
+		Literal literal; // The text for Contains and Exact, the longest literal fragment for Glob
+		QString glob;
+	};
+
+	static Pattern compile(QString pattern, bool caseInsensitive);
+	bool matches(const Pattern& pattern, QStringView name, QStringView fullPath) const;
+
+private:
+	std::vector<Pattern> _patterns;
+	bool _caseInsensitive;
+	bool _hasInclusionPatterns = false;
+};
@@ -14,9 +14,23 @@ RESTORE_COMPILER_WARNINGS
 #include <Windows.h>
 #else
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <unistd.h> // access()
 #endif
 
+#if defined __linux__
+#include <sys/vfs.h>
+#elif defined __APPLE__ || defined __FreeBSD__
+#include <sys/param.h>
+#include <sys/mount.h>
+#endif
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+
 // If the command exists, returns its path: either the argument as is if exists (absolute, or in the working dir),
 // or based on the PATH env var.
 // Returns empty string if the command's location cannot be found.
@@ -105,3 +119,68 @@ bool FileSystemHelpers::pathIsAccessible(QString path)
 	//return true;
 #endif
 }
+
+FileSystemHelpers::MountLatencyEstimate FileSystemHelpers::updateMountLatencyEstimate(uint64_t mountId, double latencyMs)
+{
+	static std::mutex mutex;
+	static std::map<uint64_t, MountLatencyEstimate> estimateByMount;
+
+	std::lock_guard<std::mutex> locker(mutex);
+	MountLatencyEstimate& estimate = estimateByMount[mountId];
+	if (estimate.numSamples == 0)
+		estimate.latencyMs = latencyMs;
+	else
+		estimate.latencyMs += 0.25 * (latencyMs - estimate.latencyMs);
+
+	if (estimate.numSamples < UINT32_MAX)
+		++estimate.numSamples;
+
+	return estimate;
+}
+
+bool FileSystemHelpers::isHighLatencyLocation(const QString& path)
+{
+#ifdef _WIN32
+	(void)path;
+	return false;
+#else
+	const QByteArray nativePath = QFile::encodeName(path);
+
+	struct statfs fsInfo;
+	if (::statfs(nativePath.constData(), &fsInfo) == 0)
+	{
+#ifdef __linux__
+		switch (static_cast<uint32_t>(fsInfo.f_type))
+		{
+		case 0x6969: // NFS
+		case 0x517B: // SMB
+		case 0xFF534D42: // CIFS
+		case 0xFE534D42: // SMB2
+		case 0x65735546: // FUSE (sshfs and the like)
+		case 0x5346414F: // AFS
+		case 0x00C36400: // Ceph
+		case 0x01021997: // 9P
+			return true;
+		default:
+			break;
+		}
+#else
+		if ((fsInfo.f_flags & MNT_LOCAL) == 0 || ::strstr(fsInfo.f_fstypename, "fuse") != nullptr)
+			return true;
+#endif
+	}
+
+	// Whatever the file system, if stat() on the mount is slow, so is stat() of every item in the folder.
+	// A single slow call may be a cold cache or a busy moment, so the decision is based on the smoothed estimate, which the file system watcher keeps feeding too.
+	static constexpr double HighStatLatencyMs = 2.0;
+	static constexpr uint32_t MinLatencySamples = 4;
+
+	struct stat st;
+	const auto start = std::chrono::steady_clock::now();
+	if (::stat(nativePath.constData(), &st) != 0)
+		return false;
+
+	const auto estimate = updateMountLatencyEstimate(static_cast<uint64_t>(st.st_dev), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	return estimate.numSamples >= MinLatencySamples && estimate.latencyMs >= HighStatLatencyMs;
+#endif
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 class QString;
 
 namespace FileSystemHelpers
@@ -15,4 +17,17 @@ namespace FileSystemHelpers
 
 	bool pathIsAccessible(QString path);
 
+	struct MountLatencyEstimate {
+		double latencyMs = 0.0;
+		uint32_t numSamples = 0;
+	};
+
+	// Adds a sample to the stat() latency of the mount, exponentially smoothed. Shared by everything that measures it,
+	// so that e. g. both panels looking at the same share agree on how slow it is. 'mountId' is st_dev on Unix.
+	MountLatencyEstimate updateMountLatencyEstimate(uint64_t mountId, double latencyMs);
+
+	// True for the network and FUSE file systems, and for the mounts where stat() has been consistently slow: querying the items of such a folder one by one is dominated by the round trip latency.
+	// Always false on Windows where listing a folder already returns the metadata of its items.
+	bool isHighLatencyLocation(const QString& path);
+
 } // namespace
@@ -1,13 +1,22 @@
 #include "cfilesystemwatcher.h"
 #include "assert/advanced_assert.h"
 #include "container/set_operations.hpp"
+#include "filesystemhelpers/filesystemhelpers.hpp"
 #include "system/ctimeelapsed.h"
+#include "tracing/ctracer.h"
 
 DISABLE_COMPILER_WARNINGS
 #include <QDebug>
 #include <QDir>
+#include <QHash>
 RESTORE_COMPILER_WARNINGS
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+
 void detail::CFileSystemWatcherInterface::addCallback(ChangeDetectedCallback callback)
 {
 	_callbacks.push_back(callback);
@@ -53,12 +62,118 @@ void detail::CFileSystemWatcherInterface::processChangesAndNotifySubscribers(con
 	}
 }
 
+bool detail::CFileSystemWatcherInterface::checkDetailsOfSomeItems(size_t maxItems)
+{
+	const size_t numItemsToCheck = std::min(maxItems, _previousState.size());
+	auto item = _lastCheckedItemPath.isEmpty() ? _previousState.begin() : _previousState.upper_bound(QFileInfo(_lastCheckedItemPath));
+
+	transparent_set<QFileInfo> changedItems;
+	for (size_t i = 0; i < numItemsToCheck; ++i, ++item)
+	{
+		if (item == _previousState.end())
+			item = _previousState.begin();
+
+		// exists(), size() and lastModified() are all answered by the same stat() call
+		const QFileInfo currentInfo(item->fullPath);
+		if (!currentInfo.exists())
+		{
+			_lastCheckedItemPath.clear();
+			return false;
+		}
+
+		_lastCheckedItemPath = item->fullPath;
+		if (item->fileDetailsChanged(currentInfo))
+			changedItems.insert(currentInfo);
+	}
+
+	if (changedItems.empty())
+		return true;
+
+	for (const auto& changedItem : changedItems)
+	{
+		const auto oldItem = container_aware_find(_previousState, changedItem);
+		assert_debug_only(oldItem != _previousState.end());
+		_previousState.erase(oldItem);
+		_previousState.insert(BasicFileSystemItemInfo(changedItem));
+	}
+
+	for (const auto& callback : _callbacks)
+		callback(transparent_set<QFileInfo>(), transparent_set<QFileInfo>(), changedItems);
+
+	return true;
+}
+
+
+
+static constexpr int ForegroundPollingPeriodMs = 333;
+static constexpr int BackgroundPollingPeriodMs = 2000;
+// The polling period grows with the latency of the mount so that the polling keeps the mount busy for no more than ~0.5% of the time
+static constexpr int LatencyToPollingPeriodFactor = 200;
+static constexpr int MaxPollingPeriodMs = 10000;
+// The mounts slower than this get fewer per-file checks per tick
+static constexpr double HighLatencyThresholdMs = 1.0;
+static constexpr size_t DetailChecksPerTick = 64;
+static constexpr size_t DetailChecksPerTickOnHighLatencyMount = 8;
+static constexpr auto StampSettlingTime = std::chrono::seconds(2);
+
+#ifdef _WIN32
+// The drive ("C:") or the share ("//server/share") the path belongs to
+static uint64_t mountIdForPath(const QString& path)
+{
+	const QString cleanPath = QDir::fromNativeSeparators(path);
+	if (!cleanPath.startsWith(QLatin1String("//")))
+		return qHash(cleanPath.left(2).toUpper());
+
+	const int serverEnd = cleanPath.indexOf('/', 2);
+	const int shareEnd = serverEnd < 0 ? -1 : cleanPath.indexOf('/', serverEnd + 1);
+	return qHash(cleanPath.left(shareEnd).toLower());
+}
+#endif
+
+bool CFileSystemWatcher::DirectoryStamp::operator==(const DirectoryStamp& other) const
+{
+	return valid == other.valid && modificationTimeNs == other.modificationTimeNs && statusChangeTimeNs == other.statusChangeTimeNs
+		&& linkCount == other.linkCount && inode == other.inode && deviceId == other.deviceId;
+}
+
+CFileSystemWatcher::DirectoryStamp CFileSystemWatcher::directoryStamp(const QString& path)
+{
+	DirectoryStamp stamp;
+
+#ifndef _WIN32
+	struct stat st;
+	if (::stat(QFile::encodeName(path).constData(), &st) != 0)
+		return stamp;
+
+#ifdef __APPLE__
+	stamp.modificationTimeNs = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+	stamp.statusChangeTimeNs = static_cast<int64_t>(st.st_ctimespec.tv_sec) * 1000000000 + st.st_ctimespec.tv_nsec;
+#else
+	stamp.modificationTimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+	stamp.statusChangeTimeNs = static_cast<int64_t>(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+#endif
+	stamp.linkCount = static_cast<uint64_t>(st.st_nlink);
+	stamp.inode = static_cast<uint64_t>(st.st_ino);
+	stamp.deviceId = static_cast<uint64_t>(st.st_dev);
+#else
+	// No link count or inode here, but the folder's modification time changes when an item is added, removed or renamed
+	const QFileInfo info(path);
+	if (!info.exists())
+		return stamp;
+
+	stamp.modificationTimeNs = info.lastModified().toMSecsSinceEpoch() * 1000000;
+	stamp.statusChangeTimeNs = info.metadataChangeTime().toMSecsSinceEpoch() * 1000000;
+	stamp.deviceId = mountIdForPath(path);
+#endif
 
+	stamp.valid = true;
+	return stamp;
+}
 
-CFileSystemWatcher::CFileSystemWatcher()
+CFileSystemWatcher::CFileSystemWatcher() : _detailChecksPerTick{DetailChecksPerTick}
 {
-	QObject::connect(&_timer, &QTimer::timeout, [this]() {onCheckForChanges();});
-	_timer.start(333);
+	QObject::connect(&_timer, &QTimer::timeout, [this]() {checkForChanges();});
+	_timer.start(ForegroundPollingPeriodMs);
 }
 
 bool CFileSystemWatcher::setPathToWatch(const QString& path)
@@ -71,15 +186,91 @@ bool CFileSystemWatcher::setPathToWatch(const QString& path)
 	return true;
 }
 
-void CFileSystemWatcher::onCheckForChanges()
+void CFileSystemWatcher::setActivityState(ActivityState state)
+{
+	if (state == _activityState)
+		return;
+
+	_activityState = state;
+
+	switch (state)
+	{
+	case ActivityState::Foreground:
+		_timer.start(basePollingPeriodMs());
+		checkForChanges();
+		break;
+	case ActivityState::Background:
+		_timer.start(basePollingPeriodMs());
+		break;
+	case ActivityState::Suspended:
+		_timer.stop();
+		break;
+	}
+}
+
+void CFileSystemWatcher::checkForChanges()
 {
+	TRACE_SCOPE("CFileSystemWatcher::checkForChanges");
+
+	QString path;
 	{
 		std::lock_guard<std::recursive_mutex> locker(_pathMutex);
 		if (_pathToWatch.isEmpty())
 			return;
+
+		path = _pathToWatch;
+	}
+
+	const auto statStartTime = std::chrono::steady_clock::now();
+	const DirectoryStamp stamp = directoryStamp(path);
+	const auto now = std::chrono::steady_clock::now();
+
+	bool listingRequired = true;
+	if (!stamp.valid || path != _stampedPath || stamp != _stamp)
+	{
+		_stampedPath = path;
+		_stamp = stamp;
+		_stampChangeTime = now;
+	}
+	else if (now - _stampChangeTime >= StampSettlingTime)
+	{
+		// Nothing has been added, removed or renamed; a few of the files are checked for in-place modifications on every tick
+		TRACE_SCOPE("CFileSystemWatcher::checkDetailsOfSomeItems");
+		listingRequired = !checkDetailsOfSomeItems(_detailChecksPerTick);
 	}
 
-	QDir directory(_pathToWatch);
-	const auto state = directory.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
-	processChangesAndNotifySubscribers(state);
+	if (listingRequired)
+	{
+		QDir directory(path);
+		const auto state = directory.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+		processChangesAndNotifySubscribers(state);
+	}
+
+	if (stamp.valid)
+		updatePollingPeriod(stamp.deviceId, now - statStartTime);
+}
+
+void CFileSystemWatcher::updatePollingPeriod(uint64_t mountId, std::chrono::steady_clock::duration statLatency)
+{
+	const double latencyMs = FileSystemHelpers::updateMountLatencyEstimate(mountId, std::chrono::duration<double, std::milli>(statLatency).count()).latencyMs;
+	_detailChecksPerTick = latencyMs < HighLatencyThresholdMs ? DetailChecksPerTick : DetailChecksPerTickOnHighLatencyMount;
+
+	const int periodMs = std::clamp(static_cast<int>(latencyMs * LatencyToPollingPeriodFactor), basePollingPeriodMs(), std::max(MaxPollingPeriodMs, basePollingPeriodMs()));
+	if (_timer.isActive() && _timer.interval() != periodMs)
+		_timer.setInterval(periodMs);
+}
+
+int CFileSystemWatcher::pollingPeriodMs() const
+{
+	return _timer.isActive() ? _timer.interval() : 0;
+}
+
+size_t CFileSystemWatcher::detailChecksPerTick() const
+{
+	return _detailChecksPerTick;
+}
+
+int CFileSystemWatcher::basePollingPeriodMs() const
+{
+	return _activityState == ActivityState::Background ? BackgroundPollingPeriodMs : ForegroundPollingPeriodMs;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "activitystate.h"
 #include "compiler/compiler_warnings_control.h"
 #include "container/std_container_helpers.hpp"
 
@@ -9,6 +10,7 @@ DISABLE_COMPILER_WARNINGS
 #include <QTimer>
 RESTORE_COMPILER_WARNINGS
 
+#include <chrono>
 #include <functional>
 #include <mutex>
 #include <set>
@@ -60,6 +62,9 @@ public:
 
 protected:
 	void processChangesAndNotifySubscribers(const QFileInfoList& newState);
+	// Re-reads the size and the modification time of up to 'maxItems' known items, continuing where the previous call stopped, and notifies of the ones that have changed.
+	// Returns false if one of the items no longer exists, meaning the folder has to be listed again.
+	bool checkDetailsOfSomeItems(size_t maxItems);
 
 protected:
 	std::recursive_mutex _pathMutex;
@@ -68,6 +73,8 @@ protected:
 private:
 	std::vector<ChangeDetectedCallback> _callbacks;
 	transparent_set<BasicFileSystemItemInfo> _previousState;
+	// The last item checked by checkDetailsOfSomeItems()
+	QString _lastCheckedItemPath;
 };
 
 }
@@ -84,9 +91,48 @@ public:
 
 	bool setPathToWatch(const QString &path) override;
 
+	// Polls less often in the background and not at all when suspended.
+	// Back in the foreground, checks for changes right away - which costs a single stat() if the folder hasn't changed.
+	void setActivityState(ActivityState state);
+
+	// Called by the timer on every tick; can also be called directly to poll right away
+	void checkForChanges();
+
+	// 0 when not polling
+	int pollingPeriodMs() const;
+	size_t detailChecksPerTick() const;
+
 private:
-	void onCheckForChanges();
+	// What a stat() of the folder says. Adding, removing or renaming an item changes the modification time or the status change time of the folder,
+	// and creating or removing a subfolder also changes its link count, so the folder only has to be listed when the stamp differs.
+	struct DirectoryStamp
+	{
+		int64_t modificationTimeNs = 0;
+		int64_t statusChangeTimeNs = 0;
+		uint64_t linkCount = 0;
+		uint64_t inode = 0;
+		uint64_t deviceId = 0;
+		bool valid = false;
+
+		bool operator==(const DirectoryStamp& other) const;
+		bool operator!=(const DirectoryStamp& other) const { return !(*this == other); }
+	};
+
+	static DirectoryStamp directoryStamp(const QString& path);
+
+	void updatePollingPeriod(uint64_t mountId, std::chrono::steady_clock::duration statLatency);
+	int basePollingPeriodMs() const;
 
 private:
 	QTimer _timer;
+
+	ActivityState _activityState = ActivityState::Foreground;
+
+	QString _stampedPath;
+	DirectoryStamp _stamp;
+	// When the stamp last changed. The time stamps of some file systems are as coarse as 2 seconds, so a second change made
+	// shortly after the first one may leave the stamp as it was; the folder keeps being listed until the stamp has settled.
+	std::chrono::steady_clock::time_point _stampChangeTime;
+
+	size_t _detailChecksPerTick;
 };
@@ -0,0 +1,293 @@
+#include "cblake3hasher.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace {
+
+constexpr uint32_t IV[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+constexpr size_t MessagePermutation[16] = {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8};
+
+enum Flags : uint32_t {
+	ChunkStart = 1 << 0,
+	ChunkEnd = 1 << 1,
+	Parent = 1 << 2,
+	Root = 1 << 3
+};
+
+constexpr size_t BlockLength = 64;
+
+inline uint32_t rotr(uint32_t x, int n) noexcept
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+#define BLAKE3_G(a, b, c, d, mx, my) \
+	a = a + b + (mx); d = rotr(d ^ a, 16); c = c + d; b = rotr(b ^ c, 12); \
+	a = a + b + (my); d = rotr(d ^ a, 8); c = c + d; b = rotr(b ^ c, 7)
+
+// The message words used by each of the 7 rounds, i.e. MessagePermutation applied 0..6 times
+struct MessageSchedule {
+	size_t indices[7][16];
+};
+
+constexpr MessageSchedule makeMessageSchedule() noexcept
+{
+	MessageSchedule schedule {};
+	for (size_t i = 0; i < 16; ++i)
+		schedule.indices[0][i] = i;
+
+	for (size_t r = 1; r < 7; ++r)
+		for (size_t i = 0; i < 16; ++i)
+			schedule.indices[r][i] = schedule.indices[r - 1][MessagePermutation[i]];
+
+	return schedule;
+}
+
+constexpr MessageSchedule Schedule = makeMessageSchedule();
+
+void compress(const uint32_t* cv, const uint32_t* m, uint64_t counter, uint32_t blockLength, uint32_t flags, uint32_t* out) noexcept
+{
+	// Keeping the state in separate local variables lets the compiler hold all of it in registers
+	uint32_t s0 = cv[0], s1 = cv[1], s2 = cv[2], s3 = cv[3], s4 = cv[4], s5 = cv[5], s6 = cv[6], s7 = cv[7];
+	uint32_t s8 = IV[0], s9 = IV[1], s10 = IV[2], s11 = IV[3];
+	uint32_t s12 = static_cast<uint32_t>(counter), s13 = static_cast<uint32_t>(counter >> 32), s14 = blockLength, s15 = flags;
+
+#define BLAKE3_ROUND(r) \
+	BLAKE3_G(s0, s4, s8, s12, m[Schedule.indices[r][0]], m[Schedule.indices[r][1]]); \
+	BLAKE3_G(s1, s5, s9, s13, m[Schedule.indices[r][2]], m[Schedule.indices[r][3]]); \
+	BLAKE3_G(s2, s6, s10, s14, m[Schedule.indices[r][4]], m[Schedule.indices[r][5]]); \
+	BLAKE3_G(s3, s7, s11, s15, m[Schedule.indices[r][6]], m[Schedule.indices[r][7]]); \
+	BLAKE3_G(s0, s5, s10, s15, m[Schedule.indices[r][8]], m[Schedule.indices[r][9]]); \
+	BLAKE3_G(s1, s6, s11, s12, m[Schedule.indices[r][10]], m[Schedule.indices[r][11]]); \
+	BLAKE3_G(s2, s7, s8, s13, m[Schedule.indices[r][12]], m[Schedule.indices[r][13]]); \
+	BLAKE3_G(s3, s4, s9, s14, m[Schedule.indices[r][14]], m[Schedule.indices[r][15]])
+
+	// Columns first, then diagonals; the message word indices are compile-time constants
+	BLAKE3_ROUND(0);
+	BLAKE3_ROUND(1);
+	BLAKE3_ROUND(2);
+	BLAKE3_ROUND(3);
+	BLAKE3_ROUND(4);
+	BLAKE3_ROUND(5);
+	BLAKE3_ROUND(6);
+
+#undef BLAKE3_ROUND
+
+	out[0] = s0 ^ s8; out[1] = s1 ^ s9; out[2] = s2 ^ s10; out[3] = s3 ^ s11;
+	out[4] = s4 ^ s12; out[5] = s5 ^ s13; out[6] = s6 ^ s14; out[7] = s7 ^ s15;
+	out[8] = s8 ^ cv[0]; out[9] = s9 ^ cv[1]; out[10] = s10 ^ cv[2]; out[11] = s11 ^ cv[3];
+	out[12] = s12 ^ cv[4]; out[13] = s13 ^ cv[5]; out[14] = s14 ^ cv[6]; out[15] = s15 ^ cv[7];
+}
+
+#undef BLAKE3_G
+
+inline void wordsFromLittleEndianBytes(const uint8_t* bytes, size_t numBytes, uint32_t* words) noexcept
+{
+	for (size_t i = 0; i < numBytes / 4; ++i)
+		words[i] = uint32_t(bytes[4 * i]) | (uint32_t(bytes[4 * i + 1]) << 8) | (uint32_t(bytes[4 * i + 2]) << 16) | (uint32_t(bytes[4 * i + 3]) << 24);
+}
+
+inline CBlake3Hasher::ChainingValue ivChainingValue() noexcept
+{
+	CBlake3Hasher::ChainingValue cv;
+	std::copy(std::begin(IV), std::end(IV), cv.begin());
+	return cv;
+}
+
+} // namespace
+
+CBlake3Hasher::ChunkState::ChunkState(uint64_t counter) noexcept :
+	cv(ivChainingValue()),
+	chunkCounter(counter)
+{
+	::memset(block, 0, sizeof(block));
+}
+
+inline size_t CBlake3Hasher::ChunkState::length() const noexcept
+{
+	return BlockLength * blocksCompressed + blockLength;
+}
+
+inline uint32_t CBlake3Hasher::ChunkState::startFlag() const noexcept
+{
+	return blocksCompressed == 0 ? static_cast<uint32_t>(ChunkStart) : 0u;
+}
+
+void CBlake3Hasher::ChunkState::update(const uint8_t* data, size_t length) noexcept
+{
+	while (length > 0)
+	{
+		// Compressing whole blocks straight from the input, but never the last one as it needs the ChunkEnd flag
+		if (blockLength == 0 && length > BlockLength)
+		{
+			uint32_t blockWords[16];
+			wordsFromLittleEndianBytes(data, BlockLength, blockWords);
+			uint32_t out[16];
+			compress(cv.data(), blockWords, chunkCounter, BlockLength, startFlag(), out);
+			std::copy(out, out + 8, cv.begin());
+			++blocksCompressed;
+			data += BlockLength;
+			length -= BlockLength;
+			continue;
+		}
+
+		// Only compressing a full block once more input arrives, because the last block of the chunk needs the ChunkEnd flag
+		if (blockLength == BlockLength)
+		{
+			uint32_t blockWords[16];
+			wordsFromLittleEndianBytes(block, BlockLength, blockWords);
+			uint32_t out[16];
+			compress(cv.data(), blockWords, chunkCounter, BlockLength, startFlag(), out);
+			std::copy(out, out + 8, cv.begin());
+			++blocksCompressed;
+			::memset(block, 0, sizeof(block));
+			blockLength = 0;
+		}
+
+		const size_t take = std::min(BlockLength - blockLength, length);
+		::memcpy(block + blockLength, data, take);
+		blockLength = static_cast<uint8_t>(blockLength + take);
+		data += take;
+		length -= take;
+	}
+}
+
+CBlake3Hasher::ChainingValue CBlake3Hasher::Output::chainingValue() const noexcept
+{
+	uint32_t out[16];
+	compress(inputCv.data(), blockWords, counter, blockLength, flags, out);
+
+	ChainingValue cv;
+	std::copy(out, out + 8, cv.begin());
+	return cv;
+}
+
+CBlake3Hasher::Digest CBlake3Hasher::Output::rootDigest() const noexcept
+{
+	uint32_t out[16];
+	compress(inputCv.data(), blockWords, 0, blockLength, flags | Root, out);
+
+	Digest digest;
+	for (size_t i = 0; i < 8; ++i)
+	{
+		digest[4 * i] = static_cast<uint8_t>(out[i]);
+		digest[4 * i + 1] = static_cast<uint8_t>(out[i] >> 8);
+		digest[4 * i + 2] = static_cast<uint8_t>(out[i] >> 16);
+		digest[4 * i + 3] = static_cast<uint8_t>(out[i] >> 24);
+	}
+
+	return digest;
+}
+
+CBlake3Hasher::CBlake3Hasher() noexcept : _chunkState(0)
+{
+}
+
+void CBlake3Hasher::update(const void* data, size_t length) noexcept
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	while (length > 0)
+	{
+		// Only finishing a full chunk once more input arrives, because the last chunk may turn out to be the root
+		if (_chunkState.length() == ChunkLength)
+		{
+			const ChainingValue chunkCv = chunkOutput(_chunkState).chainingValue();
+			const uint64_t totalChunks = _chunkState.chunkCounter + 1;
+			addChunkChainingValue(chunkCv, totalChunks);
+			_chunkState = ChunkState(totalChunks);
+		}
+
+		const size_t take = std::min(ChunkLength - _chunkState.length(), length);
+		_chunkState.update(bytes, take);
+		bytes += take;
+		length -= take;
+	}
+}
+
+CBlake3Hasher::Digest CBlake3Hasher::finalize() const noexcept
+{
+	Output output = chunkOutput(_chunkState);
+	for (size_t i = _cvStackLength; i > 0; --i)
+		output = parentOutput(_cvStack[i - 1], output.chainingValue());
+
+	return output.rootDigest();
+}
+
+CBlake3Hasher::ChainingValue CBlake3Hasher::subtreeChainingValue(const void* data, size_t length, uint64_t firstChunkIndex) noexcept
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+	ChainingValue stack[54];
+	size_t stackLength = 0;
+	const uint64_t numChunks = length / ChunkLength;
+	for (uint64_t i = 0; i < numChunks; ++i)
+	{
+		ChunkState chunk(firstChunkIndex + i);
+		chunk.update(bytes + i * ChunkLength, ChunkLength);
+		ChainingValue cv = chunkOutput(chunk).chainingValue();
+
+		// Merging completed pairs right away, same as addChunkChainingValue()
+		for (uint64_t total = i + 1; (total & 1) == 0; total >>= 1)
+			cv = parentOutput(stack[--stackLength], cv).chainingValue();
+
+		stack[stackLength++] = cv;
+	}
+
+	return stack[0];
+}
+
+void CBlake3Hasher::pushSubtree(const ChainingValue& subtreeCv, uint64_t numChunks) noexcept
+{
+	// The stack is merged in units of the subtree size, which is valid since all the subtrees pushed so far are at least as big and aligned
+	uint64_t totalSubtrees = (_chunkState.chunkCounter + numChunks) / numChunks;
+	ChainingValue cv = subtreeCv;
+	while ((totalSubtrees & 1) == 0)
+	{
+		cv = parentOutput(_cvStack[--_cvStackLength], cv).chainingValue();
+		totalSubtrees >>= 1;
+	}
+
+	_cvStack[_cvStackLength++] = cv;
+	_chunkState = ChunkState(_chunkState.chunkCounter + numChunks);
+}
+
+uint64_t CBlake3Hasher::length() const noexcept
+{
+	return _chunkState.chunkCounter * ChunkLength + _chunkState.length();
+}
+
+CBlake3Hasher::Output CBlake3Hasher::chunkOutput(const ChunkState& chunk) noexcept
+{
+	Output output;
+	output.inputCv = chunk.cv;
+	wordsFromLittleEndianBytes(chunk.block, BlockLength, output.blockWords);
+	output.counter = chunk.chunkCounter;
+	output.blockLength = chunk.blockLength;
+	output.flags = chunk.startFlag() | ChunkEnd;
+	return output;
+}
+
+CBlake3Hasher::Output CBlake3Hasher::parentOutput(const ChainingValue& left, const ChainingValue& right) noexcept
+{
+	Output output;
+	output.inputCv = ivChainingValue();
+	std::copy(left.begin(), left.end(), output.blockWords);
+	std::copy(right.begin(), right.end(), output.blockWords + 8);
+	output.counter = 0;
+	output.blockLength = BlockLength;
+	output.flags = Parent;
+	return output;
+}
+
+void CBlake3Hasher::addChunkChainingValue(ChainingValue cv, uint64_t totalChunks) noexcept
+{
+	// A completed subtree is merged as soon as its sibling is complete; the number of trailing zero bits in the chunk count is the number of merges due
+	while ((totalChunks & 1) == 0)
+	{
+		cv = parentOutput(_cvStack[--_cvStackLength], cv).chainingValue();
+		totalChunks >>= 1;
+	}
+
+	_cvStack[_cvStackLength++] = cv;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+// A portable implementation of the BLAKE3 hash function (default hashing mode, 256-bit output).
+// Besides the usual incremental interface it can hash complete, aligned subtrees of the input independently so that a large input can be hashed on several threads:
+// hash the subtrees with subtreeChainingValue() in parallel, feed the results to pushSubtree() in order, then update() the hasher with the remainder and finalize().
+class CBlake3Hasher
+{
+public:
+	static constexpr size_t ChunkLength = 1024;
+	static constexpr size_t DigestLength = 32;
+
+	using Digest = std::array<uint8_t, DigestLength>;
+	using ChainingValue = std::array<uint32_t, 8>;
+
+	CBlake3Hasher() noexcept;
+
+	void update(const void* data, size_t length) noexcept;
+	Digest finalize() const noexcept;
+
+	// Returns the chaining value of a complete subtree: 'length' must be ChunkLength times a power of two, and 'firstChunkIndex' must be a multiple of that power of two.
+	static ChainingValue subtreeChainingValue(const void* data, size_t length, uint64_t firstChunkIndex) noexcept;
+
+	// Appends a subtree computed by subtreeChainingValue(). Can only be called on a chunk boundary, with the subtree being aligned as described above.
+	// The last subtree of the input must always go through update() instead, because the root node requires special handling.
+	void pushSubtree(const ChainingValue& subtreeCv, uint64_t numChunks) noexcept;
+
+	// Number of bytes hashed so far
+	uint64_t length() const noexcept;
+
+private:
+	struct ChunkState {
+		ChainingValue cv;
+		uint64_t chunkCounter = 0;
+		uint8_t block[64];
+		uint8_t blockLength = 0;
+		uint8_t blocksCompressed = 0;
+
+		explicit ChunkState(uint64_t counter) noexcept;
+		size_t length() const noexcept;
+		void update(const uint8_t* data, size_t length) noexcept;
+		uint32_t startFlag() const noexcept;
+	};
+
+	struct Output {
+		ChainingValue inputCv;
+		uint32_t blockWords[16];
+		uint64_t counter;
+		uint32_t blockLength;
+		uint32_t flags;
+
+		ChainingValue chainingValue() const noexcept;
+		Digest rootDigest() const noexcept;
+	};
+
+	static Output chunkOutput(const ChunkState& chunk) noexcept;
+	static Output parentOutput(const ChainingValue& left, const ChainingValue& right) noexcept;
+	void addChunkChainingValue(ChainingValue cv, uint64_t totalChunks) noexcept;
+
+private:
+	ChunkState _chunkState;
+	ChainingValue _cvStack[54]; // Enough for 2^64 bytes of input
+	uint8_t _cvStackLength = 0;
+};
@@ -0,0 +1,149 @@
+#include "cxxhash64.h"
+
+#include <string.h>
+
+namespace {
+
+constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t Prime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r) noexcept
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const uint8_t* p) noexcept
+{
+	uint64_t value = 0;
+	for (int i = 7; i >= 0; --i)
+		value = (value << 8) | p[i];
+	return value;
+}
+
+inline uint32_t read32(const uint8_t* p) noexcept
+{
+	return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline uint64_t accumulatorRound(uint64_t accumulator, uint64_t input) noexcept
+{
+	accumulator += input * Prime2;
+	accumulator = rotl(accumulator, 31);
+	return accumulator * Prime1;
+}
+
+inline uint64_t mergeRound(uint64_t accumulator, uint64_t value) noexcept
+{
+	accumulator ^= accumulatorRound(0, value);
+	return accumulator * Prime1 + Prime4;
+}
+
+} // namespace
+
+CXxHash64::CXxHash64(uint64_t seed) noexcept
+{
+	reset(seed);
+}
+
+void CXxHash64::reset(uint64_t seed) noexcept
+{
+	_seed = seed;
+	_accumulators[0] = seed + Prime1 + Prime2;
+	_accumulators[1] = seed + Prime2;
+	_accumulators[2] = seed;
+	_accumulators[3] = seed - Prime1;
+	_totalLength = 0;
+	_bufferSize = 0;
+}
+
+void CXxHash64::update(const void* data, size_t length) noexcept
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	const uint8_t* const end = p + length;
+	_totalLength += length;
+
+	if (_bufferSize + length < 32)
+	{
+		::memcpy(_buffer + _bufferSize, p, length);
+		_bufferSize += length;
+		return;
+	}
+
+	if (_bufferSize > 0)
+	{
+		const size_t take = 32 - _bufferSize;
+		::memcpy(_buffer + _bufferSize, p, take);
+		p += take;
+		for (int i = 0; i < 4; ++i)
+			_accumulators[i] = accumulatorRound(_accumulators[i], read64(_buffer + 8 * i));
+		_bufferSize = 0;
+	}
+
+	for (; p + 32 <= end; p += 32)
+	{
+		_accumulators[0] = accumulatorRound(_accumulators[0], read64(p));
+		_accumulators[1] = accumulatorRound(_accumulators[1], read64(p + 8));
+		_accumulators[2] = accumulatorRound(_accumulators[2], read64(p + 16));
+		_accumulators[3] = accumulatorRound(_accumulators[3], read64(p + 24));
+	}
+
+	if (p < end)
+	{
+		_bufferSize = static_cast<size_t>(end - p);
+		::memcpy(_buffer, p, _bufferSize);
+	}
+}
+
+uint64_t CXxHash64::digest() const noexcept
+{
+	uint64_t h;
+	if (_totalLength >= 32)
+	{
+		h = rotl(_accumulators[0], 1) + rotl(_accumulators[1], 7) + rotl(_accumulators[2], 12) + rotl(_accumulators[3], 18);
+		for (const uint64_t accumulator: _accumulators)
+			h = mergeRound(h, accumulator);
+	}
+	else
+		h = _seed + Prime5;
+
+	h += _totalLength;
+
+	const uint8_t* p = _buffer;
+	const uint8_t* const end = _buffer + _bufferSize;
+	for (; p + 8 <= end; p += 8)
+	{
+		h ^= accumulatorRound(0, read64(p));
+		h = rotl(h, 27) * Prime1 + Prime4;
+	}
+
+	if (p + 4 <= end)
+	{
+		h ^= uint64_t(read32(p)) * Prime1;
+		h = rotl(h, 23) * Prime2 + Prime3;
+		p += 4;
+	}
+
+	for (; p < end; ++p)
+	{
+		h ^= (*p) * Prime5;
+		h = rotl(h, 11) * Prime1;
+	}
+
+	// Avalanche
+	h ^= h >> 33;
+	h *= Prime2;
+	h ^= h >> 29;
+	h *= Prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+uint64_t CXxHash64::hash(const void* data, size_t length, uint64_t seed) noexcept
+{
+	CXxHash64 hasher(seed);
+	hasher.update(data, length);
+	return hasher.digest();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Incremental XXH64, a fast non-cryptographic 64-bit hash. The results are identical to the reference implementation.
+class CXxHash64
+{
+public:
+	explicit CXxHash64(uint64_t seed = 0) noexcept;
+
+	void reset(uint64_t seed = 0) noexcept;
+	void update(const void* data, size_t length) noexcept;
+	uint64_t digest() const noexcept;
+
+	// One-shot hashing
+	static uint64_t hash(const void* data, size_t length, uint64_t seed = 0) noexcept;
+
+private:
+	uint64_t _accumulators[4];
+	uint64_t _seed;
+	uint64_t _totalLength = 0;
+	uint8_t _buffer[32];
+	size_t _bufferSize = 0;
+};
@@ -0,0 +1,252 @@
+#include "casynclogger.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QHash>
+#include <QLoggingCategory>
+#include <QStringBuilder>
+RESTORE_COMPILER_WARNINGS
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr std::chrono::seconds RepeatWindow {1};
+// The writer wakes up on its own this often, in case a notification has been missed (the producers don't lock the mutex)
+static constexpr std::chrono::milliseconds MaxWriterSleep {100};
+
+CAsyncLogger& CAsyncLogger::instance()
+{
+	static CAsyncLogger logger;
+	return logger;
+}
+
+CAsyncLogger::~CAsyncLogger()
+{
+	uninstall();
+}
+
+void CAsyncLogger::install()
+{
+	assert_and_return_r(!_running, );
+
+	_stopRequested = false;
+	_running = true;
+	_thread = std::thread(&CAsyncLogger::writerThread, this);
+	_previousHandler = qInstallMessageHandler(&CAsyncLogger::messageHandler);
+}
+
+void CAsyncLogger::uninstall()
+{
+	if (!_running)
+		return;
+
+	qInstallMessageHandler(_previousHandler);
+
+	{
+		std::lock_guard<std::mutex> lock(_wakeUpMutex);
+		_stopRequested = true;
+	}
+	_wakeUp.notify_one();
+	_thread.join();
+
+	// Whatever has been logged since the writer has exited; this thread is the only consumer now
+	_running = false;
+	Message message;
+	while (_queue.pop(message))
+	{
+		write(message);
+		_numProcessed.fetch_add(1, std::memory_order_release);
+	}
+
+	expireRepeatedMessages(Clock::time_point::max());
+	_processed.notify_all();
+}
+
+void CAsyncLogger::flush()
+{
+	if (!_running || std::this_thread::get_id() == _thread.get_id())
+		return;
+
+	const uint64_t numEnqueued = _numEnqueued.load(std::memory_order_acquire);
+	_wakeUp.notify_one();
+
+	std::unique_lock<std::mutex> lock(_wakeUpMutex);
+	_processed.wait(lock, [this, numEnqueued]() {
+		return _numProcessed.load(std::memory_order_acquire) >= numEnqueued || !_running;
+	});
+}
+
+void CAsyncLogger::setCategoryLevel(const QString& category, Level level)
+{
+	QString rules;
+	{
+		std::lock_guard<std::mutex> lock(_levelsMutex);
+		_categoryLevels[category] = level;
+
+		for (const auto& categoryLevel: _categoryLevels)
+		{
+			const auto enabled = [&categoryLevel](Level messageLevel) {
+				return categoryLevel.second <= messageLevel ? QLatin1String("true") : QLatin1String("false");
+			};
+
+			rules += categoryLevel.first % QStringLiteral(".debug=") % enabled(Level::Debug) % '\n'
+				% categoryLevel.first % QStringLiteral(".info=") % enabled(Level::Info) % '\n'
+				% categoryLevel.first % QStringLiteral(".warning=") % enabled(Level::Warning) % '\n'
+				% categoryLevel.first % QStringLiteral(".critical=") % enabled(Level::Critical) % '\n';
+		}
+	}
+
+	QLoggingCategory::setFilterRules(rules);
+}
+
+void CAsyncLogger::setMaxRepeatsPerSecond(uint32_t maxRepeats)
+{
+	_maxRepeatsPerSecond = maxRepeats;
+}
+
+uint64_t CAsyncLogger::numMessagesSuppressed() const
+{
+	return _numSuppressed;
+}
+
+void CAsyncLogger::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& text)
+{
+	CAsyncLogger& logger = instance();
+
+	Message message;
+	message.type = type;
+	message.category = context.category;
+	message.file = context.file;
+	message.function = context.function;
+	message.line = context.line;
+	message.text = text;
+
+	if (type == QtFatalMsg || !logger._running)
+	{
+		// The process is about to be aborted, so everything has to be out before this message
+		logger.flush();
+		logger.passOn(message);
+		return;
+	}
+
+	logger.enqueue(std::move(message));
+}
+
+void CAsyncLogger::enqueue(Message&& message)
+{
+	// Counting before pushing so that the writer never sees more messages processed than enqueued
+	_numEnqueued.fetch_add(1, std::memory_order_acq_rel);
+	_queue.push(std::move(message));
+	_wakeUp.notify_one();
+}
+
+void CAsyncLogger::writerThread()
+{
+	for (;;)
+	{
+		Message message;
+		while (_queue.pop(message))
+		{
+			write(message);
+			_numProcessed.fetch_add(1, std::memory_order_release);
+		}
+
+		const auto now = Clock::now();
+		if (now - _lastExpiryCheck >= RepeatWindow / 4)
+		{
+			expireRepeatedMessages(now);
+			_lastExpiryCheck = now;
+		}
+
+		std::unique_lock<std::mutex> lock(_wakeUpMutex);
+		_processed.notify_all();
+
+		const auto hasPendingMessages = [this]() {
+			return _numProcessed.load(std::memory_order_acquire) < _numEnqueued.load(std::memory_order_acquire);
+		};
+
+		if (_stopRequested && !hasPendingMessages())
+			return;
+
+		// The repeat counts are summed up after a second even if no other message comes
+		const auto sleepDuration = _repeatedMessages.empty() ? MaxWriterSleep : std::min<Clock::duration>(MaxWriterSleep, RepeatWindow / 4);
+		_wakeUp.wait_for(lock, sleepDuration, [this, &hasPendingMessages]() {
+			return _stopRequested || hasPendingMessages();
+		});
+	}
+}
+
+void CAsyncLogger::write(Message& message)
+{
+	const uint32_t maxRepeats = _maxRepeatsPerSecond;
+	if (maxRepeats == 0)
+	{
+		passOn(message);
+		return;
+	}
+
+	const auto now = Clock::now();
+	const size_t key = qHash(message.text, static_cast<uint>(message.type));
+	auto& repeated = _repeatedMessages[key];
+	if (repeated.numWritten == 0)
+	{
+		repeated.windowStart = now;
+		repeated.sample = message;
+	}
+	else if (repeated.sample.text != message.text || repeated.sample.type != message.type)
+	{
+		// A hash collision, not a repeat
+		passOn(message);
+		return;
+	}
+	else if (now - repeated.windowStart >= RepeatWindow)
+	{
+		writeSuppressedCount(repeated);
+		repeated.windowStart = now;
+		repeated.numWritten = 0;
+		repeated.numSuppressed = 0;
+	}
+
+	if (repeated.numWritten < maxRepeats)
+	{
+		++repeated.numWritten;
+		passOn(message);
+	}
+	else
+	{
+		++repeated.numSuppressed;
+		_numSuppressed.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void CAsyncLogger::writeSuppressedCount(const RepeatedMessage& repeated) const
+{
+	if (repeated.numSuppressed == 0)
+		return;
+
+	Message summary = repeated.sample;
+	summary.text = repeated.sample.text % QStringLiteral(" (repeated %1 more times, suppressed)").arg(repeated.numSuppressed);
+	passOn(summary);
+}
+
+void CAsyncLogger::expireRepeatedMessages(Clock::time_point now)
+{
+	for (auto it = _repeatedMessages.begin(); it != _repeatedMessages.end();)
+	{
+		if (now == Clock::time_point::max() || now - it->second.windowStart >= RepeatWindow)
+		{
+			writeSuppressedCount(it->second);
+			it = _repeatedMessages.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+void CAsyncLogger::passOn(const Message& message) const
+{
+	if (!_previousHandler)
+		return;
+
+	const QMessageLogContext context(message.file, message.line, message.function, message.category);
+	_previousHandler(message.type, context, message.text);
+}
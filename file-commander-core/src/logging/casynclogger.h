@@ -0,0 +1,112 @@
+#pragma once
+
+#include "cmpscqueue.hpp"
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+#include <QtGlobal>
+RESTORE_COMPILER_WARNINGS
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <unordered_map>
+
+// Takes the Qt message output (qDebug(), qInfo(), qWarning(), qCritical() and their qC* counterparts) off the calling thread.
+// The message handler only puts the message into a lock-free queue; a background thread passes it on to the handler that was installed before,
+// so the messages still end up wherever they used to go. qFatal() messages are written synchronously, after everything queued before them.
+//
+// Levels:
+// - at run time, per logging category, with setCategoryLevel() (built on QLoggingCategory filter rules, so a disabled message isn't even formatted);
+// - at compile time, with QT_NO_DEBUG_OUTPUT, QT_NO_INFO_OUTPUT and QT_NO_WARNING_OUTPUT, which turn the corresponding macros into no-ops.
+//   Release builds define QT_NO_DEBUG_OUTPUT.
+//
+// Repeated messages are rate-limited: the same message is written no more than maxRepeatsPerSecond times a second,
+// the rest are counted and summed up in a single line once the second is over.
+class CAsyncLogger
+{
+public:
+	enum class Level {
+		Debug,
+		Info,
+		Warning,
+		Critical,
+		Off
+	};
+
+	static CAsyncLogger& instance();
+
+	// Installs the message handler and starts the writer thread
+	void install();
+	// Writes out the remaining messages, stops the writer thread and restores the previous message handler
+	void uninstall();
+
+	// Blocks until all the messages logged so far have been written
+	void flush();
+
+	// The messages of 'category' below 'level' are dropped; "default" is the category of plain qInfo() and the like
+	void setCategoryLevel(const QString& category, Level level);
+	// 0 disables the rate limiting
+	void setMaxRepeatsPerSecond(uint32_t maxRepeats);
+
+	uint64_t numMessagesSuppressed() const;
+
+private:
+	struct Message {
+		QtMsgType type = QtInfoMsg;
+		// All the context strings are string literals or belong to static QLoggingCategory objects
+		const char* category = nullptr;
+		const char* file = nullptr;
+		const char* function = nullptr;
+		int line = 0;
+		QString text;
+	};
+
+	struct RepeatedMessage {
+		std::chrono::steady_clock::time_point windowStart;
+		uint32_t numWritten = 0;
+		uint64_t numSuppressed = 0;
+		Message sample;
+	};
+
+	CAsyncLogger() = default;
+	~CAsyncLogger();
+
+	static void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& text);
+
+	void enqueue(Message&& message);
+	void writerThread();
+	void write(Message& message);
+	void writeSuppressedCount(const RepeatedMessage& repeated) const;
+	void expireRepeatedMessages(std::chrono::steady_clock::time_point now);
+	void passOn(const Message& message) const;
+
+private:
+	CMpscQueue<Message> _queue;
+	std::atomic<uint64_t> _numEnqueued {0};
+	std::atomic<uint64_t> _numProcessed {0};
+	std::atomic<bool> _running {false};
+	std::atomic<bool> _stopRequested {false};
+
+	std::mutex _wakeUpMutex;
+	std::condition_variable _wakeUp;
+	std::condition_variable _processed;
+
+	QtMessageHandler _previousHandler = nullptr;
+	std::thread _thread;
+
+	// Only accessed by the writer thread
+	std::unordered_map<size_t, RepeatedMessage> _repeatedMessages;
+	std::chrono::steady_clock::time_point _lastExpiryCheck;
+	std::atomic<uint32_t> _maxRepeatsPerSecond {20};
+	std::atomic<uint64_t> _numSuppressed {0};
+
+	std::mutex _levelsMutex;
+	std::map<QString, Level> _categoryLevels;
+};
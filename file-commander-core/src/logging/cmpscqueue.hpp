@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// An unbounded lock-free multiple producer / single consumer queue (Dmitry Vyukov's intrusive MPSC node-based queue).
+// push() may be called from any thread and never blocks: it's one allocation and one atomic exchange.
+// pop() must only be called from one thread at a time. It never blocks either, and may spuriously report the queue as empty
+// while a push() is in the middle of linking its node; the item shows up on one of the subsequent calls.
+template <typename T>
+class CMpscQueue
+{
+public:
+	CMpscQueue() noexcept : _head{&_stub}, _tail{&_stub}
+	{}
+
+	~CMpscQueue()
+	{
+		T item;
+		while (pop(item));
+	}
+
+	CMpscQueue(const CMpscQueue&) = delete;
+	CMpscQueue& operator=(const CMpscQueue&) = delete;
+
+	void push(T&& item)
+	{
+		pushNode(new Node{std::move(item)});
+	}
+
+	bool pop(T& item)
+	{
+		Node* tail = _tail;
+		Node* next = tail->next.load(std::memory_order_acquire);
+		if (tail == &_stub)
+		{
+			if (!next)
+				return false;
+
+			_tail = next;
+			tail = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if (!next)
+		{
+			if (tail != _head.load(std::memory_order_acquire))
+				return false; // A producer has taken the head but hasn't linked its node yet
+
+			// 'tail' is the last node, the stub has to be put after it before it can be taken out
+			pushNode(&_stub);
+			next = tail->next.load(std::memory_order_acquire);
+			if (!next)
+				return false;
+		}
+
+		_tail = next;
+		item = std::move(tail->item);
+		delete tail;
+		return true;
+	}
+
+private:
+	struct Node {
+		explicit Node(T&& value = T{}) noexcept : item{std::move(value)} {}
+
+		std::atomic<Node*> next {nullptr};
+		T item;
+	};
+
+	void pushNode(Node* node) noexcept
+	{
+		node->next.store(nullptr, std::memory_order_relaxed);
+		Node* previous = _head.exchange(node, std::memory_order_acq_rel);
+		previous->next.store(node, std::memory_order_release);
+	}
+
+private:
+	Node _stub;
+	std::atomic<Node*> _head; // Where the producers push
+	Node* _tail;              // Where the consumer pops
+};
@@ -0,0 +1,220 @@
+#include "cmetricsregistry.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStorageInfo>
+#include <QStringBuilder>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <cmath>
+
+uint64_t CLatencyHistogram::Snapshot::percentile(double percentile) const
+{
+	if (count == 0)
+		return 0;
+
+	const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count))));
+	uint64_t cumulativeCount = 0;
+	for (size_t i = 0; i < buckets.size(); ++i)
+	{
+		cumulativeCount += buckets[i];
+		if (cumulativeCount >= rank)
+			return std::min(bucketUpperBound(i), max);
+	}
+
+	return max;
+}
+
+double CLatencyHistogram::Snapshot::mean() const
+{
+	return count > 0 ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+}
+
+CLatencyHistogram::Snapshot CLatencyHistogram::Snapshot::since(const Snapshot& earlier) const
+{
+	Snapshot difference;
+	for (size_t i = 0; i < NumBuckets; ++i)
+		difference.buckets[i] = buckets[i] - std::min(buckets[i], earlier.buckets[i]);
+
+	difference.count = count - std::min(count, earlier.count);
+	difference.sum = sum - std::min(sum, earlier.sum);
+	difference.max = max;
+	return difference;
+}
+
+void CLatencyHistogram::record(uint64_t microseconds) noexcept
+{
+	_buckets[bucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+	_sum.fetch_add(microseconds, std::memory_order_relaxed);
+
+	uint64_t max = _max.load(std::memory_order_relaxed);
+	while (microseconds > max && !_max.compare_exchange_weak(max, microseconds, std::memory_order_relaxed));
+}
+
+CLatencyHistogram::Snapshot CLatencyHistogram::snapshot() const
+{
+	Snapshot snapshot;
+	// The count is the sum of the buckets rather than a separate counter, so that it's consistent with them even if values are being recorded right now
+	for (size_t i = 0; i < NumBuckets; ++i)
+	{
+		snapshot.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+		snapshot.count += snapshot.buckets[i];
+	}
+
+	snapshot.sum = _sum.load(std::memory_order_relaxed);
+	snapshot.max = _max.load(std::memory_order_relaxed);
+	return snapshot;
+}
+
+size_t CLatencyHistogram::bucketIndex(uint64_t value) noexcept
+{
+	if (value < NumSubBuckets)
+		return static_cast<size_t>(value);
+
+	value = std::min(value, (uint64_t{1} << MaxValueBits) - 1);
+
+	size_t highestBit = 0;
+	for (uint64_t v = value; v > 1; v >>= 1)
+		++highestBit;
+
+	// The highest SubBucketBits + 1 bits of the value: the leading 1 picks the power of two range, the rest pick the sub-bucket
+	const size_t shift = highestBit - SubBucketBits;
+	const auto subBucket = static_cast<size_t>((value >> shift) & (NumSubBuckets - 1));
+	return NumSubBuckets + shift * NumSubBuckets + subBucket;
+}
+
+uint64_t CLatencyHistogram::bucketUpperBound(size_t index) noexcept
+{
+	if (index < NumSubBuckets)
+		return index;
+
+	const size_t shift = (index - NumSubBuckets) / NumSubBuckets;
+	const uint64_t subBucket = (index - NumSubBuckets) % NumSubBuckets;
+	return ((NumSubBuckets + subBucket + 1) << shift) - 1;
+}
+
+CMetricsRegistry& CMetricsRegistry::instance()
+{
+	static CMetricsRegistry registry;
+	return registry;
+}
+
+template <class Metric>
+static Metric& findOrCreate(std::map<QString, std::unique_ptr<Metric>>& metrics, const QString& name)
+{
+	auto& metric = metrics[name];
+	if (!metric)
+		metric = std::make_unique<Metric>();
+
+	return *metric;
+}
+
+CMetricCounter& CMetricsRegistry::counter(const QString& name)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return findOrCreate(_counters, name);
+}
+
+CMetricGauge& CMetricsRegistry::gauge(const QString& name)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return findOrCreate(_gauges, name);
+}
+
+CLatencyHistogram& CMetricsRegistry::histogram(const QString& name)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return findOrCreate(_histograms, name);
+}
+
+CMetricsRegistry::Snapshot CMetricsRegistry::snapshot() const
+{
+	Snapshot snapshot;
+	snapshot.time = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (const auto& counter: _counters)
+		snapshot.counters[counter.first] = counter.second->value();
+
+	for (const auto& gauge: _gauges)
+		snapshot.gauges[gauge.first] = gauge.second->value();
+
+	for (const auto& histogram: _histograms)
+		snapshot.histograms[histogram.first] = histogram.second->snapshot();
+
+	return snapshot;
+}
+
+QString CMetricsRegistry::withDevice(const QString& name, const QString& device)
+{
+	return name % '{' % device % '}';
+}
+
+QString CMetricsRegistry::deviceForPath(const QString& path)
+{
+	// The destination of a copy doesn't exist yet when the counters are set up
+	QFileInfo existingPath(path);
+	while (!existingPath.exists() && !existingPath.isRoot() && existingPath.absolutePath() != existingPath.absoluteFilePath())
+		existingPath.setFile(existingPath.absolutePath());
+
+	const QStorageInfo storage(existingPath.absoluteFilePath());
+	return storage.isValid() ? storage.rootPath() : QStringLiteral("?");
+}
+
+QJsonObject CMetricsRegistry::toJson(const Snapshot& snapshot, uint64_t timestamp)
+{
+	QJsonObject counters;
+	for (const auto& counter: snapshot.counters)
+		counters.insert(counter.first, static_cast<qint64>(counter.second));
+
+	QJsonObject gauges;
+	for (const auto& gauge: snapshot.gauges)
+		gauges.insert(gauge.first, static_cast<qint64>(gauge.second));
+
+	QJsonObject histograms;
+	for (const auto& histogram: snapshot.histograms)
+	{
+		const auto& h = histogram.second;
+
+		// [upper bound, count] pairs
+		QJsonArray buckets;
+		for (size_t i = 0; i < h.buckets.size(); ++i)
+		{
+			if (h.buckets[i] != 0)
+				buckets.push_back(QJsonArray{static_cast<qint64>(CLatencyHistogram::bucketUpperBound(i)), static_cast<qint64>(h.buckets[i])});
+		}
+
+		histograms.insert(histogram.first, QJsonObject{
+			{"count", static_cast<qint64>(h.count)},
+			{"sum", static_cast<qint64>(h.sum)},
+			{"max", static_cast<qint64>(h.max)},
+			{"mean", h.mean()},
+			{"p50", static_cast<qint64>(h.percentile(50))},
+			{"p90", static_cast<qint64>(h.percentile(90))},
+			{"p99", static_cast<qint64>(h.percentile(99))},
+			{"p999", static_cast<qint64>(h.percentile(99.9))},
+			{"buckets", buckets}
+		});
+	}
+
+	return QJsonObject{
+		{"timestamp_ms", static_cast<qint64>(timestamp)},
+		{"counters", counters},
+		{"gauges", gauges},
+		{"histograms", histograms}
+	};
+}
+
+bool CMetricsRegistry::exportToFile(const QString& filePath) const
+{
+	QFile file(filePath);
+	assert_and_return_r(file.open(QFile::WriteOnly | QFile::Truncate), false);
+
+	const QByteArray json = QJsonDocument(toJson(snapshot(), 0)).toJson();
+	return file.write(json) == json.size();
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QJsonObject>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+// A monotonically increasing count (bytes, operations); the rate is the difference between two snapshots
+class CMetricCounter
+{
+public:
+	inline void add(uint64_t n = 1) noexcept {
+		_value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	inline uint64_t value() const noexcept {
+		return _value.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<uint64_t> _value {0};
+};
+
+// The current level of something (queue depth, the number of busy workers). Concurrent jobs add their share and take it back when done.
+class CMetricGauge
+{
+public:
+	inline void add(int64_t delta) noexcept {
+		_value.fetch_add(delta, std::memory_order_relaxed);
+	}
+
+	inline int64_t value() const noexcept {
+		return _value.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<int64_t> _value {0};
+};
+
+// A latency histogram in the spirit of HdrHistogram: every power of two range is split into 16 linear sub-buckets,
+// so any value is placed within 1/16 (6.25%) of its actual value over the whole range from 1 us to hours, with a fixed amount of memory.
+// Recording is lock-free.
+class CLatencyHistogram
+{
+public:
+	static constexpr size_t SubBucketBits = 4;
+	static constexpr size_t NumSubBuckets = size_t{1} << SubBucketBits;
+	static constexpr size_t MaxValueBits = 42; // ~50 days in microseconds
+	static constexpr size_t NumBuckets = NumSubBuckets + (MaxValueBits - SubBucketBits) * NumSubBuckets;
+
+	struct Snapshot {
+		std::vector<uint64_t> buckets = std::vector<uint64_t>(NumBuckets, 0);
+		uint64_t count = 0;
+		uint64_t sum = 0;
+		uint64_t max = 0;
+
+		// 'percentile' is 0 to 100. The value returned is the upper bound of the bucket the percentile falls into, never more than max.
+		uint64_t percentile(double percentile) const;
+		double mean() const;
+		// The values recorded after 'earlier' was taken. The max is that of the whole lifetime.
+		Snapshot since(const Snapshot& earlier) const;
+	};
+
+	void record(uint64_t microseconds) noexcept;
+	Snapshot snapshot() const;
+
+	static size_t bucketIndex(uint64_t value) noexcept;
+	static uint64_t bucketUpperBound(size_t index) noexcept;
+
+private:
+	std::array<std::atomic<uint64_t>, NumBuckets> _buckets {};
+	std::atomic<uint64_t> _sum {0};
+	std::atomic<uint64_t> _max {0};
+};
+
+// Records the time from its construction to its destruction, less the time spent paused, unless cancelled
+class CScopedLatency
+{
+public:
+	inline explicit CScopedLatency(CLatencyHistogram& histogram) noexcept : _histogram{&histogram}, _start{std::chrono::steady_clock::now()}
+	{}
+
+	inline ~CScopedLatency() {
+		if (_histogram)
+			_histogram->record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start - _pausedTime).count()));
+	}
+
+	// The time until resume() is not counted
+	inline void pause() noexcept {
+		_pauseStart = std::chrono::steady_clock::now();
+	}
+
+	inline void resume() noexcept {
+		_pausedTime += std::chrono::steady_clock::now() - _pauseStart;
+	}
+
+	inline void cancel() noexcept {
+		_histogram = nullptr;
+	}
+
+	CScopedLatency(const CScopedLatency&) = delete;
+	CScopedLatency& operator=(const CScopedLatency&) = delete;
+
+private:
+	CLatencyHistogram* _histogram;
+	const std::chrono::steady_clock::time_point _start;
+	std::chrono::steady_clock::time_point _pauseStart;
+	std::chrono::steady_clock::duration _pausedTime {0};
+};
+
+// The process-wide set of named metrics, fed by the file operations and read by the operations dashboard.
+// The metrics are created on the first request and live until the process exits, so the references returned can be cached.
+// A metric that is tracked per device carries the device in the name: "io.bytes_written{/mnt/data}", see withDevice().
+class CMetricsRegistry
+{
+public:
+	struct Snapshot {
+		std::chrono::steady_clock::time_point time;
+		std::map<QString, uint64_t> counters;
+		std::map<QString, int64_t> gauges;
+		std::map<QString, CLatencyHistogram::Snapshot> histograms;
+	};
+
+	static CMetricsRegistry& instance();
+
+	CMetricCounter& counter(const QString& name);
+	CMetricGauge& gauge(const QString& name);
+	CLatencyHistogram& histogram(const QString& name);
+
+	Snapshot snapshot() const;
+
+	static QString withDevice(const QString& name, const QString& device);
+	// The root of the volume 'path' is on
+	static QString deviceForPath(const QString& path);
+
+	// Counters and gauges as they are, histograms as the count, sum, max, a few percentiles and the non-empty buckets;
+	// 'timestamp' is in milliseconds since whatever origin the caller chooses
+	static QJsonObject toJson(const Snapshot& snapshot, uint64_t timestamp);
+	bool exportToFile(const QString& filePath) const;
+
+private:
+	CMetricsRegistry() = default;
+
+private:
+	mutable std::mutex _mutex;
+	std::map<QString, std::unique_ptr<CMetricCounter>> _counters;
+	std::map<QString, std::unique_ptr<CMetricGauge>> _gauges;
+	std::map<QString, std::unique_ptr<CLatencyHistogram>> _histograms;
+};
+
+// The names of the metrics recorded by the core
+namespace Metrics {
+
+// Latency histograms, microseconds
+constexpr char FileOpenLatency[] = "file.open_latency_us";     // Opening the source and the destination of a copy
+constexpr char FileCopyLatency[] = "file.copy_latency_us";     // Copying a whole file
+constexpr char FileFsyncLatency[] = "file.fsync_latency_us";   // Flushing a copy to the disk
+constexpr char FileUnlinkLatency[] = "file.unlink_latency_us"; // Deleting a file or an empty folder
+
+// Counters
+constexpr char IoOperations[] = "io.operations"; // Opens, copied chunks, unlinks
+constexpr char BytesRead[] = "io.bytes_read";       // Per device
+constexpr char BytesWritten[] = "io.bytes_written"; // Per device
+
+// Gauges
+constexpr char RunningOperations[] = "operations.running";
+constexpr char CopyQueueDepth[] = "copy.queue_depth"; // Items enumerated but not yet copied
+constexpr char Workers[] = "workers.total";
+constexpr char BusyWorkers[] = "workers.busy"; // Not waiting for the user, paused or idle
+
+}
@@ -0,0 +1,282 @@
+#include "cparalleldirectoryscanner.h"
+#include "assert/advanced_assert.h"
+#include "threading/thread_helpers.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+struct PendingFolder {
+	QString path; // Ends with a '/'
+	uint64_t token;
+	uint32_t depth;
+	uint32_t rootIndex;
+};
+
+inline QString withTrailingSlash(const QString& path)
+{
+	return path.endsWith('/') ? path : path + '/';
+}
+
+#ifndef _WIN32
+
+inline void fillFromStat(ScannedItemInfo& info, const struct stat& st)
+{
+	info.exists = true;
+	info.size = static_cast<uint64_t>(st.st_size);
+	info.allocatedSize = static_cast<uint64_t>(st.st_blocks) * 512;
+	info.inode = static_cast<uint64_t>(st.st_ino);
+	info.deviceId = static_cast<uint64_t>(st.st_dev);
+	info.linkCount = static_cast<uint32_t>(st.st_nlink);
+	info.permissions = static_cast<uint32_t>(st.st_mode & 07777);
+	info.modificationTime = st.st_mtime;
+	info.statusChangeTime = st.st_ctime;
+	info.isSymLink = S_ISLNK(st.st_mode);
+	info.type = S_ISDIR(st.st_mode) ? Directory : File;
+	if (info.isDir())
+		info.size = info.allocatedSize = 0;
+}
+
+#else
+
+inline void fillFromFileInfo(ScannedItemInfo& info, const QFileInfo& fileInfo)
+{
+	info.exists = fileInfo.exists() || fileInfo.isSymLink();
+	info.isSymLink = fileInfo.isSymLink();
+	info.type = (fileInfo.isDir() && !info.isSymLink) ? Directory : File;
+	info.size = info.isDir() ? 0 : static_cast<uint64_t>(fileInfo.size());
+	info.allocatedSize = info.size;
+	info.modificationTime = static_cast<time_t>(fileInfo.lastModified().toSecsSinceEpoch());
+	info.statusChangeTime = info.modificationTime;
+	info.permissions = static_cast<uint32_t>(fileInfo.permissions());
+}
+
+#endif
+
+} // namespace
+
+CParallelDirectoryScanner::CParallelDirectoryScanner(size_t numThreads) :
+	// Listing folders is dominated by I/O latency rather than CPU, so it's worth having more threads than cores, within reason
+	_numThreads(numThreads > 0 ? numThreads : std::clamp<size_t>(std::thread::hardware_concurrency() * 2, 4, 32))
+{
+}
+
+void CParallelDirectoryScanner::setPruningRules(CPruningRules rules)
+{
+	_pruningRules = std::move(rules);
+}
+
+void CParallelDirectoryScanner::scan(const std::vector<QString>& roots, const ItemCallback& callback, const std::atomic<bool>& abort) const
+{
+	scan(roots, TreeItemCallback{[&callback](const ScannedItemInfo& item, uint64_t /*parentToken*/) -> uint64_t {
+		callback(item);
+		return 0;
+	}}, abort);
+}
+
+void CParallelDirectoryScanner::scan(const std::vector<QString>& roots, const TreeItemCallback& callback, const std::atomic<bool>& abort) const
+{
+	const bool pruning = !_pruningRules.isEmpty();
+	// For the pruning rules: the relative paths start after the root path, and the same file system is the root's one
+	std::vector<int> rootPathLengths(roots.size(), 0);
+	std::vector<uint64_t> rootDeviceIds(roots.size(), 0);
+
+	std::deque<PendingFolder> pendingFolders;
+	for (size_t i = 0; i < roots.size(); ++i)
+	{
+		ScannedItemInfo rootInfo = itemInfo(roots[i]);
+		if (!rootInfo.exists)
+			continue;
+
+		rootInfo.rootIndex = static_cast<uint32_t>(i);
+		rootPathLengths[i] = rootInfo.fullPath.length();
+		rootDeviceIds[i] = rootInfo.deviceId;
+		const uint64_t token = callback(rootInfo, 0);
+		if (rootInfo.isDir() && !rootInfo.isSymLink && _pruningRules.descendsInto(0, true))
+			pendingFolders.push_back({rootInfo.fullPath, token, 0, rootInfo.rootIndex});
+	}
+
+	if (pendingFolders.empty())
+		return;
+
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	size_t numFoldersInProgress = 0;
+
+	const auto workerFunc = [&]() {
+		setThreadName("Directory scanner thread");
+
+		std::vector<PendingFolder> subfolders;
+		for (;;)
+		{
+			PendingFolder folder;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				workAvailable.wait(lock, [&]() {
+					return abort || !pendingFolders.empty() || numFoldersInProgress == 0;
+				});
+
+				if (abort || pendingFolders.empty())
+					return; // Either aborted, or nothing is queued and nobody is going to queue more
+
+				// LIFO keeps the working set of every thread local to one subtree, which is friendlier to the OS caches
+				folder = std::move(pendingFolders.back());
+				pendingFolders.pop_back();
+				++numFoldersInProgress;
+			}
+
+			subfolders.clear();
+			const uint32_t childDepth = folder.depth + 1;
+			const QStringView folderRelativePath = QStringView{folder.path}.mid(rootPathLengths[folder.rootIndex]);
+			const auto descendsInto = [&](const ScannedItemInfo& info) {
+				return info.isDir() && (!pruning || _pruningRules.descendsInto(childDepth, info.deviceId == rootDeviceIds[folder.rootIndex]));
+			};
+
+#ifndef _WIN32
+			const QByteArray encodedFolderPath = QFile::encodeName(folder.path);
+			DIR* dir = ::opendir(encodedFolderPath.constData());
+			if (dir)
+			{
+				const int dirFd = ::dirfd(dir);
+				while (const dirent* entry = ::readdir(dir))
+				{
+					if (abort)
+						break;
+
+					const char* entryName = entry->d_name;
+					if (entryName[0] == '.' && (entryName[1] == '\0' || (entryName[1] == '.' && entryName[2] == '\0')))
+						continue;
+
+					ScannedItemInfo info;
+					info.name = QFile::decodeName(entryName);
+					info.isHidden = entryName[0] == '.';
+
+					// Where the file system reports the entry type, the excluded items aren't even stat()-ed
+					const bool typeKnown = entry->d_type != DT_UNKNOWN;
+					if (pruning && typeKnown)
+					{
+						const bool isSystem = entry->d_type != DT_REG && entry->d_type != DT_DIR && entry->d_type != DT_LNK;
+						if (_pruningRules.excludes(folderRelativePath, info.name, entry->d_type == DT_DIR, info.isHidden, isSystem))
+							continue;
+					}
+
+					struct stat st;
+					if (::fstatat(dirFd, entryName, &st, AT_SYMLINK_NOFOLLOW) != 0)
+						continue;
+
+					if (pruning && !typeKnown)
+					{
+						const bool isSystem = !S_ISREG(st.st_mode) && !S_ISDIR(st.st_mode) && !S_ISLNK(st.st_mode);
+						if (_pruningRules.excludes(folderRelativePath, info.name, S_ISDIR(st.st_mode), info.isHidden, isSystem))
+							continue;
+					}
+
+					fillFromStat(info, st);
+					info.depth = childDepth;
+					info.rootIndex = folder.rootIndex;
+					info.fullPath = folder.path + info.name;
+					if (info.isDir())
+						info.fullPath += '/';
+
+					const uint64_t token = callback(info, folder.token);
+					if (descendsInto(info))
+						subfolders.push_back({info.fullPath, token, childDepth, folder.rootIndex});
+				}
+
+				::closedir(dir);
+			}
+#else
+			const auto entries = QDir(folder.path).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+			for (const QFileInfo& entry: entries)
+			{
+				if (abort)
+					break;
+
+				ScannedItemInfo info;
+				fillFromFileInfo(info, entry);
+				info.name = entry.fileName();
+				info.isHidden = entry.isHidden();
+				if (pruning && _pruningRules.excludes(folderRelativePath, info.name, info.isDir(), info.isHidden, _pruningRules.skipsSystemItems() && CPruningRules::isSystemItem(entry)))
+					continue;
+
+				info.depth = childDepth;
+				info.rootIndex = folder.rootIndex;
+				info.fullPath = folder.path + info.name;
+				if (info.isDir())
+					info.fullPath += '/';
+
+				const uint64_t token = callback(info, folder.token);
+				if (descendsInto(info))
+					subfolders.push_back({info.fullPath, token, childDepth, folder.rootIndex});
+			}
+#endif
+
+			bool allDone = false;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (auto& subfolder: subfolders)
+					pendingFolders.push_back(std::move(subfolder));
+				--numFoldersInProgress;
+				allDone = numFoldersInProgress == 0 && pendingFolders.empty();
+			}
+
+			// Wake up everybody when the last folder has been processed so that all the threads can quit
+			if (!subfolders.empty() || allDone || abort)
+				workAvailable.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(_numThreads);
+	for (size_t i = 0; i < _numThreads; ++i)
+		threads.emplace_back(workerFunc);
+
+	for (auto& thread: threads)
+		thread.join();
+}
+
+ScannedItemInfo CParallelDirectoryScanner::itemInfo(const QString& path)
+{
+	ScannedItemInfo info;
+	QString cleanedPath = QDir::cleanPath(QDir::fromNativeSeparators(path));
+	if (cleanedPath.length() > 1 && cleanedPath.endsWith('/'))
+		cleanedPath.chop(1);
+
+	info.name = QFileInfo(cleanedPath).fileName();
+	info.isHidden = info.name.startsWith('.');
+
+#ifndef _WIN32
+	struct stat st;
+	if (::lstat(QFile::encodeName(cleanedPath).constData(), &st) != 0)
+	{
+		info.fullPath = cleanedPath;
+		return info;
+	}
+
+	fillFromStat(info, st);
+#else
+	const QFileInfo fileInfo(cleanedPath);
+	fillFromFileInfo(info, fileInfo);
+	info.isHidden = fileInfo.isHidden();
+#endif
+
+	info.fullPath = info.isDir() ? withTrailingSlash(cleanedPath) : cleanedPath;
+	return info;
+}
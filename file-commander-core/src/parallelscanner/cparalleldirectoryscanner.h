@@ -0,0 +1,61 @@
+#pragma once
+
+#include "cfilesystemobject.h"
+#include "pruningrules/cpruningrules.h"
+
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+// Metadata collected for every item with a single lstat() call during enumeration
+struct ScannedItemInfo
+{
+	QString fullPath; // Folder paths end with a '/'
+	QString name;
+	uint64_t size = 0;
+	uint64_t allocatedSize = 0; // The space actually occupied on disk (st_blocks * 512)
+	uint64_t inode = 0;
+	uint64_t deviceId = 0;
+	time_t modificationTime = 0;
+	time_t statusChangeTime = 0;
+	uint32_t linkCount = 1;
+	uint32_t permissions = 0; // st_mode & 07777
+	uint32_t depth = 0; // 0 for the scan root itself
+	uint32_t rootIndex = 0; // Index of the root this item was found under
+	FileSystemObjectType type = UnknownType;
+	bool isSymLink = false;
+	bool isHidden = false;
+	bool exists = false;
+
+	inline bool isFile() const noexcept { return type == File; }
+	inline bool isDir() const noexcept { return type == Directory || type == Bundle; }
+};
+
+// Enumerates one or more directory trees with a pool of threads, every thread taking the next pending folder.
+// Symbolic links are reported but never followed. The items excluded by the pruning rules are neither reported nor entered.
+class CParallelDirectoryScanner
+{
+public:
+	// Is called concurrently from all the worker threads
+	using ItemCallback = std::function<void (const ScannedItemInfo& item)>;
+	// Same as above, but also receives the token returned for the item's parent folder (0 for the roots).
+	// The value returned for a folder is passed to the callbacks for all of its children, which allows building a tree without looking parents up by path.
+	using TreeItemCallback = std::function<uint64_t (const ScannedItemInfo& item, uint64_t parentToken)>;
+
+	explicit CParallelDirectoryScanner(size_t numThreads = 0 /* pick automatically */);
+
+	void setPruningRules(CPruningRules rules);
+
+	// Blocks until all the roots have been scanned or until 'abort' is set
+	void scan(const std::vector<QString>& roots, const ItemCallback& callback, const std::atomic<bool>& abort) const;
+	void scan(const std::vector<QString>& roots, const TreeItemCallback& callback, const std::atomic<bool>& abort) const;
+
+	// Queries the metadata for a single item
+	static ScannedItemInfo itemInfo(const QString& path);
+
+private:
+	const size_t _numThreads;
+	CPruningRules _pruningRules;
+};
@@ -12,6 +12,11 @@ void CPluginProxy::setToolMenuEntryCreatorImplementation(const CreateToolMenuEnt
 	_createToolMenuEntryImplementation = implementation;
 }
 
+void CPluginProxy::setNavigationImplementation(const NavigationImplementationType& implementation)
+{
+	_navigationImplementation = implementation;
+}
+
 void CPluginProxy::createToolMenuEntries(const std::vector<MenuTree>& menuTrees)
 {
 	if (_createToolMenuEntryImplementation)
@@ -23,6 +28,13 @@ void CPluginProxy::createToolMenuEntries(const MenuTree& menuTree)
 	createToolMenuEntries(std::vector<MenuTree>(1, menuTree));
 }
 
+void CPluginProxy::navigateTo(PanelPosition panel, const QString& path)
+{
+	assert_and_return_r(panel != PluginUnknownPanel, );
+	if (_navigationImplementation)
+		_navigationImplementation(panel, path);
+}
+
 void CPluginProxy::panelContentsChanged(PanelPosition panel, const QString &folder, const std::map<qulonglong, CFileSystemObject>& contents)
 {
 	PanelState& state = _panelState[panel];
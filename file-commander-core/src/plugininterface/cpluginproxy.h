@@ -36,14 +36,20 @@ public:
 	CPluginProxy(std::function<void (std::function<void ()>)> execOnUiThreadImplementation);
 
 	using CreateToolMenuEntryImplementationType = std::function<void(const std::vector<CPluginProxy::MenuTree>&)>;
+	using NavigationImplementationType = std::function<void(PanelPosition panel, const QString& path)>;
 
 // Proxy initialization (by core / UI)
 	void setToolMenuEntryCreatorImplementation(const CreateToolMenuEntryImplementationType& implementation);
+	void setNavigationImplementation(const NavigationImplementationType& implementation);
 
 // UI access for plugins; every plugin is only supposed to call this method once
 	void createToolMenuEntries(const std::vector<MenuTree>& menuTrees);
 	void createToolMenuEntries(const MenuTree& menuTree);
 
+// Panel navigation for plugins, must be called on the UI thread.
+// A folder path opens that folder, a file path opens its parent folder with the file selected.
+	void navigateTo(PanelPosition panel, const QString& path);
+
 // Events and data updates from the core
 	void panelContentsChanged(PanelPosition panel, const QString& folder, const std::map<qulonglong /*hash*/, CFileSystemObject>& contents);
 
@@ -68,6 +74,7 @@ public:
 
 private:
 	CreateToolMenuEntryImplementationType _createToolMenuEntryImplementation;
+	NavigationImplementationType _navigationImplementation;
 	std::map<PanelPosition, PanelState> _panelState;
 	std::function<void(std::function<void()>)> _execOnUiThreadImplementation;
 	PanelPosition                       _currentPanel = PluginUnknownPanel;
@@ -0,0 +1,276 @@
+#include "cpruningrules.h"
+#include "settings/csettings.h"
+#include "settings.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+RESTORE_COMPILER_WARNINGS
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#if defined _WIN32 || defined __APPLE__
+static constexpr Qt::CaseSensitivity fileNameCaseSensitivity = Qt::CaseInsensitive;
+#else
+static constexpr Qt::CaseSensitivity fileNameCaseSensitivity = Qt::CaseSensitive;
+#endif
+
+static inline bool sameChar(QChar a, QChar b)
+{
+	return a == b || (fileNameCaseSensitivity == Qt::CaseInsensitive && a.toCaseFolded() == b.toCaseFolded());
+}
+
+// [...] set at 'pattern[p]'. Returns the index past the closing bracket, or -1 if the set isn't terminated.
+static qsizetype matchSet(QStringView pattern, qsizetype p, QChar c, bool& match)
+{
+	qsizetype i = p + 1;
+	const bool negated = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+	if (negated)
+		++i;
+
+	match = false;
+	for (bool first = true; i < pattern.size(); first = false)
+	{
+		if (pattern[i] == ']' && !first)
+		{
+			match = match != negated;
+			return i + 1;
+		}
+
+		if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']')
+		{
+			const QChar from = pattern[i], to = pattern[i + 2];
+			match = match || (c >= from && c <= to);
+			if (fileNameCaseSensitivity == Qt::CaseInsensitive)
+				match = match || (c.toCaseFolded() >= from.toCaseFolded() && c.toCaseFolded() <= to.toCaseFolded());
+			i += 3;
+		}
+		else
+		{
+			match = match || sameChar(c, pattern[i]);
+			++i;
+		}
+	}
+
+	return -1;
+}
+
+// The .gitignore flavour of wildcards: '*' and '?' stay within one path component, "**" spans any number of them
+static bool globMatch(QStringView pattern, QStringView text)
+{
+	qsizetype p = 0, t = 0;
+	while (p < pattern.size())
+	{
+		const QChar c = pattern[p];
+		if (c == '*')
+		{
+			if (p + 1 < pattern.size() && pattern[p + 1] == '*')
+			{
+				const qsizetype rest = p + 2;
+				if (rest < pattern.size() && pattern[rest] == '/')
+				{
+					// "**/" - zero or more whole folders
+					for (qsizetype k = t; ; )
+					{
+						if (globMatch(pattern.mid(rest + 1), text.mid(k)))
+							return true;
+
+						const qsizetype slash = text.indexOf('/', k);
+						if (slash < 0)
+							return false;
+						k = slash + 1;
+					}
+				}
+
+				for (qsizetype k = t; k <= text.size(); ++k)
+				{
+					if (globMatch(pattern.mid(rest), text.mid(k)))
+						return true;
+				}
+
+				return false;
+			}
+
+			for (qsizetype k = t; ; ++k)
+			{
+				if (globMatch(pattern.mid(p + 1), text.mid(k)))
+					return true;
+				else if (k == text.size() || text[k] == '/')
+					return false;
+			}
+		}
+
+		if (t == text.size())
+			return false;
+
+		if (c == '?')
+		{
+			if (text[t] == '/')
+				return false;
+		}
+		else if (c == '[')
+		{
+			bool match = false;
+			const qsizetype next = matchSet(pattern, p, text[t], match);
+			if (next >= 0)
+			{
+				if (!match || text[t] == '/')
+					return false;
+
+				p = next;
+				++t;
+				continue;
+			}
+			else if (!sameChar(c, text[t]))
+				return false;
+		}
+		else if (c == '\\' && p + 1 < pattern.size())
+		{
+			if (!sameChar(pattern[++p], text[t]))
+				return false;
+		}
+		else if (!sameChar(c, text[t]))
+			return false;
+
+		++p;
+		++t;
+	}
+
+	return t == text.size();
+}
+
+void CPruningRules::setPatterns(const QStringList& patterns)
+{
+	_rules.clear();
+	for (const QString& line : patterns)
+	{
+		QString pattern = line.trimmed();
+		if (pattern.isEmpty() || pattern.startsWith('#'))
+			continue;
+
+		Rule rule;
+		if (pattern.startsWith('!'))
+		{
+			rule.negated = true;
+			pattern.remove(0, 1);
+		}
+
+		if (pattern.endsWith('/'))
+		{
+			rule.foldersOnly = true;
+			pattern.chop(1);
+		}
+
+		rule.anchored = pattern.contains('/');
+		if (pattern.startsWith('/'))
+			pattern.remove(0, 1);
+
+		if (pattern.isEmpty())
+			continue;
+
+		rule.pattern = pattern;
+		_rules.push_back(std::move(rule));
+	}
+}
+
+void CPruningRules::setMaxDepth(uint32_t maxDepth)
+{
+	_maxDepth = maxDepth;
+}
+
+void CPruningRules::setSameFileSystemOnly(bool sameFileSystemOnly)
+{
+	_sameFileSystemOnly = sameFileSystemOnly;
+}
+
+void CPruningRules::setSkipHidden(bool skipHidden)
+{
+	_skipHidden = skipHidden;
+}
+
+void CPruningRules::setSkipSystem(bool skipSystem)
+{
+	_skipSystem = skipSystem;
+}
+
+bool CPruningRules::sameFileSystemOnly() const
+{
+	return _sameFileSystemOnly;
+}
+
+bool CPruningRules::skipsSystemItems() const
+{
+	return _skipSystem;
+}
+
+bool CPruningRules::isEmpty() const
+{
+	return _rules.empty() && _maxDepth == std::numeric_limits<uint32_t>::max() && !_sameFileSystemOnly && !_skipHidden && !_skipSystem;
+}
+
+bool CPruningRules::excludes(QStringView parentRelativePath, QStringView name, bool isDir, bool isHidden, bool isSystem) const
+{
+	if ((_skipHidden && isHidden) || (_skipSystem && isSystem))
+		return true;
+
+	QString relativePath; // Only built if there's an anchored pattern to match it against
+	bool excluded = false;
+	for (const Rule& rule : _rules)
+	{
+		// A rule that can't change the outcome needn't be matched
+		if ((rule.foldersOnly && !isDir) || excluded != rule.negated)
+			continue;
+
+		if (rule.anchored && relativePath.isEmpty())
+			relativePath = parentRelativePath.toString() + name;
+
+		if (globMatch(rule.pattern, rule.anchored ? QStringView{relativePath} : name))
+			excluded = !rule.negated;
+	}
+
+	return excluded;
+}
+
+bool CPruningRules::descendsInto(uint32_t folderDepth, bool onRootFileSystem) const
+{
+	return folderDepth < _maxDepth && (onRootFileSystem || !_sameFileSystemOnly);
+}
+
+CPruningRules CPruningRules::fromSettings()
+{
+	CSettings s;
+	CPruningRules rules;
+	rules.setPatterns(s.value(KEY_OTHER_SCAN_EXCLUSION_PATTERNS).toStringList());
+	rules.setSameFileSystemOnly(s.value(KEY_OTHER_SCAN_SAME_FILE_SYSTEM_ONLY, false).toBool());
+	rules.setSkipSystem(s.value(KEY_OTHER_SCAN_SKIP_SYSTEM_ITEMS, false).toBool());
+	return rules;
+}
+
+uint64_t CPruningRules::deviceId(const QString& path)
+{
+#ifdef _WIN32
+	(void)path;
+	return 0;
+#else
+	struct stat st;
+	if (::stat(QFile::encodeName(path).constData(), &st) != 0)
+		return 0;
+
+	return static_cast<uint64_t>(st.st_dev);
+#endif
+}
+
+bool CPruningRules::isSystemItem(const QFileInfo& info)
+{
+#ifdef _WIN32
+	const DWORD attributes = ::GetFileAttributesW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(info.absoluteFilePath()).utf16()));
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_SYSTEM) != 0;
+#else
+	return !info.isFile() && !info.isDir() && !info.isSymLink() && info.exists();
+#endif
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QStringList>
+#include <QStringView>
+RESTORE_COMPILER_WARNINGS
+
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+class QFileInfo;
+
+// Decides which parts of a tree a scan skips. The rules are evaluated for every entry before it's reported and before its folder is listed,
+// so an excluded subtree costs nothing beyond reading its name from the parent folder.
+//
+// The patterns follow the .gitignore syntax: '*' and '?' don't match '/', "**" matches any number of folders, a leading '!' re-includes what an earlier pattern
+// excluded, a trailing '/' limits the pattern to folders, and a pattern with a '/' anywhere else is anchored to the scan root instead of matching the name at any level.
+// Blank lines and the lines starting with '#' are ignored. The last matching pattern wins.
+class CPruningRules
+{
+public:
+	void setPatterns(const QStringList& patterns);
+	// Items deeper than 'maxDepth' aren't listed, the scan root being at depth 0
+	void setMaxDepth(uint32_t maxDepth);
+	// Don't enter the folders on a different file system (mount points, /proc and such) than the scan root. The mount point folders themselves are still reported.
+	void setSameFileSystemOnly(bool sameFileSystemOnly);
+	void setSkipHidden(bool skipHidden);
+	// System items: the ones with the system attribute on Windows; FIFOs, sockets and device files elsewhere
+	void setSkipSystem(bool skipSystem);
+
+	bool sameFileSystemOnly() const;
+	bool skipsSystemItems() const;
+	// True if nothing is ever pruned
+	bool isEmpty() const;
+
+	// Whether to skip an item entirely, along with everything inside it. 'parentRelativePath' is the path of the item's folder relative to the scan root,
+	// either empty or ending with a '/'.
+	bool excludes(QStringView parentRelativePath, QStringView name, bool isDir, bool isHidden, bool isSystem) const;
+	// Whether to list the contents of a folder that isn't excluded
+	bool descendsInto(uint32_t folderDepth, bool onRootFileSystem) const;
+
+	// The rules configured in the settings for the interactive scans: the flattened view, searches and size calculations
+	static CPruningRules fromSettings();
+
+	// Helpers for the scanners. The device ID is 0 where it can't be determined.
+	static uint64_t deviceId(const QString& path);
+	static bool isSystemItem(const QFileInfo& info);
+
+private:
+	struct Rule {
+		QString pattern;
+		bool negated = false;
+		bool foldersOnly = false;
+		bool anchored = false; // Matched against the path relative to the root rather than the name
+	};
+
+	std::vector<Rule> _rules;
+	uint32_t _maxDepth = std::numeric_limits<uint32_t>::max();
+	bool _sameFileSystemOnly = false;
+	bool _skipHidden = false;
+	bool _skipSystem = false;
+};
@@ -0,0 +1,202 @@
+#include "coccupiedspacecalculator.h"
+#include "parallelscanner/cparalleldirectoryscanner.h"
+#include "assert/advanced_assert.h"
+#include "threading/thread_helpers.h"
+#include "utility/on_scope_exit.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDebug>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+
+// How often the current item is updated for the user
+static constexpr uint64_t currentItemUpdateIntervalMs = 50;
+
+void COccupiedSpaceCalculator::AtomicStatistics::add(const FilesystemObjectsStatistics& delta) noexcept
+{
+	// Nothing reads these in between the scanner's updates but the snapshots, which don't need them to be consistent with each other
+	if (delta.files != 0)
+		files.fetch_add(delta.files, std::memory_order_relaxed);
+	if (delta.folders != 0)
+		folders.fetch_add(delta.folders, std::memory_order_relaxed);
+	if (delta.occupiedSpace != 0)
+		occupiedSpace.fetch_add(delta.occupiedSpace, std::memory_order_relaxed);
+	if (delta.allocatedSpace != 0)
+		allocatedSpace.fetch_add(delta.allocatedSpace, std::memory_order_relaxed);
+}
+
+FilesystemObjectsStatistics COccupiedSpaceCalculator::AtomicStatistics::load() const noexcept
+{
+	FilesystemObjectsStatistics result(files.load(std::memory_order_relaxed), folders.load(std::memory_order_relaxed), occupiedSpace.load(std::memory_order_relaxed));
+	result.allocatedSpace = allocatedSpace.load(std::memory_order_relaxed);
+	return result;
+}
+
+COccupiedSpaceCalculator::COccupiedSpaceCalculator(std::vector<QString> paths, CPruningRules pruningRules) : _paths(std::move(paths)), _pruningRules(std::move(pruningRules))
+{
+}
+
+COccupiedSpaceCalculator::~COccupiedSpaceCalculator()
+{
+	cancel();
+	if (_thread.joinable())
+		_thread.join();
+}
+
+void COccupiedSpaceCalculator::start()
+{
+	assert_and_return_r(!_thread.joinable(), );
+
+	_timer.start();
+	_thread = std::thread(&COccupiedSpaceCalculator::threadFunc, this);
+}
+
+void COccupiedSpaceCalculator::cancel()
+{
+	_cancelRequested = true;
+}
+
+bool COccupiedSpaceCalculator::finished() const
+{
+	return _finished;
+}
+
+COccupiedSpaceCalculator::Snapshot COccupiedSpaceCalculator::snapshot() const
+{
+	Snapshot result;
+	result.totals = _totals.load();
+	result.hardLinksSkipped = _hardLinksSkipped;
+	{
+		std::lock_guard<std::mutex> lock(_breakdownMutex);
+		result.breakdown.reserve(_breakdown.size());
+		for (const auto& entry: _breakdown)
+		{
+			OccupiedSpaceEntry& resultEntry = result.breakdown.emplace_back();
+			resultEntry.fullPath = entry->fullPath;
+			resultEntry.name = entry->name;
+			resultEntry.stats = entry->stats.load();
+			resultEntry.isDir = entry->isDir;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(_currentItemMutex);
+		result.currentItem = _currentItem;
+	}
+
+	result.finished = _finished;
+	result.cancelled = result.finished && _cancelRequested;
+	result.msElapsed = result.finished ? _msElapsedTotal.load() : _timer.elapsed();
+
+	std::sort(result.breakdown.begin(), result.breakdown.end(), [](const OccupiedSpaceEntry& l, const OccupiedSpaceEntry& r) {
+		return l.stats.occupiedSpace > r.stats.occupiedSpace;
+	});
+
+	return result;
+}
+
+void COccupiedSpaceCalculator::publishCurrentItem(const QString& path)
+{
+	const uint64_t now = _timer.elapsed();
+	uint64_t nextUpdateTime = _nextCurrentItemUpdateTime.load(std::memory_order_relaxed);
+	// Only one of the threads that get here at the same time wins
+	if (now < nextUpdateTime || !_nextCurrentItemUpdateTime.compare_exchange_strong(nextUpdateTime, now + currentItemUpdateIntervalMs))
+		return;
+
+	std::lock_guard<std::mutex> lock(_currentItemMutex);
+	_currentItem = path;
+}
+
+void COccupiedSpaceCalculator::threadFunc()
+{
+	setThreadName("COccupiedSpaceCalculator thread");
+
+	EXEC_ON_SCOPE_EXIT([this]() {
+		_msElapsedTotal = _timer.elapsed();
+		_finished = true;
+	});
+
+	if (_paths.size() == 1)
+	{
+		const ScannedItemInfo rootInfo = CParallelDirectoryScanner::itemInfo(_paths.front());
+		_breakdownByChildren = rootInfo.isDir() && !rootInfo.isSymLink;
+	}
+
+	if (!_breakdownByChildren)
+	{
+		std::lock_guard<std::mutex> lock(_breakdownMutex);
+		for (const QString& path: _paths)
+		{
+			const ScannedItemInfo info = CParallelDirectoryScanner::itemInfo(path);
+			auto entry = std::make_unique<BreakdownEntry>();
+			entry->fullPath = info.fullPath;
+			entry->name = info.name;
+			entry->isDir = info.isDir();
+			_breakdown.push_back(std::move(entry));
+		}
+	}
+
+	CParallelDirectoryScanner scanner;
+	scanner.setPruningRules(_pruningRules);
+	// The token of an item is the breakdown entry it's accounted under
+	scanner.scan(_paths, CParallelDirectoryScanner::TreeItemCallback{[&](const ScannedItemInfo& item, uint64_t parentToken) -> uint64_t {
+		if (item.isDir())
+			publishCurrentItem(item.fullPath);
+
+		FilesystemObjectsStatistics delta;
+		if (item.isDir())
+			delta.folders = 1;
+		else
+		{
+			delta.files = 1;
+
+			// Only the first link to a file occupies space, the rest are merely additional names for the same data
+			bool extraLink = false;
+			if (item.linkCount > 1)
+			{
+				std::lock_guard<std::mutex> lock(_hardLinksMutex);
+				extraLink = !_hardLinkedFilesSeen.emplace(item.deviceId, item.inode).second;
+			}
+
+			if (extraLink)
+				++_hardLinksSkipped;
+			else
+			{
+				delta.occupiedSpace = item.size;
+				delta.allocatedSpace = item.allocatedSize;
+			}
+		}
+
+		_totals.add(delta);
+
+		BreakdownEntry* entry = reinterpret_cast<BreakdownEntry*>(static_cast<uintptr_t>(parentToken));
+		if (item.depth == 0)
+		{
+			if (_breakdownByChildren)
+				return 0; // The examined folder itself
+
+			std::lock_guard<std::mutex> lock(_breakdownMutex);
+			assert_and_return_r(item.rootIndex < _breakdown.size(), 0);
+			entry = _breakdown[item.rootIndex].get();
+		}
+		else if (item.depth == 1 && _breakdownByChildren)
+		{
+			// One of the examined folder's children
+			auto newEntry = std::make_unique<BreakdownEntry>();
+			newEntry->fullPath = item.fullPath;
+			newEntry->name = item.name;
+			newEntry->isDir = item.isDir();
+			entry = newEntry.get();
+
+			std::lock_guard<std::mutex> lock(_breakdownMutex);
+			_breakdown.push_back(std::move(newEntry));
+		}
+
+		assert_and_return_r(entry, 0);
+		entry->stats.add(delta);
+		return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(entry));
+	}}, _cancelRequested);
+
+	const FilesystemObjectsStatistics totals = _totals.load();
+	qInfo() << "COccupiedSpaceCalculator: scanned" << totals.files << "files and" << totals.folders << "folders in" << _timer.elapsed() << "ms";
+}
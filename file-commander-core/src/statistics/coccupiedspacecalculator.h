@@ -0,0 +1,102 @@
+#pragma once
+
+#include "cpanel.h"
+#include "pruningrules/cpruningrules.h"
+#include "system/ctimeelapsed.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Accumulated statistics for one entry of the breakdown list
+struct OccupiedSpaceEntry
+{
+	QString fullPath;
+	QString name;
+	FilesystemObjectsStatistics stats;
+	bool isDir = false;
+};
+
+// Calculates the size of a set of items along with all their subitems on the parallel directory scanner, in the background.
+// The results accumulated so far can be queried at any time with snapshot().
+// Each hard-linked file is only counted once, symbolic links are counted but not followed. The items excluded by 'pruningRules' aren't counted.
+class COccupiedSpaceCalculator
+{
+public:
+	struct Snapshot
+	{
+		FilesystemObjectsStatistics totals;
+		uint64_t hardLinksSkipped = 0; // Number of extra links to files that had already been counted
+		// If a single folder is being examined, the breakdown lists its immediate children, otherwise the items themselves.
+		// Sorted by apparent size, largest first.
+		std::vector<OccupiedSpaceEntry> breakdown;
+		QString currentItem;
+		uint64_t msElapsed = 0;
+		bool finished = false;
+		bool cancelled = false;
+	};
+
+	explicit COccupiedSpaceCalculator(std::vector<QString> paths, CPruningRules pruningRules = CPruningRules{});
+	~COccupiedSpaceCalculator();
+
+	void start();
+	void cancel();
+	bool finished() const;
+
+	Snapshot snapshot() const;
+
+private:
+	// Updated concurrently by all the scanner threads without locking
+	struct AtomicStatistics
+	{
+		std::atomic<uint64_t> files {0};
+		std::atomic<uint64_t> folders {0};
+		std::atomic<uint64_t> occupiedSpace {0};
+		std::atomic<uint64_t> allocatedSpace {0};
+
+		void add(const FilesystemObjectsStatistics& delta) noexcept;
+		FilesystemObjectsStatistics load() const noexcept;
+	};
+
+	struct BreakdownEntry
+	{
+		QString fullPath;
+		QString name;
+		AtomicStatistics stats;
+		bool isDir = false;
+	};
+
+	void threadFunc();
+	// Sets the current item shown to the user every so often rather than for every item scanned
+	void publishCurrentItem(const QString& path);
+
+private:
+	const std::vector<QString> _paths;
+	const CPruningRules _pruningRules;
+	bool _breakdownByChildren = false;
+
+	AtomicStatistics _totals;
+	std::atomic<uint64_t> _hardLinksSkipped {0};
+
+	// Guards the list of the breakdown entries, but not their statistics. The entries never move once created,
+	// so the scanner passes the entry of a folder on to the subitems and only takes the mutex for the examined folder's children.
+	mutable std::mutex _breakdownMutex;
+	std::vector<std::unique_ptr<BreakdownEntry>> _breakdown;
+
+	std::mutex _hardLinksMutex;
+	std::set<std::pair<uint64_t /* device */, uint64_t /* inode */>> _hardLinkedFilesSeen;
+
+	mutable std::mutex _currentItemMutex;
+	QString _currentItem;
+	std::atomic<uint64_t> _nextCurrentItemUpdateTime {0};
+
+	std::atomic<bool> _cancelRequested {false};
+	std::atomic<bool> _finished {false};
+	std::atomic<uint64_t> _msElapsedTotal {0};
+	CTimeElapsed _timer;
+	std::thread _thread;
+};
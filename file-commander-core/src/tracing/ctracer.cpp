@@ -0,0 +1,270 @@
+#include "ctracer.h"
+#include "assert/advanced_assert.h"
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCoreApplication>
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined __linux__ || defined __APPLE__
+#include <pthread.h>
+#endif
+
+std::atomic<bool> CTracer::_enabled {false};
+
+namespace {
+
+struct Span {
+	const char* name;
+	const char* category;
+	uint64_t startTimestamp;
+	uint64_t endTimestamp;
+};
+
+// The spans of one thread. Only the owning thread writes into it, so the mutex is only ever contended by clear() and export.
+// The storage (512 KB) is reserved when the thread records its first span, so that recording never reallocates.
+struct ThreadBuffer {
+	static constexpr size_t Capacity = 16384;
+
+	std::mutex mutex;
+	std::vector<Span> spans;
+	size_t oldestSpan = 0; // Where the next span goes once the buffer is full
+	uint64_t numRecorded = 0; // Including the ones overwritten
+	uint64_t numExported = 0; // 'numRecorded' as of the last export
+	uint32_t threadId = 0;
+	std::string threadName;
+};
+
+struct Registry {
+	// The limit for all the threads together, the short-lived threads included (about 32 MB)
+	static constexpr size_t MaxTotalSpans = 1024 * 1024;
+
+	std::mutex mutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	std::atomic<size_t> totalSpans {0}; // Stored in all the buffers. Only a hint for the recording threads, so it's accessed with relaxed ordering.
+	uint32_t nextThreadId = 1;
+};
+
+Registry& registry()
+{
+	static Registry instance;
+	return instance;
+}
+
+const std::chrono::steady_clock::time_point& epoch()
+{
+	static const auto start = std::chrono::steady_clock::now();
+	return start;
+}
+
+// Only the registry holds on to the buffers of the threads that have exited
+inline bool threadExited(const std::shared_ptr<ThreadBuffer>& buffer)
+{
+	return buffer.use_count() == 1;
+}
+
+inline bool nothingLeftToExport(const ThreadBuffer& buffer)
+{
+	return buffer.spans.empty() || buffer.numRecorded == buffer.numExported;
+}
+
+// Drops the buffers of the exited threads for which 'condition' holds. Must be called with the registry mutex locked.
+template <typename Condition>
+void dropExitedThreadBuffers(Registry& r, Condition&& condition, size_t maxBuffersToDrop = std::numeric_limits<size_t>::max())
+{
+	r.buffers.erase(std::remove_if(r.buffers.begin(), r.buffers.end(), [&](const std::shared_ptr<ThreadBuffer>& buffer) {
+		if (maxBuffersToDrop == 0 || !threadExited(buffer))
+			return false;
+
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+		if (!condition(*buffer))
+			return false;
+
+		r.totalSpans.fetch_sub(buffer->spans.size(), std::memory_order_relaxed);
+		--maxBuffersToDrop;
+		return true;
+	}), r.buffers.end());
+}
+
+// The registry shares the ownership of the buffer so that the spans of a thread outlive the thread itself
+ThreadBuffer& currentThreadBuffer()
+{
+	static thread_local const std::shared_ptr<ThreadBuffer> buffer = [] {
+		auto newBuffer = std::make_shared<ThreadBuffer>();
+		newBuffer->spans.reserve(ThreadBuffer::Capacity);
+
+#if defined __linux__ || defined __APPLE__
+		char name[64] {0};
+		if (::pthread_getname_np(::pthread_self(), name, sizeof(name)) == 0)
+			newBuffer->threadName = name;
+#endif
+
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		// The exited threads that have nothing left to export would otherwise pile up
+		dropExitedThreadBuffers(r, &nothingLeftToExport);
+		// Once all the threads together have reached the limit, the oldest exited thread gives way to the new one
+		if (r.totalSpans.load(std::memory_order_relaxed) >= Registry::MaxTotalSpans)
+			dropExitedThreadBuffers(r, [](const ThreadBuffer& exitedBuffer) {
+				return !exitedBuffer.spans.empty();
+			}, 1);
+
+		newBuffer->threadId = r.nextThreadId++;
+		r.buffers.push_back(newBuffer);
+		return newBuffer;
+	}();
+
+	return *buffer;
+}
+
+void appendJsonString(QByteArray& json, const char* str)
+{
+	json += '"';
+	for (; *str != '\0'; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+			json += '\\';
+
+		if (static_cast<unsigned char>(*str) >= 0x20)
+			json += *str;
+	}
+	json += '"';
+}
+
+}
+
+void CTracer::setEnabled(bool enabled)
+{
+	epoch(); // Starting the clock before the first span is recorded
+	_enabled = enabled;
+}
+
+void CTracer::clear()
+{
+	Registry& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+
+	dropExitedThreadBuffers(r, [](const ThreadBuffer&) {
+		return true;
+	});
+
+	for (const auto& buffer: r.buffers)
+	{
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+		r.totalSpans.fetch_sub(buffer->spans.size(), std::memory_order_relaxed);
+		// The capacity is kept for the live threads to go on recording without reallocating
+		buffer->spans.clear();
+		buffer->oldestSpan = 0;
+		buffer->numExported = buffer->numRecorded;
+	}
+}
+
+bool CTracer::exportChromeTrace(const QString& filePath)
+{
+	const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+
+	QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool firstEvent = true;
+	const auto startEvent = [&json, &firstEvent]() {
+		if (!firstEvent)
+			json += ",\n";
+		firstEvent = false;
+	};
+
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	{
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		buffers = r.buffers;
+	}
+
+	for (const auto& buffer: buffers)
+	{
+		std::vector<Span> spans;
+		std::string threadName;
+		{
+			std::lock_guard<std::mutex> lock(buffer->mutex);
+			spans = buffer->spans;
+			threadName = buffer->threadName;
+			buffer->numExported = buffer->numRecorded;
+		}
+
+		if (spans.empty())
+			continue;
+
+		const QByteArray tid = QByteArray::number(buffer->threadId);
+		if (threadName.empty())
+			threadName = "Thread " + std::to_string(buffer->threadId);
+
+		startEvent();
+		json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"args\":{\"name\":";
+		appendJsonString(json, threadName.c_str());
+		json += "}}";
+
+		for (const Span& span: spans)
+		{
+			startEvent();
+			json += "{\"name\":";
+			appendJsonString(json, span.name);
+			json += ",\"cat\":";
+			appendJsonString(json, span.category);
+			json += ",\"ph\":\"X\",\"ts\":" + QByteArray::number(static_cast<qulonglong>(span.startTimestamp))
+				+ ",\"dur\":" + QByteArray::number(static_cast<qulonglong>(span.endTimestamp - span.startTimestamp))
+				+ ",\"pid\":" + pid + ",\"tid\":" + tid + '}';
+		}
+	}
+
+	json += "\n]}\n";
+
+	// The exited threads that have been written out completely are of no further use
+	buffers.clear();
+	{
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		dropExitedThreadBuffers(r, &nothingLeftToExport);
+	}
+
+	QFile file(filePath);
+	assert_and_return_r(file.open(QFile::WriteOnly | QFile::Truncate), false);
+	return file.write(json) == json.size();
+}
+
+uint64_t CTracer::timestamp() noexcept
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch()).count());
+}
+
+void CTracer::recordSpan(const char* name, const char* category, uint64_t startTimestamp, uint64_t endTimestamp)
+{
+	ThreadBuffer& buffer = currentThreadBuffer();
+	Registry& r = registry();
+
+	// A few threads racing past the limit overshoot it by a span each, which is harmless
+	const bool totalLimitReached = r.totalSpans.load(std::memory_order_relaxed) >= Registry::MaxTotalSpans;
+
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	++buffer.numRecorded;
+
+	const Span span{name, category, startTimestamp, endTimestamp};
+	if (buffer.spans.size() < ThreadBuffer::Capacity && !totalLimitReached)
+	{
+		buffer.spans.push_back(span); // Within the reserved capacity
+		r.totalSpans.fetch_add(1, std::memory_order_relaxed);
+	}
+	else if (!buffer.spans.empty())
+	{
+		// Full: overwriting the oldest span of this thread
+		buffer.spans[buffer.oldestSpan] = span;
+		buffer.oldestSpan = (buffer.oldestSpan + 1) % buffer.spans.size();
+	}
+	// Otherwise the limit was reached before this thread recorded anything, and the span is dropped
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+class QString;
+
+// Records how long the instrumented scopes take on every thread and exports the result in the Chrome trace event format
+// (open it in chrome://tracing or ui.perfetto.dev).
+// Each thread records into its own ring buffer, so the threads never wait for each other; once a buffer is full, its oldest spans are overwritten.
+// The total number of spans kept is limited too: once the limit is reached, the threads only overwrite their own oldest spans.
+// The buffers of the exited threads are dropped once exported, or to make room for a new thread when the limit is reached.
+// Disabled by default. A span created while tracing is disabled costs a single relaxed atomic load.
+class CTracer
+{
+public:
+	static void setEnabled(bool enabled);
+	static bool enabled() noexcept {
+		return _enabled.load(std::memory_order_relaxed);
+	}
+
+	// Discards everything recorded so far
+	static void clear();
+	// Writes out the spans recorded by all the threads, including the ones that have already exited
+	static bool exportChromeTrace(const QString& filePath);
+
+	// Microseconds since the tracer was first used
+	static uint64_t timestamp() noexcept;
+	// 'name' and 'category' must point to the strings that live forever, i. e. string literals.
+	// Only the first span of a thread allocates (the thread's buffer); the rest neither allocate nor take a shared lock.
+	static void recordSpan(const char* name, const char* category, uint64_t startTimestamp, uint64_t endTimestamp);
+
+private:
+	static std::atomic<bool> _enabled;
+};
+
+// Records the time from its construction to its destruction as a span of the calling thread
+class CTraceSpan
+{
+public:
+	// 'name' and 'category' must be string literals
+	inline explicit CTraceSpan(const char* name, const char* category = "core") noexcept :
+		_name{name}, _category{category}, _active{CTracer::enabled()}, _startTimestamp{_active ? CTracer::timestamp() : 0}
+	{}
+
+	inline ~CTraceSpan() {
+		if (_active)
+			CTracer::recordSpan(_name, _category, _startTimestamp, CTracer::timestamp());
+	}
+
+	CTraceSpan(const CTraceSpan&) = delete;
+	CTraceSpan& operator=(const CTraceSpan&) = delete;
+
+private:
+	const char* const _name;
+	const char* const _category;
+	const bool _active;
+	const uint64_t _startTimestamp;
+};
+
+#define TRACE_SCOPE_CONCAT_IMPL(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT_IMPL(a, b)
+
+// Traces the rest of the enclosing scope
+#define TRACE_SCOPE(name) const CTraceSpan TRACE_SCOPE_CONCAT(traceSpan_, __LINE__){name}
+#define TRACE_SCOPE_CATEGORY(name, category) const CTraceSpan TRACE_SCOPE_CONCAT(traceSpan_, __LINE__){name, category}
@@ -1,7 +1,7 @@
 TEMPLATE = subdirs
 
-SUBDIRS += qt_app qtutils text_encoding_detector file_commander_core autoupdater cpputils image-processing cpp-template-utils
-SUBDIRS += textviewerplugin imageviewerplugin filecomparisonplugin
+SUBDIRS += qt_app cli_app qtutils text_encoding_detector file_commander_core autoupdater cpputils image-processing cpp-template-utils
+SUBDIRS += textviewerplugin imageviewerplugin filecomparisonplugin diskusageplugin checksumplugin
 
 qtutils.depends = cpputils
 
@@ -17,7 +17,10 @@ text_encoding_detector.depends = cpputils
 image-processing.depends = cpputils
 
 qt_app.subdir  = qt-app
-qt_app.depends = file_commander_core qtutils imageviewerplugin textviewerplugin autoupdater image-processing filecomparisonplugin
+qt_app.depends = file_commander_core qtutils imageviewerplugin textviewerplugin autoupdater image-processing filecomparisonplugin diskusageplugin checksumplugin
+
+cli_app.subdir = cli-app
+cli_app.depends = file_commander_core qtutils
 
 imageviewerplugin.subdir = plugins/viewer/imageviewer
 imageviewerplugin.depends = file_commander_core
@@ -27,3 +30,9 @@ textviewerplugin.depends = file_commander_core text_encoding_detector
 
 filecomparisonplugin.subdir = plugins/tools/filecomparisonplugin
 filecomparisonplugin.depends = file_commander_core
+
+diskusageplugin.subdir = plugins/tools/diskusageplugin
+diskusageplugin.depends = file_commander_core
+
+checksumplugin.subdir = plugins/tools/checksumplugin
+checksumplugin.depends = file_commander_core
@@ -0,0 +1,105 @@
+#include "cchecksumplugin.h"
+#include "cchecksumwindow.h"
+#include "plugininterface/cpluginproxy.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QMessageBox>
+RESTORE_COMPILER_WARNINGS
+
+CFileCommanderPlugin* createPlugin()
+{
+	return new CChecksumPlugin;
+}
+
+QString CChecksumPlugin::name() const
+{
+	return QObject::tr("Checksum plugin");
+}
+
+void CChecksumPlugin::proxySet()
+{
+	std::vector<CPluginProxy::MenuTree> menu;
+	menu.emplace_back(QObject::tr("Calculate checksums..."), [this]() {
+		calculateForSelection();
+	});
+	menu.emplace_back(QObject::tr("Verify checksums"), [this]() {
+		verifyCurrentManifest();
+	});
+
+	_proxy->createToolMenuEntries(menu);
+}
+
+void CChecksumPlugin::calculateForSelection()
+{
+	const PanelPosition panel = _proxy->currentPanel();
+	const PanelState& state = _proxy->panelState(panel);
+
+	std::vector<QString> paths;
+	for (const qulonglong hash: state.selectedItemsHashes)
+	{
+		const auto it = state.panelContents.find(hash);
+		if (it != state.panelContents.end() && !it->second.isCdUp())
+			paths.push_back(it->second.fullAbsolutePath());
+	}
+
+	if (paths.empty())
+	{
+		const CFileSystemObject& currentItem = _proxy->currentItemForPanel(panel);
+		if (currentItem.exists() && !currentItem.isCdUp())
+			paths.push_back(currentItem.fullAbsolutePath());
+	}
+
+	if (paths.empty())
+	{
+		QMessageBox::information(nullptr, name(), QObject::tr("No files are selected."));
+		return;
+	}
+
+	// The window deletes itself when closed
+	auto* window = new CChecksumWindow(std::move(paths), _proxy->currentFolderPathForPanel(panel));
+	window->show();
+}
+
+void CChecksumPlugin::verifyCurrentManifest()
+{
+	const CFileSystemObject& currentItem = _proxy->currentItemForPanel(_proxy->currentPanel());
+	if (!currentItem.isFile())
+	{
+		QMessageBox::information(nullptr, name(), QObject::tr("Select a checksum file (such as .sha256 or .b3sum) to verify."));
+		return;
+	}
+
+	const QString manifestPath = currentItem.fullAbsolutePath();
+
+	std::vector<ChecksumManifest::Entry> entries;
+	size_t numMalformedLines = 0;
+	QString errorMessage;
+	if (!ChecksumManifest::read(manifestPath, entries, numMalformedLines, errorMessage))
+	{
+		QMessageBox::warning(nullptr, name(), QObject::tr("Failed to read %1:\n%2").arg(manifestPath, errorMessage));
+		return;
+	}
+
+	if (entries.empty())
+	{
+		QMessageBox::information(nullptr, name(), QObject::tr("%1 doesn't contain any checksums.").arg(manifestPath));
+		return;
+	}
+
+	// The extension is the most reliable hint; SHA-256 and BLAKE3 digests can't be told apart by length
+	ChecksumAlgorithm algorithm = ChecksumAlgorithm::SHA256;
+	if (!checksumAlgorithmForManifest(manifestPath, algorithm))
+		checksumAlgorithmForDigestLength(static_cast<size_t>(entries.front().digest.size()) * 2, algorithm);
+
+	if (static_cast<size_t>(entries.front().digest.size()) != checksumDigestLength(algorithm))
+	{
+		QMessageBox::warning(nullptr, name(), QObject::tr("The checksums in %1 don't match the %2 algorithm.").arg(manifestPath, checksumAlgorithmName(algorithm)));
+		return;
+	}
+
+	if (numMalformedLines > 0)
+		QMessageBox::warning(nullptr, name(), QObject::tr("%1 improperly formatted line(s) in %2 will be ignored.").arg(numMalformedLines).arg(manifestPath));
+
+	auto* window = new CChecksumWindow(manifestPath, entries, algorithm);
+	window->show();
+}
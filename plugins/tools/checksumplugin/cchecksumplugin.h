@@ -0,0 +1,17 @@
+#pragma once
+
+#include "plugininterface/cfilecommandertoolplugin.h"
+#include "compiler/compiler_warnings_control.h"
+
+class CChecksumPlugin : public CFileCommanderToolPlugin
+{
+public:
+	QString name() const override;
+
+protected:
+	void proxySet() override;
+
+private:
+	void calculateForSelection();
+	void verifyCurrentManifest();
+};
@@ -0,0 +1,407 @@
+#include "cchecksumcalculator.h"
+#include "hashing/cblake3hasher.h"
+#include "parallelscanner/cparalleldirectoryscanner.h"
+#include "assert/advanced_assert.h"
+#include "threading/thread_helpers.h"
+#include "utility/on_scope_exit.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+RESTORE_COMPILER_WARNINGS
+
+#if defined __linux__ || defined __FreeBSD__
+#include <fcntl.h>
+#endif
+
+#include <algorithm>
+
+namespace {
+
+constexpr size_t ReadBufferSize = 1024 * 1024;
+
+// Every subtree is hashed by one thread in one go. 4 MiB is large enough for the synchronization overhead to be negligible and small enough to keep all the threads busy.
+constexpr uint64_t ChunksPerSubtree = 4096;
+constexpr uint64_t SubtreeLength = ChunksPerSubtree * CBlake3Hasher::ChunkLength;
+// Smaller files are only hashed in parallel with each other
+constexpr uint64_t ParallelHashingThreshold = 64 * 1024 * 1024;
+
+inline void adviseSequentialAccess(QFile& file)
+{
+#if defined __linux__ || defined __FreeBSD__
+	// Lets the kernel read ahead more aggressively
+	::posix_fadvise(file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+	(void)file;
+#endif
+}
+
+// Reads until the buffer is full or the end of the file is reached
+qint64 readFully(QFile& file, char* buffer, qint64 length)
+{
+	qint64 totalRead = 0;
+	while (totalRead < length)
+	{
+		const qint64 bytesRead = file.read(buffer + totalRead, length - totalRead);
+		if (bytesRead < 0)
+			return -1;
+		else if (bytesRead == 0)
+			break;
+
+		totalRead += bytesRead;
+	}
+
+	return totalRead;
+}
+
+}
+
+CChecksumCalculator::CChecksumCalculator(ChecksumAlgorithm algorithm) :
+	_algorithm(algorithm),
+	_numThreads(std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 32))
+{
+}
+
+CChecksumCalculator::~CChecksumCalculator()
+{
+	cancel();
+	if (_thread.joinable())
+		_thread.join();
+}
+
+void CChecksumCalculator::calculate(std::vector<QString> paths, const QString& baseFolder)
+{
+	assert_and_return_r(!_thread.joinable(), );
+
+	_baseFolder = QDir::fromNativeSeparators(baseFolder);
+	if (!_baseFolder.endsWith('/'))
+		_baseFolder += '/';
+
+	_enumerating = true;
+	_timer.start();
+	_thread = std::thread(&CChecksumCalculator::threadFunc, this, std::move(paths));
+}
+
+void CChecksumCalculator::verify(const std::vector<ChecksumManifest::Entry>& entries, const QString& baseFolder)
+{
+	assert_and_return_r(!_thread.joinable(), );
+
+	const QDir baseDir(baseFolder);
+	_items.resize(entries.size());
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		_items[i].result.path = entries[i].path;
+		_items[i].result.expectedDigest = entries[i].digest;
+		_items[i].absolutePath = baseDir.filePath(entries[i].path);
+	}
+
+	_totalFiles = _items.size();
+	_timer.start();
+	_thread = std::thread(&CChecksumCalculator::threadFunc, this, std::vector<QString>{});
+}
+
+void CChecksumCalculator::cancel()
+{
+	_cancelRequested = true;
+}
+
+bool CChecksumCalculator::finished() const
+{
+	return _finished;
+}
+
+ChecksumAlgorithm CChecksumCalculator::algorithm() const
+{
+	return _algorithm;
+}
+
+CChecksumCalculator::Progress CChecksumCalculator::progress() const
+{
+	Progress progress;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		progress.filesDone = _completedItems.size();
+	}
+
+	progress.bytesHashed = _bytesHashed;
+	progress.totalBytes = _totalBytes;
+	progress.totalFiles = _totalFiles;
+	progress.enumerating = _enumerating;
+	progress.finished = _finished;
+	progress.cancelled = progress.finished && _cancelRequested;
+	progress.msElapsed = progress.finished ? _msElapsedTotal.load() : _timer.elapsed();
+	return progress;
+}
+
+std::vector<CChecksumCalculator::Result> CChecksumCalculator::takeCompletedResults()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::vector<Result> results;
+	results.reserve(_completedItems.size() - _numCompletedItemsTaken);
+	for (; _numCompletedItemsTaken < _completedItems.size(); ++_numCompletedItemsTaken)
+		results.push_back(_items[_completedItems[_numCompletedItemsTaken]].result);
+
+	return results;
+}
+
+std::vector<CChecksumCalculator::Result> CChecksumCalculator::results() const
+{
+	assert_r(_finished);
+
+	std::vector<Result> results;
+	results.reserve(_items.size());
+	for (const Item& item: _items)
+		results.push_back(item.result);
+
+	return results;
+}
+
+void CChecksumCalculator::threadFunc(std::vector<QString> pathsToEnumerate)
+{
+	setThreadName("CChecksumCalculator thread");
+
+	EXEC_ON_SCOPE_EXIT([this]() {
+		_msElapsedTotal = _timer.elapsed();
+		_enumerating = false;
+		_finished = true;
+	});
+
+	if (!pathsToEnumerate.empty())
+		enumerateFiles(pathsToEnumerate);
+	else
+	{
+		// Verifying: the sizes are only needed for progress reporting
+		uint64_t totalBytes = 0;
+		for (Item& item: _items)
+		{
+			if (_cancelRequested)
+				return;
+
+			const QFileInfo fileInfo(item.absolutePath);
+			if (fileInfo.isFile())
+				totalBytes += (item.result.size = static_cast<uint64_t>(fileInfo.size()));
+		}
+
+		_totalBytes = totalBytes;
+	}
+
+	_enumerating = false;
+
+	// Large files first, each one hashed by all the threads together
+	if (_algorithm == ChecksumAlgorithm::BLAKE3 && _numThreads > 1)
+	{
+		for (size_t i = 0; i < _items.size() && !_cancelRequested; ++i)
+		{
+			if (_items[i].result.size >= ParallelHashingThreshold)
+			{
+				hashLargeFileParallel(_items[i]);
+				if (_items[i].result.status != Status::Pending)
+					itemCompleted(i);
+			}
+		}
+	}
+
+	// Then everything else, every thread taking the next file
+	std::atomic<size_t> nextItem {0};
+	const auto workerFunc = [&]() {
+		setThreadName("Checksum worker thread");
+
+		std::vector<char> buffer(ReadBufferSize);
+		for (size_t i = nextItem++; i < _items.size() && !_cancelRequested; i = nextItem++)
+		{
+			if (_items[i].result.status != Status::Pending)
+				continue; // Already hashed in parallel
+
+			hashItem(_items[i], buffer);
+			if (_items[i].result.status != Status::Pending) // Not cancelled
+				itemCompleted(i);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(_numThreads);
+	for (size_t i = 0; i < _numThreads; ++i)
+		threads.emplace_back(workerFunc);
+
+	for (auto& thread: threads)
+		thread.join();
+
+	qInfo() << "CChecksumCalculator:" << checksumAlgorithmName(_algorithm) << "of" << _totalFiles.load() << "files," << _bytesHashed.load() << "bytes in" << _timer.elapsed() << "ms";
+}
+
+void CChecksumCalculator::enumerateFiles(const std::vector<QString>& paths)
+{
+	std::mutex itemsMutex;
+	std::vector<Item> items;
+	uint64_t totalBytes = 0;
+
+	CParallelDirectoryScanner().scan(paths, [&](const ScannedItemInfo& info) {
+		if (info.isDir())
+			return;
+
+		// Symbolic links are followed, unless they point to a folder
+		if (info.isSymLink && !QFileInfo(info.fullPath).isFile())
+			return;
+
+		Item item;
+		item.absolutePath = info.fullPath;
+		item.result.path = info.fullPath.startsWith(_baseFolder) ? info.fullPath.mid(_baseFolder.length()) : info.fullPath;
+		item.result.size = info.isSymLink ? static_cast<uint64_t>(QFileInfo(info.fullPath).size()) : info.size;
+
+		std::lock_guard<std::mutex> lock(itemsMutex);
+		totalBytes += item.result.size;
+		items.emplace_back(std::move(item));
+		_totalFiles = items.size();
+		_totalBytes = totalBytes;
+	}, _cancelRequested);
+
+	std::sort(items.begin(), items.end(), [](const Item& l, const Item& r) {
+		return l.result.path < r.result.path;
+	});
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_items = std::move(items);
+}
+
+void CChecksumCalculator::hashItem(Item& item, std::vector<char>& buffer)
+{
+	Result& result = item.result;
+
+	QFile file(item.absolutePath);
+	if (!file.exists())
+	{
+		result.status = Status::Missing;
+		return;
+	}
+
+	if (!file.open(QFile::ReadOnly | QFile::Unbuffered))
+	{
+		result.status = Status::Failed;
+		result.errorMessage = file.errorString();
+		return;
+	}
+
+	adviseSequentialAccess(file);
+
+	const auto hasher = CChecksumHasher::create(_algorithm);
+	for (;;)
+	{
+		if (_cancelRequested)
+			return;
+
+		const qint64 bytesRead = file.read(buffer.data(), static_cast<qint64>(buffer.size()));
+		if (bytesRead < 0)
+		{
+			result.status = Status::Failed;
+			result.errorMessage = file.errorString();
+			return;
+		}
+		else if (bytesRead == 0)
+			break;
+
+		hasher->update(buffer.data(), static_cast<size_t>(bytesRead));
+		_bytesHashed += static_cast<uint64_t>(bytesRead);
+	}
+
+	result.digest = hasher->digest();
+	if (result.expectedDigest.isEmpty())
+		result.status = Status::Calculated;
+	else
+		result.status = result.digest == result.expectedDigest ? Status::Matched : Status::Mismatched;
+}
+
+void CChecksumCalculator::hashLargeFileParallel(Item& item)
+{
+	Result& result = item.result;
+	const uint64_t fileSize = result.size;
+
+	// The last subtree has to be hashed with update() because it may be the root, so it's left out here even if the file size is a multiple of the subtree size
+	const uint64_t numSubtrees = (fileSize - 1) / SubtreeLength;
+	std::vector<CBlake3Hasher::ChainingValue> subtreeCvs(static_cast<size_t>(numSubtrees));
+
+	std::atomic<uint64_t> nextSubtree {0};
+	std::atomic<bool> failed {false};
+	std::mutex errorMutex;
+
+	const auto workerFunc = [&]() {
+		setThreadName("BLAKE3 subtree hashing thread");
+
+		const auto fail = [&](const QString& errorMessage) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!failed.exchange(true))
+				result.errorMessage = errorMessage;
+		};
+
+		QFile file(item.absolutePath);
+		if (!file.open(QFile::ReadOnly | QFile::Unbuffered))
+			return fail(file.errorString());
+
+		adviseSequentialAccess(file);
+
+		std::vector<char> buffer(static_cast<size_t>(SubtreeLength));
+		for (uint64_t i = nextSubtree++; i < numSubtrees && !_cancelRequested && !failed; i = nextSubtree++)
+		{
+			if (!file.seek(static_cast<qint64>(i * SubtreeLength)))
+				return fail(file.errorString());
+
+			const qint64 bytesRead = readFully(file, buffer.data(), static_cast<qint64>(SubtreeLength));
+			if (bytesRead < 0)
+				return fail(file.errorString());
+			else if (static_cast<uint64_t>(bytesRead) != SubtreeLength)
+				return fail(QObject::tr("The file was modified while being read"));
+
+			subtreeCvs[static_cast<size_t>(i)] = CBlake3Hasher::subtreeChainingValue(buffer.data(), buffer.size(), i * ChunksPerSubtree);
+			_bytesHashed += SubtreeLength;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(_numThreads);
+	for (size_t i = 0; i < _numThreads; ++i)
+		threads.emplace_back(workerFunc);
+
+	for (auto& thread: threads)
+		thread.join();
+
+	if (_cancelRequested)
+		return;
+
+	if (failed)
+	{
+		result.status = Status::Failed;
+		return;
+	}
+
+	CBlake3Hasher hasher;
+	for (const auto& cv: subtreeCvs)
+		hasher.pushSubtree(cv, ChunksPerSubtree);
+
+	QFile file(item.absolutePath);
+	const qint64 tailLength = static_cast<qint64>(fileSize - numSubtrees * SubtreeLength);
+	std::vector<char> tail(static_cast<size_t>(tailLength));
+	if (!file.open(QFile::ReadOnly | QFile::Unbuffered) || !file.seek(static_cast<qint64>(numSubtrees * SubtreeLength)) || readFully(file, tail.data(), tailLength) != tailLength)
+	{
+		result.status = Status::Failed;
+		result.errorMessage = file.error() != QFile::NoError ? file.errorString() : QObject::tr("The file was modified while being read");
+		return;
+	}
+
+	hasher.update(tail.data(), tail.size());
+	_bytesHashed += static_cast<uint64_t>(tailLength);
+
+	const auto digest = hasher.finalize();
+	result.digest = QByteArray(reinterpret_cast<const char*>(digest.data()), static_cast<int>(digest.size()));
+	if (result.expectedDigest.isEmpty())
+		result.status = Status::Calculated;
+	else
+		result.status = result.digest == result.expectedDigest ? Status::Matched : Status::Mismatched;
+}
+
+void CChecksumCalculator::itemCompleted(size_t index)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_completedItems.push_back(index);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "checksumalgorithm.h"
+#include "checksummanifest.h"
+#include "system/ctimeelapsed.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Calculates or verifies the checksums of a set of files in the background.
+// Files are hashed in parallel by a pool of threads. Large files hashed with BLAKE3 are additionally split into subtrees that are hashed on all the threads at once,
+// which is what allows a single file to be hashed faster than one core can manage; the other algorithms are inherently sequential.
+class CChecksumCalculator
+{
+public:
+	enum class Status {Pending, Calculated, Matched, Mismatched, Missing, Failed};
+
+	struct Result {
+		QString path; // As listed in the manifest
+		QByteArray digest;
+		QByteArray expectedDigest; // Only when verifying
+		QString errorMessage;
+		uint64_t size = 0;
+		Status status = Status::Pending;
+	};
+
+	struct Progress {
+		uint64_t bytesHashed = 0;
+		uint64_t totalBytes = 0;
+		size_t filesDone = 0;
+		size_t totalFiles = 0;
+		uint64_t msElapsed = 0;
+		bool enumerating = false;
+		bool finished = false;
+		bool cancelled = false;
+	};
+
+	explicit CChecksumCalculator(ChecksumAlgorithm algorithm);
+	~CChecksumCalculator();
+
+	// Hashes the files among 'paths' along with all the files in the folders among them. The result paths are relative to 'baseFolder'.
+	void calculate(std::vector<QString> paths, const QString& baseFolder);
+	// Hashes the files listed in a manifest and compares them to the expected digests. Relative paths are resolved against 'baseFolder'.
+	void verify(const std::vector<ChecksumManifest::Entry>& entries, const QString& baseFolder);
+
+	void cancel();
+	bool finished() const;
+
+	ChecksumAlgorithm algorithm() const;
+	Progress progress() const;
+	// Returns the results completed since the previous call, in the order of completion
+	std::vector<Result> takeCompletedResults();
+	// All the results in their final order. Must only be called once finished() returns true.
+	std::vector<Result> results() const;
+
+private:
+	struct Item {
+		QString absolutePath;
+		Result result;
+	};
+
+	void threadFunc(std::vector<QString> pathsToEnumerate);
+	void enumerateFiles(const std::vector<QString>& paths);
+	void hashItem(Item& item, std::vector<char>& buffer);
+	void hashLargeFileParallel(Item& item);
+	void itemCompleted(size_t index);
+
+private:
+	const ChecksumAlgorithm _algorithm;
+	const size_t _numThreads;
+	QString _baseFolder; // Ends with a '/'
+
+	std::vector<Item> _items;
+	std::vector<size_t> _completedItems; // Indices in the order of completion
+	size_t _numCompletedItemsTaken = 0;
+	mutable std::mutex _mutex;
+
+	std::atomic<uint64_t> _bytesHashed {0};
+	std::atomic<uint64_t> _totalBytes {0};
+	std::atomic<size_t> _totalFiles {0};
+	std::atomic<bool> _enumerating {false};
+	std::atomic<bool> _cancelRequested {false};
+	std::atomic<bool> _finished {false};
+	std::atomic<uint64_t> _msElapsedTotal {0};
+	CTimeElapsed _timer;
+	std::thread _thread;
+};
@@ -0,0 +1,262 @@
+#include "cchecksumwindow.h"
+#include "filesystemhelperfunctions.h"
+#include "settings/csettings.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include "ui_cchecksumwindow.h"
+
+#include <QCloseEvent>
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+
+#define SETTINGS_ALGORITHM "Plugins/Checksum/Algorithm"
+
+namespace {
+
+enum ResultColumn {PathColumn, DigestColumn, StatusColumn, NumColumns};
+
+QString statusText(const CChecksumCalculator::Result& result)
+{
+	switch (result.status)
+	{
+	case CChecksumCalculator::Status::Pending:
+		return QString();
+	case CChecksumCalculator::Status::Calculated:
+		return fileSizeToString(result.size);
+	case CChecksumCalculator::Status::Matched:
+		return QObject::tr("OK");
+	case CChecksumCalculator::Status::Mismatched:
+		return QObject::tr("FAILED");
+	case CChecksumCalculator::Status::Missing:
+		return QObject::tr("Missing");
+	case CChecksumCalculator::Status::Failed:
+		return QObject::tr("Error: %1").arg(result.errorMessage);
+	}
+
+	return QString();
+}
+
+}
+
+CChecksumWindow::CChecksumWindow() :
+	QMainWindow(nullptr),
+	ui(new Ui::CChecksumWindow)
+{
+	ui->setupUi(this);
+
+	setAttribute(Qt::WA_DeleteOnClose, true);
+
+	_statusLabel = new QLabel(this);
+	statusBar()->addWidget(_statusLabel, 1);
+
+	for (const ChecksumAlgorithm algorithm: allChecksumAlgorithms())
+		ui->_cbAlgorithm->addItem(checksumAlgorithmName(algorithm), static_cast<int>(algorithm));
+
+	ui->_results->setColumnCount(NumColumns);
+	ui->_results->setHeaderLabels({tr("File"), tr("Checksum"), tr("Status")});
+	ui->_results->header()->setSectionResizeMode(PathColumn, QHeaderView::Stretch);
+	ui->_results->header()->setSectionResizeMode(DigestColumn, QHeaderView::ResizeToContents);
+	ui->_results->header()->setStretchLastSection(false);
+
+	ui->_btnSaveManifest->setEnabled(false);
+	ui->_btnStop->setEnabled(false);
+	ui->_progress->setRange(0, 1000);
+	ui->_progress->setValue(0);
+
+	connect(ui->_btnStart, &QPushButton::clicked, this, &CChecksumWindow::startCalculation);
+	connect(ui->_btnSaveManifest, &QPushButton::clicked, this, &CChecksumWindow::saveManifest);
+	connect(ui->_btnStop, &QPushButton::clicked, this, [this]() {
+		if (_calculator)
+			_calculator->cancel();
+		ui->_btnStop->setEnabled(false);
+	});
+
+	connect(&_refreshTimer, &QTimer::timeout, this, &CChecksumWindow::refresh);
+}
+
+CChecksumWindow::CChecksumWindow(std::vector<QString> paths, const QString& baseFolder) : CChecksumWindow()
+{
+	_paths = std::move(paths);
+	_baseFolder = baseFolder;
+
+	setWindowTitle(tr("Checksums: %1").arg(toNativeSeparators(baseFolder)));
+
+	const int savedAlgorithm = ui->_cbAlgorithm->findData(CSettings().value(SETTINGS_ALGORITHM, static_cast<int>(ChecksumAlgorithm::SHA256)).toInt());
+	ui->_cbAlgorithm->setCurrentIndex(std::max(savedAlgorithm, 0));
+	_statusLabel->setText(tr("%1 item(s) selected. Pick the algorithm and press \"Calculate\".").arg(_paths.size()));
+}
+
+CChecksumWindow::CChecksumWindow(const QString& manifestPath, const std::vector<ChecksumManifest::Entry>& entries, ChecksumAlgorithm algorithm) : CChecksumWindow()
+{
+	_baseFolder = QFileInfo(manifestPath).absolutePath();
+
+	setWindowTitle(tr("Verifying %1").arg(toNativeSeparators(manifestPath)));
+
+	ui->_cbAlgorithm->setCurrentIndex(ui->_cbAlgorithm->findData(static_cast<int>(algorithm)));
+	ui->_cbAlgorithm->setEnabled(false);
+	ui->_btnStart->setVisible(false);
+	ui->_btnSaveManifest->setVisible(false);
+
+	_calculator = std::make_unique<CChecksumCalculator>(algorithm);
+	_calculator->verify(entries, _baseFolder);
+	ui->_btnStop->setEnabled(true);
+	_refreshTimer.start(200);
+}
+
+CChecksumWindow::~CChecksumWindow()
+{
+	delete ui;
+}
+
+void CChecksumWindow::closeEvent(QCloseEvent* e)
+{
+	if (_calculator)
+		_calculator->cancel();
+
+	QMainWindow::closeEvent(e);
+}
+
+void CChecksumWindow::startCalculation()
+{
+	assert_and_return_r(!_paths.empty(), );
+	if (_calculator && !_calculator->finished())
+		return;
+
+	CSettings().setValue(SETTINGS_ALGORITHM, static_cast<int>(selectedAlgorithm()));
+
+	ui->_results->clear();
+	_numFailed = 0;
+	_numMissing = 0;
+
+	_calculator = std::make_unique<CChecksumCalculator>(selectedAlgorithm());
+	_calculator->calculate(_paths, _baseFolder);
+
+	ui->_btnStart->setEnabled(false);
+	ui->_cbAlgorithm->setEnabled(false);
+	ui->_btnSaveManifest->setEnabled(false);
+	ui->_btnStop->setEnabled(true);
+	_refreshTimer.start(200);
+}
+
+void CChecksumWindow::refresh()
+{
+	assert_and_return_r(_calculator, );
+
+	// Must be checked before taking the results so that none are left behind
+	const bool finished = _calculator->finished();
+
+	QList<QTreeWidgetItem*> newItems;
+	for (const auto& result: _calculator->takeCompletedResults())
+	{
+		auto* item = new QTreeWidgetItem;
+		item->setText(PathColumn, toNativeSeparators(result.path));
+		item->setText(DigestColumn, QString::fromLatin1(result.digest.toHex()));
+		item->setText(StatusColumn, statusText(result));
+
+		if (result.status == CChecksumCalculator::Status::Mismatched)
+			item->setToolTip(DigestColumn, tr("Expected: %1").arg(QString::fromLatin1(result.expectedDigest.toHex())));
+
+		if (result.status == CChecksumCalculator::Status::Mismatched || result.status == CChecksumCalculator::Status::Failed || result.status == CChecksumCalculator::Status::Missing)
+		{
+			for (int column = 0; column < NumColumns; ++column)
+				item->setForeground(column, Qt::red);
+
+			if (result.status == CChecksumCalculator::Status::Missing)
+				++_numMissing;
+			else
+				++_numFailed;
+		}
+
+		newItems.push_back(item);
+	}
+	ui->_results->addTopLevelItems(newItems);
+
+	const auto progress = _calculator->progress();
+	updateStatus(progress);
+
+	if (finished)
+	{
+		_refreshTimer.stop();
+		ui->_btnStop->setEnabled(false);
+		ui->_btnStart->setEnabled(true);
+		ui->_cbAlgorithm->setEnabled(!_paths.empty());
+		ui->_btnSaveManifest->setEnabled(!_paths.empty() && !progress.cancelled && progress.filesDone > 0);
+		ui->_results->sortItems(PathColumn, Qt::AscendingOrder);
+	}
+}
+
+void CChecksumWindow::updateStatus(const CChecksumCalculator::Progress& progress)
+{
+	if (progress.totalBytes > 0)
+		ui->_progress->setValue(static_cast<int>(1000 * progress.bytesHashed / progress.totalBytes));
+	else if (progress.finished)
+		ui->_progress->setValue(ui->_progress->maximum());
+
+	const double seconds = static_cast<double>(progress.msElapsed) / 1000.0;
+	const uint64_t bytesPerSecond = progress.msElapsed > 0 ? progress.bytesHashed * 1000 / progress.msElapsed : 0;
+
+	QString state;
+	if (progress.enumerating)
+		state = tr("Looking for files...");
+	else if (progress.cancelled)
+		state = tr("Cancelled.");
+	else if (progress.finished)
+		state = tr("Done.");
+	else
+		state = tr("Hashing...");
+
+	QString summary = tr("%1 %2 of %3 files, %4 of %5 in %6 s (%7/s)").
+		arg(state).
+		arg(progress.filesDone).
+		arg(progress.totalFiles).
+		arg(fileSizeToString(progress.bytesHashed)).
+		arg(fileSizeToString(progress.totalBytes)).
+		arg(QString::number(seconds, 'f', 1)).
+		arg(fileSizeToString(bytesPerSecond));
+
+	if (_numFailed > 0 || _numMissing > 0)
+		summary += ' ' + tr("%1 failed, %2 missing.").arg(_numFailed).arg(_numMissing);
+
+	_statusLabel->setText(summary);
+}
+
+void CChecksumWindow::saveManifest()
+{
+	assert_and_return_r(_calculator && _calculator->finished(), );
+
+	const ChecksumAlgorithm algorithm = _calculator->algorithm();
+	const QString extension = checksumManifestExtension(algorithm);
+	const QString defaultName = _paths.size() == 1 ? QFileInfo(_paths.front()).fileName() : QDir(_baseFolder).dirName();
+
+	const QString manifestPath = QFileDialog::getSaveFileName(this, tr("Save the checksums"), QDir(_baseFolder).filePath(defaultName + '.' + extension), tr("%1 checksums (*.%2);;All files (*)").arg(checksumAlgorithmName(algorithm), extension));
+	if (manifestPath.isEmpty())
+		return;
+
+	// The paths in a manifest are relative to its own folder
+	const QDir baseDir(_baseFolder);
+	const QDir manifestDir = QFileInfo(manifestPath).absoluteDir();
+
+	std::vector<ChecksumManifest::Entry> entries;
+	for (const auto& result: _calculator->results())
+	{
+		if (result.status == CChecksumCalculator::Status::Calculated)
+			entries.push_back({manifestDir.relativeFilePath(baseDir.absoluteFilePath(result.path)), result.digest});
+	}
+
+	QString errorMessage;
+	if (!ChecksumManifest::write(manifestPath, entries, errorMessage))
+		QMessageBox::warning(this, windowTitle(), tr("Failed to write %1:\n%2").arg(toNativeSeparators(manifestPath), errorMessage));
+}
+
+ChecksumAlgorithm CChecksumWindow::selectedAlgorithm() const
+{
+	return static_cast<ChecksumAlgorithm>(ui->_cbAlgorithm->currentData().toInt());
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "cchecksumcalculator.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QMainWindow>
+#include <QTimer>
+RESTORE_COMPILER_WARNINGS
+
+#include <memory>
+
+namespace Ui {
+class CChecksumWindow;
+}
+
+class QLabel;
+
+class CChecksumWindow : public QMainWindow
+{
+public:
+	// Calculation mode: the user picks the algorithm and starts the calculation
+	CChecksumWindow(std::vector<QString> paths, const QString& baseFolder);
+	// Verification mode: starts verifying the manifest entries right away
+	CChecksumWindow(const QString& manifestPath, const std::vector<ChecksumManifest::Entry>& entries, ChecksumAlgorithm algorithm);
+	~CChecksumWindow();
+
+protected:
+	void closeEvent(QCloseEvent* e) override;
+
+private:
+	CChecksumWindow();
+
+	void startCalculation();
+	void refresh();
+	void updateStatus(const CChecksumCalculator::Progress& progress);
+	void saveManifest();
+
+	ChecksumAlgorithm selectedAlgorithm() const;
+
+private:
+	Ui::CChecksumWindow *ui;
+
+	std::vector<QString> _paths; // Only in calculation mode
+	QString _baseFolder;
+	std::unique_ptr<CChecksumCalculator> _calculator;
+
+	size_t _numFailed = 0;
+	size_t _numMissing = 0;
+
+	QLabel* _statusLabel;
+	QTimer _refreshTimer;
+};
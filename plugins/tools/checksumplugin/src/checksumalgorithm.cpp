@@ -0,0 +1,224 @@
+#include "checksumalgorithm.h"
+#include "hashing/cblake3hasher.h"
+#include "hashing/cxxhash64.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCryptographicHash>
+#include <QFileInfo>
+RESTORE_COMPILER_WARNINGS
+
+namespace {
+
+class CQtHasher final : public CChecksumHasher
+{
+public:
+	explicit CQtHasher(QCryptographicHash::Algorithm algorithm) : _hash(algorithm)
+	{}
+
+	void update(const char* data, size_t length) override
+	{
+		_hash.addData(data, static_cast<int>(length));
+	}
+
+	QByteArray digest() override
+	{
+		return _hash.result();
+	}
+
+private:
+	QCryptographicHash _hash;
+};
+
+class CBlake3ChecksumHasher final : public CChecksumHasher
+{
+public:
+	void update(const char* data, size_t length) override
+	{
+		_hasher.update(data, length);
+	}
+
+	QByteArray digest() override
+	{
+		const auto result = _hasher.finalize();
+		return QByteArray(reinterpret_cast<const char*>(result.data()), static_cast<int>(result.size()));
+	}
+
+private:
+	CBlake3Hasher _hasher;
+};
+
+class CXxHash64ChecksumHasher final : public CChecksumHasher
+{
+public:
+	void update(const char* data, size_t length) override
+	{
+		_hasher.update(data, length);
+	}
+
+	QByteArray digest() override
+	{
+		// Big endian, same as the canonical representation printed by xxhsum
+		const uint64_t value = _hasher.digest();
+		QByteArray result(8, '\0');
+		for (int i = 0; i < 8; ++i)
+			result[i] = static_cast<char>((value >> (56 - 8 * i)) & 0xFFu);
+
+		return result;
+	}
+
+private:
+	CXxHash64 _hasher;
+};
+
+}
+
+const std::vector<ChecksumAlgorithm>& allChecksumAlgorithms()
+{
+	static const std::vector<ChecksumAlgorithm> algorithms {
+		ChecksumAlgorithm::MD5,
+		ChecksumAlgorithm::SHA1,
+		ChecksumAlgorithm::SHA256,
+		ChecksumAlgorithm::SHA512,
+		ChecksumAlgorithm::BLAKE3,
+		ChecksumAlgorithm::XXH64
+	};
+
+	return algorithms;
+}
+
+QString checksumAlgorithmName(ChecksumAlgorithm algorithm)
+{
+	switch (algorithm)
+	{
+	case ChecksumAlgorithm::MD5:
+		return QStringLiteral("MD5");
+	case ChecksumAlgorithm::SHA1:
+		return QStringLiteral("SHA-1");
+	case ChecksumAlgorithm::SHA256:
+		return QStringLiteral("SHA-256");
+	case ChecksumAlgorithm::SHA512:
+		return QStringLiteral("SHA-512");
+	case ChecksumAlgorithm::BLAKE3:
+		return QStringLiteral("BLAKE3");
+	case ChecksumAlgorithm::XXH64:
+		return QStringLiteral("xxHash64");
+	}
+
+	assert_unconditional_r("Unknown checksum algorithm");
+	return QString();
+}
+
+QString checksumManifestExtension(ChecksumAlgorithm algorithm)
+{
+	switch (algorithm)
+	{
+	case ChecksumAlgorithm::MD5:
+		return QStringLiteral("md5");
+	case ChecksumAlgorithm::SHA1:
+		return QStringLiteral("sha1");
+	case ChecksumAlgorithm::SHA256:
+		return QStringLiteral("sha256");
+	case ChecksumAlgorithm::SHA512:
+		return QStringLiteral("sha512");
+	case ChecksumAlgorithm::BLAKE3:
+		return QStringLiteral("b3sum");
+	case ChecksumAlgorithm::XXH64:
+		return QStringLiteral("xxh64");
+	}
+
+	assert_unconditional_r("Unknown checksum algorithm");
+	return QString();
+}
+
+size_t checksumDigestLength(ChecksumAlgorithm algorithm)
+{
+	switch (algorithm)
+	{
+	case ChecksumAlgorithm::MD5:
+		return 16;
+	case ChecksumAlgorithm::SHA1:
+		return 20;
+	case ChecksumAlgorithm::SHA256:
+		return 32;
+	case ChecksumAlgorithm::SHA512:
+		return 64;
+	case ChecksumAlgorithm::BLAKE3:
+		return CBlake3Hasher::DigestLength;
+	case ChecksumAlgorithm::XXH64:
+		return 8;
+	}
+
+	assert_unconditional_r("Unknown checksum algorithm");
+	return 0;
+}
+
+bool checksumAlgorithmForManifest(const QString& manifestPath, ChecksumAlgorithm& algorithm)
+{
+	const QString extension = QFileInfo(manifestPath).suffix().toLower();
+	for (const ChecksumAlgorithm candidate: allChecksumAlgorithms())
+	{
+		if (checksumManifestExtension(candidate) == extension)
+		{
+			algorithm = candidate;
+			return true;
+		}
+	}
+
+	// Common alternative spellings
+	if (extension == QLatin1String("b3"))
+		algorithm = ChecksumAlgorithm::BLAKE3;
+	else if (extension == QLatin1String("xxh"))
+		algorithm = ChecksumAlgorithm::XXH64;
+	else
+		return false;
+
+	return true;
+}
+
+bool checksumAlgorithmForDigestLength(size_t hexDigestLength, ChecksumAlgorithm& algorithm)
+{
+	if (hexDigestLength % 2 != 0)
+		return false;
+
+	switch (hexDigestLength / 2)
+	{
+	case 8:
+		algorithm = ChecksumAlgorithm::XXH64;
+		return true;
+	case 16:
+		algorithm = ChecksumAlgorithm::MD5;
+		return true;
+	case 20:
+		algorithm = ChecksumAlgorithm::SHA1;
+		return true;
+	case 64:
+		algorithm = ChecksumAlgorithm::SHA512;
+		return true;
+	default:
+		// 32 bytes is ambiguous between SHA-256 and BLAKE3
+		return false;
+	}
+}
+
+std::unique_ptr<CChecksumHasher> CChecksumHasher::create(ChecksumAlgorithm algorithm)
+{
+	switch (algorithm)
+	{
+	case ChecksumAlgorithm::MD5:
+		return std::make_unique<CQtHasher>(QCryptographicHash::Md5);
+	case ChecksumAlgorithm::SHA1:
+		return std::make_unique<CQtHasher>(QCryptographicHash::Sha1);
+	case ChecksumAlgorithm::SHA256:
+		return std::make_unique<CQtHasher>(QCryptographicHash::Sha256);
+	case ChecksumAlgorithm::SHA512:
+		return std::make_unique<CQtHasher>(QCryptographicHash::Sha512);
+	case ChecksumAlgorithm::BLAKE3:
+		return std::make_unique<CBlake3ChecksumHasher>();
+	case ChecksumAlgorithm::XXH64:
+		return std::make_unique<CXxHash64ChecksumHasher>();
+	}
+
+	assert_unconditional_r("Unknown checksum algorithm");
+	return nullptr;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <memory>
+#include <stddef.h>
+#include <vector>
+
+enum class ChecksumAlgorithm {
+	MD5,
+	SHA1,
+	SHA256,
+	SHA512,
+	BLAKE3,
+	XXH64
+};
+
+const std::vector<ChecksumAlgorithm>& allChecksumAlgorithms();
+
+QString checksumAlgorithmName(ChecksumAlgorithm algorithm);
+// The extension used by the matching *sum utility for its manifests, e. g. "sha256" or "b3sum"
+QString checksumManifestExtension(ChecksumAlgorithm algorithm);
+size_t checksumDigestLength(ChecksumAlgorithm algorithm);
+
+// Guesses the algorithm of a manifest by its file extension, returns false if the extension isn't recognized
+bool checksumAlgorithmForManifest(const QString& manifestPath, ChecksumAlgorithm& algorithm);
+// Guesses the algorithm by the length of a hex-encoded digest. Only works for the lengths that are unique among the supported algorithms.
+bool checksumAlgorithmForDigestLength(size_t hexDigestLength, ChecksumAlgorithm& algorithm);
+
+// A uniform incremental interface over all the supported algorithms
+class CChecksumHasher
+{
+public:
+	virtual ~CChecksumHasher() = default;
+
+	virtual void update(const char* data, size_t length) = 0;
+	// Can only be called once
+	virtual QByteArray digest() = 0;
+
+	static std::unique_ptr<CChecksumHasher> create(ChecksumAlgorithm algorithm);
+};
@@ -0,0 +1,162 @@
+#include "checksummanifest.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+namespace {
+
+inline bool isHexDigit(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// QByteArray::fromHex() silently skips invalid characters, so the input is validated first
+bool decodeHex(const QByteArray& hex, QByteArray& result)
+{
+	if (hex.isEmpty() || hex.size() % 2 != 0)
+		return false;
+
+	for (const char c: hex)
+	{
+		if (!isHexDigit(c))
+			return false;
+	}
+
+	result = QByteArray::fromHex(hex);
+	return true;
+}
+
+QByteArray unescapePath(const QByteArray& path)
+{
+	QByteArray result;
+	result.reserve(path.size());
+	for (int i = 0; i < path.size(); ++i)
+	{
+		if (path[i] == '\\' && i + 1 < path.size())
+		{
+			if (path[i + 1] == '\\')
+			{
+				result += '\\';
+				++i;
+				continue;
+			}
+			else if (path[i + 1] == 'n')
+			{
+				result += '\n';
+				++i;
+				continue;
+			}
+		}
+
+		result += path[i];
+	}
+
+	return result;
+}
+
+}
+
+QByteArray ChecksumManifest::formatLine(const Entry& entry)
+{
+	QByteArray path = entry.path.toUtf8();
+
+	QByteArray line;
+	if (path.contains('\\') || path.contains('\n'))
+	{
+		line += '\\';
+		path.replace("\\", "\\\\");
+		path.replace("\n", "\\n");
+	}
+
+	line += entry.digest.toHex();
+	line += "  ";
+	line += path;
+	line += '\n';
+	return line;
+}
+
+bool ChecksumManifest::parseLine(const QByteArray& line, Entry& entry)
+{
+	QByteArray text = line;
+	while (text.endsWith('\n') || text.endsWith('\r'))
+		text.chop(1);
+
+	const bool escaped = text.startsWith('\\');
+	if (escaped)
+		text.remove(0, 1);
+
+	QByteArray path;
+	const int digestEnd = text.indexOf(' ');
+	if (digestEnd > 0 && digestEnd + 2 < text.size() && (text[digestEnd + 1] == ' ' || text[digestEnd + 1] == '*') && decodeHex(text.left(digestEnd), entry.digest))
+	{
+		// GNU style; '*' marks binary mode, which makes no difference for us
+		path = text.mid(digestEnd + 2);
+	}
+	else
+	{
+		// BSD style: "SHA256 (path) = digest"
+		const int pathStart = text.indexOf(" (");
+		const int pathEnd = text.lastIndexOf(") = ");
+		if (pathStart <= 0 || pathEnd <= pathStart || !decodeHex(text.mid(pathEnd + 4), entry.digest))
+			return false;
+
+		path = text.mid(pathStart + 2, pathEnd - pathStart - 2);
+	}
+
+	if (path.isEmpty())
+		return false;
+
+	entry.path = QString::fromUtf8(escaped ? unescapePath(path) : path);
+	return true;
+}
+
+bool ChecksumManifest::write(const QString& manifestPath, const std::vector<Entry>& entries, QString& errorMessage)
+{
+	QFile file(manifestPath);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		errorMessage = file.errorString();
+		return false;
+	}
+
+	QByteArray contents;
+	for (const Entry& entry: entries)
+		contents += formatLine(entry);
+
+	if (file.write(contents) != contents.size())
+	{
+		errorMessage = file.errorString();
+		return false;
+	}
+
+	return true;
+}
+
+bool ChecksumManifest::read(const QString& manifestPath, std::vector<Entry>& entries, size_t& numMalformedLines, QString& errorMessage)
+{
+	QFile file(manifestPath);
+	if (!file.open(QFile::ReadOnly))
+	{
+		errorMessage = file.errorString();
+		return false;
+	}
+
+	entries.clear();
+	numMalformedLines = 0;
+
+	const QByteArray contents = file.readAll();
+	for (const QByteArray& line: contents.split('\n'))
+	{
+		if (line.trimmed().isEmpty() || line.startsWith('#'))
+			continue;
+
+		Entry entry;
+		if (parseLine(line, entry))
+			entries.emplace_back(std::move(entry));
+		else
+			++numMalformedLines;
+	}
+
+	return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <vector>
+
+// Reading and writing checksum manifests in the format of the GNU coreutils *sum utilities (also used by b3sum and xxhsum):
+//   <hex digest><space><space or '*'><path>
+// Paths are relative to the folder the manifest is in and use '/' as the separator.
+// A path containing a backslash or a newline is escaped, and its line is prefixed with a '\'.
+// The BSD-style "ALGORITHM (path) = <hex digest>" lines are also accepted when reading.
+namespace ChecksumManifest {
+
+struct Entry {
+	QString path;
+	QByteArray digest; // Raw bytes, not hex
+};
+
+QByteArray formatLine(const Entry& entry);
+// Returns false if the line is not a valid manifest entry. Empty lines and comments must be skipped by the caller.
+bool parseLine(const QByteArray& line, Entry& entry);
+
+bool write(const QString& manifestPath, const std::vector<Entry>& entries, QString& errorMessage);
+// Lines that can't be parsed are counted in 'numMalformedLines' and otherwise ignored
+bool read(const QString& manifestPath, std::vector<Entry>& entries, size_t& numMalformedLines, QString& errorMessage);
+
+}
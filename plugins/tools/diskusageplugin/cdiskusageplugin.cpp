@@ -0,0 +1,40 @@
+#include "cdiskusageplugin.h"
+#include "cdiskusagewindow.h"
+#include "plugininterface/cpluginproxy.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QMessageBox>
+RESTORE_COMPILER_WARNINGS
+
+CFileCommanderPlugin* createPlugin()
+{
+	return new CDiskUsagePlugin;
+}
+
+QString CDiskUsagePlugin::name() const
+{
+	return QObject::tr("Disk usage analyzer plugin");
+}
+
+void CDiskUsagePlugin::proxySet()
+{
+	CPluginProxy::MenuTree menu(QObject::tr("Analyze disk usage"), [this]() {
+		analyzeCurrentFolder();
+	});
+
+	_proxy->createToolMenuEntries(menu);
+}
+
+void CDiskUsagePlugin::analyzeCurrentFolder()
+{
+	const QString folder = _proxy->currentFolderPathForPanel(_proxy->currentPanel());
+	if (folder.isEmpty())
+	{
+		QMessageBox::information(nullptr, name(), QObject::tr("No folder is open in the current panel."));
+		return;
+	}
+
+	// The window deletes itself when closed
+	auto* window = new CDiskUsageWindow(_proxy, folder);
+	window->show();
+}
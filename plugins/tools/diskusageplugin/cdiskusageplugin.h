@@ -0,0 +1,16 @@
+#pragma once
+
+#include "plugininterface/cfilecommandertoolplugin.h"
+#include "compiler/compiler_warnings_control.h"
+
+class CDiskUsagePlugin : public CFileCommanderToolPlugin
+{
+public:
+	QString name() const override;
+
+protected:
+	void proxySet() override;
+
+private:
+	void analyzeCurrentFolder();
+};
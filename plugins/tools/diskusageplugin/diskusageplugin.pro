@@ -0,0 +1,98 @@
+TEMPLATE = lib
+TARGET   = plugin_diskusage
+
+QT = core gui widgets
+CONFIG += strict_c++ c++17
+
+mac* | linux* | freebsd{
+	CONFIG(release, debug|release):CONFIG *= Release optimize_full
+	CONFIG(debug, debug|release):CONFIG *= Debug
+}
+win*{
+	QT += winextras
+}
+
+contains(QT_ARCH, x86_64) {
+	ARCHITECTURE = x64
+} else {
+	ARCHITECTURE = x86
+}
+
+android {
+	Release:OUTPUT_DIR=android/release
+	Debug:OUTPUT_DIR=android/debug
+
+} else:ios {
+	Release:OUTPUT_DIR=ios/release
+	Debug:OUTPUT_DIR=ios/debug
+
+} else {
+	Release:OUTPUT_DIR=release/$${ARCHITECTURE}
+	Debug:OUTPUT_DIR=debug/$${ARCHITECTURE}
+}
+
+DESTDIR  = ../../../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../../../build/$${OUTPUT_DIR}/$${TARGET}
+
+DEFINES += PLUGIN_MODULE
+
+LIBS += -L../../../bin/$${OUTPUT_DIR} -lcore -lqtutils -lcpputils
+
+win*{
+	QMAKE_CXXFLAGS += /MP /Zi /wd4251
+	QMAKE_CXXFLAGS += /std:c++17 /permissive- /Zc:__cplusplus
+	QMAKE_CXXFLAGS_WARN_ON = -W4
+	DEFINES += WIN32_LEAN_AND_MEAN NOMINMAX
+
+	!*msvc2013*:QMAKE_LFLAGS += /DEBUG:FASTLINK
+
+	Debug:QMAKE_LFLAGS += /INCREMENTAL
+	Release:QMAKE_LFLAGS += /OPT:REF /OPT:ICF
+}
+
+linux*|mac*|freebsd{
+	QMAKE_CXXFLAGS += -pedantic-errors
+	QMAKE_CFLAGS += -pedantic-errors
+	QMAKE_CXXFLAGS_WARN_ON = -Wall
+
+	Release:DEFINES += NDEBUG=1
+	Debug:DEFINES += _DEBUG
+}
+
+win32*:!*msvc2012:*msvc* {
+	QMAKE_CXXFLAGS += /FS
+}
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libcore.a
+}
+
+INCLUDEPATH += \
+	../../../file-commander-core/src \
+	../../../file-commander-core/include \
+	../../../qtutils \
+	../../../cpputils \
+	../../../cpp-template-utils \
+	$$PWD/src/
+
+HEADERS += \
+	cdiskusageplugin.h \
+	src/csizetree.h \
+	src/cdiskusagescanner.h \
+	src/treemaplayout.h \
+	src/ctreemapwidget.h \
+	src/cdiskusagewindow.h
+
+SOURCES += \
+	cdiskusageplugin.cpp \
+	src/csizetree.cpp \
+	src/cdiskusagescanner.cpp \
+	src/treemaplayout.cpp \
+	src/ctreemapwidget.cpp \
+	src/cdiskusagewindow.cpp
+
+FORMS += \
+	src/cdiskusagewindow.ui
@@ -0,0 +1,74 @@
+#include "cdiskusagescanner.h"
+#include "parallelscanner/cparalleldirectoryscanner.h"
+#include "assert/advanced_assert.h"
+#include "threading/thread_helpers.h"
+#include "utility/on_scope_exit.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDebug>
+RESTORE_COMPILER_WARNINGS
+
+CDiskUsageScanner::~CDiskUsageScanner()
+{
+	cancel();
+	if (_thread.joinable())
+		_thread.join();
+}
+
+void CDiskUsageScanner::start(const QString& rootPath)
+{
+	assert_and_return_r(!_thread.joinable(), );
+
+	_timer.start();
+	_thread = std::thread(&CDiskUsageScanner::threadFunc, this, rootPath);
+}
+
+void CDiskUsageScanner::cancel()
+{
+	_cancelRequested = true;
+}
+
+bool CDiskUsageScanner::finished() const
+{
+	return _finished;
+}
+
+const CSizeTree& CDiskUsageScanner::tree() const
+{
+	return _tree;
+}
+
+uint64_t CDiskUsageScanner::msElapsed() const
+{
+	return _finished ? _msElapsedTotal.load() : _timer.elapsed();
+}
+
+void CDiskUsageScanner::threadFunc(const QString& rootPath)
+{
+	setThreadName("CDiskUsageScanner thread");
+
+	EXEC_ON_SCOPE_EXIT([this]() {
+		_msElapsedTotal = _timer.elapsed();
+		_finished = true;
+	});
+
+	CParallelDirectoryScanner().scan({rootPath}, [this](const ScannedItemInfo& item, uint64_t parentToken) -> uint64_t {
+		// The space actually taken on the volume is what matters here, not the apparent size
+		uint64_t size = item.isDir() ? 0 : item.allocatedSize;
+		if (size > 0 && item.linkCount > 1)
+		{
+			std::lock_guard<std::mutex> lock(_hardLinksMutex);
+			if (!_hardLinkedFilesSeen.emplace(item.deviceId, item.inode).second)
+				size = 0;
+		}
+
+		if (item.depth == 0)
+			return _tree.addNode(CSizeTree::InvalidNode, item.fullPath, size, item.isDir());
+
+		if (parentToken == CSizeTree::InvalidNode)
+			return CSizeTree::InvalidNode; // The parent couldn't be added
+		return _tree.addNode(static_cast<CSizeTree::NodeIndex>(parentToken), item.name, size, item.isDir());
+	}, _cancelRequested);
+
+	qInfo() << "CDiskUsageScanner:" << _tree.nodeCount() << "items scanned in" << _timer.elapsed() << "ms, the tree takes" << _tree.memoryUsage() / 1024 << "KiB";
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "csizetree.h"
+#include "system/ctimeelapsed.h"
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <utility>
+
+// Fills a CSizeTree for a folder in the background with the parallel directory scanner.
+// The tree can be displayed while the scan is still in progress.
+class CDiskUsageScanner
+{
+public:
+	~CDiskUsageScanner();
+
+	void start(const QString& rootPath);
+	void cancel();
+	bool finished() const;
+
+	const CSizeTree& tree() const;
+	uint64_t msElapsed() const;
+
+private:
+	void threadFunc(const QString& rootPath);
+
+private:
+	CSizeTree _tree;
+
+	// Only the first link to a file is counted
+	std::mutex _hardLinksMutex;
+	std::set<std::pair<uint64_t /* device */, uint64_t /* inode */>> _hardLinkedFilesSeen;
+
+	std::atomic<bool> _cancelRequested {false};
+	std::atomic<bool> _finished {false};
+	std::atomic<uint64_t> _msElapsedTotal {0};
+	CTimeElapsed _timer;
+	std::thread _thread;
+};
@@ -0,0 +1,182 @@
+#include "cdiskusagewindow.h"
+#include "filesystemhelperfunctions.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include "ui_cdiskusagewindow.h"
+
+#include <QCloseEvent>
+#include <QHeaderView>
+#include <QLabel>
+RESTORE_COMPILER_WARNINGS
+
+namespace {
+
+enum ListColumn {NameColumn, SizeColumn, PercentageColumn, FilesColumn, NumColumns};
+
+// Listing millions of items in a single folder would only make the list unusable
+constexpr size_t MaxListRows = 5000;
+
+}
+
+CDiskUsageWindow::CDiskUsageWindow(CPluginProxy* proxy, const QString& rootPath) :
+	QMainWindow(nullptr),
+	ui(new Ui::CDiskUsageWindow),
+	_proxy(proxy),
+	_targetPanel(proxy->currentPanel())
+{
+	ui->setupUi(this);
+
+	setAttribute(Qt::WA_DeleteOnClose, true);
+	setWindowTitle(tr("Disk usage: %1").arg(toNativeSeparators(rootPath)));
+
+	_statusLabel = new QLabel(this);
+	statusBar()->addWidget(_statusLabel, 1);
+
+	ui->_list->setColumnCount(NumColumns);
+	ui->_list->setHeaderLabels({tr("Name"), tr("Size"), tr("%"), tr("Files")});
+	ui->_list->header()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
+	ui->_list->header()->setStretchLastSection(false);
+
+	ui->_treemap->setTree(&_scanner.tree());
+	ui->_treemap->setItemActivatedCallback([this](CSizeTree::NodeIndex node) {
+		activateNode(node);
+	});
+
+	connect(ui->_list, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem* item) {
+		const QVariant nodeData = item->data(NameColumn, Qt::UserRole);
+		if (nodeData.isValid())
+			activateNode(nodeData.value<CSizeTree::NodeIndex>());
+	});
+
+	connect(ui->_btnUp, &QPushButton::clicked, this, &CDiskUsageWindow::goUp);
+	connect(ui->_btnStop, &QPushButton::clicked, this, [this]() {
+		_scanner.cancel();
+		ui->_btnStop->setEnabled(false);
+	});
+
+	connect(&_refreshTimer, &QTimer::timeout, this, &CDiskUsageWindow::refresh);
+	_refreshTimer.start(500);
+
+	_scanner.start(rootPath);
+}
+
+CDiskUsageWindow::~CDiskUsageWindow()
+{
+	delete ui;
+}
+
+void CDiskUsageWindow::closeEvent(QCloseEvent* e)
+{
+	_scanner.cancel();
+	QMainWindow::closeEvent(e);
+}
+
+void CDiskUsageWindow::refresh()
+{
+	const bool finished = _scanner.finished();
+	if (finished)
+	{
+		_refreshTimer.stop();
+		ui->_btnStop->setEnabled(false);
+	}
+
+	if (_currentNode == CSizeTree::InvalidNode)
+	{
+		_currentNode = _scanner.tree().root();
+		ui->_treemap->setRootNode(_currentNode);
+	}
+	else
+		ui->_treemap->refresh();
+
+	refreshList();
+	updateStatus();
+}
+
+void CDiskUsageWindow::refreshList()
+{
+	const CSizeTree& tree = _scanner.tree();
+	if (_currentNode == CSizeTree::InvalidNode)
+		return;
+
+	ui->_lblPath->setText(toNativeSeparators(tree.path(_currentNode)));
+	ui->_btnUp->setEnabled(tree.node(_currentNode).parent != CSizeTree::InvalidNode);
+
+	const auto children = tree.childrenSortedBySize(_currentNode);
+	const uint64_t totalSize = tree.node(_currentNode).size;
+	const bool truncated = children.size() > MaxListRows;
+	const int numRows = static_cast<int>(std::min(children.size(), MaxListRows)) + (truncated ? 1 : 0);
+
+	// The rows are reused rather than re-created so that scrolling doesn't jump around on every update
+	while (ui->_list->topLevelItemCount() > numRows)
+		delete ui->_list->takeTopLevelItem(ui->_list->topLevelItemCount() - 1);
+
+	QList<QTreeWidgetItem*> newItems;
+	for (int i = ui->_list->topLevelItemCount(); i < numRows; ++i)
+	{
+		auto* item = new QTreeWidgetItem;
+		for (int column = SizeColumn; column < NumColumns; ++column)
+			item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+		newItems.push_back(item);
+	}
+	ui->_list->addTopLevelItems(newItems);
+
+	for (int i = 0; i < numRows; ++i)
+	{
+		QTreeWidgetItem* item = ui->_list->topLevelItem(i);
+		if (static_cast<size_t>(i) >= MaxListRows)
+		{
+			item->setText(NameColumn, tr("... %1 more items").arg(children.size() - MaxListRows));
+			item->setData(NameColumn, Qt::UserRole, QVariant());
+			for (int column = SizeColumn; column < NumColumns; ++column)
+				item->setText(column, QString());
+			continue;
+		}
+
+		const auto& child = children[static_cast<size_t>(i)];
+		item->setText(NameColumn, child.isDir ? child.name + '/' : child.name);
+		item->setData(NameColumn, Qt::UserRole, QVariant::fromValue(child.index));
+		item->setText(SizeColumn, fileSizeToString(child.size));
+		item->setText(PercentageColumn, totalSize > 0 ? QString::number(100.0 * static_cast<double>(child.size) / static_cast<double>(totalSize), 'f', 1) : QString());
+		item->setText(FilesColumn, QString::number(child.numFiles));
+	}
+}
+
+void CDiskUsageWindow::updateStatus()
+{
+	const CSizeTree& tree = _scanner.tree();
+	const QString state = _scanner.finished() ? tr("Done") : tr("Scanning...");
+	const uint64_t totalSize = tree.root() != CSizeTree::InvalidNode ? tree.node(tree.root()).size : 0;
+	_statusLabel->setText(tr("%1 %2 items, %3 in %4 s (%5 of memory used)").
+		arg(state).
+		arg(tree.nodeCount()).
+		arg(fileSizeToString(totalSize)).
+		arg(QString::number(static_cast<double>(_scanner.msElapsed()) / 1000.0, 'f', 1)).
+		arg(fileSizeToString(tree.memoryUsage())));
+}
+
+void CDiskUsageWindow::activateNode(CSizeTree::NodeIndex node)
+{
+	const CSizeTree& tree = _scanner.tree();
+	const QString path = tree.path(node);
+	if (tree.node(node).isDir)
+	{
+		_currentNode = node;
+		ui->_treemap->setRootNode(node);
+		ui->_list->clear();
+		refreshList();
+	}
+
+	if (_targetPanel != PluginUnknownPanel)
+		_proxy->navigateTo(_targetPanel, path);
+}
+
+void CDiskUsageWindow::goUp()
+{
+	if (_currentNode == CSizeTree::InvalidNode)
+		return;
+
+	const CSizeTree::NodeIndex parent = _scanner.tree().node(_currentNode).parent;
+	if (parent != CSizeTree::InvalidNode)
+		activateNode(parent);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "cdiskusagescanner.h"
+#include "plugininterface/cpluginproxy.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QMainWindow>
+#include <QTimer>
+RESTORE_COMPILER_WARNINGS
+
+namespace Ui {
+class CDiskUsageWindow;
+}
+
+class QLabel;
+
+class CDiskUsageWindow : public QMainWindow
+{
+public:
+	CDiskUsageWindow(CPluginProxy* proxy, const QString& rootPath);
+	~CDiskUsageWindow();
+
+protected:
+	void closeEvent(QCloseEvent* e) override;
+
+private:
+	void refresh();
+	void refreshList();
+	void updateStatus();
+
+	// Folders are opened both here and in the panel, files are selected in the panel
+	void activateNode(CSizeTree::NodeIndex node);
+	void goUp();
+
+private:
+	Ui::CDiskUsageWindow *ui;
+	CPluginProxy* _proxy;
+	const PanelPosition _targetPanel;
+
+	CDiskUsageScanner _scanner;
+	CSizeTree::NodeIndex _currentNode = CSizeTree::InvalidNode;
+
+	QLabel* _statusLabel;
+	QTimer _refreshTimer;
+};
@@ -0,0 +1,195 @@
+#include "csizetree.h"
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <string.h>
+
+static_assert(sizeof(CSizeTree::Node) == 32, "The node layout is meant to be as compact as possible");
+
+CSizeTree::CSizeTree() : _nodeChunkTable{new std::atomic<StoredNode*>[MaxNodeChunks]}
+{
+	static_assert(sizeof(StoredNode) == sizeof(Node), "The atomics aren't supposed to take any extra space");
+
+	for (size_t i = 0; i < MaxNodeChunks; ++i)
+		_nodeChunkTable[i].store(nullptr, std::memory_order_relaxed);
+}
+
+CSizeTree::NodeIndex CSizeTree::addNode(NodeIndex parent, const QString& name, uint64_t size, bool isDir)
+{
+	const QByteArray utf8Name = name.toUtf8();
+
+	NodeIndex index = InvalidNode;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		assert_and_return_r(_numNodes < InvalidNode, InvalidNode);
+		assert_and_return_r(parent == InvalidNode ? _numNodes == 0 : parent < _numNodes, InvalidNode);
+
+		if (_numNodes % NodesPerChunk == 0)
+		{
+			_nodeChunks.emplace_back(new StoredNode[NodesPerChunk]);
+			_nodeChunkTable[_nodeChunks.size() - 1].store(_nodeChunks.back().get(), std::memory_order_release);
+		}
+
+		index = static_cast<NodeIndex>(_numNodes++);
+		StoredNode& newNode = nodeRef(index);
+		newNode.size.store(size, std::memory_order_relaxed);
+		newNode.numFiles.store(isDir ? 0 : 1, std::memory_order_relaxed);
+		newNode.isDir = isDir ? 1 : 0;
+		newNode.nameOffset = storeName(utf8Name);
+		newNode.parent = parent;
+		newNode.firstChild = InvalidNode;
+		newNode.nextSibling = InvalidNode;
+
+		if (parent != InvalidNode)
+		{
+			StoredNode& parentNode = nodeRef(parent);
+			newNode.nextSibling = parentNode.firstChild;
+			parentNode.firstChild = index;
+		}
+	}
+
+	// Keep the totals of all the ancestors up to date so that the tree can be displayed while it's still being built.
+	// The parent links never change once set, so the walk doesn't need the lock.
+	// There can't be more files than nodes, so the file counters can't overflow.
+	if (!isDir)
+	{
+		for (NodeIndex ancestor = parent; ancestor != InvalidNode; ancestor = nodeRef(ancestor).parent)
+		{
+			StoredNode& ancestorNode = nodeRef(ancestor);
+			ancestorNode.size.fetch_add(size, std::memory_order_relaxed);
+			ancestorNode.numFiles.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	return index;
+}
+
+void CSizeTree::clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (size_t i = 0; i < _nodeChunks.size(); ++i)
+		_nodeChunkTable[i].store(nullptr, std::memory_order_relaxed);
+	_nodeChunks.clear();
+	_namePoolChunks.clear();
+	_numNodes = 0;
+	_namePoolChunkUsed = NamePoolChunkSize;
+}
+
+CSizeTree::NodeIndex CSizeTree::root() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _numNodes > 0 ? 0 : InvalidNode;
+}
+
+CSizeTree::Node CSizeTree::node(NodeIndex index) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	assert_and_return_r(index < _numNodes, Node());
+
+	const StoredNode& storedNode = nodeRef(index);
+	Node result;
+	result.size = storedNode.size.load(std::memory_order_relaxed);
+	result.parent = storedNode.parent;
+	result.firstChild = storedNode.firstChild;
+	result.nextSibling = storedNode.nextSibling;
+	result.nameOffset = storedNode.nameOffset;
+	result.numFiles = storedNode.numFiles.load(std::memory_order_relaxed);
+	result.isDir = storedNode.isDir;
+	return result;
+}
+
+QString CSizeTree::name(NodeIndex index) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	assert_and_return_r(index < _numNodes, QString());
+	return QString::fromUtf8(nameData(nodeRef(index).nameOffset));
+}
+
+QString CSizeTree::path(NodeIndex index) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	assert_and_return_r(index < _numNodes, QString());
+
+	std::vector<const char*> components;
+	for (NodeIndex i = index; i != InvalidNode; i = nodeRef(i).parent)
+		components.push_back(nameData(nodeRef(i).nameOffset));
+
+	QString result = QString::fromUtf8(components.back());
+	for (auto it = components.rbegin() + 1; it != components.rend(); ++it)
+	{
+		if (!result.endsWith('/'))
+			result += '/';
+		result += QString::fromUtf8(*it);
+	}
+
+	return result;
+}
+
+std::vector<CSizeTree::ChildInfo> CSizeTree::childrenSortedBySize(NodeIndex index) const
+{
+	std::vector<ChildInfo> children;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		assert_and_return_r(index < _numNodes, children);
+
+		for (NodeIndex child = nodeRef(index).firstChild; child != InvalidNode; child = nodeRef(child).nextSibling)
+		{
+			const StoredNode& childNode = nodeRef(child);
+			children.push_back({child, QString::fromUtf8(nameData(childNode.nameOffset)), childNode.size.load(std::memory_order_relaxed), childNode.numFiles.load(std::memory_order_relaxed), childNode.isDir != 0});
+		}
+	}
+
+	std::sort(children.begin(), children.end(), [](const ChildInfo& l, const ChildInfo& r) {
+		return l.size > r.size;
+	});
+
+	return children;
+}
+
+size_t CSizeTree::nodeCount() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _numNodes;
+}
+
+size_t CSizeTree::memoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _nodeChunks.size() * NodesPerChunk * sizeof(StoredNode) + _namePoolChunks.size() * NamePoolChunkSize;
+}
+
+inline CSizeTree::StoredNode& CSizeTree::nodeRef(NodeIndex index)
+{
+	return _nodeChunkTable[index / NodesPerChunk].load(std::memory_order_acquire)[index % NodesPerChunk];
+}
+
+inline const CSizeTree::StoredNode& CSizeTree::nodeRef(NodeIndex index) const
+{
+	return _nodeChunkTable[index / NodesPerChunk].load(std::memory_order_acquire)[index % NodesPerChunk];
+}
+
+inline const char* CSizeTree::nameData(uint32_t offset) const
+{
+	return _namePoolChunks[offset / NamePoolChunkSize].get() + offset % NamePoolChunkSize;
+}
+
+// Names never straddle a chunk boundary, the offset is global across all chunks
+uint32_t CSizeTree::storeName(const QByteArray& utf8Name)
+{
+	const size_t length = std::min(static_cast<size_t>(utf8Name.size()), NamePoolChunkSize - 1);
+	if (_namePoolChunkUsed + length + 1 > NamePoolChunkSize)
+	{
+		assert_r((_namePoolChunks.size() + 1) * NamePoolChunkSize <= 0xFFFFFFFFu);
+		_namePoolChunks.emplace_back(new char[NamePoolChunkSize]);
+		_namePoolChunkUsed = 0;
+	}
+
+	char* destination = _namePoolChunks.back().get() + _namePoolChunkUsed;
+	::memcpy(destination, utf8Name.constData(), length);
+	destination[length] = '\0';
+
+	const uint32_t offset = static_cast<uint32_t>((_namePoolChunks.size() - 1) * NamePoolChunkSize + _namePoolChunkUsed);
+	_namePoolChunkUsed += length + 1;
+	return offset;
+}
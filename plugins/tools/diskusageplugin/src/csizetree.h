@@ -0,0 +1,88 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+// A compact tree of item sizes meant to hold tens of millions of items.
+// Every node takes 32 bytes; nodes are stored in fixed-size chunks so that adding one never moves the existing ones.
+// Names (not paths) are stored in a separate UTF-8 pool, the full path is reconstructed by walking up the parents.
+// All the methods are thread-safe. Adding a node only locks the tree to link the node in; the totals of its ancestors are atomic.
+class CSizeTree
+{
+public:
+	using NodeIndex = uint32_t;
+	static constexpr NodeIndex InvalidNode = 0xFFFFFFFFu;
+
+	struct Node {
+		uint64_t size = 0; // Including all the subitems
+		NodeIndex parent = InvalidNode;
+		NodeIndex firstChild = InvalidNode;
+		NodeIndex nextSibling = InvalidNode;
+		uint32_t nameOffset = 0;
+		uint32_t numFiles = 0; // Including all the subitems
+		uint32_t isDir = 0;
+	};
+
+	struct ChildInfo {
+		NodeIndex index;
+		QString name;
+		uint64_t size;
+		uint32_t numFiles;
+		bool isDir;
+	};
+
+	CSizeTree();
+
+	// The first node added (with no parent) is the root; its name should be the full path
+	NodeIndex addNode(NodeIndex parent, const QString& name, uint64_t size, bool isDir);
+	void clear();
+
+	NodeIndex root() const;
+	Node node(NodeIndex index) const;
+	QString name(NodeIndex index) const;
+	QString path(NodeIndex index) const;
+	std::vector<ChildInfo> childrenSortedBySize(NodeIndex index) const;
+
+	size_t nodeCount() const;
+	size_t memoryUsage() const; // Bytes
+
+private:
+	// Same as Node, but the totals are updated without holding the lock
+	struct StoredNode {
+		std::atomic<uint64_t> size {0};
+		NodeIndex parent = InvalidNode;
+		NodeIndex firstChild = InvalidNode;
+		NodeIndex nextSibling = InvalidNode;
+		uint32_t nameOffset = 0;
+		std::atomic<uint32_t> numFiles {0};
+		uint32_t isDir = 0;
+	};
+
+	StoredNode& nodeRef(NodeIndex index);
+	const StoredNode& nodeRef(NodeIndex index) const;
+	const char* nameData(uint32_t offset) const;
+	uint32_t storeName(const QByteArray& utf8Name);
+
+private:
+	static constexpr size_t NodesPerChunk = 64 * 1024;
+	static constexpr size_t MaxNodeChunks = (size_t{InvalidNode} + NodesPerChunk - 1) / NodesPerChunk;
+	static constexpr size_t NamePoolChunkSize = 1024 * 1024;
+
+	std::vector<std::unique_ptr<StoredNode[]>> _nodeChunks;
+	// The same chunks for looking the nodes up without the lock. Has room for all the chunks there can be, so it never moves.
+	const std::unique_ptr<std::atomic<StoredNode*>[]> _nodeChunkTable;
+	std::vector<std::unique_ptr<char[]>> _namePoolChunks;
+	size_t _numNodes = 0;
+	size_t _namePoolChunkUsed = NamePoolChunkSize; // Forces allocating the first chunk
+
+	mutable std::mutex _mutex;
+};
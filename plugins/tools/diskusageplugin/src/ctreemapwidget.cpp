@@ -0,0 +1,150 @@
+#include "ctreemapwidget.h"
+#include "treemaplayout.h"
+#include "filesystemhelperfunctions.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFileInfo>
+#include <QHelpEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+RESTORE_COMPILER_WARNINGS
+
+namespace {
+
+constexpr int MaxDepth = 3;
+constexpr size_t MaxCells = 20000;
+constexpr double MinCellArea = 9.0; // Smaller items are not drawn at all
+constexpr double MinNestedCellSide = 24.0; // Folders smaller than this are drawn as a single cell
+constexpr double FolderHeaderHeight = 14.0;
+constexpr double FolderPadding = 2.0;
+
+QColor cellColor(const QString& name, int depth, bool isDir)
+{
+	if (isDir)
+		return QColor::fromHsv(210, 40, std::max(255 - depth * 30, 120));
+
+	// Files of the same type get the same color
+	const uint hue = qHash(QFileInfo(name).suffix().toLower()) % 360;
+	return QColor::fromHsv(static_cast<int>(hue), 110, 230);
+}
+
+}
+
+CTreemapWidget::CTreemapWidget(QWidget* parent) : QWidget(parent)
+{
+	setMinimumSize(100, 100);
+}
+
+void CTreemapWidget::setTree(const CSizeTree* tree)
+{
+	_tree = tree;
+	refresh();
+}
+
+void CTreemapWidget::setRootNode(CSizeTree::NodeIndex root)
+{
+	_rootNode = root;
+	refresh();
+}
+
+void CTreemapWidget::setItemActivatedCallback(const NodeCallback& callback)
+{
+	_itemActivated = callback;
+}
+
+void CTreemapWidget::refresh()
+{
+	_cells.clear();
+	if (_tree && _rootNode != CSizeTree::InvalidNode)
+		layoutChildren(_rootNode, QRectF(rect()).adjusted(0, 0, -1, -1), 0);
+
+	update();
+}
+
+void CTreemapWidget::layoutChildren(CSizeTree::NodeIndex parent, const QRectF& rect, int depth)
+{
+	const auto children = _tree->childrenSortedBySize(parent);
+
+	std::vector<double> weights;
+	weights.reserve(children.size());
+	for (const auto& child: children)
+		weights.push_back(static_cast<double>(child.size));
+
+	const auto rects = squarifiedLayout(weights, rect);
+	for (size_t i = 0; i < children.size() && _cells.size() < MaxCells; ++i)
+	{
+		const QRectF& childRect = rects[i];
+		if (childRect.width() * childRect.height() < MinCellArea)
+			break; // Sorted by size, so all the remaining ones are even smaller
+
+		const auto& child = children[i];
+		_cells.push_back({childRect, child.index, child.name, child.size, depth, child.isDir});
+
+		if (child.isDir && depth + 1 < MaxDepth && childRect.width() >= MinNestedCellSide && childRect.height() >= MinNestedCellSide + FolderHeaderHeight)
+			layoutChildren(child.index, childRect.adjusted(FolderPadding, FolderHeaderHeight, -FolderPadding, -FolderPadding), depth + 1);
+	}
+}
+
+const CTreemapWidget::Cell* CTreemapWidget::cellAt(const QPointF& pos) const
+{
+	// Children come after their parents, so the last match is the innermost one
+	for (auto it = _cells.rbegin(); it != _cells.rend(); ++it)
+	{
+		if (it->rect.contains(pos))
+			return &*it;
+	}
+
+	return nullptr;
+}
+
+void CTreemapWidget::paintEvent(QPaintEvent*)
+{
+	QPainter painter(this);
+	painter.fillRect(rect(), palette().window());
+
+	const QFontMetrics metrics(font());
+	for (const Cell& cell: _cells)
+	{
+		painter.setPen(palette().color(QPalette::Dark));
+		painter.setBrush(cellColor(cell.name, cell.depth, cell.isDir));
+		painter.drawRect(cell.rect);
+
+		if (cell.rect.width() > 30.0 && cell.rect.height() > metrics.height())
+		{
+			painter.setPen(Qt::black);
+			const QRectF textRect = cell.isDir ? QRectF(cell.rect.left() + 2, cell.rect.top(), cell.rect.width() - 4, FolderHeaderHeight) : cell.rect.adjusted(2, 2, -2, -2);
+			painter.drawText(textRect, Qt::AlignLeft | Qt::AlignTop, metrics.elidedText(cell.name, Qt::ElideRight, static_cast<int>(textRect.width())));
+		}
+	}
+}
+
+void CTreemapWidget::resizeEvent(QResizeEvent* event)
+{
+	QWidget::resizeEvent(event);
+	refresh();
+}
+
+void CTreemapWidget::mouseDoubleClickEvent(QMouseEvent* event)
+{
+	const Cell* cell = cellAt(event->pos());
+	if (cell && _itemActivated)
+		_itemActivated(cell->node);
+}
+
+bool CTreemapWidget::event(QEvent* event)
+{
+	if (event->type() == QEvent::ToolTip)
+	{
+		const auto* helpEvent = static_cast<QHelpEvent*>(event);
+		const Cell* cell = cellAt(helpEvent->pos());
+		if (cell && _tree)
+			QToolTip::showText(helpEvent->globalPos(), toNativeSeparators(_tree->path(cell->node)) + '\n' + fileSizeToString(cell->size), this);
+		else
+			QToolTip::hideText();
+
+		return true;
+	}
+
+	return QWidget::event(event);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "csizetree.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QWidget>
+RESTORE_COMPILER_WARNINGS
+
+#include <functional>
+#include <vector>
+
+class CTreemapWidget : public QWidget
+{
+public:
+	using NodeCallback = std::function<void (CSizeTree::NodeIndex)>;
+
+	explicit CTreemapWidget(QWidget* parent = nullptr);
+
+	void setTree(const CSizeTree* tree);
+	void setRootNode(CSizeTree::NodeIndex root);
+	void setItemActivatedCallback(const NodeCallback& callback);
+
+	// Rebuilds the layout from the current tree contents
+	void refresh();
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+	void resizeEvent(QResizeEvent* event) override;
+	void mouseDoubleClickEvent(QMouseEvent* event) override;
+	bool event(QEvent* event) override;
+
+private:
+	struct Cell {
+		QRectF rect;
+		CSizeTree::NodeIndex node;
+		QString name;
+		uint64_t size;
+		int depth;
+		bool isDir;
+	};
+
+	void layoutChildren(CSizeTree::NodeIndex parent, const QRectF& rect, int depth);
+	const Cell* cellAt(const QPointF& pos) const;
+
+private:
+	const CSizeTree* _tree = nullptr;
+	CSizeTree::NodeIndex _rootNode = CSizeTree::InvalidNode;
+	NodeCallback _itemActivated;
+
+	std::vector<Cell> _cells; // Parents precede their children
+};
@@ -0,0 +1,101 @@
+#include "treemaplayout.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// The worst aspect ratio in a row of items with the given total area laid along a side of the given length
+inline double worstAspectRatio(double rowArea, double minArea, double maxArea, double sideLength)
+{
+	const double sideSquared = sideLength * sideLength;
+	const double rowAreaSquared = rowArea * rowArea;
+	return std::max(sideSquared * maxArea / rowAreaSquared, rowAreaSquared / (sideSquared * minArea));
+}
+
+// Lays out areas[begin, end) along the shorter side of 'remaining' and cuts the occupied strip off
+void layoutRow(const std::vector<double>& areas, size_t begin, size_t end, double rowArea, QRectF& remaining, std::vector<QRectF>& result)
+{
+	if (remaining.width() >= remaining.height())
+	{
+		// A column along the left side
+		const double columnWidth = remaining.height() > 0.0 ? rowArea / remaining.height() : 0.0;
+		double y = remaining.top();
+		for (size_t i = begin; i < end; ++i)
+		{
+			const double height = columnWidth > 0.0 ? areas[i] / columnWidth : 0.0;
+			result[i] = QRectF(remaining.left(), y, columnWidth, height);
+			y += height;
+		}
+
+		remaining.setLeft(remaining.left() + columnWidth);
+	}
+	else
+	{
+		// A row along the top side
+		const double rowHeight = remaining.width() > 0.0 ? rowArea / remaining.width() : 0.0;
+		double x = remaining.left();
+		for (size_t i = begin; i < end; ++i)
+		{
+			const double width = rowHeight > 0.0 ? areas[i] / rowHeight : 0.0;
+			result[i] = QRectF(x, remaining.top(), width, rowHeight);
+			x += width;
+		}
+
+		remaining.setTop(remaining.top() + rowHeight);
+	}
+}
+
+}
+
+std::vector<QRectF> squarifiedLayout(const std::vector<double>& weights, const QRectF& bounds)
+{
+	std::vector<QRectF> result(weights.size());
+
+	const double totalWeight = std::accumulate(weights.begin(), weights.end(), 0.0);
+	if (totalWeight <= 0.0 || bounds.isEmpty())
+		return result;
+
+	// Converting weights to areas in the target rectangle
+	const double scale = bounds.width() * bounds.height() / totalWeight;
+	std::vector<double> areas(weights.size());
+	size_t numItems = 0;
+	for (size_t i = 0; i < weights.size() && weights[i] > 0.0; ++i, ++numItems)
+		areas[i] = weights[i] * scale;
+
+	QRectF remaining = bounds;
+	size_t rowBegin = 0;
+	double rowArea = 0.0, rowMin = 0.0, rowMax = 0.0;
+	for (size_t i = 0; i < numItems;)
+	{
+		const double side = std::min(remaining.width(), remaining.height());
+		const double area = areas[i];
+		if (i == rowBegin)
+		{
+			rowArea = rowMin = rowMax = area;
+			++i;
+			continue;
+		}
+
+		const double currentWorst = worstAspectRatio(rowArea, rowMin, rowMax, side);
+		const double extendedWorst = worstAspectRatio(rowArea + area, std::min(rowMin, area), std::max(rowMax, area), side);
+		if (extendedWorst <= currentWorst)
+		{
+			// Adding the item to the current row doesn't make it worse
+			rowArea += area;
+			rowMin = std::min(rowMin, area);
+			rowMax = std::max(rowMax, area);
+			++i;
+		}
+		else
+		{
+			layoutRow(areas, rowBegin, i, rowArea, remaining, result);
+			rowBegin = i;
+		}
+	}
+
+	if (rowBegin < numItems)
+		layoutRow(areas, rowBegin, numItems, rowArea, remaining, result);
+
+	return result;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QRectF>
+RESTORE_COMPILER_WARNINGS
+
+#include <vector>
+
+// Squarified treemap layout (Bruls, Huizing, van Wijk).
+// 'weights' must be sorted in descending order; returns one rectangle per weight, in the same order.
+// Items with zero weight get an empty rectangle.
+std::vector<QRectF> squarifiedLayout(const std::vector<double>& weights, const QRectF& bounds);
@@ -66,10 +66,15 @@ SOURCES += \
 	src/favoritelocationseditor/cnewfavoritelocationdialog.cpp \
 	src/panel/filelistwidget/cfilelistfilterdialog.cpp \
 	src/filessearchdialog/cfilessearchwindow.cpp \
+	src/filessearchdialog/csearchresultsmodel.cpp \
 	src/progressdialogs/cdeleteprogressdialog.cpp \
+	src/progressdialogs/cchangeattributesdialog.cpp \
 	src/aboutdialog/caboutdialog.cpp \
 	src/progressdialogs/progressdialoghelpers.cpp \
-	src/panel/cpaneldisplaycontroller.cpp
+	src/progressdialogs/coccupiedspacedialog.cpp \
+	src/panel/cpaneldisplaycontroller.cpp \
+	src/operationsdashboard/coperationsdashboard.cpp \
+	src/operationsdashboard/cmetricschart.cpp
 
 HEADERS += \
 	src/cmainwindow.h \
@@ -92,11 +97,16 @@ HEADERS += \
 	src/favoritelocationseditor/cnewfavoritelocationdialog.h \
 	src/panel/filelistwidget/cfilelistfilterdialog.h \
 	src/filessearchdialog/cfilessearchwindow.h \
+	src/filessearchdialog/csearchresultsmodel.h \
 	src/progressdialogs/cdeleteprogressdialog.h \
+	src/progressdialogs/cchangeattributesdialog.h \
 	src/version.h \
 	src/aboutdialog/caboutdialog.h \
 	src/progressdialogs/progressdialoghelpers.h \
-	src/panel/cpaneldisplaycontroller.h
+	src/progressdialogs/coccupiedspacedialog.h \
+	src/panel/cpaneldisplaycontroller.h \
+	src/operationsdashboard/coperationsdashboard.h \
+	src/operationsdashboard/cmetricschart.h
 
 FORMS += \
 	src/cmainwindow.ui \
@@ -113,7 +123,10 @@ FORMS += \
 	src/panel/filelistwidget/cfilelistfilterdialog.ui \
 	src/filessearchdialog/cfilessearchwindow.ui \
 	src/progressdialogs/cdeleteprogressdialog.ui \
-	src/aboutdialog/caboutdialog.ui
+	src/progressdialogs/cchangeattributesdialog.ui \
+	src/aboutdialog/caboutdialog.ui \
+	src/progressdialogs/coccupiedspacedialog.ui \
+	src/operationsdashboard/coperationsdashboard.ui
 
 
 DEFINES += _SCL_SECURE_NO_WARNINGS
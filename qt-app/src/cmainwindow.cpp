@@ -1,8 +1,11 @@
 #include "cmainwindow.h"
 #include "plugininterface/cpluginwindow.h"
 #include "progressdialogs/ccopymovedialog.h"
+#include "progressdialogs/cchangeattributesdialog.h"
 #include "progressdialogs/cdeleteprogressdialog.h"
 #include "progressdialogs/cfileoperationconfirmationprompt.h"
+#include "progressdialogs/coccupiedspacedialog.h"
+#include "operationsdashboard/coperationsdashboard.h"
 #include "settings.h"
 #include "settings/csettings.h"
 #include "shell/cshell.h"
@@ -22,13 +25,16 @@
 #include "widgets/cpersistentwindow.h"
 #include "widgets/widgetutils.h"
 #include "filesystemhelpers/filesystemhelpers.hpp"
+#include "tracing/ctracer.h"
 #include "version.h"
 
 DISABLE_COMPILER_WARNINGS
 #include "ui_cmainwindow.h"
 
+#include <QApplication>
 #include <QCloseEvent>
 #include <QDesktopWidget>
+#include <QDir>
 #include <QFileDialog>
 #include <QFileIconProvider>
 #include <QInputDialog>
@@ -204,6 +210,10 @@ void CMainWindow::initActions()
 	connect(ui->actionShowAllFiles, &QAction::triggered, this, &CMainWindow::showAllFilesFromCurrentFolderAndBelow);
 	connect(ui->action_Settings, &QAction::triggered, this, &CMainWindow::openSettingsDialog);
 	connect(ui->actionCalculate_occupied_space, &QAction::triggered, this, &CMainWindow::calculateOccupiedSpace);
+	connect(ui->actionOperations_dashboard, &QAction::triggered, this, &CMainWindow::openOperationsDashboard);
+	connect(ui->actionSynchronize, &QAction::triggered, this, &CMainWindow::synchronizeSelectedFiles);
+	connect(ui->actionChange_attributes, &QAction::triggered, this, &CMainWindow::changeAttributesOfSelectedFiles);
+	ui->actionChange_attributes->setVisible(CAttributeChanger::supported());
 	connect(ui->actionQuick_view, &QAction::triggered, this, &CMainWindow::toggleQuickView);
 
 	connect(ui->action_Invert_selection, &QAction::triggered, this, &CMainWindow::invertSelection);
@@ -211,6 +221,7 @@ void CMainWindow::initActions()
 	connect(ui->actionFull_screen_mode, &QAction::toggled, this, &CMainWindow::toggleFullScreenMode);
 	connect(ui->actionTablet_mode, &QAction::toggled, this, &CMainWindow::toggleTabletMode);
 
+	connect(ui->actionRecord_performance_trace, &QAction::toggled, this, &CMainWindow::togglePerformanceTracing);
 	connect(ui->action_Check_for_updates, &QAction::triggered, this, &CMainWindow::checkForUpdates);
 	connect(ui->actionAbout, &QAction::triggered, this, &CMainWindow::about);
 }
@@ -232,13 +243,20 @@ bool CMainWindow::copyFiles(std::vector<CFileSystemObject>&& files, const QStrin
 
 	const QString destPath = files.size() == 1 && files.front().isFile() ? cleanPath(destDir % nativeSeparator() % files.front().fullName()) : destDir;
 	CFileOperationConfirmationPrompt prompt(tr("Copy files"), tr("Copy %1 %2 to").arg(files.size()).arg(files.size() > 1 ? "files" : "file"), toNativeSeparators(destPath), this);
+	prompt.setCacheNeutralCopying(CSettings().value(KEY_OPERATIONS_CACHE_NEUTRAL_COPYING, false).toBool());
+	prompt.setPreserveLinks(CSettings().value(KEY_OPERATIONS_PRESERVE_LINKS, false).toBool());
+	prompt.setDeltaTransfer(CSettings().value(KEY_OPERATIONS_DELTA_TRANSFER, false).toBool());
 	if (CSettings().value(KEY_OPERATIONS_ASK_FOR_COPY_MOVE_CONFIRMATION, true).toBool())
 	{
 		if (prompt.exec() != QDialog::Accepted)
 			return false;
+
+		CSettings().setValue(KEY_OPERATIONS_CACHE_NEUTRAL_COPYING, prompt.cacheNeutralCopying());
+		CSettings().setValue(KEY_OPERATIONS_PRESERVE_LINKS, prompt.preserveLinks());
+		CSettings().setValue(KEY_OPERATIONS_DELTA_TRANSFER, prompt.deltaTransfer());
 	}
 
-	CCopyMoveDialog * dialog = new CCopyMoveDialog(operationCopy, std::move(files), toPosixSeparators(prompt.text()), this);
+	CCopyMoveDialog * dialog = new CCopyMoveDialog(operationCopy, std::move(files), toPosixSeparators(prompt.text()), this, prompt.cacheNeutralCopying(), prompt.preserveLinks(), prompt.deltaTransfer());
 	connect(this, &CMainWindow::closed, dialog, &CCopyMoveDialog::deleteLater);
 	dialog->show();
 
@@ -255,13 +273,20 @@ bool CMainWindow::moveFiles(std::vector<CFileSystemObject>&& files, const QStrin
 	activateWindow();
 
 	CFileOperationConfirmationPrompt prompt(tr("Move files"), tr("Move %1 %2 to").arg(files.size()).arg(files.size() > 1 ? "files" : "file"), toNativeSeparators(destDir), this);
+	prompt.setCacheNeutralCopying(CSettings().value(KEY_OPERATIONS_CACHE_NEUTRAL_COPYING, false).toBool());
+	prompt.setPreserveLinks(CSettings().value(KEY_OPERATIONS_PRESERVE_LINKS, false).toBool());
+	prompt.setDeltaTransfer(CSettings().value(KEY_OPERATIONS_DELTA_TRANSFER, false).toBool());
 	if (CSettings().value(KEY_OPERATIONS_ASK_FOR_COPY_MOVE_CONFIRMATION, true).toBool())
 	{
 		if (prompt.exec() != QDialog::Accepted)
 			return false;
+
+		CSettings().setValue(KEY_OPERATIONS_CACHE_NEUTRAL_COPYING, prompt.cacheNeutralCopying());
+		CSettings().setValue(KEY_OPERATIONS_PRESERVE_LINKS, prompt.preserveLinks());
+		CSettings().setValue(KEY_OPERATIONS_DELTA_TRANSFER, prompt.deltaTransfer());
 	}
 
-	CCopyMoveDialog * dialog = new CCopyMoveDialog(operationMove, std::move(files), toPosixSeparators(prompt.text()), this);
+	CCopyMoveDialog * dialog = new CCopyMoveDialog(operationMove, std::move(files), toPosixSeparators(prompt.text()), this, prompt.cacheNeutralCopying(), prompt.preserveLinks(), prompt.deltaTransfer());
 	connect(this, &CMainWindow::closed, dialog, &CCopyMoveDialog::deleteLater);
 	dialog->show();
 
@@ -285,6 +310,25 @@ void CMainWindow::closeEvent(QCloseEvent *e)
 	QMainWindow::closeEvent(e);
 }
 
+void CMainWindow::changeEvent(QEvent* e)
+{
+	QMainWindow::changeEvent(e);
+	if (e->type() == QEvent::WindowStateChange)
+		updateActivityState();
+}
+
+void CMainWindow::showEvent(QShowEvent* e)
+{
+	QMainWindow::showEvent(e);
+	updateActivityState();
+}
+
+void CMainWindow::hideEvent(QHideEvent* e)
+{
+	QMainWindow::hideEvent(e);
+	updateActivityState();
+}
+
 bool CMainWindow::eventFilter(QObject *watched, QEvent *event)
 {
 	if (watched == ui->_commandLine && event->type() == QEvent::KeyPress)
@@ -350,6 +394,27 @@ void CMainWindow::uiThreadTimerTick()
 		_controller->uiThreadTimerTick();
 }
 
+void CMainWindow::updateActivityState()
+{
+	if (!_controller)
+		return;
+
+	ActivityState state = ActivityState::Foreground;
+	if (isMinimized() || !isVisible())
+		state = ActivityState::Suspended;
+	else if (QApplication::applicationState() != Qt::ApplicationActive)
+		state = ActivityState::Background;
+
+	if (state == _controller->activityState())
+		return;
+
+	_controller->setActivityState(state);
+
+	// The UI queue still has to be drained while minimized: the search and the plugin windows get their results through it
+	static constexpr int uiTimerPeriodMs[] {5, 20, 100};
+	_uiThreadTimer.setInterval(uiTimerPeriodMs[static_cast<int>(state)]);
+}
+
 // Window title management (#143)
 void CMainWindow::updateWindowTitleWithCurrentFolderNames()
 {
@@ -395,6 +460,67 @@ void CMainWindow::moveSelectedFiles()
 		moveFiles(_controller->items(_currentFileList->panelPosition(), _currentFileList->selectedItemsHashes()), _otherFileList->currentDirPathNative());
 }
 
+void CMainWindow::synchronizeSelectedFiles()
+{
+	if (!_currentFileList || !_otherFileList)
+		return;
+
+	std::vector<CFileSystemObject> files = _controller->items(_currentFileList->panelPosition(), _currentFileList->selectedItemsHashes());
+	const QString destDir = _otherFileList->currentDirPathNative();
+	if (files.empty() || destDir.isEmpty())
+		return;
+
+	SyncOptions syncOptions;
+	syncOptions.deleteExtraneous = CSettings().value(KEY_OPERATIONS_SYNC_DELETE_EXTRANEOUS, false).toBool();
+	syncOptions.compareContents = CSettings().value(KEY_OPERATIONS_SYNC_COMPARE_CONTENTS, false).toBool();
+
+	// The options have to be chosen every time, so the prompt is shown regardless of KEY_OPERATIONS_ASK_FOR_COPY_MOVE_CONFIRMATION
+	CFileOperationConfirmationPrompt prompt(tr("Synchronize files"), tr("Synchronize %1 %2 with").arg(files.size()).arg(files.size() > 1 ? "items" : "item"), toNativeSeparators(destDir), this);
+	prompt.setCacheNeutralCopying(CSettings().value(KEY_OPERATIONS_CACHE_NEUTRAL_COPYING, false).toBool());
+	prompt.setPreserveLinks(CSettings().value(KEY_OPERATIONS_PRESERVE_LINKS, false).toBool());
+	prompt.setDeltaTransfer(CSettings().value(KEY_OPERATIONS_DELTA_TRANSFER, false).toBool());
+	prompt.setSyncOptions(syncOptions);
+	if (prompt.exec() != QDialog::Accepted)
+		return;
+
+	CSettings().setValue(KEY_OPERATIONS_CACHE_NEUTRAL_COPYING, prompt.cacheNeutralCopying());
+	CSettings().setValue(KEY_OPERATIONS_PRESERVE_LINKS, prompt.preserveLinks());
+	CSettings().setValue(KEY_OPERATIONS_DELTA_TRANSFER, prompt.deltaTransfer());
+	syncOptions = prompt.syncOptions();
+	CSettings().setValue(KEY_OPERATIONS_SYNC_DELETE_EXTRANEOUS, syncOptions.deleteExtraneous);
+	CSettings().setValue(KEY_OPERATIONS_SYNC_COMPARE_CONTENTS, syncOptions.compareContents);
+
+	// Nothing is changed until the user has seen and confirmed the results of the dry run
+	syncOptions.dryRun = true;
+	CCopyMoveDialog * dialog = new CCopyMoveDialog(operationSync, std::move(files), toPosixSeparators(prompt.text()), this, prompt.cacheNeutralCopying(), prompt.preserveLinks(), prompt.deltaTransfer(), syncOptions);
+	connect(this, &CMainWindow::closed, dialog, &CCopyMoveDialog::deleteLater);
+	dialog->show();
+}
+
+void CMainWindow::changeAttributesOfSelectedFiles()
+{
+	if (!_currentFileList)
+		return;
+
+	std::vector<CFileSystemObject> items;
+	for (auto&& item: _controller->items(_currentFileList->panelPosition(), _currentFileList->selectedItemsHashes()))
+	{
+		if (item.exists() && !item.isCdUp())
+			items.push_back(std::move(item));
+	}
+
+	if (items.empty())
+		return;
+
+	CChangeAttributesDialog attributesDialog(tr("Change the attributes of %1 %2 and their contents:").arg(items.size()).arg(items.size() > 1 ? "items" : "item"), this);
+	if (attributesDialog.exec() != QDialog::Accepted)
+		return;
+
+	CDeleteProgressDialog * dialog = new CDeleteProgressDialog(std::move(items), attributesDialog.attributeChange(), this);
+	connect(this, &CMainWindow::closed, dialog, &CDeleteProgressDialog::deleteLater);
+	dialog->show();
+}
+
 void CMainWindow::deleteFiles()
 {
 	if (!_currentFileList)
@@ -707,12 +833,45 @@ void CMainWindow::calculateOccupiedSpace()
 	if (!_currentFileList)
 		return;
 
-	const FilesystemObjectsStatistics stats = _controller->calculateStatistics(_currentFileList->panelPosition(), _currentFileList->selectedItemsHashes());
-	if (stats.empty())
+	std::vector<QString> paths;
+	for (const CFileSystemObject& item: _controller->items(_currentFileList->panelPosition(), _currentFileList->selectedItemsHashes()))
+	{
+		if (item.exists() && !item.isCdUp())
+			paths.push_back(item.fullAbsolutePath());
+	}
+
+	if (paths.empty())
+		return;
+
+	// The dialog deletes itself when closed
+	auto* dialog = new COccupiedSpaceDialog(std::move(paths), this);
+	dialog->show();
+}
+
+void CMainWindow::openOperationsDashboard()
+{
+	// The dashboard deletes itself when closed
+	auto* dashboard = new COperationsDashboard(this);
+	dashboard->show();
+}
+
+// Recording starts afresh every time; once stopped, the trace is saved in the Chrome trace format
+void CMainWindow::togglePerformanceTracing(bool enabled)
+{
+	if (enabled)
+	{
+		CTracer::clear();
+		CTracer::setEnabled(true);
+		return;
+	}
+
+	CTracer::setEnabled(false);
+	const QString path = QFileDialog::getSaveFileName(this, tr("Save the performance trace"), QDir::homePath() + "/file-commander-trace.json", tr("Chrome trace (*.json)"));
+	if (path.isEmpty())
 		return;
 
-	QMessageBox::information(this, tr("Occupied space"), tr("Statistics for the selected items(including subitems):\nFiles: %1\nFolders: %2\nOccupied space: %3").
-		arg(stats.files).arg(stats.folders).arg(fileSizeToString(stats.occupiedSpace)));
+	if (!CTracer::exportChromeTrace(path))
+		QMessageBox::warning(this, tr("Failed to save the trace"), tr("Couldn't write the trace to %1").arg(QDir::toNativeSeparators(path)));
 }
 
 void CMainWindow::checkForUpdates()
@@ -808,6 +967,9 @@ void CMainWindow::initCore()
 
 	connect(&_uiThreadTimer, &QTimer::timeout, this, &CMainWindow::uiThreadTimerTick);
 	_uiThreadTimer.start(5);
+
+	// Another application has been activated, or this one is back
+	connect(qApp, &QGuiApplication::applicationStateChanged, this, &CMainWindow::updateActivityState);
 }
 
 void CMainWindow::createToolMenuEntries(const std::vector<CPluginProxy::MenuTree>& menuEntries)
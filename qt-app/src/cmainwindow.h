@@ -55,6 +55,9 @@ signals:
 protected:
 	void closeEvent(QCloseEvent * e) override;
 	bool eventFilter(QObject *watched, QEvent *event) override;
+	void changeEvent(QEvent* e) override;
+	void showEvent(QShowEvent* e) override;
+	void hideEvent(QHideEvent* e) override;
 
 private slots: // UI slots
 	void itemActivated(qulonglong hash, CPanelWidget * panel);
@@ -63,6 +66,8 @@ private slots: // UI slots
 // File operations UI slots
 	void copySelectedFiles();
 	void moveSelectedFiles();
+	void synchronizeSelectedFiles();
+	void changeAttributesOfSelectedFiles();
 	void deleteFiles();
 	void deleteFilesIrrevocably();
 	void createFolder();
@@ -96,6 +101,8 @@ private slots: // UI slots
 	void showAllFilesFromCurrentFolderAndBelow();
 	void openSettingsDialog();
 	void calculateOccupiedSpace();
+	void openOperationsDashboard();
+	void togglePerformanceTracing(bool enabled);
 	void checkForUpdates();
 	void about();
 
@@ -129,6 +136,8 @@ private:
 
 	// Timer
 	void uiThreadTimerTick();
+	// Tells the core whether the window can be seen and is in use, see ActivityState
+	void updateActivityState();
 
 	// Window title management (#143)
 	void updateWindowTitleWithCurrentFolderNames();
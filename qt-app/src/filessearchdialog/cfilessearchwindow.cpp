@@ -9,7 +9,9 @@
 DISABLE_COMPILER_WARNINGS
 #include "ui_cfilessearchwindow.h"
 
+#include <QDateTime>
 #include <QDebug>
+#include <QHeaderView>
 #include <QLineEdit>
 RESTORE_COMPILER_WARNINGS
 
@@ -18,6 +20,12 @@ RESTORE_COMPILER_WARNINGS
 #define SETTINGS_CONTENTS_TO_FIND        "FileSearchDialog/Ui/ContentsToFind"
 #define SETTINGS_CONTENTS_CASE_SENSITIVE "FileSearchDialog/Ui/CaseSensitiveContents"
 #define SETTINGS_ROOT_FOLDER             "FileSearchDialog/Ui/RootFolder"
+#define SETTINGS_ITEM_TYPES              "FileSearchDialog/Ui/ItemTypes"
+#define SETTINGS_MIN_SIZE_MB             "FileSearchDialog/Ui/MinSizeMb"
+#define SETTINGS_MAX_SIZE_MB             "FileSearchDialog/Ui/MaxSizeMb"
+#define SETTINGS_MODIFIED_WITHIN_DAYS    "FileSearchDialog/Ui/ModifiedWithinDays"
+
+enum ItemTypesFilter {FilesAndFolders, FilesOnly, FoldersOnly};
 
 CFilesSearchWindow::CFilesSearchWindow(const std::vector<QString>& targets) :
 	QMainWindow(nullptr),
@@ -49,6 +57,10 @@ CFilesSearchWindow::CFilesSearchWindow(const std::vector<QString>& targets) :
 	CSettings s;
 	ui->cbNameCaseSensitive->setChecked(s.value(SETTINGS_NAME_CASE_SENSITIVE, false).toBool());
 	ui->cbContentsCaseSensitive->setChecked(s.value(SETTINGS_CONTENTS_CASE_SENSITIVE, false).toBool());
+	ui->itemTypes->setCurrentIndex(s.value(SETTINGS_ITEM_TYPES, FilesAndFolders).toInt());
+	ui->minSizeMb->setValue(s.value(SETTINGS_MIN_SIZE_MB, 0).toInt());
+	ui->maxSizeMb->setValue(s.value(SETTINGS_MAX_SIZE_MB, 0).toInt());
+	ui->modifiedWithinDays->setValue(s.value(SETTINGS_MODIFIED_WITHIN_DAYS, 0).toInt());
 
 	connect(ui->nameToFind, &CHistoryComboBox::itemActivated, ui->btnSearch, &QPushButton::click);
 	connect(ui->fileContentsToFind, &CHistoryComboBox::itemActivated, ui->btnSearch, &QPushButton::click);
@@ -60,11 +72,21 @@ CFilesSearchWindow::CFilesSearchWindow(const std::vector<QString>& targets) :
 	statusBar()->addWidget(_progressLabel, 1);
 	statusBar()->setSizePolicy(QSizePolicy::Ignored, statusBar()->sizePolicy().verticalPolicy());
 
-	connect(ui->resultsList, &QListWidget::itemActivated, [](QListWidgetItem* item){
-		CController::get().activePanel().goToItem(CFileSystemObject(item->data(Qt::UserRole).toString()));
+	ui->resultsList->setModel(&_resultsModel);
+	// No sort indicator: the results are listed in the order they're found until a column is clicked
+	ui->resultsList->header()->setSortIndicator(-1, Qt::AscendingOrder);
+	ui->resultsList->setSortingEnabled(true);
+	ui->resultsList->header()->resizeSection(CSearchResultsModel::PathColumn, 500);
+
+	connect(ui->resultsList, &QTreeView::activated, [this](const QModelIndex& index){
+		CController::get().activePanel().goToItem(CFileSystemObject(_resultsModel.fullPath(index)));
 		CMainWindow::get()->activateWindow();
 	});
 
+	connect(ui->resultsFilter, &QLineEdit::textChanged, [this](const QString& text){
+		_resultsModel.setFilterText(text);
+	});
+
 	QTimer::singleShot(0, [this](){
 		ui->nameToFind->setFocus();
 		ui->nameToFind->lineEdit()->selectAll();
@@ -88,9 +110,9 @@ void CFilesSearchWindow::itemScanned(const QString& currentItem)
 	_progressLabel->setText(currentItem);
 }
 
-void CFilesSearchWindow::matchFound(const QString& path)
+void CFilesSearchWindow::matchFound(const CFileSystemObject& match)
 {
-	_matches.push_back(path);
+	_matches.push_back(match);
 }
 
 void CFilesSearchWindow::searchFinished(CFileSearchEngine::SearchStatus status, uint32_t speed)
@@ -99,10 +121,10 @@ void CFilesSearchWindow::searchFinished(CFileSearchEngine::SearchStatus status,
 	QString message = (status == CFileSearchEngine::SearchCancelled ? tr("Search aborted") : tr("Search completed"));
 	if (speed > 0)
 		message = message % ", " % tr("search speed: %1 items/sec").arg(speed);
-	_progressLabel->setText(message);
+	_progressLabel->setText(message % ", " % tr("%1 items found").arg(_resultsModel.totalCount()));
 	ui->resultsList->setFocus();
-	if (ui->resultsList->count() > 0)
-		ui->resultsList->item(0)->setSelected(true);
+	if (_resultsModel.rowCount() > 0)
+		ui->resultsList->setCurrentIndex(_resultsModel.index(0, 0));
 }
 
 void CFilesSearchWindow::search()
@@ -116,30 +138,46 @@ void CFilesSearchWindow::search()
 	const QString what = ui->nameToFind->currentText();
 	const QString withText = ui->fileContentsToFind->currentText();
 
-	_engine.search(what, ui->cbNameCaseSensitive->isChecked(), ui->searchRoot->currentText().split("; "), withText, ui->cbContentsCaseSensitive->isChecked());
+	CSettings s;
+	s.setValue(SETTINGS_ITEM_TYPES, ui->itemTypes->currentIndex());
+	s.setValue(SETTINGS_MIN_SIZE_MB, ui->minSizeMb->value());
+	s.setValue(SETTINGS_MAX_SIZE_MB, ui->maxSizeMb->value());
+	s.setValue(SETTINGS_MODIFIED_WITHIN_DAYS, ui->modifiedWithinDays->value());
+
+	_engine.search(what, ui->cbNameCaseSensitive->isChecked(), ui->searchRoot->currentText().split(';', Qt::SkipEmptyParts), withText, ui->cbContentsCaseSensitive->isChecked(), attributeFilter(), CPruningRules::fromSettings());
 	ui->btnSearch->setText("Stop");
-	ui->resultsList->clear();
+	_matches.clear();
+	_resultsModel.clear();
 	setWindowTitle('\"' % what % "\" " % tr("search results"));
 }
 
+AttributeFilter CFilesSearchWindow::attributeFilter() const
+{
+	static constexpr uint64_t MB = 1024 * 1024;
+
+	AttributeFilter filter;
+	if (ui->itemTypes->currentIndex() == FilesOnly)
+		filter.types = AttributeFilter::Files;
+	else if (ui->itemTypes->currentIndex() == FoldersOnly)
+		filter.types = AttributeFilter::Folders;
+
+	// 0 means no limit
+	if (ui->minSizeMb->value() > 0)
+		filter.minSize = static_cast<uint64_t>(ui->minSizeMb->value()) * MB;
+	if (ui->maxSizeMb->value() > 0)
+		filter.maxSize = static_cast<uint64_t>(ui->maxSizeMb->value()) * MB;
+	if (ui->modifiedWithinDays->value() > 0)
+		filter.modifiedAfter = static_cast<time_t>(QDateTime::currentDateTime().addDays(-ui->modifiedWithinDays->value()).toSecsSinceEpoch());
+
+	return filter;
+}
+
 void CFilesSearchWindow::addResultsToUi()
 {
 	if (_matches.empty())
 		return;
 
-	ui->resultsList->setUpdatesEnabled(false);
-	for (const QString& path: _matches)
-	{
-		const bool isDir = QFileInfo(path).isDir();
-
-		auto item = new QListWidgetItem;
-		const QString nativePath = toNativeSeparators(path);
-		item->setText(isDir ? ('[' % nativePath % ']') : nativePath);
-		item->setData(Qt::UserRole, path);
-		ui->resultsList->addItem(item);
-	}
-
-	ui->resultsList->scrollToBottom();
-	ui->resultsList->setUpdatesEnabled(true);
+	// The view only asks the model for the rows on screen, so the cost of a batch doesn't depend on how many results there are already
+	_resultsModel.addResults(_matches);
 	_matches.clear();
 }
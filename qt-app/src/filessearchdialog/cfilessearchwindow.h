@@ -2,6 +2,8 @@
 
 #include "compiler/compiler_warnings_control.h"
 #include "filesearchengine/cfilesearchengine.h"
+#include "cfilesystemobject.h"
+#include "csearchresultsmodel.h"
 
 DISABLE_COMPILER_WARNINGS
 #include <QMainWindow>
@@ -21,11 +23,12 @@ public:
 	~CFilesSearchWindow();
 
 	void itemScanned(const QString& currentItem) override;
-	void matchFound(const QString& path) override;
+	void matchFound(const CFileSystemObject& match) override;
 	void searchFinished(CFileSearchEngine::SearchStatus status, uint32_t speed) override;
 
 private:
 	void search();
+	AttributeFilter attributeFilter() const;
 
 	void addResultsToUi();
 
@@ -35,6 +38,7 @@ private:
 
 	QLabel* _progressLabel;
 	QTimer _resultsListUpdateTimer;
-	std::vector<QString> _matches;
+	std::vector<CFileSystemObject> _matches;
+	CSearchResultsModel _resultsModel;
 };
 
@@ -0,0 +1,260 @@
+#include "csearchresultsmodel.h"
+#include "cfilesystemobject.h"
+#include "filesystemhelperfunctions.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDateTime>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+
+CSearchResultsModel::CSearchResultsModel(QObject* parent) : QAbstractTableModel(parent)
+{
+}
+
+void CSearchResultsModel::clear()
+{
+	beginResetModel();
+	_folderIds.clear();
+	_names.clear();
+	_sizes.clear();
+	_modificationTimes.clear();
+	_isDir.clear();
+	_folders.clear();
+	_folderIdByPath.clear();
+	_rows.clear();
+	endResetModel();
+}
+
+void CSearchResultsModel::addResults(const std::vector<CFileSystemObject>& results)
+{
+	if (results.empty())
+		return;
+
+	const auto firstNewItem = static_cast<uint32_t>(_names.size());
+	for (const CFileSystemObject& result : results)
+	{
+		QString path = result.fullAbsolutePath();
+		if (path.length() > 1 && path.endsWith('/'))
+			path.chop(1);
+
+		const int nameStart = path.lastIndexOf('/') + 1;
+		const QString folder = path.left(nameStart);
+		auto folderId = _folderIdByPath.constFind(folder);
+		if (folderId == _folderIdByPath.cend())
+		{
+			folderId = _folderIdByPath.insert(folder, static_cast<uint32_t>(_folders.size()));
+			_folders.push_back(folder);
+		}
+
+		_folderIds.push_back(folderId.value());
+		_names.push_back(path.mid(nameStart));
+		_sizes.push_back(result.isFile() ? result.size() : 0);
+		_modificationTimes.push_back(static_cast<int64_t>(result.properties().modificationDate));
+		_isDir.push_back(result.isDir() ? 1 : 0);
+	}
+
+	std::vector<uint32_t> newRows;
+	newRows.reserve(results.size());
+	for (auto item = firstNewItem, end = static_cast<uint32_t>(_names.size()); item < end; ++item)
+	{
+		if (passesFilter(item))
+			newRows.push_back(item);
+	}
+
+	if (newRows.empty())
+		return;
+
+	if (_sortColumn < 0)
+	{
+		const int firstRow = static_cast<int>(_rows.size());
+		beginInsertRows(QModelIndex(), firstRow, firstRow + static_cast<int>(newRows.size()) - 1);
+		_rows.insert(_rows.end(), newRows.cbegin(), newRows.cend());
+		endInsertRows();
+		return;
+	}
+
+	// Only the new rows need sorting, then they're merged into the ones already sorted
+	std::sort(newRows.begin(), newRows.end(), [this](uint32_t l, uint32_t r) { return precedes(l, r); });
+	changeLayout([this, &newRows]() {
+		const auto oldSize = static_cast<ptrdiff_t>(_rows.size());
+		_rows.insert(_rows.end(), newRows.cbegin(), newRows.cend());
+		std::inplace_merge(_rows.begin(), _rows.begin() + oldSize, _rows.end(), [this](uint32_t l, uint32_t r) { return precedes(l, r); });
+	});
+}
+
+void CSearchResultsModel::setFilterText(const QString& text)
+{
+	if (text == _filterText)
+		return;
+
+	beginResetModel();
+	_filterText = text;
+	_rows.clear();
+	for (uint32_t item = 0, end = static_cast<uint32_t>(_names.size()); item < end; ++item)
+	{
+		if (passesFilter(item))
+			_rows.push_back(item);
+	}
+
+	if (_sortColumn >= 0)
+		std::sort(_rows.begin(), _rows.end(), [this](uint32_t l, uint32_t r) { return precedes(l, r); });
+	endResetModel();
+}
+
+QString CSearchResultsModel::fullPath(const QModelIndex& index) const
+{
+	assert_and_return_r(index.isValid() && static_cast<size_t>(index.row()) < _rows.size(), QString());
+	return itemPath(_rows[static_cast<size_t>(index.row())]);
+}
+
+size_t CSearchResultsModel::totalCount() const
+{
+	return _names.size();
+}
+
+int CSearchResultsModel::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : static_cast<int>(_rows.size());
+}
+
+int CSearchResultsModel::columnCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : NumColumns;
+}
+
+QVariant CSearchResultsModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || static_cast<size_t>(index.row()) >= _rows.size())
+		return {};
+
+	const uint32_t item = _rows[static_cast<size_t>(index.row())];
+	if (role == Qt::DisplayRole)
+	{
+		switch (index.column())
+		{
+		case PathColumn:
+		{
+			const QString nativePath = toNativeSeparators(itemPath(item));
+			return _isDir[item] ? QString('[' + nativePath + ']') : nativePath;
+		}
+		case SizeColumn:
+			return _isDir[item] ? QString() : fileSizeToString(_sizes[item]);
+		case ModifiedColumn:
+			return QDateTime::fromSecsSinceEpoch(_modificationTimes[item]).toString(QLatin1String("dd.MM.yyyy hh:mm"));
+		default:
+			return {};
+		}
+	}
+	else if (role == Qt::TextAlignmentRole && index.column() == SizeColumn)
+		return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+
+	return {};
+}
+
+QVariant CSearchResultsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+		return {};
+
+	switch (section)
+	{
+	case PathColumn:
+		return tr("Path");
+	case SizeColumn:
+		return tr("Size");
+	case ModifiedColumn:
+		return tr("Modified");
+	default:
+		return {};
+	}
+}
+
+void CSearchResultsModel::sort(int column, Qt::SortOrder order)
+{
+	_sortColumn = column;
+	_sortOrder = order;
+
+	changeLayout([this]() {
+		std::sort(_rows.begin(), _rows.end(), [this](uint32_t l, uint32_t r) { return precedes(l, r); });
+	});
+}
+
+bool CSearchResultsModel::passesFilter(uint32_t item) const
+{
+	if (_filterText.isEmpty())
+		return true;
+
+	// The folder path ends with a '/', so a text without one can't span the folder and the name
+	if (!_filterText.contains('/'))
+		return _names[item].contains(_filterText, Qt::CaseInsensitive) || _folders[_folderIds[item]].contains(_filterText, Qt::CaseInsensitive);
+
+	return itemPath(item).contains(_filterText, Qt::CaseInsensitive);
+}
+
+bool CSearchResultsModel::precedes(uint32_t l, uint32_t r) const
+{
+	int result = 0;
+	switch (_sortColumn)
+	{
+	case PathColumn:
+		if (_folderIds[l] != _folderIds[r])
+			result = _folders[_folderIds[l]].compare(_folders[_folderIds[r]], Qt::CaseInsensitive);
+		if (result == 0)
+			result = _names[l].compare(_names[r], Qt::CaseInsensitive);
+		break;
+	case SizeColumn:
+		// Folders have no size, they go before the smallest files
+		if (_isDir[l] != _isDir[r])
+			result = _isDir[l] ? -1 : 1;
+		else
+			result = _sizes[l] < _sizes[r] ? -1 : (_sizes[l] > _sizes[r] ? 1 : 0);
+		break;
+	case ModifiedColumn:
+		result = _modificationTimes[l] < _modificationTimes[r] ? -1 : (_modificationTimes[l] > _modificationTimes[r] ? 1 : 0);
+		break;
+	default:
+		break;
+	}
+
+	if (result == 0)
+		return l < r;
+
+	return _sortOrder == Qt::AscendingOrder ? result < 0 : result > 0;
+}
+
+QString CSearchResultsModel::itemPath(uint32_t item) const
+{
+	return _folders[_folderIds[item]] + _names[item];
+}
+
+template <typename Reorder>
+void CSearchResultsModel::changeLayout(Reorder&& reorder)
+{
+	emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+	const QModelIndexList persistentIndexes = persistentIndexList();
+	std::vector<uint32_t> persistentItems;
+	persistentItems.reserve(static_cast<size_t>(persistentIndexes.size()));
+	for (const QModelIndex& index : persistentIndexes)
+		persistentItems.push_back(_rows[static_cast<size_t>(index.row())]);
+
+	reorder();
+
+	// '_rows' is ordered by precedes(), which has no ties, so every item can be found by a binary search rather than a full pass over the rows
+	QModelIndexList newIndexes;
+	newIndexes.reserve(persistentIndexes.size());
+	for (int i = 0; i < persistentIndexes.size(); ++i)
+	{
+		const uint32_t item = persistentItems[static_cast<size_t>(i)];
+		const auto position = _sortColumn >= 0 ?
+			std::lower_bound(_rows.cbegin(), _rows.cend(), item, [this](uint32_t l, uint32_t r) { return precedes(l, r); }) :
+			std::find(_rows.cbegin(), _rows.cend(), item);
+		assert_r(position != _rows.cend() && *position == item);
+		newIndexes.push_back(index(static_cast<int>(position - _rows.cbegin()), persistentIndexes[i].column()));
+	}
+
+	changePersistentIndexList(persistentIndexes, newIndexes);
+	emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
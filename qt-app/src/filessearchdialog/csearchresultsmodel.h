@@ -0,0 +1,71 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <stdint.h>
+#include <vector>
+
+class CFileSystemObject;
+
+// The search results for a virtual view. The matches are kept column by column in a compact store, and only the rows on screen are ever formatted.
+// Sorting and filtering work on a vector of item numbers, so adding a batch of results costs in proportion to the batch rather than to the total,
+// apart from merging it into the sorted order.
+class CSearchResultsModel final : public QAbstractTableModel
+{
+	Q_OBJECT
+
+public:
+	enum Column {PathColumn, SizeColumn, ModifiedColumn, NumColumns};
+
+	explicit CSearchResultsModel(QObject* parent = nullptr);
+
+	void clear();
+	void addResults(const std::vector<CFileSystemObject>& results);
+	// Only shows the results whose path contains 'text', case-insensitively. An empty text shows everything.
+	void setFilterText(const QString& text);
+
+	QString fullPath(const QModelIndex& index) const;
+	// Including the ones hidden by the filter
+	size_t totalCount() const;
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+	// Column -1 restores the order in which the results were found
+	void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+private:
+	bool passesFilter(uint32_t item) const;
+	// Strict total order for the current sort column: the ties are broken by the order of arrival
+	bool precedes(uint32_t l, uint32_t r) const;
+	QString itemPath(uint32_t item) const;
+
+	// Reorders '_rows' with the given function and moves the persistent indexes (the selection, the current item) along with their items
+	template <typename Reorder>
+	void changeLayout(Reorder&& reorder);
+
+private:
+	// One element per result, in the order of arrival
+	std::vector<uint32_t> _folderIds;
+	std::vector<QString> _names;
+	std::vector<uint64_t> _sizes;
+	std::vector<int64_t> _modificationTimes;
+	std::vector<uint8_t> _isDir;
+
+	// The folder paths, ending with a '/', are shared by all the results inside them
+	std::vector<QString> _folders;
+	QHash<QString, uint32_t> _folderIdByPath;
+
+	// The item numbers of the visible rows in the display order
+	std::vector<uint32_t> _rows;
+	int _sortColumn = -1;
+	Qt::SortOrder _sortOrder = Qt::AscendingOrder;
+	QString _filterText;
+};
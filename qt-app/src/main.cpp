@@ -1,6 +1,8 @@
 #include "cmainwindow.h"
 #include "settings/csettings.h"
 #include "iconprovider/ciconprovider.h"
+#include "logging/casynclogger.h"
+#include "utility/on_scope_exit.hpp"
 
 DISABLE_COMPILER_WARNINGS
 #include <QApplication>
@@ -10,8 +12,12 @@ RESTORE_COMPILER_WARNINGS
 
 int main(int argc, char *argv[])
 {
+	CAsyncLogger::instance().install();
+	EXEC_ON_SCOPE_EXIT([]() {CAsyncLogger::instance().uninstall();});
+
 	AdvancedAssert::setLoggingFunc([](const char* message){
 		qInfo() << message;
+		CAsyncLogger::instance().flush(); // The assertion may be about to abort the process
 	});
 
 	qInfo() << "Built with Qt" << QT_VERSION_STR;
@@ -0,0 +1,158 @@
+#include "cmetricschart.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QPainter>
+#include <QPainterPath>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <cmath>
+
+CMetricsChart::CMetricsChart(QWidget* parent) :
+	QWidget(parent),
+	_formatter{[](double value) { return QString::number(value, 'g', 3); }}
+{
+	setMinimumHeight(100);
+}
+
+void CMetricsChart::setTitle(const QString& title)
+{
+	_title = title;
+	update();
+}
+
+void CMetricsChart::setValueFormatter(ValueFormatter formatter)
+{
+	_formatter = std::move(formatter);
+	update();
+}
+
+void CMetricsChart::setCapacity(size_t capacity)
+{
+	assert_and_return_r(capacity >= 2, );
+	_capacity = capacity;
+	for (auto& series: _series)
+	{
+		while (series.values.size() > _capacity)
+			series.values.pop_front();
+	}
+
+	update();
+}
+
+void CMetricsChart::setMinimumRange(double minimum)
+{
+	_minimumRange = minimum;
+	update();
+}
+
+size_t CMetricsChart::addSeries(const QString& name, const QColor& color)
+{
+	_series.push_back({name, color, {}});
+	return _series.size() - 1;
+}
+
+void CMetricsChart::appendValue(size_t series, double value)
+{
+	assert_and_return_r(series < _series.size(), );
+
+	auto& values = _series[series].values;
+	values.push_back(value);
+	if (values.size() > _capacity)
+		values.pop_front();
+
+	update();
+}
+
+void CMetricsChart::clear()
+{
+	for (auto& series: _series)
+		series.values.clear();
+
+	update();
+}
+
+QSize CMetricsChart::sizeHint() const
+{
+	return {400, 150};
+}
+
+void CMetricsChart::paintEvent(QPaintEvent*)
+{
+	QPainter painter(this);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.fillRect(rect(), palette().base());
+
+	const QFontMetrics metrics = fontMetrics();
+	const int lineHeight = metrics.height();
+
+	double maxValue = _minimumRange;
+	for (const auto& series: _series)
+	{
+		if (!series.values.empty())
+			maxValue = std::max(maxValue, *std::max_element(series.values.begin(), series.values.end()));
+	}
+
+	// Rounding the top of the scale up to 1, 2 or 5 times a power of 10 keeps the labels readable and the scale from twitching on every sample
+	const double magnitude = std::pow(10.0, std::floor(std::log10(maxValue)));
+	for (const double step: {1.0, 2.0, 5.0, 10.0})
+	{
+		if (maxValue <= step * magnitude)
+		{
+			maxValue = step * magnitude;
+			break;
+		}
+	}
+
+	const QString topLabel = _formatter(maxValue);
+	const int labelsWidth = std::max(metrics.horizontalAdvance(topLabel), metrics.horizontalAdvance(_formatter(0.0))) + 6;
+	const QRect plot = rect().adjusted(labelsWidth, lineHeight + 4, -4, -4);
+	if (plot.width() < 2 || plot.height() < 2)
+		return;
+
+	// The title and the legend
+	painter.setPen(palette().color(QPalette::Text));
+	painter.drawText(QPoint(4, lineHeight), _title);
+	int legendX = std::max(plot.left(), metrics.horizontalAdvance(_title) + 16);
+	for (const auto& series: _series)
+	{
+		painter.fillRect(legendX, lineHeight / 2, 10, lineHeight / 2, series.color);
+		legendX += 14;
+		painter.setPen(palette().color(QPalette::Text));
+		const QString text = series.values.empty() ? series.name : series.name + ": " + _formatter(series.values.back());
+		painter.drawText(QPoint(legendX, lineHeight), text);
+		legendX += metrics.horizontalAdvance(text) + 12;
+	}
+
+	// The grid
+	painter.setPen(palette().color(QPalette::Mid));
+	painter.drawRect(plot);
+	painter.drawLine(plot.left(), plot.center().y(), plot.right(), plot.center().y());
+	painter.setPen(palette().color(QPalette::Text));
+	painter.drawText(QRect(0, plot.top() - lineHeight / 2, labelsWidth - 4, lineHeight), Qt::AlignRight | Qt::AlignVCenter, topLabel);
+	painter.drawText(QRect(0, plot.center().y() - lineHeight / 2, labelsWidth - 4, lineHeight), Qt::AlignRight | Qt::AlignVCenter, _formatter(maxValue / 2));
+	painter.drawText(QRect(0, plot.bottom() - lineHeight / 2, labelsWidth - 4, lineHeight), Qt::AlignRight | Qt::AlignVCenter, _formatter(0.0));
+
+	// The newest sample is at the right edge
+	const double xStep = static_cast<double>(plot.width()) / static_cast<double>(_capacity - 1);
+	for (const auto& series: _series)
+	{
+		if (series.values.size() < 2)
+			continue;
+
+		QPainterPath path;
+		const double xStart = plot.right() - xStep * static_cast<double>(series.values.size() - 1);
+		for (size_t i = 0; i < series.values.size(); ++i)
+		{
+			const QPointF point(xStart + xStep * static_cast<double>(i), plot.bottom() - series.values[i] / maxValue * plot.height());
+			if (i == 0)
+				path.moveTo(point);
+			else
+				path.lineTo(point);
+		}
+
+		painter.setPen(QPen(series.color, 1.5));
+		painter.drawPath(path);
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QColor>
+#include <QString>
+#include <QWidget>
+RESTORE_COMPILER_WARNINGS
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+// A minimal scrolling line chart: a few series sharing the vertical axis, one value appended per sample, the oldest dropped past the capacity
+class CMetricsChart : public QWidget
+{
+public:
+	using ValueFormatter = std::function<QString (double)>;
+
+	explicit CMetricsChart(QWidget* parent = nullptr);
+
+	void setTitle(const QString& title);
+	// Formats the vertical axis labels, plain numbers by default
+	void setValueFormatter(ValueFormatter formatter);
+	// The number of samples shown
+	void setCapacity(size_t capacity);
+	// The vertical axis grows to fit the values but never goes below 'minimum'
+	void setMinimumRange(double minimum);
+
+	size_t addSeries(const QString& name, const QColor& color);
+	void appendValue(size_t series, double value);
+	void clear();
+
+	QSize sizeHint() const override;
+
+protected:
+	void paintEvent(QPaintEvent* e) override;
+
+private:
+	struct Series {
+		QString name;
+		QColor color;
+		std::deque<double> values;
+	};
+
+	QString _title;
+	ValueFormatter _formatter;
+	std::vector<Series> _series;
+	size_t _capacity = 120;
+	double _minimumRange = 1.0;
+};
@@ -0,0 +1,268 @@
+#include "coperationsdashboard.h"
+#include "filesystemhelperfunctions.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include "ui_coperationsdashboard.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMessageBox>
+RESTORE_COMPILER_WARNINGS
+
+#include <map>
+
+static constexpr int SamplingPeriodMs = 500;
+// Half an hour
+static constexpr size_t MaxHistorySamples = 30 * 60 * 1000 / SamplingPeriodMs;
+
+enum DeviceColumn {DeviceNameColumn, ReadRateColumn, WriteRateColumn, TotalReadColumn, TotalWrittenColumn, NumDeviceColumns};
+enum LatencyColumn {LatencyNameColumn, CountColumn, MeanColumn, P50Column, P90Column, P99Column, P999Column, MaxColumn, NumLatencyColumns};
+
+// "io.bytes_read{/mnt/data}" -> "/mnt/data" if 'name' is "io.bytes_read"
+static QString deviceOf(const QString& metricName, const QString& name)
+{
+	if (metricName.size() < name.size() + 2 || !metricName.startsWith(name) || metricName[name.size()] != '{' || !metricName.endsWith('}'))
+		return {};
+
+	return metricName.mid(name.size() + 1, metricName.size() - name.size() - 2);
+}
+
+static uint64_t deviceTotal(const std::map<QString, uint64_t>& counters, const QString& name)
+{
+	uint64_t total = 0;
+	for (const auto& counter: counters)
+	{
+		if (!deviceOf(counter.first, name).isEmpty())
+			total += counter.second;
+	}
+
+	return total;
+}
+
+static uint64_t counterDelta(const std::map<QString, uint64_t>& current, const std::map<QString, uint64_t>& previous, const QString& name)
+{
+	const auto it = current.find(name);
+	if (it == current.end())
+		return 0;
+
+	const auto previousIt = previous.find(name);
+	return previousIt == previous.end() ? it->second : it->second - previousIt->second;
+}
+
+static int64_t gaugeValue(const std::map<QString, int64_t>& gauges, const QString& name)
+{
+	const auto it = gauges.find(name);
+	return it == gauges.end() ? 0 : it->second;
+}
+
+static QString latencyToString(uint64_t microseconds)
+{
+	if (microseconds < 1000)
+		return QObject::tr("%1 us").arg(microseconds);
+	else if (microseconds < 1000 * 1000)
+		return QObject::tr("%1 ms").arg(static_cast<double>(microseconds) / 1000.0, 0, 'f', 1);
+	else
+		return QObject::tr("%1 s").arg(static_cast<double>(microseconds) / 1e6, 0, 'f', 2);
+}
+
+COperationsDashboard::COperationsDashboard(QWidget* parent) :
+	QWidget(parent, Qt::Window),
+	ui(new Ui::COperationsDashboard),
+	_initialSnapshot(CMetricsRegistry::instance().snapshot()),
+	_previousSnapshot(_initialSnapshot)
+{
+	ui->setupUi(this);
+	setAttribute(Qt::WA_DeleteOnClose, true);
+
+	const auto throughputFormatter = [](double value) {
+		return fileSizeToString(static_cast<uint64_t>(value)) + QObject::tr("/s");
+	};
+
+	ui->_throughputChart->setTitle(tr("Throughput"));
+	ui->_throughputChart->setValueFormatter(throughputFormatter);
+	ui->_throughputChart->setMinimumRange(1024 * 1024);
+	ui->_throughputChart->addSeries(tr("Read"), QColor(0x1f, 0x77, 0xb4));
+	ui->_throughputChart->addSeries(tr("Written"), QColor(0xd6, 0x27, 0x28));
+
+	ui->_iopsChart->setTitle(tr("I/O operations per second"));
+	ui->_iopsChart->setMinimumRange(10);
+	ui->_iopsChart->addSeries(tr("IOPS"), QColor(0x2c, 0xa0, 0x2c));
+
+	ui->_queueDepthChart->setTitle(tr("Queue depth"));
+	ui->_queueDepthChart->setMinimumRange(10);
+	ui->_queueDepthChart->addSeries(tr("Items to copy"), QColor(0xff, 0x7f, 0x0e));
+	ui->_queueDepthChart->addSeries(tr("Operations"), QColor(0x94, 0x67, 0xbd));
+
+	ui->_workersChart->setTitle(tr("Worker utilisation"));
+	ui->_workersChart->setMinimumRange(100);
+	ui->_workersChart->setValueFormatter([](double value) {
+		return QString::number(value, 'f', 0) + '%';
+	});
+	ui->_workersChart->addSeries(tr("Busy"), QColor(0x8c, 0x56, 0x4b));
+
+	ui->_devices->setColumnCount(NumDeviceColumns);
+	ui->_devices->setHeaderLabels({tr("Device"), tr("Read"), tr("Written"), tr("Total read"), tr("Total written")});
+	ui->_devices->header()->setSectionResizeMode(DeviceNameColumn, QHeaderView::Stretch);
+	ui->_devices->header()->setStretchLastSection(false);
+
+	ui->_latencies->setColumnCount(NumLatencyColumns);
+	ui->_latencies->setHeaderLabels({tr("Latency"), tr("Count"), tr("Mean"), tr("p50"), tr("p90"), tr("p99"), tr("p99.9"), tr("Max")});
+	ui->_latencies->header()->setSectionResizeMode(LatencyNameColumn, QHeaderView::Stretch);
+	ui->_latencies->header()->setStretchLastSection(false);
+
+	connect(ui->_btnExport, &QPushButton::clicked, this, &COperationsDashboard::exportHistory);
+	connect(ui->_btnClose, &QPushButton::clicked, this, &COperationsDashboard::close);
+
+	connect(&_sampleTimer, &QTimer::timeout, this, &COperationsDashboard::sample);
+	_sampleTimer.start(SamplingPeriodMs);
+}
+
+COperationsDashboard::~COperationsDashboard()
+{
+	delete ui;
+}
+
+void COperationsDashboard::sample()
+{
+	const CMetricsRegistry::Snapshot current = CMetricsRegistry::instance().snapshot();
+	const double secondsElapsed = std::chrono::duration<double>(current.time - _previousSnapshot.time).count();
+	if (secondsElapsed <= 0.0)
+		return;
+
+	// The rates are the counter increments between two samples
+	const uint64_t bytesRead = deviceTotal(current.counters, Metrics::BytesRead) - deviceTotal(_previousSnapshot.counters, Metrics::BytesRead);
+	const uint64_t bytesWritten = deviceTotal(current.counters, Metrics::BytesWritten) - deviceTotal(_previousSnapshot.counters, Metrics::BytesWritten);
+	ui->_throughputChart->appendValue(0, static_cast<double>(bytesRead) / secondsElapsed);
+	ui->_throughputChart->appendValue(1, static_cast<double>(bytesWritten) / secondsElapsed);
+
+	ui->_iopsChart->appendValue(0, static_cast<double>(counterDelta(current.counters, _previousSnapshot.counters, Metrics::IoOperations)) / secondsElapsed);
+
+	ui->_queueDepthChart->appendValue(0, static_cast<double>(gaugeValue(current.gauges, Metrics::CopyQueueDepth)));
+	ui->_queueDepthChart->appendValue(1, static_cast<double>(gaugeValue(current.gauges, Metrics::RunningOperations)));
+
+	const int64_t workers = gaugeValue(current.gauges, Metrics::Workers);
+	const int64_t busyWorkers = gaugeValue(current.gauges, Metrics::BusyWorkers);
+	ui->_workersChart->appendValue(0, workers > 0 ? 100.0 * static_cast<double>(busyWorkers) / static_cast<double>(workers) : 0.0);
+
+	updateDevices(current, secondsElapsed);
+	updateLatencies(current);
+
+	const auto msSinceOpened = std::chrono::duration_cast<std::chrono::milliseconds>(current.time - _initialSnapshot.time).count();
+	_history.push_back(CMetricsRegistry::toJson(current, static_cast<uint64_t>(msSinceOpened)));
+	if (_history.size() > MaxHistorySamples)
+		_history.pop_front();
+
+	_previousSnapshot = current;
+}
+
+void COperationsDashboard::updateDevices(const CMetricsRegistry::Snapshot& current, double secondsElapsed)
+{
+	struct DeviceStats {
+		uint64_t readRate = 0, writeRate = 0;
+		uint64_t totalRead = 0, totalWritten = 0;
+	};
+
+	std::map<QString, DeviceStats> devices;
+	for (const auto& counter: current.counters)
+	{
+		QString device = deviceOf(counter.first, Metrics::BytesRead);
+		const bool isRead = !device.isEmpty();
+		if (!isRead)
+			device = deviceOf(counter.first, Metrics::BytesWritten);
+		if (device.isEmpty())
+			continue;
+
+		const auto rate = static_cast<uint64_t>(static_cast<double>(counterDelta(current.counters, _previousSnapshot.counters, counter.first)) / secondsElapsed);
+		auto& stats = devices[device];
+		(isRead ? stats.readRate : stats.writeRate) = rate;
+		(isRead ? stats.totalRead : stats.totalWritten) = counter.second;
+	}
+
+	// The rows are reused so that the selection and the scroll position survive the updates
+	const int numRows = static_cast<int>(devices.size());
+	while (ui->_devices->topLevelItemCount() > numRows)
+		delete ui->_devices->takeTopLevelItem(ui->_devices->topLevelItemCount() - 1);
+
+	while (ui->_devices->topLevelItemCount() < numRows)
+	{
+		auto* item = new QTreeWidgetItem;
+		for (int column = ReadRateColumn; column < NumDeviceColumns; ++column)
+			item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+		ui->_devices->addTopLevelItem(item);
+	}
+
+	int row = 0;
+	for (const auto& device: devices)
+	{
+		QTreeWidgetItem* item = ui->_devices->topLevelItem(row++);
+		item->setText(DeviceNameColumn, toNativeSeparators(device.first));
+		item->setText(ReadRateColumn, fileSizeToString(device.second.readRate) + tr("/s"));
+		item->setText(WriteRateColumn, fileSizeToString(device.second.writeRate) + tr("/s"));
+		item->setText(TotalReadColumn, fileSizeToString(device.second.totalRead));
+		item->setText(TotalWrittenColumn, fileSizeToString(device.second.totalWritten));
+	}
+}
+
+void COperationsDashboard::updateLatencies(const CMetricsRegistry::Snapshot& current)
+{
+	const int numRows = static_cast<int>(current.histograms.size());
+	while (ui->_latencies->topLevelItemCount() > numRows)
+		delete ui->_latencies->takeTopLevelItem(ui->_latencies->topLevelItemCount() - 1);
+
+	while (ui->_latencies->topLevelItemCount() < numRows)
+	{
+		auto* item = new QTreeWidgetItem;
+		for (int column = CountColumn; column < NumLatencyColumns; ++column)
+			item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+		ui->_latencies->addTopLevelItem(item);
+	}
+
+	int row = 0;
+	for (const auto& histogram: current.histograms)
+	{
+		const auto initial = _initialSnapshot.histograms.find(histogram.first);
+		const CLatencyHistogram::Snapshot h = initial == _initialSnapshot.histograms.end() ? histogram.second : histogram.second.since(initial->second);
+
+		QTreeWidgetItem* item = ui->_latencies->topLevelItem(row++);
+		item->setText(LatencyNameColumn, histogram.first);
+		item->setText(CountColumn, QString::number(h.count));
+		if (h.count == 0)
+		{
+			for (int column = MeanColumn; column < NumLatencyColumns; ++column)
+				item->setText(column, QStringLiteral("-"));
+			continue;
+		}
+
+		item->setText(MeanColumn, latencyToString(static_cast<uint64_t>(h.mean())));
+		item->setText(P50Column, latencyToString(h.percentile(50)));
+		item->setText(P90Column, latencyToString(h.percentile(90)));
+		item->setText(P99Column, latencyToString(h.percentile(99)));
+		item->setText(P999Column, latencyToString(h.percentile(99.9)));
+		item->setText(MaxColumn, latencyToString(h.max));
+	}
+}
+
+void COperationsDashboard::exportHistory()
+{
+	const QString path = QFileDialog::getSaveFileName(this, tr("Export the metrics"), QDir::homePath() + "/file-commander-metrics.json", tr("JSON (*.json)"));
+	if (path.isEmpty())
+		return;
+
+	QJsonArray samples;
+	for (const QJsonObject& sample: _history)
+		samples.push_back(sample);
+
+	const QByteArray json = QJsonDocument(QJsonObject{
+		{"sampling_period_ms", SamplingPeriodMs},
+		{"samples", samples}
+	}).toJson(QJsonDocument::Compact);
+
+	QFile file(path);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(json) != json.size())
+		QMessageBox::warning(this, tr("Failed to export the metrics"), tr("Failed to write %1:\n%2").arg(toNativeSeparators(path), file.errorString()));
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "metrics/cmetricsregistry.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QTimer>
+#include <QWidget>
+RESTORE_COMPILER_WARNINGS
+
+#include <deque>
+
+namespace Ui {
+class COperationsDashboard;
+}
+
+// Charts the throughput, IOPS, queue depth and worker utilisation of all the running operations, sampled from CMetricsRegistry
+class COperationsDashboard : public QWidget
+{
+public:
+	explicit COperationsDashboard(QWidget* parent);
+	~COperationsDashboard();
+
+private:
+	void sample();
+	void updateDevices(const CMetricsRegistry::Snapshot& current, double secondsElapsed);
+	void updateLatencies(const CMetricsRegistry::Snapshot& current);
+	void exportHistory();
+
+private:
+	Ui::COperationsDashboard *ui;
+	QTimer _sampleTimer;
+
+	// The latencies shown are those recorded since the dashboard was opened
+	const CMetricsRegistry::Snapshot _initialSnapshot;
+	CMetricsRegistry::Snapshot _previousSnapshot;
+	// Every sample taken, as exported, up to a limit
+	std::deque<QJsonObject> _history;
+};
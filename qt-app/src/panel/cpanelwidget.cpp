@@ -18,6 +18,7 @@
 #include "settings/csettings.h"
 #include "settings.h"
 #include "utility/memory_cast.hpp"
+#include "tracing/ctracer.h"
 
 DISABLE_COMPILER_WARNINGS
 #include <QClipboard>
@@ -169,6 +170,8 @@ void CPanelWidget::setPanelPosition(Panel p)
 // Returns the list of items added to the view
 void CPanelWidget::fillFromList(const std::map<qulonglong, CFileSystemObject>& items, FileListRefreshCause operation)
 {
+	TRACE_SCOPE_CATEGORY("CPanelWidget::fillFromList", "ui");
+
 	disconnect(_selectionModel, &QItemSelectionModel::currentChanged, this, &CPanelWidget::currentItemChanged);
 
 	const QString previousFolder = _directoryCurrentlyBeingDisplayed;
@@ -218,7 +221,7 @@ void CPanelWidget::fillFromList(const std::map<qulonglong, CFileSystemObject>& i
 
 		auto sizeItem = new QStandardItem();
 		sizeItem->setEditable(false);
-		if (props.size > 0 || props.type == File)
+		if (!props.metadataPending && (props.size > 0 || props.type == File))
 			sizeItem->setData(fileSizeToString(props.size), Qt::DisplayRole);
 
 		sizeItem->setData(props.hash, Qt::UserRole); // Unique identifier for this object
@@ -226,7 +229,7 @@ void CPanelWidget::fillFromList(const std::map<qulonglong, CFileSystemObject>& i
 
 		auto dateItem = new QStandardItem();
 		dateItem->setEditable(false);
-		if (!object.isCdUp())
+		if (!object.isCdUp() && !props.metadataPending)
 		{
 			QDateTime modificationDate;
 			modificationDate.setTime_t((uint) props.modificationDate);
@@ -242,9 +245,11 @@ void CPanelWidget::fillFromList(const std::map<qulonglong, CFileSystemObject>& i
 	for (const auto& qTreeViewItem: qTreeViewItems)
 		_model->setItem(qTreeViewItem.row, qTreeViewItem.column, qTreeViewItem.item);
 
-	_sortModel->setSourceModel(_model);
-
-	ui->_list->restoreHeaderState();
+	{
+		TRACE_SCOPE_CATEGORY("Sorting", "ui");
+		_sortModel->setSourceModel(_model);
+		ui->_list->restoreHeaderState();
+	}
 
 	auto indexUnderCursor = _sortModel->index(0, 0);
 
@@ -284,6 +289,8 @@ void CPanelWidget::fillFromList(const std::map<qulonglong, CFileSystemObject>& i
 
 void CPanelWidget::fillFromPanel(const CPanel &panel, FileListRefreshCause operation)
 {
+	TRACE_SCOPE_CATEGORY("CPanelWidget::fillFromPanel", "ui");
+
 	const auto itemList = panel.list();
 	const auto previousSelection = selectedItemsHashes(true);
 	std::set<qulonglong> selectedItemsHashes; // For fast search
@@ -296,7 +303,7 @@ void CPanelWidget::fillFromPanel(const CPanel &panel, FileListRefreshCause opera
 	// Restoring previous selection
 	if (!selectedItemsHashes.empty())
 	{
-		CTimeElapsed timer(true);
+		TRACE_SCOPE_CATEGORY("Restoring the selection", "ui");
 		QItemSelection selection;
 		for (int row = 0, numRows = _sortModel->rowCount(); row < numRows; ++row)
 		{
@@ -305,11 +312,8 @@ void CPanelWidget::fillFromPanel(const CPanel &panel, FileListRefreshCause opera
 				selection.select(_sortModel->index(row, 0), _sortModel->index(row, 0));
 		}
 
-		timer.start();
 		if (!selection.empty())
 			_selectionModel->select(selection, QItemSelectionModel::Rows | QItemSelectionModel::Select);
-
-		qInfo() << "_selectionModel->select took" << timer.elapsed() << "ms for" << selection.size() << "items";
 	}
 
 	fillHistory();
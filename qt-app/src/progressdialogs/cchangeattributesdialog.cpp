@@ -0,0 +1,122 @@
+#include "cchangeattributesdialog.h"
+#include "ui_cchangeattributesdialog.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDateTime>
+#include <QMessageBox>
+RESTORE_COMPILER_WARNINGS
+
+#ifndef _WIN32
+#include <grp.h>
+#include <pwd.h>
+#endif
+
+namespace {
+
+// A user or a group can be specified by name or by ID; -1 if there's no such user / group
+int64_t userId(const QString& name)
+{
+	bool isNumber = false;
+	const uint id = name.toUInt(&isNumber);
+	if (isNumber)
+		return id;
+
+#ifndef _WIN32
+	const passwd* user = ::getpwnam(name.toLocal8Bit().constData());
+	if (user)
+		return user->pw_uid;
+#endif
+	return -1;
+}
+
+int64_t groupId(const QString& name)
+{
+	bool isNumber = false;
+	const uint id = name.toUInt(&isNumber);
+	if (isNumber)
+		return id;
+
+#ifndef _WIN32
+	const group* g = ::getgrnam(name.toLocal8Bit().constData());
+	if (g)
+		return g->gr_gid;
+#endif
+	return -1;
+}
+
+}
+
+CChangeAttributesDialog::CChangeAttributesDialog(const QString& labelText, QWidget *parent) :
+	QDialog(parent),
+	ui(new Ui::CChangeAttributesDialog)
+{
+	ui->setupUi(this);
+	ui->_label->setText(labelText);
+
+	// Nothing is changed unless the user asks for it
+	for (QCheckBox* checkBox: {ui->_cbOwnerRead, ui->_cbOwnerWrite, ui->_cbOwnerExecute, ui->_cbGroupRead, ui->_cbGroupWrite, ui->_cbGroupExecute, ui->_cbOthersRead, ui->_cbOthersWrite, ui->_cbOthersExecute})
+		checkBox->setCheckState(Qt::PartiallyChecked);
+
+	const QDateTime now = QDateTime::currentDateTime();
+	ui->_dteModificationTime->setDateTime(now);
+	ui->_dteAccessTime->setDateTime(now);
+
+	connect(ui->buttonBox, &QDialogButtonBox::accepted, this, &CChangeAttributesDialog::acceptIfValid);
+}
+
+CChangeAttributesDialog::~CChangeAttributesDialog()
+{
+	delete ui;
+}
+
+AttributeChange CChangeAttributesDialog::attributeChange() const
+{
+	return _change;
+}
+
+void CChangeAttributesDialog::acceptIfValid()
+{
+	AttributeChange change;
+
+	const std::pair<QCheckBox*, uint32_t> permissions[] {
+		{ui->_cbOwnerRead, 0400}, {ui->_cbOwnerWrite, 0200}, {ui->_cbOwnerExecute, 0100},
+		{ui->_cbGroupRead, 0040}, {ui->_cbGroupWrite, 0020}, {ui->_cbGroupExecute, 0010},
+		{ui->_cbOthersRead, 0004}, {ui->_cbOthersWrite, 0002}, {ui->_cbOthersExecute, 0001}
+	};
+
+	for (const auto& permission: permissions)
+	{
+		if (permission.first->checkState() == Qt::Checked)
+			change.modeToSet |= permission.second;
+		else if (permission.first->checkState() == Qt::Unchecked)
+			change.modeToClear |= permission.second;
+	}
+	change.executeOnlyIfExecutable = ui->_cbExecuteOnlyIfExecutable->isChecked();
+
+	const QString ownerName = ui->_leOwner->text().trimmed();
+	if (!ownerName.isEmpty() && (change.ownerId = userId(ownerName)) < 0)
+	{
+		QMessageBox::warning(this, tr("Unknown user"), tr("There is no user named %1.").arg(ownerName));
+		return;
+	}
+
+	const QString groupName = ui->_leGroup->text().trimmed();
+	if (!groupName.isEmpty() && (change.groupId = groupId(groupName)) < 0)
+	{
+		QMessageBox::warning(this, tr("Unknown group"), tr("There is no group named %1.").arg(groupName));
+		return;
+	}
+
+	if (ui->_cbModificationTime->isChecked())
+		change.modificationTime = ui->_dteModificationTime->dateTime().toMSecsSinceEpoch() / 1000;
+	if (ui->_cbAccessTime->isChecked())
+		change.accessTime = ui->_dteAccessTime->dateTime().toMSecsSinceEpoch() / 1000;
+
+	change.applyToFiles = ui->_cbApplyToFiles->isChecked();
+	change.applyToFolders = ui->_cbApplyToFolders->isChecked();
+	change.includeMasks = ui->_leIncludeMasks->text().split(' ', Qt::SkipEmptyParts);
+	change.excludeMasks = ui->_leExcludeMasks->text().split(' ', Qt::SkipEmptyParts);
+
+	_change = change;
+	accept();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "fileoperations/cattributechanger.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDialog>
+RESTORE_COMPILER_WARNINGS
+
+namespace Ui {
+class CChangeAttributesDialog;
+}
+
+// Lets the user choose the permissions, the owner and the times to apply to the selected items and everything inside them
+class CChangeAttributesDialog : public QDialog
+{
+public:
+	CChangeAttributesDialog(const QString& labelText, QWidget *parent = nullptr);
+	~CChangeAttributesDialog();
+
+	// Only valid once the dialog has been accepted
+	AttributeChange attributeChange() const;
+
+private:
+	// Doesn't let the dialog close with an owner or a group that doesn't exist
+	void acceptIfValid();
+
+private:
+	Ui::CChangeAttributesDialog *ui;
+	AttributeChange _change;
+};
@@ -10,14 +10,16 @@ DISABLE_COMPILER_WARNINGS
 #include <QMessageBox>
 RESTORE_COMPILER_WARNINGS
 
-CCopyMoveDialog::CCopyMoveDialog(Operation operation, std::vector<CFileSystemObject>&& source, QString destination, CMainWindow * mainWindow) :
+CCopyMoveDialog::CCopyMoveDialog(Operation operation, std::vector<CFileSystemObject>&& source, QString destination, CMainWindow * mainWindow, bool cacheNeutralCopying, bool preserveLinks, bool deltaTransfer, const SyncOptions& syncOptions) :
 	QWidget(nullptr, Qt::Window),
 	ui(new Ui::CCopyMoveDialog),
-	_performer(new COperationPerformer(operation, std::move(source), destination)),
 	_mainWindow(mainWindow),
 	_op(operation),
-	_titleTemplate(_op == operationCopy ? tr("%1% Copying %2/s, %3 remaining") : tr("%1% Moving %2/s, %3 remaining")),
-	_labelTemplate(_op == operationCopy ? tr("Copying files... %2/s, %3 remaining") : tr("Moving files... %2/s, %3 remaining"))
+	_destination(destination),
+	_cacheNeutralCopying(cacheNeutralCopying),
+	_preserveLinks(preserveLinks),
+	_deltaTransfer(deltaTransfer),
+	_syncOptions(syncOptions)
 {
 	ui->setupUi(this);
 	ui->_overallProgress->linkToWidgetstaskbarButton(this);
@@ -29,25 +31,33 @@ CCopyMoveDialog::CCopyMoveDialog(Operation operation, std::vector<CFileSystemObj
 
 	assert_r(mainWindow);
 
-	if (operation == operationCopy)
-		ui->_lblOperationName->setText("Copying files...");
-	else if (operation == operationMove)
-		ui->_lblOperationName->setText("Moving files...");
-	else
-		assert_unconditional_r("Unknown operation");
+	updateTemplates();
 
 	connect (ui->_btnCancel,     &QPushButton::clicked, this, &CCopyMoveDialog::cancelPressed);
 	connect (ui->_btnBackground, &QPushButton::clicked, this, &CCopyMoveDialog::switchToBackground);
 	connect (ui->_btnPause,      &QPushButton::clicked, this, &CCopyMoveDialog::pauseResume);
 
-	setWindowTitle(ui->_lblOperationName->text());
-
 	_eventsProcessTimer.setInterval(100);
 	_eventsProcessTimer.start();
-	connect(&_eventsProcessTimer, &QTimer::timeout, this, [this]() {processEvents();});
+	connect(&_eventsProcessTimer, &QTimer::timeout, this, [this]() {
+		processEvents();
+		updateEffectiveRate();
+	});
 
-	_performer->setObserver(this);
-	_performer->start();
+	// Throttling can be adjusted while the operation is running
+	connect(ui->_cbIoPriority, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, [this](int index) {
+		if (_performer)
+			_performer->setIoPriority(static_cast<IoPriority>(index));
+	});
+	connect(ui->_sbLimit, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, [this](int megabytesPerSecond) {
+		if (_performer)
+			_performer->setBandwidthLimit(static_cast<uint64_t>(megabytesPerSecond) * 1024 * 1024);
+	});
+
+	if (_op == operationSync && _syncOptions.dryRun)
+		_syncSource = source;
+
+	startPerformer(std::move(source));
 }
 
 CCopyMoveDialog::~CCopyMoveDialog()
@@ -68,7 +78,14 @@ void CCopyMoveDialog::onProgressChanged(float totalPercentage, size_t numFilesPr
 
 
 	ui->_lblOperationName->setText(_labelTemplate.arg(fileSizeToString(speed), secondsToTimeIntervalString(secondsRemaining)));
-	ui->_lblNumFiles->setText(QString("%1/%2").arg(numFilesProcessed).arg(totalNumFiles));
+	QString numFilesText = QString("%1/%2").arg(numFilesProcessed).arg(totalNumFiles);
+	const auto linkStatistics = _performer ? _performer->linkStatistics() : COperationPerformer::LinkStatistics{};
+	if (linkStatistics.hardLinksRecreated > 0)
+		numFilesText += tr(" (%1 hard links, %2 saved)").arg(linkStatistics.hardLinksRecreated).arg(fileSizeToString(linkStatistics.bytesSaved));
+	const auto deltaStatistics = _performer ? _performer->deltaTransferStatistics() : COperationPerformer::DeltaTransferStatistics{};
+	if (deltaStatistics.filesUpdated > 0)
+		numFilesText += tr(" (%1 written, %2 already up to date)").arg(fileSizeToString(deltaStatistics.bytesWritten), fileSizeToString(deltaStatistics.bytesSkipped));
+	ui->_lblNumFiles->setText(numFilesText);
 	setWindowTitle(_titleTemplate.arg(QString::number(totalPercentage, 'f', 1), fileSizeToString(speed), secondsToTimeIntervalString(secondsRemaining)));
 }
 
@@ -84,7 +101,13 @@ void CCopyMoveDialog::onProcessHalted(HaltReason reason, CFileSystemObject sourc
 
 void CCopyMoveDialog::onProcessFinished(QString message)
 {
+	const bool dryRunCompleted = _op == operationSync && _syncOptions.dryRun && !_cancelled && message.isEmpty();
+	const SyncReport syncReport = dryRunCompleted ? _performer->syncReport() : SyncReport();
 	_performer.reset();
+
+	if (dryRunCompleted && confirmSync(syncReport))
+		return;
+
 	close();
 
 	if (!message.isEmpty())
@@ -164,8 +187,93 @@ void CCopyMoveDialog::closeEvent(QCloseEvent *e)
 		e->ignore();
 }
 
+void CCopyMoveDialog::updateEffectiveRate()
+{
+	if (_performer)
+		ui->_lblEffectiveRate->setText(tr("Now: %1/s").arg(fileSizeToString(_performer->currentBytesPerSecond())));
+}
+
+void CCopyMoveDialog::startPerformer(std::vector<CFileSystemObject>&& source)
+{
+	_performer = std::make_unique<COperationPerformer>(_op, std::move(source), _destination);
+	_performer->setObserver(this);
+	_performer->setCacheNeutralCopying(_cacheNeutralCopying);
+	_performer->setPreserveLinks(_preserveLinks);
+	_performer->setDeltaTransfer(_deltaTransfer);
+	if (_op == operationSync)
+		_performer->setSyncOptions(_syncOptions);
+	// The throttling settings the user may have changed during the dry run carry over
+	_performer->setIoPriority(static_cast<IoPriority>(ui->_cbIoPriority->currentIndex()));
+	_performer->setBandwidthLimit(static_cast<uint64_t>(ui->_sbLimit->value()) * 1024 * 1024);
+	_performer->start();
+}
+
+void CCopyMoveDialog::updateTemplates()
+{
+	if (_op == operationCopy)
+	{
+		_titleTemplate = tr("%1% Copying %2/s, %3 remaining");
+		_labelTemplate = tr("Copying files... %2/s, %3 remaining");
+		ui->_lblOperationName->setText(tr("Copying files..."));
+	}
+	else if (_op == operationMove)
+	{
+		_titleTemplate = tr("%1% Moving %2/s, %3 remaining");
+		_labelTemplate = tr("Moving files... %2/s, %3 remaining");
+		ui->_lblOperationName->setText(tr("Moving files..."));
+	}
+	else if (_op == operationSync && _syncOptions.dryRun)
+	{
+		_titleTemplate = tr("%1% Comparing %2/s, %3 remaining");
+		_labelTemplate = tr("Comparing files... %2/s, %3 remaining");
+		ui->_lblOperationName->setText(tr("Comparing files..."));
+	}
+	else if (_op == operationSync)
+	{
+		_titleTemplate = tr("%1% Synchronizing %2/s, %3 remaining");
+		_labelTemplate = tr("Synchronizing files... %2/s, %3 remaining");
+		ui->_lblOperationName->setText(tr("Synchronizing files..."));
+	}
+	else
+		assert_unconditional_r("Unknown operation");
+
+	setWindowTitle(ui->_lblOperationName->text());
+}
+
+bool CCopyMoveDialog::confirmSync(const SyncReport& report)
+{
+	if (!report.hasChanges())
+	{
+		QMessageBox::information(this, tr("Synchronize"), tr("The destination is already up to date (%1 items checked).").arg(report.numItemsUpToDate));
+		return false;
+	}
+
+	static const char* const prefixes[] = {"+ ", "+ ", "* ", "- "}; // CreateFolder, CopyNew, Update, Delete
+	QString details;
+	for (const SyncReport::Entry& entry: report.entries)
+		details += prefixes[entry.type] + toNativeSeparators(entry.path) + '\n';
+	if (report.entries.size() >= SyncReport::MaxEntries)
+		details += "...";
+
+	QMessageBox messageBox(QMessageBox::Question, tr("Synchronize"),
+		tr("%1 new folders and %2 new files will be created, %3 files will be updated (%4 to copy in total), %5 items will be deleted. %6 items are already up to date.\n\nApply these changes?")
+			.arg(report.numFoldersCreated).arg(report.numFilesCopied).arg(report.numFilesUpdated).arg(fileSizeToString(report.bytesCopied)).arg(report.numItemsDeleted).arg(report.numItemsUpToDate),
+		QMessageBox::Yes | QMessageBox::No, this);
+	messageBox.setDetailedText(details);
+	if (messageBox.exec() != QMessageBox::Yes)
+		return false;
+
+	_syncOptions.dryRun = false;
+	updateTemplates();
+	ui->_overallProgress->setValue(0);
+	ui->_fileProgress->setValue(0);
+	startPerformer(std::move(_syncSource));
+	return true;
+}
+
 void CCopyMoveDialog::cancel()
 {
+	_cancelled = true;
 	_performer->cancel();
 	ui->_btnCancel->setEnabled(false);
 	ui->_btnPause->setEnabled(false);
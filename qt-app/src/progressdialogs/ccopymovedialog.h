@@ -19,7 +19,7 @@ class CCopyMoveDialog : public QWidget, protected CFileOperationObserver
 	Q_OBJECT
 
 public:
-	explicit CCopyMoveDialog(Operation, std::vector<CFileSystemObject>&& source, QString destination, CMainWindow * mainWindow);
+	explicit CCopyMoveDialog(Operation, std::vector<CFileSystemObject>&& source, QString destination, CMainWindow * mainWindow, bool cacheNeutralCopying = false, bool preserveLinks = false, bool deltaTransfer = false, const SyncOptions& syncOptions = SyncOptions());
 	~CCopyMoveDialog();
 
 // Callbacks
@@ -42,6 +42,11 @@ private: // slots
 
 private:
 	void cancel();
+	void updateEffectiveRate();
+	void startPerformer(std::vector<CFileSystemObject>&& source);
+	void updateTemplates();
+	// Presents the results of a synchronization dry run; true if the user chose to apply the changes and the synchronization has been started
+	bool confirmSync(const SyncReport& report);
 
 private:
 	Ui::CCopyMoveDialog * ui;
@@ -49,8 +54,16 @@ private:
 	CMainWindow         * _mainWindow;
 	Operation             _op;
 	QTimer                _eventsProcessTimer;
-	const QString         _titleTemplate;
-	const QString         _labelTemplate;
+	QString               _titleTemplate;
+	QString               _labelTemplate;
+
+	const QString         _destination;
+	const bool            _cacheNeutralCopying;
+	const bool            _preserveLinks;
+	const bool            _deltaTransfer;
+	SyncOptions           _syncOptions;
+	std::vector<CFileSystemObject> _syncSource; // Kept for the actual synchronization that follows the dry run
+	bool                  _cancelled = false;
 };
 
 #endif // CCOPYMOVEDIALOG_H
@@ -12,10 +12,24 @@ DISABLE_COMPILER_WARNINGS
 RESTORE_COMPILER_WARNINGS
 
 CDeleteProgressDialog::CDeleteProgressDialog(std::vector<CFileSystemObject>&& source, QString destination, CMainWindow *mainWindow) :
+	CDeleteProgressDialog(operationDelete, std::move(source), destination, mainWindow)
+{
+	_performer->start();
+}
+
+CDeleteProgressDialog::CDeleteProgressDialog(std::vector<CFileSystemObject>&& source, const AttributeChange& change, CMainWindow* mainWindow) :
+	CDeleteProgressDialog(operationChangeAttributes, std::move(source), QString(), mainWindow)
+{
+	_performer->setAttributeChange(change);
+	_performer->start();
+}
+
+CDeleteProgressDialog::CDeleteProgressDialog(Operation operation, std::vector<CFileSystemObject>&& source, QString destination, CMainWindow *mainWindow) :
 	QWidget(nullptr, Qt::Window),
 	ui(new Ui::CDeleteProgressDialog),
-	_performer(new COperationPerformer(operationDelete, std::move(source), destination)),
-	_mainWindow(mainWindow)
+	_performer(new COperationPerformer(operation, std::move(source), destination)),
+	_mainWindow(mainWindow),
+	_op(operation)
 {
 	ui->setupUi(this);
 	ui->_progress->linkToWidgetstaskbarButton(this);
@@ -29,14 +43,24 @@ CDeleteProgressDialog::CDeleteProgressDialog(std::vector<CFileSystemObject>&& so
 	connect (ui->_btnBackground, &QPushButton::clicked, this, &CDeleteProgressDialog::background);
 	connect (ui->_btnPause, &QPushButton::clicked, this, &CDeleteProgressDialog::pauseResume);
 
-	setWindowTitle(tr("Deleting..."));
+	setWindowTitle(_op == operationDelete ? tr("Deleting...") : tr("Changing attributes..."));
 
 	_eventsProcessTimer.setInterval(100);
 	_eventsProcessTimer.start();
-	connect(&_eventsProcessTimer, &QTimer::timeout, this, [this]() {processEvents(); });
+	connect(&_eventsProcessTimer, &QTimer::timeout, this, [this]() {
+		processEvents();
+		updateEffectiveRate();
+	});
+
+	// Throttling can be adjusted while the operation is running
+	connect(ui->_cbIoPriority, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, [this](int index) {
+		_performer->setIoPriority(static_cast<IoPriority>(index));
+	});
+	connect(ui->_sbLimit, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, [this](int itemsPerSecond) {
+		_performer->setOperationsPerSecondLimit(static_cast<uint64_t>(itemsPerSecond));
+	});
 
 	_performer->setObserver(this);
-	_performer->start();
 }
 
 CDeleteProgressDialog::~CDeleteProgressDialog()
@@ -47,14 +71,15 @@ CDeleteProgressDialog::~CDeleteProgressDialog()
 void CDeleteProgressDialog::onProgressChanged(float totalPercentage, size_t numFilesProcessed, size_t totalNumFiles, float /*filePercentage*/, uint64_t speed, uint32_t secondsRemaining)
 {
 	ui->_progress->setValue((int)(totalPercentage + 0.5f));
-	ui->_lblOperationNameAndSpeed->setText(tr("Deleting item %1 of %2, %3 items / second, %4 remaining").arg(numFilesProcessed).arg(totalNumFiles).arg(speed).arg(secondsToTimeIntervalString(secondsRemaining)));
-	static const QString titleTemplate(tr("%1% Deleting... %2 items / second, %3 remaining"));
+	const QString labelTemplate = _op == operationDelete ? tr("Deleting item %1 of %2, %3 items / second, %4 remaining") : tr("Processing item %1 of %2, %3 items / second, %4 remaining");
+	ui->_lblOperationNameAndSpeed->setText(labelTemplate.arg(numFilesProcessed).arg(totalNumFiles).arg(speed).arg(secondsToTimeIntervalString(secondsRemaining)));
+	const QString titleTemplate = _op == operationDelete ? tr("%1% Deleting... %2 items / second, %3 remaining") : tr("%1% Changing attributes... %2 items / second, %3 remaining");
 	setWindowTitle(titleTemplate.arg(QString::number(totalPercentage, 'f', 1)).arg(speed).arg(secondsToTimeIntervalString(secondsRemaining)));
 }
 
 void CDeleteProgressDialog::onProcessHalted(HaltReason reason, CFileSystemObject source, CFileSystemObject dest, QString errorMessage)
 {
-	CPromptDialog prompt(this, operationDelete, reason, source, dest, errorMessage);
+	CPromptDialog prompt(this, _op, reason, source, dest, errorMessage);
 
 	ui->_progress->setState(psStopped);
 
@@ -110,6 +135,11 @@ void CDeleteProgressDialog::background()
 	});
 }
 
+void CDeleteProgressDialog::updateEffectiveRate()
+{
+	ui->_lblEffectiveRate->setText(tr("Now: %1 items/s").arg(_performer->currentOperationsPerSecond()));
+}
+
 void CDeleteProgressDialog::cancel()
 {
 	_performer->cancel();
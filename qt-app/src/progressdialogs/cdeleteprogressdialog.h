@@ -20,6 +20,8 @@ class CDeleteProgressDialog : public QWidget, protected CFileOperationObserver
 {
 public:
 	CDeleteProgressDialog(std::vector<CFileSystemObject>&& source, QString destination, CMainWindow * mainWindow);
+	// Changing attributes goes item by item just like deleting does, and is presented the same way
+	CDeleteProgressDialog(std::vector<CFileSystemObject>&& source, const AttributeChange& change, CMainWindow * mainWindow);
 	~CDeleteProgressDialog();
 
 // Callbacks
@@ -32,16 +34,20 @@ protected:
 	void closeEvent(QCloseEvent * e) override;
 
 private:
+	CDeleteProgressDialog(Operation operation, std::vector<CFileSystemObject>&& source, QString destination, CMainWindow * mainWindow);
+
 	void cancelPressed();
 	void pauseResume();
 	void background();
 
 private:
 	void cancel();
+	void updateEffectiveRate();
 
 private:
 	Ui::CDeleteProgressDialog *ui;
 	const std::unique_ptr<COperationPerformer> _performer;
 	CMainWindow         * _mainWindow;
+	const Operation       _op;
 	QTimer                _eventsProcessTimer;
 };
@@ -10,6 +10,14 @@ CFileOperationConfirmationPrompt::CFileOperationConfirmationPrompt(const QString
 	ui->_editField->setText(editText);
 	ui->_editField->selectAll();
 	setWindowTitle(caption);
+
+	ui->_cbSyncDeleteExtraneous->hide();
+	ui->_cbSyncCompareContents->hide();
+
+#ifdef _WIN32
+	ui->_cbPreserveLinks->hide(); // Not supported
+	ui->_cbDeltaTransfer->hide();
+#endif
 }
 
 CFileOperationConfirmationPrompt::~CFileOperationConfirmationPrompt()
@@ -21,3 +29,49 @@ QString CFileOperationConfirmationPrompt::text() const
 {
 	return ui->_editField->text();
 }
+
+void CFileOperationConfirmationPrompt::setCacheNeutralCopying(bool cacheNeutral)
+{
+	ui->_cbCacheNeutralCopying->setChecked(cacheNeutral);
+}
+
+bool CFileOperationConfirmationPrompt::cacheNeutralCopying() const
+{
+	return ui->_cbCacheNeutralCopying->isChecked();
+}
+
+void CFileOperationConfirmationPrompt::setPreserveLinks(bool preserve)
+{
+	ui->_cbPreserveLinks->setChecked(preserve);
+}
+
+bool CFileOperationConfirmationPrompt::preserveLinks() const
+{
+	return ui->_cbPreserveLinks->isChecked();
+}
+
+void CFileOperationConfirmationPrompt::setDeltaTransfer(bool deltaTransfer)
+{
+	ui->_cbDeltaTransfer->setChecked(deltaTransfer);
+}
+
+bool CFileOperationConfirmationPrompt::deltaTransfer() const
+{
+	return ui->_cbDeltaTransfer->isChecked();
+}
+
+void CFileOperationConfirmationPrompt::setSyncOptions(const SyncOptions& options)
+{
+	ui->_cbSyncDeleteExtraneous->setChecked(options.deleteExtraneous);
+	ui->_cbSyncCompareContents->setChecked(options.compareContents);
+	ui->_cbSyncDeleteExtraneous->show();
+	ui->_cbSyncCompareContents->show();
+}
+
+SyncOptions CFileOperationConfirmationPrompt::syncOptions() const
+{
+	SyncOptions options;
+	options.deleteExtraneous = ui->_cbSyncDeleteExtraneous->isChecked();
+	options.compareContents = ui->_cbSyncCompareContents->isChecked();
+	return options;
+}
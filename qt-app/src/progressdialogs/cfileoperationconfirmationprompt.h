@@ -1,6 +1,7 @@
 #ifndef CFILEOPERATIONCONFIRMATIONPROMPT_H
 #define CFILEOPERATIONCONFIRMATIONPROMPT_H
 
+#include "fileoperations/csyncplanner.h"
 #include "compiler/compiler_warnings_control.h"
 
 DISABLE_COMPILER_WARNINGS
@@ -19,6 +20,19 @@ public:
 
 	QString text() const;
 
+	void setCacheNeutralCopying(bool cacheNeutral);
+	bool cacheNeutralCopying() const;
+
+	void setPreserveLinks(bool preserve);
+	bool preserveLinks() const;
+
+	void setDeltaTransfer(bool deltaTransfer);
+	bool deltaTransfer() const;
+
+	// The synchronization options are only shown once set
+	void setSyncOptions(const SyncOptions& options);
+	SyncOptions syncOptions() const;
+
 private:
 	Ui::CFileOperationConfirmationPrompt *ui;
 };
@@ -0,0 +1,110 @@
+#include "coccupiedspacedialog.h"
+#include "ccontroller.h"
+#include "../cmainwindow.h"
+#include "filesystemhelperfunctions.h"
+#include "assert/advanced_assert.h"
+
+DISABLE_COMPILER_WARNINGS
+#include "ui_coccupiedspacedialog.h"
+
+#include <QCloseEvent>
+#include <QHeaderView>
+RESTORE_COMPILER_WARNINGS
+
+enum BreakdownColumn {NameColumn, SizeColumn, AllocatedSizeColumn, FilesColumn, FoldersColumn, NumColumns};
+
+COccupiedSpaceDialog::COccupiedSpaceDialog(std::vector<QString> paths, QWidget* parent) :
+	QWidget(parent, Qt::Window),
+	ui(new Ui::COccupiedSpaceDialog),
+	_calculator(new COccupiedSpaceCalculator(std::move(paths), CPruningRules::fromSettings()))
+{
+	ui->setupUi(this);
+
+	setAttribute(Qt::WA_DeleteOnClose, true);
+	setWindowTitle(tr("Calculating occupied space..."));
+
+	ui->_breakdown->setColumnCount(NumColumns);
+	ui->_breakdown->setHeaderLabels({tr("Name"), tr("Size"), tr("On disk"), tr("Files"), tr("Folders")});
+	ui->_breakdown->header()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
+	ui->_breakdown->header()->setStretchLastSection(false);
+
+	connect(ui->_btnCancel, &QPushButton::clicked, this, &COccupiedSpaceDialog::cancelOrClose);
+	connect(ui->_breakdown, &QTreeWidget::itemActivated, this, [](QTreeWidgetItem* item) {
+		CController::get().activePanel().goToItem(CFileSystemObject(item->data(NameColumn, Qt::UserRole).toString()));
+		CMainWindow::get()->activateWindow();
+	});
+
+	connect(&_updateTimer, &QTimer::timeout, this, &COccupiedSpaceDialog::updateResults);
+	_updateTimer.start(100);
+
+	_calculator->start();
+}
+
+COccupiedSpaceDialog::~COccupiedSpaceDialog()
+{
+	delete ui;
+}
+
+void COccupiedSpaceDialog::closeEvent(QCloseEvent* e)
+{
+	_calculator->cancel();
+	QWidget::closeEvent(e);
+}
+
+void COccupiedSpaceDialog::updateResults()
+{
+	const COccupiedSpaceCalculator::Snapshot results = _calculator->snapshot();
+	if (results.finished)
+		_updateTimer.stop();
+
+	const auto& totals = results.totals;
+	ui->_lblTotals->setText(tr("Files: %1, folders: %2").arg(totals.files).arg(totals.folders) +
+		(results.hardLinksSkipped > 0 ? tr(" (%1 hard links counted once)").arg(results.hardLinksSkipped) : QString()));
+	ui->_lblSize->setText(tr("Size: %1 (%2 bytes), on disk: %3 (%4 bytes)").
+		arg(fileSizeToString(totals.occupiedSpace)).arg(totals.occupiedSpace).
+		arg(fileSizeToString(totals.allocatedSpace)).arg(totals.allocatedSpace));
+
+	if (!results.finished)
+		ui->_lblCurrentItem->setText(toNativeSeparators(results.currentItem));
+	else
+	{
+		ui->_lblCurrentItem->setText((results.cancelled ? tr("Cancelled after %1 ms") : tr("Done in %1 ms")).arg(results.msElapsed));
+		ui->_btnCancel->setText(tr("Close"));
+		setWindowTitle(tr("Occupied space"));
+	}
+
+	// The rows are reused rather than re-created so that scrolling doesn't jump around on every update
+	const int numRows = static_cast<int>(results.breakdown.size());
+	while (ui->_breakdown->topLevelItemCount() > numRows)
+		delete ui->_breakdown->takeTopLevelItem(ui->_breakdown->topLevelItemCount() - 1);
+
+	QList<QTreeWidgetItem*> newItems;
+	for (int i = ui->_breakdown->topLevelItemCount(); i < numRows; ++i)
+	{
+		auto* item = new QTreeWidgetItem;
+		for (int column = SizeColumn; column < NumColumns; ++column)
+			item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+		newItems.push_back(item);
+	}
+	ui->_breakdown->addTopLevelItems(newItems);
+
+	for (int i = 0; i < numRows; ++i)
+	{
+		const OccupiedSpaceEntry& entry = results.breakdown[static_cast<size_t>(i)];
+		QTreeWidgetItem* item = ui->_breakdown->topLevelItem(i);
+		item->setText(NameColumn, entry.isDir ? entry.name + '/' : entry.name);
+		item->setData(NameColumn, Qt::UserRole, entry.fullPath);
+		item->setText(SizeColumn, fileSizeToString(entry.stats.occupiedSpace));
+		item->setText(AllocatedSizeColumn, fileSizeToString(entry.stats.allocatedSpace));
+		item->setText(FilesColumn, QString::number(entry.stats.files));
+		item->setText(FoldersColumn, QString::number(entry.stats.folders));
+	}
+}
+
+void COccupiedSpaceDialog::cancelOrClose()
+{
+	if (_calculator->finished())
+		close();
+	else
+		_calculator->cancel();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "statistics/coccupiedspacecalculator.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QTimer>
+#include <QWidget>
+RESTORE_COMPILER_WARNINGS
+
+#include <memory>
+
+namespace Ui {
+class COccupiedSpaceDialog;
+}
+
+class COccupiedSpaceDialog : public QWidget
+{
+	Q_OBJECT
+
+public:
+	COccupiedSpaceDialog(std::vector<QString> paths, QWidget* parent);
+	~COccupiedSpaceDialog();
+
+protected:
+	void closeEvent(QCloseEvent* e) override;
+
+private:
+	void updateResults();
+	void cancelOrClose();
+
+private:
+	Ui::COccupiedSpaceDialog *ui;
+	const std::unique_ptr<COccupiedSpaceCalculator> _calculator;
+	QTimer _updateTimer;
+};
@@ -82,6 +82,12 @@ CPromptDialog::CPromptDialog(QWidget *parent, Operation op, HaltReason promptRea
 		ui->btnDeleteAllAnyway->setVisible(false);
 		ui->btnRename->setVisible(false);
 		break;
+	case hrFailedToChangeAttributes:
+		ui->lblQuestion->setText(tr("Failed to change the attributes of\n%1").arg(source.fullAbsolutePath()));
+		ui->btnOverwrite->setVisible(false);
+		ui->btnOverwriteAll->setVisible(false);
+		ui->btnRename->setVisible(false);
+		break;
 	case hrUnknownError:
 		ui->lblQuestion->setText("An unknown error occurred. What do you want to do?");
 		ui->btnOverwrite->setVisible(false);
@@ -15,6 +15,14 @@ CSettingsPageOther::CSettingsPageOther(QWidget *parent) :
 	CSettings s;
 	ui->_shellCommandName->setText(s.value(KEY_OTHER_SHELL_COMMAND_NAME, OsShell::shellExecutable()).toString());
 	ui->_cbCheckForUpdatesAutomatically->setChecked(s.value(KEY_OTHER_CHECK_FOR_UPDATES_AUTOMATICALLY, true).toBool());
+
+	ui->_cbContentIndexEnabled->setChecked(s.value(KEY_OTHER_CONTENT_INDEX_ENABLED, false).toBool());
+	ui->_contentIndexFolders->setPlainText(s.value(KEY_OTHER_CONTENT_INDEX_FOLDERS).toStringList().join('\n'));
+	ui->_contentIndexMaxFileSize->setValue(s.value(KEY_OTHER_CONTENT_INDEX_MAX_FILE_SIZE_MB, CONTENT_INDEX_MAX_FILE_SIZE_MB_DEFAULT).toInt());
+
+	ui->_scanExclusionPatterns->setPlainText(s.value(KEY_OTHER_SCAN_EXCLUSION_PATTERNS).toStringList().join('\n'));
+	ui->_cbScanSameFileSystemOnly->setChecked(s.value(KEY_OTHER_SCAN_SAME_FILE_SYSTEM_ONLY, false).toBool());
+	ui->_cbScanSkipSystemItems->setChecked(s.value(KEY_OTHER_SCAN_SKIP_SYSTEM_ITEMS, false).toBool());
 }
 
 CSettingsPageOther::~CSettingsPageOther()
@@ -27,4 +35,16 @@ void CSettingsPageOther::acceptSettings()
 	CSettings s;
 	s.setValue(KEY_OTHER_SHELL_COMMAND_NAME, ui->_shellCommandName->text());
 	s.setValue(KEY_OTHER_CHECK_FOR_UPDATES_AUTOMATICALLY, ui->_cbCheckForUpdatesAutomatically->isChecked());
+
+	s.setValue(KEY_OTHER_CONTENT_INDEX_ENABLED, ui->_cbContentIndexEnabled->isChecked());
+	QStringList folders = ui->_contentIndexFolders->toPlainText().split('\n', Qt::SkipEmptyParts);
+	for (QString& folder : folders)
+		folder = folder.trimmed();
+	folders.removeAll(QString());
+	s.setValue(KEY_OTHER_CONTENT_INDEX_FOLDERS, folders);
+	s.setValue(KEY_OTHER_CONTENT_INDEX_MAX_FILE_SIZE_MB, ui->_contentIndexMaxFileSize->value());
+
+	s.setValue(KEY_OTHER_SCAN_EXCLUSION_PATTERNS, ui->_scanExclusionPatterns->toPlainText().split('\n', Qt::SkipEmptyParts));
+	s.setValue(KEY_OTHER_SCAN_SAME_FILE_SYSTEM_ONLY, ui->_cbScanSameFileSystemOnly->isChecked());
+	s.setValue(KEY_OTHER_SCAN_SKIP_SYSTEM_ITEMS, ui->_cbScanSkipSystemItems->isChecked());
 }